@@ -2,6 +2,23 @@
 #include<zephyr/device.h>
 #include<zephyr/drivers/gpio.h>
 #include<zephyr/shell/shell.h>
+#include <errno.h>
+
+#if defined(CONFIG_APP_PROBE)
+#include "probe.h"
+#endif
+
+#if defined(CONFIG_APP_PROBE_SELFTEST)
+#include <posix_board_if.h>
+#endif
+
+/*
+ * LED on and off from the shell, and the GPIO timing probes (probe.h)
+ * under "probe". On native_sim the probes drive the GPIO emulator and
+ * their edges are recorded; for an unattended check:
+ *   west build -b native_sim led_cmd -- -DCONFIG_APP_PROBE_SELFTEST=y
+ *   build/zephyr/zephyr.exe
+ */
 
 #define LED0 DT_ALIAS(led0)
 
@@ -31,8 +48,19 @@ int  main(void)
 {
     if (!device_is_ready(led.port)) {
         printk("Error: LED device not ready\n");
-        return;
+        return -ENODEV;
     }
     gpio_pin_configure_dt(&led, GPIO_OUTPUT_INACTIVE);
-}
 
+#if defined(CONFIG_APP_PROBE_SELFTEST)
+    int rc = probe_selftest();
+
+    if (rc) {
+        printk("PROBE selftest failed (%d)\n", rc);
+    } else {
+        printk("PROBE selftest ok, %u probes\n", (unsigned)probe_count());
+    }
+    posix_exit(rc ? 1 : 0);
+#endif
+    return 0;
+}
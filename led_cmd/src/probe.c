@@ -0,0 +1,583 @@
+#include "probe.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <zephyr/device.h>
+#include <zephyr/devicetree.h>
+#include <zephyr/drivers/gpio.h>
+#include <zephyr/init.h>
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/shell/shell.h>
+#include <zephyr/sys/util.h>
+
+#if defined(CONFIG_GPIO_EMUL)
+#include <zephyr/drivers/gpio/gpio_emul.h>
+#endif
+
+LOG_MODULE_REGISTER(probe, LOG_LEVEL_INF);
+
+#define PROBES_NODE DT_COMPAT_GET_ANY_STATUS_OKAY(app_timing_probes)
+
+#if defined(CONFIG_APP_PROBE_EDGES) && CONFIG_APP_PROBE_EDGES > 0
+#define PROBE_EDGES CONFIG_APP_PROBE_EDGES
+#else
+#define PROBE_EDGES 0
+#endif
+
+/* -------- Pins, from the devicetree -------- */
+
+struct probe_pin {
+    const char *name;
+    struct gpio_dt_spec spec;
+#if PROBE_DIRECT
+    GPIO_TypeDef *regs;
+#endif
+};
+
+#define PROBE_PIN(node)                                                         \
+    {                                                                           \
+        .name = DT_NODE_FULL_NAME(node),                                        \
+        .spec = GPIO_DT_SPEC_GET(node, gpios),                                  \
+        COND_CODE_1(PROBE_DIRECT,                                               \
+                    (.regs = (GPIO_TypeDef *)DT_REG_ADDR(DT_GPIO_CTLR(node, gpios)),), \
+                    ())                                                         \
+    },
+
+static const struct probe_pin pins[] = {
+    DT_FOREACH_CHILD(PROBES_NODE, PROBE_PIN)
+};
+
+BUILD_ASSERT(ARRAY_SIZE(pins) > 0, "app,timing-probes needs at least one probe");
+BUILD_ASSERT(ARRAY_SIZE(pins) <= UINT8_MAX, "too many probes");
+
+/* The *-on properties: probe index, mode, event name; NULL ends the list */
+struct probe_default {
+    uint8_t probe;
+    uint8_t mode;
+    const char *event;
+};
+
+#define PROBE_DEF_ONE(node, prop, idx, mode) \
+    { DT_NODE_CHILD_IDX(node), mode, DT_PROP_BY_IDX(node, prop, idx) },
+#define PROBE_DEF_PROP(node, prop, mode)                                        \
+    COND_CODE_1(DT_NODE_HAS_PROP(node, prop),                                   \
+                (DT_FOREACH_PROP_ELEM_VARGS(node, prop, PROBE_DEF_ONE, mode)), ())
+#define PROBE_DEF_NODE(node)                                                    \
+    PROBE_DEF_PROP(node, set_on, PROBE_SET)                                     \
+    PROBE_DEF_PROP(node, clear_on, PROBE_CLEAR)                                 \
+    PROBE_DEF_PROP(node, pulse_on, PROBE_PULSE)                                 \
+    PROBE_DEF_PROP(node, toggle_on, PROBE_TOGGLE)
+
+static const struct probe_default defaults[] = {
+    DT_FOREACH_CHILD(PROBES_NODE, PROBE_DEF_NODE)
+    { 0, PROBE_OFF, NULL },
+};
+
+struct probe_action probe_actions[PROBE_EV_COUNT];
+
+/* -------- Names -------- */
+
+#define PROBE_EV_NAME(name) #name,
+static const char *const event_names[PROBE_EV_COUNT] = { PROBE_EVENTS(PROBE_EV_NAME) };
+
+static const char *const mode_names[] = { "off", "set", "clear", "pulse", "toggle" };
+
+const char *probe_event_name(enum probe_event ev)
+{
+    return (ev < PROBE_EV_COUNT) ? event_names[ev] : "-";
+}
+
+const char *probe_mode_name(enum probe_mode mode)
+{
+    return (mode < ARRAY_SIZE(mode_names)) ? mode_names[mode] : "?";
+}
+
+int probe_event_parse(const char *name)
+{
+    for (int i = 0; i < PROBE_EV_COUNT; i++) {
+        if (strcmp(name, event_names[i]) == 0) return i;
+    }
+    return -EINVAL;
+}
+
+int probe_mode_parse(const char *name)
+{
+    for (size_t i = 0; i < ARRAY_SIZE(mode_names); i++) {
+        if (strcmp(name, mode_names[i]) == 0) return (int)i;
+    }
+    return -EINVAL;
+}
+
+/* -------- Edges -------- */
+
+#if PROBE_EDGES
+static struct k_spinlock edge_lock;
+static struct probe_edge edges[PROBE_EDGES];
+static uint32_t edge_count;
+static uint32_t edge_lost;
+static uint8_t edge_level[ARRAY_SIZE(pins)];    /* last recorded, logical */
+
+/* After a write, under edge_lock: the emulator's output tells whether the pin moved */
+static void edge_record(size_t probe, uint8_t ev)
+{
+    const struct gpio_dt_spec *s = &pins[probe].spec;
+    int v = gpio_emul_output_get(s->port, s->pin);
+
+    if (v < 0) return;
+    uint8_t level = (uint8_t)v ^ ((s->dt_flags & GPIO_ACTIVE_LOW) ? 1 : 0);
+    if (level == edge_level[probe]) return;
+    edge_level[probe] = level;
+
+    if (edge_count == PROBE_EDGES) {
+        edge_lost++;
+        return;
+    }
+    edges[edge_count++] = (struct probe_edge){
+        .cycles = k_cycle_get_32(),
+        .probe = (uint8_t)probe,
+        .level = level,
+        .event = ev,
+    };
+}
+#endif
+
+int probe_edges_get(struct probe_edge *out, size_t max, uint32_t *lost)
+{
+#if PROBE_EDGES
+    k_spinlock_key_t key = k_spin_lock(&edge_lock);
+    size_t n = MIN(max, edge_count);
+
+    memcpy(out, edges, n * sizeof(edges[0]));
+    if (lost) *lost = edge_lost;
+    k_spin_unlock(&edge_lock, key);
+    return (int)n;
+#else
+    ARG_UNUSED(out);
+    ARG_UNUSED(max);
+    ARG_UNUSED(lost);
+    return -ENOTSUP;
+#endif
+}
+
+void probe_edges_clear(void)
+{
+#if PROBE_EDGES
+    k_spinlock_key_t key = k_spin_lock(&edge_lock);
+
+    edge_count = 0;
+    edge_lost = 0;
+    k_spin_unlock(&edge_lock, key);
+#endif
+}
+
+/* -------- Driving -------- */
+
+static void level_write(const struct gpio_dt_spec *s, bool active)
+{
+    gpio_port_pins_t bit = BIT(s->pin);
+
+    if (active != ((s->dt_flags & GPIO_ACTIVE_LOW) != 0)) {
+        gpio_port_set_bits_raw(s->port, bit);
+    } else {
+        gpio_port_clear_bits_raw(s->port, bit);
+    }
+}
+
+/* The driver path: every board but STM32, and probe_set() everywhere */
+static void drive(size_t probe, enum probe_mode mode, uint8_t ev)
+{
+    const struct gpio_dt_spec *s = &pins[probe].spec;
+
+#if PROBE_EDGES
+    k_spinlock_key_t key = k_spin_lock(&edge_lock);
+#define EDGE() edge_record(probe, ev)
+#else
+    ARG_UNUSED(ev);
+#define EDGE() do { } while (0)
+#endif
+
+    switch (mode) {
+    case PROBE_SET:
+        level_write(s, true);
+        EDGE();
+        break;
+    case PROBE_CLEAR:
+        level_write(s, false);
+        EDGE();
+        break;
+    case PROBE_PULSE:
+        level_write(s, true);
+        EDGE();
+        level_write(s, false);
+        EDGE();
+        break;
+    case PROBE_TOGGLE:
+        gpio_port_toggle_bits(s->port, BIT(s->pin));
+        EDGE();
+        break;
+    default:
+        break;
+    }
+#undef EDGE
+
+#if PROBE_EDGES
+    k_spin_unlock(&edge_lock, key);
+#endif
+}
+
+#if !PROBE_DIRECT
+void probe_fire(enum probe_event ev)
+{
+    const struct probe_action *a = &probe_actions[ev];
+    uint8_t mode = a->mode;
+
+    if (mode != PROBE_OFF) {
+        drive(a->probe, mode, ev);
+    }
+}
+#endif
+
+int probe_set(size_t probe, bool active)
+{
+    if (probe >= ARRAY_SIZE(pins)) return -EINVAL;
+    drive(probe, active ? PROBE_SET : PROBE_CLEAR, PROBE_EV_COUNT);
+    return 0;
+}
+
+/* -------- Mapping -------- */
+
+size_t probe_count(void)
+{
+    return ARRAY_SIZE(pins);
+}
+
+int probe_info_get(size_t probe, struct probe_info *out)
+{
+    if (probe >= ARRAY_SIZE(pins)) return -EINVAL;
+
+    const struct gpio_dt_spec *s = &pins[probe].spec;
+
+    out->name = pins[probe].name;
+    out->port = s->port->name;
+    out->pin = s->pin;
+    out->active_low = (s->dt_flags & GPIO_ACTIVE_LOW) != 0;
+    return 0;
+}
+
+int probe_map(enum probe_event ev, size_t probe, enum probe_mode mode)
+{
+    if (ev >= PROBE_EV_COUNT || probe >= ARRAY_SIZE(pins) || mode > PROBE_TOGGLE) {
+        return -EINVAL;
+    }
+
+    struct probe_action *a = &probe_actions[ev];
+
+    a->mode = PROBE_OFF;
+    compiler_barrier();
+    a->probe = (uint8_t)probe;
+#if PROBE_DIRECT
+    const struct gpio_dt_spec *s = &pins[probe].spec;
+    uint32_t set = BIT(s->pin);
+    uint32_t reset = BIT(s->pin) << 16;
+    bool low = (s->dt_flags & GPIO_ACTIVE_LOW) != 0;
+
+    a->regs = pins[probe].regs;
+    a->mask = set;
+    a->active = low ? reset : set;
+    a->inactive = low ? set : reset;
+#endif
+    compiler_barrier();
+    a->mode = mode;
+    return 0;
+}
+
+void probe_mapping_get(enum probe_event ev, size_t *probe, enum probe_mode *mode)
+{
+    *probe = probe_actions[ev].probe;
+    *mode = probe_actions[ev].mode;
+}
+
+static int probe_init(void)
+{
+    for (size_t i = 0; i < ARRAY_SIZE(pins); i++) {
+        if (!gpio_is_ready_dt(&pins[i].spec)) return -ENODEV;
+        int rc = gpio_pin_configure_dt(&pins[i].spec, GPIO_OUTPUT_INACTIVE);
+        if (rc) return rc;
+    }
+
+    for (const struct probe_default *d = defaults; d->event; d++) {
+        int ev = probe_event_parse(d->event);
+
+        if (ev < 0) {
+            LOG_ERR("%s: unknown event %s", pins[d->probe].name, d->event);
+            continue;
+        }
+        if (probe_actions[ev].mode != PROBE_OFF) {
+            LOG_WRN("%s mapped twice, %s wins", d->event, pins[d->probe].name);
+        }
+        probe_map(ev, d->probe, d->mode);
+    }
+    return 0;
+}
+
+SYS_INIT(probe_init, APPLICATION, CONFIG_APPLICATION_INIT_PRIORITY);
+
+/* -------- Self-test -------- */
+
+#if PROBE_EDGES
+struct selftest_case {
+    uint8_t mode;
+    uint8_t start;          /* level before the event */
+    uint8_t n;              /* edges expected */
+    uint8_t level[2];
+};
+
+static const struct selftest_case cases[] = {
+    { PROBE_SET,    0, 1, { 1 } },
+    { PROBE_SET,    1, 0, { 0 } },
+    { PROBE_CLEAR,  1, 1, { 0 } },
+    { PROBE_CLEAR,  0, 0, { 0 } },
+    { PROBE_PULSE,  0, 2, { 1, 0 } },
+    { PROBE_TOGGLE, 0, 1, { 1 } },
+    { PROBE_TOGGLE, 1, 1, { 0 } },
+};
+
+/* The "bench" edges on probe since edge index from, checked against c */
+static int selftest_check(size_t probe, uint32_t from, const struct selftest_case *c)
+{
+    k_spinlock_key_t key = k_spin_lock(&edge_lock);
+    uint32_t prev = edges[from ? from - 1 : 0].cycles;
+    int n = 0, rc = 0;
+
+    if (edge_lost) rc = -ENOSPC;
+    for (uint32_t i = from; i < edge_count && rc == 0; i++) {
+        const struct probe_edge *e = &edges[i];
+
+        if (e->probe != probe || e->event != PROBE_EV_bench) continue;
+        if (n == c->n || e->level != c->level[n] || (int32_t)(e->cycles - prev) < 0) {
+            rc = -EIO;
+        }
+        prev = e->cycles;
+        n++;
+    }
+    k_spin_unlock(&edge_lock, key);
+    return (rc == 0 && n != c->n) ? -EIO : rc;
+}
+#endif
+
+int probe_selftest(void)
+{
+#if PROBE_EDGES
+    size_t old_probe;
+    enum probe_mode old_mode;
+    int rc = 0;
+
+    probe_mapping_get(PROBE_EV_bench, &old_probe, &old_mode);
+    probe_edges_clear();
+
+    for (size_t p = 0; p < ARRAY_SIZE(pins) && rc == 0; p++) {
+        uint8_t was = edge_level[p];
+
+        for (size_t i = 0; i < ARRAY_SIZE(cases) && rc == 0; i++) {
+            const struct selftest_case *c = &cases[i];
+
+            probe_set(p, c->start);
+            probe_map(PROBE_EV_bench, p, c->mode);
+            uint32_t from = edge_count;
+            probe_fire(PROBE_EV_bench);
+            rc = selftest_check(p, from, c);
+            if (rc) {
+                LOG_ERR("%s: %s from %u failed (%d)", pins[p].name,
+                        mode_names[c->mode], c->start, rc);
+            }
+            probe_map(PROBE_EV_bench, 0, PROBE_OFF);
+        }
+        probe_set(p, was);
+    }
+
+    probe_map(PROBE_EV_bench, old_probe, old_mode);
+    probe_edges_clear();
+    return rc;
+#else
+    return -ENOTSUP;
+#endif
+}
+
+/* -------- Overhead -------- */
+
+static uint32_t per_call_x100(uint32_t cyc, uint32_t base, uint32_t calls)
+{
+    return (cyc > base) ? (uint32_t)(100ull * (cyc - base) / calls) : 0;
+}
+
+int probe_bench_run(uint32_t calls, struct probe_bench *out)
+{
+    size_t old_probe;
+    enum probe_mode old_mode;
+    uint32_t t0, base, off, pulse;
+
+    if (calls == 0) return -EINVAL;
+    probe_mapping_get(PROBE_EV_bench, &old_probe, &old_mode);
+
+    t0 = k_cycle_get_32();
+    for (uint32_t i = 0; i < calls; i++) {
+        __asm__ volatile("" ::: "memory");
+    }
+    base = k_cycle_get_32() - t0;
+
+    probe_map(PROBE_EV_bench, 0, PROBE_OFF);
+    t0 = k_cycle_get_32();
+    for (uint32_t i = 0; i < calls; i++) {
+        probe_fire(PROBE_EV_bench);
+        __asm__ volatile("" ::: "memory");
+    }
+    off = k_cycle_get_32() - t0;
+
+    probe_map(PROBE_EV_bench, 0, PROBE_PULSE);
+    t0 = k_cycle_get_32();
+    for (uint32_t i = 0; i < calls; i++) {
+        probe_fire(PROBE_EV_bench);
+        __asm__ volatile("" ::: "memory");
+    }
+    pulse = k_cycle_get_32() - t0;
+
+    probe_map(PROBE_EV_bench, old_probe, old_mode);
+
+    out->calls = calls;
+    out->off_cycles_x100 = per_call_x100(off, base, calls);
+    out->pulse_cycles_x100 = per_call_x100(pulse, base, calls);
+    return 0;
+}
+
+/* -------- Shell -------- */
+
+#if defined(CONFIG_SHELL)
+static int cmd_probe_list(const struct shell *shell, size_t argc, char **argv)
+{
+    for (size_t p = 0; p < ARRAY_SIZE(pins); p++) {
+        struct probe_info info;
+
+        probe_info_get(p, &info);
+        shell_print(shell, "%u %-10s %s %u%s", (unsigned)p, info.name, info.port, info.pin,
+                    info.active_low ? " (active low)" : "");
+    }
+    for (int ev = 0; ev < PROBE_EV_COUNT; ev++) {
+        const struct probe_action *a = &probe_actions[ev];
+
+        if (a->mode == PROBE_OFF) continue;
+        shell_print(shell, "  %-15s %-6s %s", event_names[ev], mode_names[a->mode],
+                    pins[a->probe].name);
+    }
+    return 0;
+}
+
+static int find_probe(const char *arg)
+{
+    for (size_t p = 0; p < ARRAY_SIZE(pins); p++) {
+        if (strcmp(arg, pins[p].name) == 0) return (int)p;
+    }
+
+    char *end;
+    unsigned long p = strtoul(arg, &end, 10);
+
+    return (*end == '\0' && p < ARRAY_SIZE(pins)) ? (int)p : -EINVAL;
+}
+
+static int cmd_probe_map(const struct shell *shell, size_t argc, char **argv)
+{
+    int ev = probe_event_parse(argv[1]);
+    int p = find_probe(argv[2]);
+    int mode = (argc > 3) ? probe_mode_parse(argv[3]) : PROBE_PULSE;
+
+    if (ev < 0 || p < 0 || mode < 0) {
+        shell_error(shell, "Usage: probe map <event> <probe> [off|set|clear|pulse|toggle]");
+        return -EINVAL;
+    }
+    return probe_map(ev, p, mode);
+}
+
+static int cmd_probe_fire(const struct shell *shell, size_t argc, char **argv)
+{
+    int ev = probe_event_parse(argv[1]);
+
+    if (ev < 0) {
+        shell_error(shell, "Unknown event %s", argv[1]);
+        return -EINVAL;
+    }
+    probe_fire(ev);
+    return 0;
+}
+
+static int cmd_probe_edges(const struct shell *shell, size_t argc, char **argv)
+{
+#if PROBE_EDGES
+    static struct probe_edge copy[PROBE_EDGES];
+    uint32_t lost;
+
+    if (argc > 1 && strcmp(argv[1], "clear") == 0) {
+        probe_edges_clear();
+        return 0;
+    }
+
+    int n = probe_edges_get(copy, ARRAY_SIZE(copy), &lost);
+
+    /* CSV: grep '^EDGE,' */
+    shell_print(shell, "EDGE,t_ns,probe,level,event");
+    for (int i = 0; i < n; i++) {
+        const struct probe_edge *e = &copy[i];
+
+        shell_print(shell, "EDGE,%llu,%s,%u,%s",
+                    (unsigned long long)k_cyc_to_ns_floor64(e->cycles - copy[0].cycles),
+                    pins[e->probe].name, e->level, probe_event_name(e->event));
+    }
+    shell_print(shell, "%d edges, %u lost", n, lost);
+    return 0;
+#else
+    shell_error(shell, "No edge recorder (CONFIG_APP_PROBE_EDGES on the GPIO emulator)");
+    return -ENOTSUP;
+#endif
+}
+
+static int cmd_probe_selftest(const struct shell *shell, size_t argc, char **argv)
+{
+    int rc = probe_selftest();
+
+    if (rc) {
+        shell_error(shell, "selftest failed (%d)", rc);
+        return rc;
+    }
+    shell_print(shell, "selftest ok, %u probes", (unsigned)ARRAY_SIZE(pins));
+    return 0;
+}
+
+static int cmd_probe_bench(const struct shell *shell, size_t argc, char **argv)
+{
+    uint32_t calls = (argc > 1) ? strtoul(argv[1], NULL, 10) : 10000;
+    struct probe_bench b;
+
+    int rc = probe_bench_run(calls, &b);
+    if (rc) {
+        shell_error(shell, "bench failed (%d)", rc);
+        return rc;
+    }
+    shell_print(shell, "%u events: unmapped %u.%02u cycles, pulse %u.%02u cycles (%s)", b.calls,
+                b.off_cycles_x100 / 100, b.off_cycles_x100 % 100,
+                b.pulse_cycles_x100 / 100, b.pulse_cycles_x100 % 100,
+                PROBE_DIRECT ? "BSRR" : "driver");
+    return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(sub_probe,
+    SHELL_CMD(list, NULL, "Probes and the events mapped to them", cmd_probe_list),
+    SHELL_CMD_ARG(map, NULL, "<event> <probe> [off|set|clear|pulse|toggle]", cmd_probe_map, 3, 1),
+    SHELL_CMD_ARG(fire, NULL, "<event>: raise an event by hand", cmd_probe_fire, 2, 0),
+    SHELL_CMD_ARG(edges, NULL, "[clear]: edges recorded on the GPIO emulator", cmd_probe_edges, 1, 1),
+    SHELL_CMD(selftest, NULL, "Check every mode on every probe against the edges", cmd_probe_selftest),
+    SHELL_CMD_ARG(bench, NULL, "[calls]: cycles per event", cmd_probe_bench, 1, 1),
+    SHELL_SUBCMD_SET_END
+);
+
+SHELL_CMD_REGISTER(probe, &sub_probe, "GPIO timing probes", NULL);
+#endif
@@ -0,0 +1,160 @@
+#ifndef PROBE_H
+#define PROBE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <zephyr/toolchain.h>
+
+/*
+ * GPIO timing probes (CONFIG_APP_PROBE): pipeline events drive pins of
+ * the devicetree's "app,timing-probes" node, so a logic analyser shows
+ * fetch, queue and flash latency as it happens. Each event drives at
+ * most one probe in one of four ways: set, clear, pulse (set then clear)
+ * or toggle.
+ *
+ * On STM32 an event is a single write to the port's BSRR, inlined at the
+ * call site; toggle reads ODR first. Elsewhere it goes through the GPIO
+ * driver's raw port calls. On the GPIO emulator (native_sim) every edge
+ * is recorded with its time, CONFIG_APP_PROBE_EDGES of them, for checks
+ * without an analyser.
+ *
+ * The mapping starts from the devicetree and changes at run time with
+ * probe_map(); an event that fires while its entry changes can apply
+ * the old mode to the new pin.
+ */
+
+/* The event names match PIPE_TRACE's in p13_3.0 */
+#define PROBE_EVENTS(X)     \
+    X(fetch_start)          \
+    X(fetch_end)            \
+    X(merge_start)          \
+    X(merge_end)            \
+    X(enqueue)              \
+    X(drop)                 \
+    X(dequeue)              \
+    X(fs_write_start)       \
+    X(fs_write_end)         \
+    X(fs_sync_start)        \
+    X(fs_sync_end)          \
+    X(bench)
+
+#define PROBE_EV_ENUM(name) PROBE_EV_##name,
+enum probe_event {
+    PROBE_EVENTS(PROBE_EV_ENUM)
+    PROBE_EV_COUNT,
+};
+#undef PROBE_EV_ENUM
+
+enum probe_mode {
+    PROBE_OFF,
+    PROBE_SET,
+    PROBE_CLEAR,
+    PROBE_PULSE,
+    PROBE_TOGGLE,
+};
+
+#if defined(CONFIG_SOC_FAMILY_STM32) && !defined(CONFIG_GPIO_EMUL)
+#define PROBE_DIRECT 1
+#include <soc.h>
+#else
+#define PROBE_DIRECT 0
+#endif
+
+/* One event's resolved writes; mode is written last on a change */
+struct probe_action {
+    volatile uint8_t mode;
+    uint8_t probe;
+#if PROBE_DIRECT
+    GPIO_TypeDef *regs;
+    uint32_t mask;          /* the pin */
+    uint32_t active;        /* BSRR word driving it active, active-low included */
+    uint32_t inactive;
+#endif
+};
+
+extern struct probe_action probe_actions[PROBE_EV_COUNT];
+
+#if PROBE_DIRECT
+static ALWAYS_INLINE void probe_fire(enum probe_event ev)
+{
+    const struct probe_action *a = &probe_actions[ev];
+
+    switch (a->mode) {
+    case PROBE_SET:
+        a->regs->BSRR = a->active;
+        break;
+    case PROBE_CLEAR:
+        a->regs->BSRR = a->inactive;
+        break;
+    case PROBE_PULSE:
+        a->regs->BSRR = a->active;
+        a->regs->BSRR = a->inactive;
+        break;
+    case PROBE_TOGGLE:
+        a->regs->BSRR = (a->regs->ODR & a->mask) ? (a->mask << 16) : a->mask;
+        break;
+    default:
+        break;
+    }
+}
+#else
+void probe_fire(enum probe_event ev);
+#endif
+
+/* -------- Mapping -------- */
+
+struct probe_info {
+    const char *name;       /* devicetree node name */
+    const char *port;       /* GPIO controller */
+    uint8_t pin;
+    bool active_low;
+};
+
+size_t probe_count(void);
+int probe_info_get(size_t probe, struct probe_info *out);
+const char *probe_event_name(enum probe_event ev);
+const char *probe_mode_name(enum probe_mode mode);
+/* -EINVAL for an unknown name */
+int probe_event_parse(const char *name);
+int probe_mode_parse(const char *name);
+int probe_map(enum probe_event ev, size_t probe, enum probe_mode mode);
+void probe_mapping_get(enum probe_event ev, size_t *probe, enum probe_mode *mode);
+/* Drive a probe directly, outside any event */
+int probe_set(size_t probe, bool active);
+
+/* -------- Edges (GPIO emulator) -------- */
+
+struct probe_edge {
+    uint32_t cycles;        /* k_cycle_get_32() */
+    uint8_t probe;
+    uint8_t level;          /* logical: 1 active */
+    uint8_t event;          /* enum probe_event, or PROBE_EV_COUNT for probe_set() */
+};
+
+/*
+ * Copies the oldest recorded edges (at most max) and returns how many,
+ * or -ENOTSUP without a recorder. *lost counts edges that arrived with
+ * the buffer full.
+ */
+int probe_edges_get(struct probe_edge *out, size_t max, uint32_t *lost);
+void probe_edges_clear(void);
+
+/*
+ * Every mode on every probe through the "bench" event, checked against
+ * the recorded edges; restores the mapping and the levels. 0, -EIO on
+ * a wrong edge, or -ENOTSUP without a recorder.
+ */
+int probe_selftest(void);
+
+/* -------- Overhead -------- */
+
+struct probe_bench {
+    uint32_t calls;
+    uint32_t off_cycles_x100;   /* per event, loop overhead removed */
+    uint32_t pulse_cycles_x100; /* mapped to a pulse on probe 0 */
+};
+
+int probe_bench_run(uint32_t calls, struct probe_bench *out);
+
+#endif /* PROBE_H */
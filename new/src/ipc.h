@@ -0,0 +1,49 @@
+#ifndef IPC_H
+#define IPC_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "sensors_common.h"
+
+/*
+ * The IPC primitives under test, each as a pair of one-way channels
+ * (ping to pong, pong to ping) carrying messages of one size, set at
+ * init. send() blocks while the channel is full, recv() while it is
+ * empty; both copy the message.
+ *
+ * Primitives that only signal (k_sem, k_event) carry the message in a
+ * one-slot mailbox, so they hold one message per direction; the queues
+ * hold IPC_DEPTH.
+ */
+#define IPC_MSG_MAX     256
+#define IPC_DEPTH       8
+
+/* Payload sizes: name, bytes. zbus needs them at build time */
+#define IPC_SIZES(X)                                \
+    X(4, 4)                                         \
+    X(16, 16)                                       \
+    X(snap, sizeof(struct all_sensors_data))        \
+    X(256, IPC_MSG_MAX)
+
+enum ipc_dir {
+    IPC_TO_PONG,
+    IPC_TO_PING,
+    IPC_DIRS,
+};
+
+struct ipc_prim {
+    const char *name;
+    /* a reader can see a newer message than the one it was notified of */
+    bool latest_only;
+    /* both directions, empty; -ENOTSUP for a size it cannot carry */
+    int (*init)(size_t size);
+    int (*send)(enum ipc_dir dir, const void *msg);
+    int (*recv)(enum ipc_dir dir, void *msg);
+};
+
+extern const struct ipc_prim ipc_prims[];
+extern const size_t ipc_prim_count;
+
+#endif /* IPC_H */
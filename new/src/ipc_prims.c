@@ -0,0 +1,311 @@
+#include "ipc.h"
+
+#include <errno.h>
+#include <string.h>
+#include <zephyr/kernel.h>
+#include <zephyr/sys/atomic.h>
+#include <zephyr/zbus/zbus.h>
+
+static size_t msg_size;
+
+/* -------- k_sem: one-slot mailbox -------- */
+
+static struct {
+    struct k_sem full;
+    struct k_sem empty;
+    uint8_t slot[IPC_MSG_MAX];
+} sem_ch[IPC_DIRS];
+
+static int sem_init(size_t size)
+{
+    for (int d = 0; d < IPC_DIRS; d++) {
+        k_sem_init(&sem_ch[d].full, 0, 1);
+        k_sem_init(&sem_ch[d].empty, 1, 1);
+    }
+    msg_size = size;
+    return 0;
+}
+
+static int sem_send(enum ipc_dir dir, const void *msg)
+{
+    k_sem_take(&sem_ch[dir].empty, K_FOREVER);
+    memcpy(sem_ch[dir].slot, msg, msg_size);
+    k_sem_give(&sem_ch[dir].full);
+    return 0;
+}
+
+static int sem_recv(enum ipc_dir dir, void *msg)
+{
+    k_sem_take(&sem_ch[dir].full, K_FOREVER);
+    memcpy(msg, sem_ch[dir].slot, msg_size);
+    k_sem_give(&sem_ch[dir].empty);
+    return 0;
+}
+
+/* -------- k_msgq -------- */
+
+static struct k_msgq msgq[IPC_DIRS];
+static char __aligned(4) msgq_buf[IPC_DIRS][IPC_DEPTH * IPC_MSG_MAX];
+
+static int msgq_init(size_t size)
+{
+    for (int d = 0; d < IPC_DIRS; d++) {
+        k_msgq_init(&msgq[d], msgq_buf[d], size, IPC_DEPTH);
+    }
+    return 0;
+}
+
+static int msgq_send(enum ipc_dir dir, const void *msg)
+{
+    return k_msgq_put(&msgq[dir], msg, K_FOREVER);
+}
+
+static int msgq_recv(enum ipc_dir dir, void *msg)
+{
+    return k_msgq_get(&msgq[dir], msg, K_FOREVER);
+}
+
+/* -------- k_fifo: node pool -------- */
+
+struct fifo_node {
+    void *reserved;         /* for the kernel's list */
+    uint8_t data[IPC_MSG_MAX];
+};
+
+static struct {
+    struct k_fifo data;
+    struct k_fifo free;
+    struct fifo_node nodes[IPC_DEPTH];
+} fifo_ch[IPC_DIRS];
+
+static int fifo_init(size_t size)
+{
+    for (int d = 0; d < IPC_DIRS; d++) {
+        k_fifo_init(&fifo_ch[d].data);
+        k_fifo_init(&fifo_ch[d].free);
+        for (int i = 0; i < IPC_DEPTH; i++) {
+            k_fifo_put(&fifo_ch[d].free, &fifo_ch[d].nodes[i]);
+        }
+    }
+    msg_size = size;
+    return 0;
+}
+
+static int fifo_send(enum ipc_dir dir, const void *msg)
+{
+    struct fifo_node *n = k_fifo_get(&fifo_ch[dir].free, K_FOREVER);
+
+    memcpy(n->data, msg, msg_size);
+    k_fifo_put(&fifo_ch[dir].data, n);
+    return 0;
+}
+
+static int fifo_recv(enum ipc_dir dir, void *msg)
+{
+    struct fifo_node *n = k_fifo_get(&fifo_ch[dir].data, K_FOREVER);
+
+    memcpy(msg, n->data, msg_size);
+    k_fifo_put(&fifo_ch[dir].free, n);
+    return 0;
+}
+
+/* -------- k_pipe -------- */
+
+static struct k_pipe pipe[IPC_DIRS];
+static unsigned char pipe_buf[IPC_DIRS][IPC_DEPTH * IPC_MSG_MAX];
+
+static int pipe_init(size_t size)
+{
+    for (int d = 0; d < IPC_DIRS; d++) {
+        k_pipe_init(&pipe[d], pipe_buf[d], IPC_DEPTH * size);
+    }
+    msg_size = size;
+    return 0;
+}
+
+static int pipe_send(enum ipc_dir dir, const void *msg)
+{
+    size_t n;
+
+    return k_pipe_put(&pipe[dir], (void *)msg, msg_size, &n, msg_size, K_FOREVER);
+}
+
+static int pipe_recv(enum ipc_dir dir, void *msg)
+{
+    size_t n;
+
+    return k_pipe_get(&pipe[dir], msg, msg_size, &n, msg_size, K_FOREVER);
+}
+
+/* -------- k_event: one-slot mailbox -------- */
+
+#define EV_FULL     BIT(0)
+#define EV_EMPTY    BIT(1)
+
+static struct {
+    struct k_event ev;
+    uint8_t slot[IPC_MSG_MAX];
+} event_ch[IPC_DIRS];
+
+static int event_init(size_t size)
+{
+    for (int d = 0; d < IPC_DIRS; d++) {
+        k_event_init(&event_ch[d].ev);
+        k_event_post(&event_ch[d].ev, EV_EMPTY);
+    }
+    msg_size = size;
+    return 0;
+}
+
+static int event_send(enum ipc_dir dir, const void *msg)
+{
+    k_event_wait(&event_ch[dir].ev, EV_EMPTY, false, K_FOREVER);
+    k_event_clear(&event_ch[dir].ev, EV_EMPTY);
+    memcpy(event_ch[dir].slot, msg, msg_size);
+    k_event_post(&event_ch[dir].ev, EV_FULL);
+    return 0;
+}
+
+static int event_recv(enum ipc_dir dir, void *msg)
+{
+    k_event_wait(&event_ch[dir].ev, EV_FULL, false, K_FOREVER);
+    k_event_clear(&event_ch[dir].ev, EV_FULL);
+    memcpy(msg, event_ch[dir].slot, msg_size);
+    k_event_post(&event_ch[dir].ev, EV_EMPTY);
+    return 0;
+}
+
+/* -------- zbus: one channel per size and direction -------- */
+
+ZBUS_SUBSCRIBER_DEFINE(pong_sub, IPC_DEPTH);
+ZBUS_SUBSCRIBER_DEFINE(ping_sub, IPC_DEPTH);
+
+#define ZB_MSG(name, bytes) struct ipc_msg_##name { uint8_t b[bytes]; };
+IPC_SIZES(ZB_MSG)
+
+#define ZB_CHANS(name, bytes)                                                           \
+    ZBUS_CHAN_DEFINE(to_pong_##name, struct ipc_msg_##name, NULL, NULL,                 \
+                     ZBUS_OBSERVERS(pong_sub), ZBUS_MSG_INIT(0));                       \
+    ZBUS_CHAN_DEFINE(to_ping_##name, struct ipc_msg_##name, NULL, NULL,                 \
+                     ZBUS_OBSERVERS(ping_sub), ZBUS_MSG_INIT(0));
+IPC_SIZES(ZB_CHANS)
+
+static const struct zbus_channel *zb_chan[IPC_DIRS];
+
+static int zbus_init(size_t size)
+{
+#define ZB_PICK(name, bytes)                                                            \
+    if (size == (bytes)) {                                                              \
+        zb_chan[IPC_TO_PONG] = &to_pong_##name;                                         \
+        zb_chan[IPC_TO_PING] = &to_ping_##name;                                         \
+        return 0;                                                                       \
+    }
+    IPC_SIZES(ZB_PICK)
+#undef ZB_PICK
+    return -ENOTSUP;
+}
+
+static int zbus_send(enum ipc_dir dir, const void *msg)
+{
+    /* blocks while the subscriber's notification queue is full */
+    return zbus_chan_pub(zb_chan[dir], msg, K_FOREVER);
+}
+
+static int zbus_recv(enum ipc_dir dir, void *msg)
+{
+    const struct zbus_observer *sub = (dir == IPC_TO_PONG) ? &pong_sub : &ping_sub;
+    const struct zbus_channel *chan;
+
+    int rc = zbus_sub_wait(sub, &chan, K_FOREVER);
+    if (rc) return rc;
+    return zbus_chan_read(chan, msg, K_FOREVER);
+}
+
+/* -------- Lock-free SPSC ring -------- */
+
+/*
+ * head and tail only ever grow and each has one writer, so the data
+ * path takes no lock. A side that finds the ring empty (full) raises
+ * its waiting flag, checks again and only then sleeps on a semaphore,
+ * which the other side gives when it sees the flag: spinning would
+ * starve a lower priority peer.
+ */
+struct spsc_ring {
+    atomic_t head;
+    atomic_t tail;
+    atomic_t reader_waiting;
+    atomic_t writer_waiting;
+    struct k_sem data;
+    struct k_sem space;
+    uint8_t slot[IPC_DEPTH][IPC_MSG_MAX];
+};
+
+static struct spsc_ring ring[IPC_DIRS];
+
+static int ring_init(size_t size)
+{
+    for (int d = 0; d < IPC_DIRS; d++) {
+        atomic_set(&ring[d].head, 0);
+        atomic_set(&ring[d].tail, 0);
+        atomic_set(&ring[d].reader_waiting, 0);
+        atomic_set(&ring[d].writer_waiting, 0);
+        k_sem_init(&ring[d].data, 0, 1);
+        k_sem_init(&ring[d].space, 0, 1);
+    }
+    msg_size = size;
+    return 0;
+}
+
+static int ring_send(enum ipc_dir dir, const void *msg)
+{
+    struct spsc_ring *r = &ring[dir];
+    atomic_val_t head = atomic_get(&r->head);
+
+    while (head - atomic_get(&r->tail) == IPC_DEPTH) {
+        atomic_set(&r->writer_waiting, 1);
+        if (head - atomic_get(&r->tail) == IPC_DEPTH) {
+            k_sem_take(&r->space, K_FOREVER);
+        }
+        atomic_set(&r->writer_waiting, 0);
+    }
+    memcpy(r->slot[head % IPC_DEPTH], msg, msg_size);
+    atomic_set(&r->head, head + 1);
+    if (atomic_get(&r->reader_waiting)) {
+        k_sem_give(&r->data);
+    }
+    return 0;
+}
+
+static int ring_recv(enum ipc_dir dir, void *msg)
+{
+    struct spsc_ring *r = &ring[dir];
+    atomic_val_t tail = atomic_get(&r->tail);
+
+    while (atomic_get(&r->head) == tail) {
+        atomic_set(&r->reader_waiting, 1);
+        if (atomic_get(&r->head) == tail) {
+            k_sem_take(&r->data, K_FOREVER);
+        }
+        atomic_set(&r->reader_waiting, 0);
+    }
+    memcpy(msg, r->slot[tail % IPC_DEPTH], msg_size);
+    atomic_set(&r->tail, tail + 1);
+    if (atomic_get(&r->writer_waiting)) {
+        k_sem_give(&r->space);
+    }
+    return 0;
+}
+
+/* -------- Table -------- */
+
+const struct ipc_prim ipc_prims[] = {
+    { "sem",   false, sem_init,   sem_send,   sem_recv },
+    { "msgq",  false, msgq_init,  msgq_send,  msgq_recv },
+    { "fifo",  false, fifo_init,  fifo_send,  fifo_recv },
+    { "pipe",  false, pipe_init,  pipe_send,  pipe_recv },
+    { "event", false, event_init, event_send, event_recv },
+    { "zbus",  true,  zbus_init,  zbus_send,  zbus_recv },
+    { "ring",  false, ring_init,  ring_send,  ring_recv },
+};
+
+const size_t ipc_prim_count = ARRAY_SIZE(ipc_prims);
@@ -1,32 +1,231 @@
-#include<zephyr/kernel.h>
-#include<zephyr/sys/printk.h>
+#include <zephyr/kernel.h>
+#include <zephyr/sys/printk.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
 
-K_SEM_DEFINE(SEM1,1,1);
-K_SEM_DEFINE(SEM2,0,1);
+#include "ipc.h"
 
-void ping(){
+#if defined(CONFIG_ARCH_POSIX)
+#include <posix_board_if.h>
+#endif
 
-    while (1)
-    {
+/*
+ * Round-trip latency and streaming throughput of the kernel's IPC
+ * primitives, zbus and a lock-free ring, between two threads: ping and
+ * pong. For every primitive, payload size and priority pair:
+ *
+ *   rtt     ping sends a message, pong sends it back; ITERATIONS timed
+ *           round trips after WARMUP untimed ones
+ *   stream  ping sends STREAM_MSGS messages back to back, pong receives
+ *           them; first send to last receive
+ *
+ * Every message carries its sequence number, which the receiver checks.
+ * Output is CSV: the header and one row per run start with "IPC,", so
+ *   grep '^IPC,' output.txt | cut -d, -f2- > ipc.csv
+ * Then "IPC done"; native_sim exits.
+ *
+ * Simulated time does not advance while threads run without sleeping on
+ * native_sim, so there the host clock times the runs
+ * (../p13_3.0/native/host_clock.c).
+ */
+#define ITERATIONS      1000
+#define WARMUP          16
+#define STREAM_MSGS     2000
+#define STACK_SIZE      1024
+#define RUN_TIMEOUT     K_SECONDS(10)
 
-        k_sem_take(&SEM1, K_FOREVER);
-        printk("ping\n");
-        k_sem_give(&SEM2);
+/* ping, pong: equal, receiver preempts the sender, sender preempts the receiver */
+static const struct {
+    int ping;
+    int pong;
+} prios[] = { { 5, 5 }, { 5, 4 }, { 4, 5 } };
 
+#define SIZE_BYTES(name, bytes) (bytes),
+static const size_t sizes[] = { IPC_SIZES(SIZE_BYTES) };
+
+K_THREAD_STACK_DEFINE(ping_stack, STACK_SIZE);
+K_THREAD_STACK_DEFINE(pong_stack, STACK_SIZE);
+static struct k_thread ping_thread, pong_thread;
+
+/* -------- Time -------- */
+
+#if defined(CONFIG_BOARD_NATIVE_SIM)
+/* ../p13_3.0/native/host_clock.c */
+uint64_t app_host_time_ns(void);
+
+static inline uint32_t stamp(void)
+{
+    return (uint32_t)app_host_time_ns();
+}
+
+static inline uint32_t stamp_ns(uint32_t d)
+{
+    return d;
+}
+#else
+static inline uint32_t stamp(void)
+{
+    return k_cycle_get_32();
+}
+
+static inline uint32_t stamp_ns(uint32_t d)
+{
+    return (uint32_t)k_cyc_to_ns_floor64(d);
+}
+#endif
+
+/* -------- Runs -------- */
+
+enum mode {
+    MODE_RTT,
+    MODE_STREAM,
+};
+
+/* the run in progress; written by ping and pong, read once both joined */
+static const struct ipc_prim *cur;
+static size_t cur_size;
+static uint32_t rtt[ITERATIONS];
+static uint32_t stream_t0, stream_t1;
+static volatile int ping_rc, pong_rc;
+
+static int check_seq(const uint8_t *msg, uint32_t want, bool at_least)
+{
+    uint32_t seq;
+
+    memcpy(&seq, msg, sizeof(seq));
+    return (seq == want || (at_least && seq > want)) ? 0 : -EBADMSG;
+}
+
+static void ping(void *p1, void *p2, void *p3)
+{
+    enum mode mode = (enum mode)(uintptr_t)p1;
+    uint8_t msg[IPC_MSG_MAX];
+    int rc = 0;
+
+    memset(msg, 0xA5, sizeof(msg));
+    if (mode == MODE_RTT) {
+        for (uint32_t i = 0; i < WARMUP + ITERATIONS && rc == 0; i++) {
+            memcpy(msg, &i, sizeof(i));
+            uint32_t t0 = stamp();
+            rc = cur->send(IPC_TO_PONG, msg);
+            if (rc == 0) rc = cur->recv(IPC_TO_PING, msg);
+            uint32_t t = stamp() - t0;
+            if (rc == 0) rc = check_seq(msg, i, false);
+            if (i >= WARMUP) rtt[i - WARMUP] = t;
+        }
+    } else {
+        stream_t0 = stamp();
+        for (uint32_t i = 0; i < STREAM_MSGS && rc == 0; i++) {
+            memcpy(msg, &i, sizeof(i));
+            rc = cur->send(IPC_TO_PONG, msg);
+        }
     }
-    
+    ping_rc = rc;
 }
 
-void pong()
+static void pong(void *p1, void *p2, void *p3)
 {
-    while(1)
-    {
-        k_sem_take(&SEM2, K_FOREVER);
-        printk("pong\n");
-        k_sem_give(&SEM1);
+    enum mode mode = (enum mode)(uintptr_t)p1;
+    uint8_t msg[IPC_MSG_MAX];
+    int rc = 0;
+
+    if (mode == MODE_RTT) {
+        for (uint32_t i = 0; i < WARMUP + ITERATIONS && rc == 0; i++) {
+            rc = cur->recv(IPC_TO_PONG, msg);
+            if (rc == 0) rc = cur->send(IPC_TO_PING, msg);
+        }
+    } else {
+        /* zbus keeps the latest message only: the number can skip ahead */
+        uint32_t want = 0;
+
+        for (uint32_t i = 0; i < STREAM_MSGS && rc == 0; i++) {
+            rc = cur->recv(IPC_TO_PONG, msg);
+            if (rc == 0) rc = check_seq(msg, want, cur->latest_only);
+            if (rc == 0) memcpy(&want, msg, sizeof(want));
+            want++;
+        }
+        stream_t1 = stamp();
+        if (rc == 0 && want != STREAM_MSGS) rc = -EBADMSG;
+    }
+    pong_rc = rc;
+}
+
+static int run(enum mode mode, int prio_ping, int prio_pong)
+{
+    int rc = cur->init(cur_size);
+    if (rc) return rc;
+
+    ping_rc = pong_rc = -EINPROGRESS;
+    /* main runs at a higher priority: neither starts before both exist */
+    k_thread_create(&pong_thread, pong_stack, K_THREAD_STACK_SIZEOF(pong_stack), pong,
+                    (void *)(uintptr_t)mode, NULL, NULL, K_PRIO_PREEMPT(prio_pong), 0,
+                    K_NO_WAIT);
+    k_thread_create(&ping_thread, ping_stack, K_THREAD_STACK_SIZEOF(ping_stack), ping,
+                    (void *)(uintptr_t)mode, NULL, NULL, K_PRIO_PREEMPT(prio_ping), 0,
+                    K_NO_WAIT);
+
+    int j1 = k_thread_join(&ping_thread, RUN_TIMEOUT);
+    int j2 = k_thread_join(&pong_thread, RUN_TIMEOUT);
+    if (j1 || j2) {
+        k_thread_abort(&ping_thread);
+        k_thread_abort(&pong_thread);
+        return -ETIMEDOUT;
+    }
+    return ping_rc ? ping_rc : pong_rc;
+}
+
+static int cmp_u32(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+
+    return (x > y) - (x < y);
+}
+
+static void run_one(int prio_ping, int prio_pong)
+{
+    uint32_t p50 = 0, p99 = 0, lo = 0, hi = 0, stream_us = 0, mps = 0;
+
+    int rc = run(MODE_RTT, prio_ping, prio_pong);
+    if (rc == 0) {
+        qsort(rtt, ITERATIONS, sizeof(rtt[0]), cmp_u32);
+        lo = stamp_ns(rtt[0]);
+        p50 = stamp_ns(rtt[ITERATIONS / 2]);
+        p99 = stamp_ns(rtt[ITERATIONS * 99 / 100]);
+        hi = stamp_ns(rtt[ITERATIONS - 1]);
+        rc = run(MODE_STREAM, prio_ping, prio_pong);
+    }
+    if (rc == 0) {
+        uint32_t ns = stamp_ns(stream_t1 - stream_t0);
+
+        stream_us = ns / 1000;
+        mps = ns ? (uint32_t)((uint64_t)STREAM_MSGS * 1000000000u / ns) : 0;
     }
+    printk("IPC,%s,%u,%d,%d,%u,%u,%u,%u,%u,%u,%u,%u,%u,%d\n", cur->name, (unsigned)cur_size,
+           prio_ping, prio_pong, ITERATIONS, lo, p50, p99, hi, STREAM_MSGS, stream_us, mps,
+           (uint32_t)((uint64_t)mps * cur_size), rc);
 }
 
- K_THREAD_DEFINE(PING,1024,ping,NULL,NULL,NULL,1,0,0);
- K_THREAD_DEFINE(PONG,1024,pong,NULL,NULL,NULL,1,0,0);
- 
\ No newline at end of file
+/* -------- main -------- */
+
+int main(void)
+{
+    printk("IPC,prim,size,prio_ping,prio_pong,iters,rtt_min_ns,rtt_p50_ns,rtt_p99_ns,"
+           "rtt_max_ns,stream_msgs,stream_us,msgs_per_s,bytes_per_s,rc\n");
+
+    for (size_t p = 0; p < ipc_prim_count; p++) {
+        cur = &ipc_prims[p];
+        for (size_t s = 0; s < ARRAY_SIZE(sizes); s++) {
+            cur_size = sizes[s];
+            for (size_t r = 0; r < ARRAY_SIZE(prios); r++) {
+                run_one(prios[r].ping, prios[r].pong);
+            }
+        }
+    }
+    printk("IPC done\n");
+
+#if defined(CONFIG_ARCH_POSIX)
+    posix_exit(0);
+#endif
+    return 0;
+}
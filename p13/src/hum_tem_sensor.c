@@ -1,4 +1,5 @@
 #include "hum_temp_sensor.h"
+#include "fixed_fmt.h"
 #include <zephyr/device.h>
 #include <zephyr/drivers/sensor.h>
 #include <zephyr/kernel.h>
@@ -14,22 +15,40 @@ const struct device *const hts_dev = DEVICE_DT_GET(DT_ALIAS(ht_sensor));
 #error("Humidity-Temperature sensor not found.");
 #endif
 
-int hum_temp_sensor_get_string(char *buf, size_t buf_len)
+static int hum_temp_fetch(struct sensor_value *temp, struct sensor_value *hum)
 {
     if (!device_is_ready(hts_dev)) return -1;
     if (sensor_sample_fetch(hts_dev) < 0) return -1;
 
+    if (sensor_channel_get(hts_dev, SENSOR_CHAN_AMBIENT_TEMP, temp) < 0) return -1;
+    if (sensor_channel_get(hts_dev, SENSOR_CHAN_HUMIDITY, hum) < 0) return -1;
+
+    /* integer args only: dictionary logging ships these raw, host formats */
+    LOG_INF("Temperature: %d mC", (int32_t)sensor_value_to_milli(temp));
+    LOG_INF("Humidity: %d m%%RH", (int32_t)sensor_value_to_milli(hum));
+    return 0;
+}
+
+int hum_temp_sensor_read(struct ht_record *rec)
+{
     struct sensor_value temp, hum;
-    if (sensor_channel_get(hts_dev, SENSOR_CHAN_AMBIENT_TEMP, &temp) < 0) return -1;
-    if (sensor_channel_get(hts_dev, SENSOR_CHAN_HUMIDITY, &hum) < 0) return -1;
+    if (hum_temp_fetch(&temp, &hum) < 0) return -1;
 
-    double t = sensor_value_to_double(&temp);
-    double h = sensor_value_to_double(&hum);
+    rec->uptime_ms = k_uptime_get_32();
+    rec->temp_centi = (int16_t)(temp.val1 * 100 + temp.val2 / 10000);
+    rec->hum_centi = (int16_t)(hum.val1 * 100 + hum.val2 / 10000);
+    return 0;
+}
+
+int hum_temp_sensor_get_string(char *buf, size_t buf_len)
+{
+    struct sensor_value temp, hum;
+    if (hum_temp_fetch(&temp, &hum) < 0) return -1;
 
-    LOG_INF("Temperature: %.1f C", t);
-    LOG_INF("Humidity: %.1f %%", h);
+    char t[FIXED_FMT_BUF], h[FIXED_FMT_BUF];
 
-    return snprintf(buf, buf_len, "Temperature: %.1f C, Humidity: %.1f %%\n", t, h);
+    return snprintf(buf, buf_len, "Temperature: %s C, Humidity: %s %%\n",
+                    fmt_sensor_value(t, &temp, 1), fmt_sensor_value(h, &hum, 1));
 }
 
 int hun_temp_sensor_init(void)
@@ -1,45 +1,41 @@
 #include "hum_temp_sensor.h"
 #include "imu_sensor.h"
 #include "pressure_sensor.h"
+#include "record_log.h"
+#include "fixed_fmt.h"
 
 #include <zephyr/kernel.h>
 #include <zephyr/fs/fs.h>
 #include <zephyr/fs/littlefs.h>
 #include <zephyr/storage/flash_map.h>
 #include <zephyr/logging/log.h>
+#include <zephyr/shell/shell.h>
 #include <string.h>
 
 LOG_MODULE_REGISTER(main);
 
-// Mount points
-#define MOUNT_POINT_HUM "/lfs_hum"
-#define MOUNT_POINT_PRESS "/lfs_press"
-#define MOUNT_POINT_TEMP "/lfs_temp"
+// One LittleFS for all streams
+#define MOUNT_POINT "/lfs"
 
-// LittleFS configs
-FS_LITTLEFS_DECLARE_DEFAULT_CONFIG(lfs_hum);
-FS_LITTLEFS_DECLARE_DEFAULT_CONFIG(lfs_press);
-FS_LITTLEFS_DECLARE_DEFAULT_CONFIG(lfs_temp);
+/* Sized for the STM32L4 bank: memory-mapped reads, 64-bit programming,
+ * 2 KB pages. A 256-byte cache holds a sync interval of the largest
+ * record (RECORD_LOG_SYNC_EVERY); 8 bytes of lookahead map all 64 blocks
+ * of the 128 KB partition. Open files take their caches from
+ * CONFIG_FS_LITTLEFS_FC_HEAP_SIZE.
+ */
+#define LFS_READ_SIZE       16
+#define LFS_PROG_SIZE       8
+#define LFS_CACHE_SIZE      256
+#define LFS_LOOKAHEAD_SIZE  8
 
-static struct fs_mount_t mount_hum = {
-    .type = FS_LITTLEFS,
-    .fs_data = &lfs_hum,
-    .storage_dev = (void *)FIXED_PARTITION_ID(humidity_fs),
-    .mnt_point = MOUNT_POINT_HUM,
-};
-
-static struct fs_mount_t mount_press = {
-    .type = FS_LITTLEFS,
-    .fs_data = &lfs_press,
-    .storage_dev = (void *)FIXED_PARTITION_ID(pressure_fs),
-    .mnt_point = MOUNT_POINT_PRESS,
-};
+FS_LITTLEFS_DECLARE_CUSTOM_CONFIG(lfs_logs, 4, LFS_READ_SIZE, LFS_PROG_SIZE,
+                                  LFS_CACHE_SIZE, LFS_LOOKAHEAD_SIZE);
 
-static struct fs_mount_t mount_temp = {
+static struct fs_mount_t mount_logs = {
     .type = FS_LITTLEFS,
-    .fs_data = &lfs_temp,
-    .storage_dev = (void *)FIXED_PARTITION_ID(temp_fs),
-    .mnt_point = MOUNT_POINT_TEMP,
+    .fs_data = &lfs_logs,
+    .storage_dev = (void *)FIXED_PARTITION_ID(logs_fs),
+    .mnt_point = MOUNT_POINT,
 };
 
 static void mount_fs(struct fs_mount_t *mp)
@@ -52,19 +48,24 @@ static void mount_fs(struct fs_mount_t *mp)
     }
 }
 
+// Binary per-sensor logs, held open for the life of each thread
+static struct record_log hum_log =
+    RECORD_LOG_INIT(MOUNT_POINT "/humidity.bin", struct ht_record);
+static struct record_log press_log =
+    RECORD_LOG_INIT(MOUNT_POINT "/pressure.bin", struct press_record);
+static struct record_log imu_log =
+    RECORD_LOG_INIT(MOUNT_POINT "/imu.bin", struct imu_record);
+
 // ------------ Threads --------------
 void hum_thread(void *a, void *b, void *c)
 {
-    struct fs_file_t file;
-    char buffer[128];
+    struct ht_record rec;
+
+    if (record_log_open(&hum_log) != 0) return;
 
     while (1) {
-        if (hum_temp_sensor_get_string(buffer, sizeof(buffer)) > 0) {
-            fs_file_t_init(&file);
-            if (fs_open(&file, MOUNT_POINT_HUM "/humidity.txt", FS_O_CREATE | FS_O_WRITE | FS_O_APPEND) == 0) {
-                fs_write(&file, buffer, strlen(buffer));
-                fs_close(&file);
-            }
+        if (hum_temp_sensor_read(&rec) == 0) {
+            record_log_append(&hum_log, &rec);
         }
         k_sleep(K_SECONDS(2));
     }
@@ -72,16 +73,13 @@ void hum_thread(void *a, void *b, void *c)
 
 void press_thread(void *a, void *b, void *c)
 {
-    struct fs_file_t file;
-    char buffer[128];
+    struct press_record rec;
+
+    if (record_log_open(&press_log) != 0) return;
 
     while (1) {
-        if (pressure_sensor_get_string(buffer, sizeof(buffer)) > 0) {
-            fs_file_t_init(&file);
-            if (fs_open(&file, MOUNT_POINT_PRESS "/pressure.txt", FS_O_CREATE | FS_O_WRITE | FS_O_APPEND) == 0) {
-                fs_write(&file, buffer, strlen(buffer));
-                fs_close(&file);
-            }
+        if (pressure_sensor_read(&rec) == 0) {
+            record_log_append(&press_log, &rec);
         }
         k_sleep(K_SECONDS(3));
     }
@@ -89,21 +87,99 @@ void press_thread(void *a, void *b, void *c)
 
 void imu_thread(void *a, void *b, void *c)
 {
-    struct fs_file_t file;
-    char buffer[256];
+    struct imu_record rec;
+
+    if (record_log_open(&imu_log) != 0) return;
 
     while (1) {
-        if (imu_sensor_get_string(buffer, sizeof(buffer)) > 0) {
-            fs_file_t_init(&file);
-            if (fs_open(&file, MOUNT_POINT_TEMP "/imu.txt", FS_O_CREATE | FS_O_WRITE | FS_O_APPEND) == 0) {
-                fs_write(&file, buffer, strlen(buffer));
-                fs_close(&file);
-            }
+        if (imu_sensor_read(&rec) == 0) {
+            record_log_append(&imu_log, &rec);
         }
         k_sleep(K_SECONDS(4));
     }
 }
 
+// ------------ Export -----------------
+// Text is only produced here, from the binary records
+static void print_ht(const struct shell *sh, const void *p)
+{
+    const struct ht_record *r = p;
+    char t[FIXED_FMT_BUF], h[FIXED_FMT_BUF];
+
+    shell_print(sh, "%u,%s,%s", r->uptime_ms,
+                fmt_fixed(t, r->temp_centi, 2), fmt_fixed(h, r->hum_centi, 2));
+}
+
+static void print_press(const struct shell *sh, const void *p)
+{
+    const struct press_record *r = p;
+    shell_print(sh, "%u,%d", r->uptime_ms, r->press_pa);
+}
+
+static void print_imu(const struct shell *sh, const void *p)
+{
+    const struct imu_record *r = p;
+    char f[6][FIXED_FMT_BUF];
+
+    shell_print(sh, "%u,%s,%s,%s,%s,%s,%s", r->uptime_ms,
+                fmt_fixed(f[0], r->accel_centi[0], 2), fmt_fixed(f[1], r->accel_centi[1], 2),
+                fmt_fixed(f[2], r->accel_centi[2], 2), fmt_fixed(f[3], r->gyro_centi[0], 2),
+                fmt_fixed(f[4], r->gyro_centi[1], 2), fmt_fixed(f[5], r->gyro_centi[2], 2));
+}
+
+struct export_stream {
+    const char *name;
+    const struct record_log *log;
+    const char *header;
+    void (*print)(const struct shell *sh, const void *rec);
+};
+
+static const struct export_stream export_streams[] = {
+    { "hum",   &hum_log,   "uptime_ms,temp_C,hum_pct", print_ht },
+    { "press", &press_log, "uptime_ms,press_pa", print_press },
+    { "imu",   &imu_log,   "uptime_ms,ax_ms2,ay_ms2,az_ms2,gx_rads,gy_rads,gz_rads", print_imu },
+};
+
+static int cmd_export(const struct shell *sh, size_t argc, char **argv)
+{
+    const struct export_stream *st = NULL;
+
+    for (size_t i = 0; i < ARRAY_SIZE(export_streams); i++) {
+        if (strcmp(argv[1], export_streams[i].name) == 0) {
+            st = &export_streams[i];
+        }
+    }
+    if (!st) {
+        shell_error(sh, "Unknown stream %s (hum|press|imu)", argv[1]);
+        return -EINVAL;
+    }
+
+    // whole records per read; only synced records are visible here
+    uint8_t buf[8 * sizeof(struct imu_record)];
+    size_t rec_size = st->log->rec_size;
+    size_t chunk = (sizeof(buf) / rec_size) * rec_size;
+    struct fs_file_t file;
+
+    fs_file_t_init(&file);
+    int rc = fs_open(&file, st->log->path, FS_O_READ);
+    if (rc) {
+        shell_error(sh, "Failed to open %s (%d)", st->log->path, rc);
+        return rc;
+    }
+
+    shell_print(sh, "%s", st->header);
+    ssize_t r;
+    while ((r = fs_read(&file, buf, chunk)) > 0) {
+        for (size_t off = 0; off + rec_size <= (size_t)r; off += rec_size) {
+            st->print(sh, buf + off);
+        }
+    }
+    fs_close(&file);
+    return r < 0 ? (int)r : 0;
+}
+
+SHELL_CMD_ARG_REGISTER(export, NULL, "Dump a binary log as CSV: export <hum|press|imu>", cmd_export, 2, 0);
+
 // ------------ Main -----------------
 int main(void)
 {
@@ -115,9 +191,7 @@ int main(void)
     imu_sensor_init();
 
     // Mount FS
-    mount_fs(&mount_hum);
-    mount_fs(&mount_press);
-    mount_fs(&mount_temp);
+    mount_fs(&mount_logs);
 
     // Start threads
     static K_THREAD_STACK_DEFINE(hum_stack, 2048);
@@ -1,8 +1,11 @@
 #ifndef PRESSURE_SENSOR_H
 #define PRESSURE_SENSOR_H
 #include <stddef.h>
+#include "sensor_record.h"
 
 int pressure_sensor_init(void);
+/* Fetch one sample as a binary log record */
+int pressure_sensor_read(struct press_record *rec);
 /* New */
 int pressure_sensor_get_string(char *buf, size_t buf_len);
 
@@ -0,0 +1,60 @@
+#include "record_log.h"
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+
+LOG_MODULE_REGISTER(record_log);
+
+int record_log_open(struct record_log *log)
+{
+    if (log->is_open) return 0;
+
+    fs_file_t_init(&log->file);
+    int rc = fs_open(&log->file, log->path, FS_O_CREATE | FS_O_WRITE | FS_O_APPEND);
+    if (rc) {
+        LOG_ERR("open %s failed (%d)", log->path, rc);
+        return rc;
+    }
+    log->is_open = true;
+    log->unsynced = 0;
+    log->last_sync_ms = k_uptime_get();
+    return 0;
+}
+
+int record_log_sync(struct record_log *log)
+{
+    if (!log->is_open || log->unsynced == 0) return 0;
+
+    int rc = fs_sync(&log->file);
+    if (rc == 0) {
+        log->unsynced = 0;
+        log->last_sync_ms = k_uptime_get();
+    }
+    return rc;
+}
+
+int record_log_append(struct record_log *log, const void *rec)
+{
+    if (!log->is_open) return -EBADF;
+
+    ssize_t w = fs_write(&log->file, rec, log->rec_size);
+    if (w < 0) return (int)w;
+    if (w != log->rec_size) return -EIO;
+
+    log->unsynced++;
+    if (log->unsynced >= RECORD_LOG_SYNC_EVERY ||
+        k_uptime_get() - log->last_sync_ms >= RECORD_LOG_SYNC_MS) {
+        return record_log_sync(log);
+    }
+    return 0;
+}
+
+int record_log_close(struct record_log *log)
+{
+    if (!log->is_open) return 0;
+
+    /* fs_close() flushes anything not yet synced */
+    int rc = fs_close(&log->file);
+    log->is_open = false;
+    log->unsynced = 0;
+    return rc;
+}
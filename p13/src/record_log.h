@@ -0,0 +1,30 @@
+#ifndef RECORD_LOG_H
+#define RECORD_LOG_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <zephyr/fs/fs.h>
+
+/* Bound on data lost at power-off: sync after this many records ... */
+#define RECORD_LOG_SYNC_EVERY   16
+/* ... or once this much time has passed since the last sync */
+#define RECORD_LOG_SYNC_MS      10000
+
+/* Append-only file of fixed-size records, kept open for the writer's life */
+struct record_log {
+    const char *path;
+    size_t rec_size;
+    struct fs_file_t file;
+    bool is_open;
+    uint32_t unsynced;
+    int64_t last_sync_ms;
+};
+
+#define RECORD_LOG_INIT(_path, _type) { .path = (_path), .rec_size = sizeof(_type) }
+
+int record_log_open(struct record_log *log);
+int record_log_append(struct record_log *log, const void *rec);
+int record_log_sync(struct record_log *log);
+int record_log_close(struct record_log *log);
+
+#endif /* RECORD_LOG_H */
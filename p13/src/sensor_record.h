@@ -0,0 +1,26 @@
+#ifndef SENSOR_RECORD_H
+#define SENSOR_RECORD_H
+
+#include <stdint.h>
+
+/* Fixed-size binary records appended to the per-sensor log files.
+ * Values are 0.01 units of the SI quantity (same as p13_3.0).
+ */
+struct ht_record {
+    uint32_t uptime_ms;
+    int16_t temp_centi;     /* degC * 100 */
+    int16_t hum_centi;      /* %RH * 100 */
+};
+
+struct press_record {
+    uint32_t uptime_ms;
+    int32_t press_pa;       /* Pa */
+};
+
+struct imu_record {
+    uint32_t uptime_ms;
+    int16_t accel_centi[3]; /* m/s^2 * 100 */
+    int16_t gyro_centi[3];  /* rad/s * 100 */
+};
+
+#endif /* SENSOR_RECORD_H */
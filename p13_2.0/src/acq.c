@@ -0,0 +1,122 @@
+#include "acq.h"
+#include <zephyr/logging/log.h>
+
+LOG_MODULE_REGISTER(acq);
+
+/* Sync before the close so a sync error is not lost in it */
+static int stream_pause(struct acq_stream *st)
+{
+    int rc = record_log_sync(st->log);
+    int crc = record_log_close(st->log);
+
+    return rc ? rc : crc;
+}
+
+static void apply(struct acq_stream *st, bool want)
+{
+    if (want) {
+        st->rc = record_log_open(st->log);
+        st->running = (st->rc == 0);
+        if (st->rc) {
+            /* do not retry on every wake */
+            atomic_set(&st->want, 0);
+        }
+    } else {
+        st->rc = stream_pause(st);
+        st->running = false;
+    }
+    k_sem_give(&st->done);
+}
+
+static void acq_thread(void *p1, void *p2, void *p3)
+{
+    struct acq_stream *st = p1;
+    uint8_t rec[ACQ_REC_MAX];
+    int64_t next = 0;
+
+    while (1) {
+        bool want = atomic_get(&st->want);
+
+        if (want != st->running) {
+            apply(st, want);
+            next = k_uptime_get();
+        }
+        if (!st->running) {
+            k_sem_take(&st->wake, K_FOREVER);
+            continue;
+        }
+
+        /* a request ends the wait early; no sample then */
+        if (k_sem_take(&st->wake, K_TIMEOUT_ABS_MS(next)) == 0) {
+            continue;
+        }
+        if (st->read(rec) == 0) {
+            record_log_append(st->log, rec);
+        }
+        next += st->period_ms;
+        if (next < k_uptime_get()) {
+            next = k_uptime_get();
+        }
+    }
+}
+
+int acq_init(struct acq_stream *st, int prio)
+{
+    if (st->log->rec_size > ACQ_REC_MAX) return -EINVAL;
+
+    k_mutex_init(&st->lock);
+    k_sem_init(&st->wake, 0, 1);
+    k_sem_init(&st->done, 0, 1);
+    atomic_set(&st->want, 0);
+
+    k_thread_create(&st->thread, st->stack, st->stack_size, acq_thread,
+                    st, NULL, NULL, prio, 0, K_NO_WAIT);
+    k_thread_name_set(&st->thread, st->name);
+    return 0;
+}
+
+int acq_set(struct acq_stream *st, bool on, uint32_t *us)
+{
+    int rc;
+
+    k_mutex_lock(&st->lock, K_FOREVER);
+    if (atomic_get(&st->want) == on && st->running == on) {
+        k_mutex_unlock(&st->lock);
+        return -EALREADY;
+    }
+
+    /* an ack that came after an earlier timeout is not ours */
+    k_sem_reset(&st->done);
+    uint32_t t0 = k_cycle_get_32();
+    atomic_set(&st->want, on);
+    k_sem_give(&st->wake);
+    rc = k_sem_take(&st->done, K_MSEC(ACQ_ACK_TIMEOUT_MS));
+    uint32_t lat = k_cyc_to_us_ceil32(k_cycle_get_32() - t0);
+
+    if (rc) {
+        LOG_ERR("%s: %s not acknowledged", st->name, on ? "start" : "stop");
+        rc = -ETIMEDOUT;
+    } else {
+        rc = st->rc;
+        if (on) {
+            st->starts++;
+            st->start_last_us = lat;
+            st->start_max_us = MAX(st->start_max_us, lat);
+        } else {
+            st->stops++;
+            st->stop_last_us = lat;
+            st->stop_max_us = MAX(st->stop_max_us, lat);
+        }
+    }
+    k_mutex_unlock(&st->lock);
+
+    if (us) {
+        *us = lat;
+    }
+    return rc;
+}
+
+bool acq_running(const struct acq_stream *st)
+{
+    return st->running;
+}
@@ -0,0 +1,57 @@
+#ifndef ACQ_H
+#define ACQ_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <zephyr/kernel.h>
+#include "record_log.h"
+
+/* Largest record a stream reads */
+#define ACQ_REC_MAX         32
+/* Longest a start or stop may take: one sample, a sync and the close */
+#define ACQ_ACK_TIMEOUT_MS  2000
+
+/*
+ * One sensor stream with a thread created once at boot. Start and stop
+ * only change the requested state; the thread applies it between
+ * samples, never inside a read or fs_write(), so a stop finishes the
+ * sample in flight, syncs and closes the log before it is acknowledged.
+ */
+struct acq_stream {
+    const char *name;
+    struct record_log *log;
+    int (*read)(void *rec);
+    uint32_t period_ms;
+    k_thread_stack_t *stack;
+    size_t stack_size;
+
+    struct k_thread thread;
+    struct k_mutex lock;        /* one request at a time */
+    struct k_sem wake;          /* request pending */
+    struct k_sem done;          /* request applied */
+    atomic_t want;
+    bool running;               /* owned by the thread */
+    int rc;                     /* of the last open or sync/close */
+
+    /* request to acknowledge, microseconds */
+    uint32_t starts, stops;
+    uint32_t start_last_us, start_max_us;
+    uint32_t stop_last_us, stop_max_us;
+};
+
+#define ACQ_STREAM_INIT(_name, _log, _read, _period_ms, _stack)                 \
+    {                                                                           \
+        .name = (_name), .log = (_log), .read = (_read),                        \
+        .period_ms = (_period_ms), .stack = (_stack),                           \
+        .stack_size = K_THREAD_STACK_SIZEOF(_stack),                            \
+    }
+
+int acq_init(struct acq_stream *st, int prio);
+/* Blocks until the thread applied it; us gets the latency (may be NULL).
+ * -EALREADY if already in that state, -ETIMEDOUT if not acknowledged.
+ */
+int acq_set(struct acq_stream *st, bool on, uint32_t *us);
+bool acq_running(const struct acq_stream *st);
+
+#endif /* ACQ_H */
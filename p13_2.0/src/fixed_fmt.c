@@ -0,0 +1,70 @@
+#include "fixed_fmt.h"
+#include <stdbool.h>
+
+static const uint32_t pow10[] = {
+    1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000,
+};
+
+/* Write at least min_digits digits of v at p, return the new end */
+static char *put_digits(char *p, uint32_t v, unsigned int min_digits)
+{
+    char tmp[10];
+    unsigned int n = 0;
+
+    do {
+        tmp[n++] = (char)('0' + v % 10);
+        v /= 10;
+    } while (v);
+    while (n < min_digits) {
+        tmp[n++] = '0';
+    }
+    while (n) {
+        *p++ = tmp[--n];
+    }
+    return p;
+}
+
+static const char *put_fixed(char *out, bool neg, uint32_t ip, uint32_t frac,
+                             unsigned int decimals)
+{
+    char *p = out;
+
+    if (neg && (ip || frac)) {
+        *p++ = '-';
+    }
+    p = put_digits(p, ip, 1);
+    if (decimals) {
+        *p++ = '.';
+        p = put_digits(p, frac, decimals);
+    }
+    *p = '\0';
+    return out;
+}
+
+const char *fmt_fixed(char *out, int32_t value, unsigned int decimals)
+{
+    if (decimals > 9) decimals = 9;
+
+    bool neg = value < 0;
+    uint32_t u = neg ? 0U - (uint32_t)value : (uint32_t)value;
+
+    return put_fixed(out, neg, u / pow10[decimals], u % pow10[decimals], decimals);
+}
+
+const char *fmt_sensor_value(char *out, const struct sensor_value *v, unsigned int decimals)
+{
+    if (decimals > 6) decimals = 6;
+
+    /* val1 and val2 carry the same sign; val2 is in [-999999, 999999] */
+    bool neg = v->val1 < 0 || v->val2 < 0;
+    uint32_t ip = v->val1 < 0 ? 0U - (uint32_t)v->val1 : (uint32_t)v->val1;
+    uint32_t micro = v->val2 < 0 ? (uint32_t)-v->val2 : (uint32_t)v->val2;
+
+    uint32_t div = pow10[6 - decimals];
+    uint32_t frac = (micro + div / 2) / div;
+    if (frac >= pow10[decimals]) {
+        frac -= pow10[decimals];
+        ip++;
+    }
+    return put_fixed(out, neg, ip, frac, decimals);
+}
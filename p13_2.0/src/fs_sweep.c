@@ -0,0 +1,154 @@
+#include "fs_sweep.h"
+#include "record_log.h"
+#include "sensor_record.h"
+
+#include <zephyr/kernel.h>
+#include <zephyr/fs/fs.h>
+#include <zephyr/fs/littlefs.h>
+#include <zephyr/storage/flash_map.h>
+#include <string.h>
+
+#define SWEEP_MNT           "/lfs_sweep"
+#define SWEEP_PARTITION     FIXED_PARTITION_ID(bench_fs)
+
+/* Flash geometry, not swept: see LFS_READ_SIZE/LFS_PROG_SIZE in main.c */
+#define SWEEP_READ_SIZE     16
+#define SWEEP_PROG_SIZE     8
+
+#define SWEEP_FILES         3
+
+static const uint16_t caches[] = { 64, 128, 256, 512 };
+static const uint16_t lookaheads[] = { 8, 32 };
+static const int32_t cycles[] = { 100, 512, -1 };
+
+#define SWEEP_CACHE_MAX     512
+#define SWEEP_LOOKAHEAD_MAX 32
+
+static uint8_t __aligned(4) read_buf[SWEEP_CACHE_MAX];
+static uint8_t __aligned(4) prog_buf[SWEEP_CACHE_MAX];
+static uint32_t lookahead_buf[SWEEP_LOOKAHEAD_MAX / sizeof(uint32_t)];
+
+static struct fs_littlefs sweep_fs;
+static struct fs_mount_t sweep_mnt = {
+    .type = FS_LITTLEFS,
+    .fs_data = &sweep_fs,
+    .storage_dev = (void *)SWEEP_PARTITION,
+    .mnt_point = SWEEP_MNT,
+};
+
+static unsigned long free_bytes(void)
+{
+    struct fs_statvfs st;
+    if (fs_statvfs(SWEEP_MNT, &st) != 0) return 0;
+    return st.f_bfree * st.f_frsize;
+}
+
+/* Empty partition, formatted by the mount with this point's settings */
+static int mount_point(const struct fs_sweep_point *pt)
+{
+    const struct flash_area *fa;
+
+    int rc = flash_area_open(SWEEP_PARTITION, &fa);
+    if (rc) return rc;
+    rc = flash_area_erase(fa, 0, fa->fa_size);
+    flash_area_close(fa);
+    if (rc) return rc;
+
+    memset(&sweep_fs, 0, sizeof(sweep_fs));
+    sweep_fs.cfg.read_size = SWEEP_READ_SIZE;
+    sweep_fs.cfg.prog_size = SWEEP_PROG_SIZE;
+    sweep_fs.cfg.cache_size = pt->cache_size;
+    sweep_fs.cfg.lookahead_size = pt->lookahead_size;
+    sweep_fs.cfg.block_cycles = pt->block_cycles;
+    sweep_fs.cfg.read_buffer = read_buf;
+    sweep_fs.cfg.prog_buffer = prog_buf;
+    sweep_fs.cfg.lookahead_buffer = lookahead_buf;
+    return fs_mount(&sweep_mnt);
+}
+
+/* Humidity every 2 s, pressure every 3 s, IMU every 4 s, as the streams */
+static int workload(struct fs_sweep_point *pt, uint32_t records)
+{
+    struct record_log logs[SWEEP_FILES] = {
+        RECORD_LOG_INIT(SWEEP_MNT "/humidity.bin", struct ht_record),
+        RECORD_LOG_INIT(SWEEP_MNT "/pressure.bin", struct press_record),
+        RECORD_LOG_INIT(SWEEP_MNT "/imu.bin", struct imu_record),
+    };
+    static const uint8_t every[SWEEP_FILES] = { 2, 3, 4 };
+    uint8_t rec[sizeof(struct imu_record)];
+    uint64_t bytes = 0;
+    int rc = 0;
+
+    for (int f = 0; f < SWEEP_FILES && rc == 0; f++) {
+        rc = record_log_open(&logs[f]);
+    }
+
+    unsigned long free0 = free_bytes();
+    int64_t start = k_uptime_ticks();
+
+    for (uint32_t s = 0; rc == 0 && pt->records < records; s++) {
+        for (int f = 0; f < SWEEP_FILES && rc == 0; f++) {
+            if (s % every[f]) continue;
+
+            memset(rec, (uint8_t)pt->records, sizeof(rec));
+            memcpy(rec, &s, sizeof(s));
+            uint32_t t0 = k_cycle_get_32();
+            rc = record_log_append(&logs[f], rec);
+            uint32_t us = k_cyc_to_us_ceil32(k_cycle_get_32() - t0);
+            if (rc) break;
+
+            pt->append_max_us = MAX(pt->append_max_us, us);
+            pt->records++;
+            bytes += logs[f].rec_size;
+        }
+    }
+    for (int f = 0; f < SWEEP_FILES; f++) {
+        int crc = record_log_close(&logs[f]);
+        rc = rc ? rc : crc;
+    }
+
+    uint64_t us = k_ticks_to_us_floor64(k_uptime_ticks() - start);
+    pt->elapsed_us = (uint32_t)us;
+    pt->records_per_s = us ? (uint32_t)(pt->records * 1000000ull / us) : 0;
+    pt->bytes_per_s = us ? (uint32_t)(bytes * 1000000ull / us) : 0;
+    pt->fs_used = free0 - free_bytes();
+    return rc;
+}
+
+static void run_point(struct fs_sweep_point *pt, uint32_t records)
+{
+    pt->ram = 2 * pt->cache_size + pt->lookahead_size + SWEEP_FILES * pt->cache_size;
+
+    pt->rc = mount_point(pt);
+    if (pt->rc) return;
+    pt->rc = workload(pt, records);
+    int rc = fs_unmount(&sweep_mnt);
+    pt->rc = pt->rc ? pt->rc : rc;
+}
+
+int fs_sweep_run(uint32_t records, fs_sweep_cb cb, void *ctx)
+{
+    int failed = 0;
+
+    for (size_t c = 0; c < ARRAY_SIZE(caches); c++) {
+        for (size_t l = 0; l < ARRAY_SIZE(lookaheads); l++) {
+            for (size_t b = 0; b < ARRAY_SIZE(cycles); b++) {
+                struct fs_sweep_point pt = {
+                    .cache_size = caches[c],
+                    .lookahead_size = lookaheads[l],
+                    .block_cycles = cycles[b],
+                };
+
+                run_point(&pt, records);
+                failed += (pt.rc != 0);
+                cb(&pt, ctx);
+            }
+        }
+    }
+    return failed;
+}
+
+size_t fs_sweep_mount_overhead(void)
+{
+    return sizeof(struct fs_littlefs);
+}
@@ -0,0 +1,37 @@
+#ifndef FS_SWEEP_H
+#define FS_SWEEP_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * LittleFS parameter sweep on the bench_fs partition. Every point erases
+ * the partition, mounts it with its cache, lookahead and block-cycle
+ * settings and appends records to three record_log files in the
+ * interleaving and sync pattern of the sensor streams. The partition has
+ * half the blocks of logs_fs; 8 bytes of lookahead cover either.
+ */
+struct fs_sweep_point {
+    uint16_t cache_size;
+    uint16_t lookahead_size;
+    int32_t block_cycles;       /* -1: no wear leveling */
+    int rc;
+    uint32_t records;
+    uint32_t elapsed_us;        /* mount excluded */
+    uint32_t records_per_s;
+    uint32_t bytes_per_s;
+    uint32_t append_max_us;     /* includes the periodic syncs */
+    uint32_t fs_used;           /* bytes taken from the partition */
+    uint32_t ram;               /* read, prog and file caches plus lookahead */
+};
+
+typedef void (*fs_sweep_cb)(const struct fs_sweep_point *pt, void *ctx);
+
+/* Runs the whole grid, calling cb after each point; returns the number
+ * of points that failed
+ */
+int fs_sweep_run(uint32_t records, fs_sweep_cb cb, void *ctx);
+/* Bytes per mount that do not depend on the parameters */
+size_t fs_sweep_mount_overhead(void);
+
+#endif /* FS_SWEEP_H */
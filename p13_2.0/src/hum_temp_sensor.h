@@ -1,7 +1,10 @@
 #ifndef HUM_TEMP_SENSOR_H
 #define HUM_TEMP_SENSOR_H
 #include <stddef.h>
+#include "sensor_record.h"
 int hun_temp_sensor_init(void);
+/* Fetch one sample as a binary log record */
+int hum_temp_sensor_read(struct ht_record *rec);
 /* New: get formatted sensor data string */
 int hum_temp_sensor_get_string(char *buf, size_t buf_len);
 
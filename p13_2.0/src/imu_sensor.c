@@ -1,4 +1,5 @@
 #include "imu_sensor.h"
+#include "fixed_fmt.h"
 #include <zephyr/device.h>
 #include <zephyr/drivers/sensor.h>
 #include <zephyr/kernel.h>
@@ -14,34 +15,48 @@ const struct device *const imu_dev = DEVICE_DT_GET(DT_ALIAS(imu_sensor));
 #error("IMU sensor not found.");
 #endif
 
-int imu_sensor_get_string(char *buf, size_t buf_len)
+/* accel[3] and gyro[3] in SI units; one bus transaction for both */
+static int imu_fetch(struct sensor_value *accel, struct sensor_value *gyro)
 {
     if (!device_is_ready(imu_dev)) return -1;
     if (sensor_sample_fetch(imu_dev) < 0) return -1;
 
-    struct sensor_value ax, ay, az, gx, gy, gz;
+    if (sensor_channel_get(imu_dev, SENSOR_CHAN_ACCEL_XYZ, accel) < 0) return -1;
+    if (sensor_channel_get(imu_dev, SENSOR_CHAN_GYRO_XYZ, gyro) < 0) return -1;
 
-    sensor_sample_fetch_chan(imu_dev, SENSOR_CHAN_ACCEL_XYZ);
-    sensor_channel_get(imu_dev, SENSOR_CHAN_ACCEL_X, &ax);
-    sensor_channel_get(imu_dev, SENSOR_CHAN_ACCEL_Y, &ay);
-    sensor_channel_get(imu_dev, SENSOR_CHAN_ACCEL_Z, &az);
+    LOG_INF("Accel: x=%d y=%d z=%d mm/s^2",
+            (int32_t)sensor_value_to_milli(&accel[0]), (int32_t)sensor_value_to_milli(&accel[1]),
+            (int32_t)sensor_value_to_milli(&accel[2]));
+    LOG_INF("Gyro : x=%d y=%d z=%d mrad/s",
+            (int32_t)sensor_value_to_milli(&gyro[0]), (int32_t)sensor_value_to_milli(&gyro[1]),
+            (int32_t)sensor_value_to_milli(&gyro[2]));
+    return 0;
+}
+
+int imu_sensor_read(struct imu_record *rec)
+{
+    struct sensor_value a[3], g[3];
+    if (imu_fetch(a, g) < 0) return -1;
 
-    sensor_sample_fetch_chan(imu_dev, SENSOR_CHAN_GYRO_XYZ);
-    sensor_channel_get(imu_dev, SENSOR_CHAN_GYRO_X, &gx);
-    sensor_channel_get(imu_dev, SENSOR_CHAN_GYRO_Y, &gy);
-    sensor_channel_get(imu_dev, SENSOR_CHAN_GYRO_Z, &gz);
+    rec->uptime_ms = k_uptime_get_32();
+    for (int i = 0; i < 3; i++) {
+        rec->accel_centi[i] = (int16_t)(a[i].val1 * 100 + a[i].val2 / 10000);
+        rec->gyro_centi[i] = (int16_t)(g[i].val1 * 100 + g[i].val2 / 10000);
+    }
+    return 0;
+}
 
-    double axd = sensor_value_to_double(&ax);
-    double ayd = sensor_value_to_double(&ay);
-    double azd = sensor_value_to_double(&az);
-    double gxd = sensor_value_to_double(&gx);
-    double gyd = sensor_value_to_double(&gy);
-    double gzd = sensor_value_to_double(&gz);
+int imu_sensor_get_string(char *buf, size_t buf_len)
+{
+    struct sensor_value a[3], g[3];
+    if (imu_fetch(a, g) < 0) return -1;
 
-   LOG_INF("Accel: x=%.2f y=%.2f z=%.2f", axd, ayd, azd);
-   LOG_INF("Gyro : x=%.2f y=%.2f z=%.2f", gxd, gyd, gzd);
+    char f[6][FIXED_FMT_BUF];
 
-    return snprintf(buf, buf_len,"Accel: %.2f, %.2f, %.2f | Gyro: %.2f, %.2f, %.2f\n",axd, ayd, azd, gxd, gyd, gzd);
+    return snprintf(buf, buf_len, "Accel: %s, %s, %s | Gyro: %s, %s, %s\n",
+                    fmt_sensor_value(f[0], &a[0], 2), fmt_sensor_value(f[1], &a[1], 2),
+                    fmt_sensor_value(f[2], &a[2], 2), fmt_sensor_value(f[3], &g[0], 2),
+                    fmt_sensor_value(f[4], &g[1], 2), fmt_sensor_value(f[5], &g[2], 2));
 }
 
 int imu_sensor_init(void)
@@ -1,7 +1,10 @@
 #ifndef IMU_SENSOR_H
 #define IMU_SENSOR_H
 #include <stddef.h>
+#include "sensor_record.h"
 int imu_sensor_init(void);
+/* Fetch one sample as a binary log record */
+int imu_sensor_read(struct imu_record *rec);
 /* New */
 int imu_sensor_get_string(char *buf, size_t buf_len);
 
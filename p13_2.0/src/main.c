@@ -1,6 +1,10 @@
 #include "hum_temp_sensor.h"
 #include "imu_sensor.h"
 #include "pressure_sensor.h"
+#include "record_log.h"
+#include "acq.h"
+#include "fs_sweep.h"
+#include "fixed_fmt.h"
 
 #include <zephyr/kernel.h>
 #include <zephyr/fs/fs.h>
@@ -9,166 +13,180 @@
 #include <zephyr/logging/log.h>
 #include <zephyr/shell/shell.h>
 #include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
 
 LOG_MODULE_REGISTER(main);
 
-/* Mount points */
-#define MOUNT_POINT_HUM   "/lfs_hum"
-#define MOUNT_POINT_PRESS "/lfs_press"
-#define MOUNT_POINT_TEMP  "/lfs_temp"
+/* One LittleFS for all streams */
+#define MOUNT_POINT "/lfs"
 
-/* LittleFS configs */
-FS_LITTLEFS_DECLARE_DEFAULT_CONFIG(lfs_hum);
-FS_LITTLEFS_DECLARE_DEFAULT_CONFIG(lfs_press);
-FS_LITTLEFS_DECLARE_DEFAULT_CONFIG(lfs_temp);
+/* Sized for the STM32L4 bank: memory-mapped reads, 64-bit programming,
+ * 2 KB pages. A 256-byte cache holds a sync interval of the largest
+ * record (RECORD_LOG_SYNC_EVERY); 8 bytes of lookahead map all 64 blocks
+ * of the 128 KB partition. "sensors fs_sweep" measures the alternatives.
+ */
+#define LFS_READ_SIZE       16
+#define LFS_PROG_SIZE       8
+#define LFS_CACHE_SIZE      256
+#define LFS_LOOKAHEAD_SIZE  8
 
-static struct fs_mount_t mount_hum = {
-    .type = FS_LITTLEFS,
-    .fs_data = &lfs_hum,
-    .storage_dev = (void *)FIXED_PARTITION_ID(humidity_fs),
-    .mnt_point = MOUNT_POINT_HUM,
-};
+FS_LITTLEFS_DECLARE_CUSTOM_CONFIG(lfs_logs, 4, LFS_READ_SIZE, LFS_PROG_SIZE,
+                                  LFS_CACHE_SIZE, LFS_LOOKAHEAD_SIZE);
 
-static struct fs_mount_t mount_press = {
+static struct fs_mount_t mount_logs = {
     .type = FS_LITTLEFS,
-    .fs_data = &lfs_press,
-    .storage_dev = (void *)FIXED_PARTITION_ID(pressure_fs),
-    .mnt_point = MOUNT_POINT_PRESS,
+    .fs_data = &lfs_logs,
+    .storage_dev = (void *)FIXED_PARTITION_ID(logs_fs),
+    .mnt_point = MOUNT_POINT,
 };
 
-static struct fs_mount_t mount_temp = {
-    .type = FS_LITTLEFS,
-    .fs_data = &lfs_temp,
-    .storage_dev = (void *)FIXED_PARTITION_ID(temp_fs),
-    .mnt_point = MOUNT_POINT_TEMP,
-};
+/* Binary per-sensor logs, held open while their stream runs */
+static struct record_log hum_log =
+    RECORD_LOG_INIT(MOUNT_POINT "/humidity.bin", struct ht_record);
+static struct record_log press_log =
+    RECORD_LOG_INIT(MOUNT_POINT "/pressure.bin", struct press_record);
+static struct record_log imu_log =
+    RECORD_LOG_INIT(MOUNT_POINT "/imu.bin", struct imu_record);
 
-/*--- Threads --- */
-static struct k_thread hum_thread_data, press_thread_data, imu_thread_data;
+/*--- Acquisition streams: threads live for the whole run --- */
 static K_THREAD_STACK_DEFINE(hum_stack, 2048);
 static K_THREAD_STACK_DEFINE(press_stack, 2048);
 static K_THREAD_STACK_DEFINE(imu_stack, 2048);
 
-static k_tid_t hum_tid = NULL, press_tid = NULL, imu_tid = NULL;
+static int read_hum(void *rec)   { return hum_temp_sensor_read(rec); }
+static int read_press(void *rec) { return pressure_sensor_read(rec); }
+static int read_imu(void *rec)   { return imu_sensor_read(rec); }
 
-void hum_thread(void *a, void *b, void *c)
-{
-    struct fs_file_t file;
-    char buffer[128];
-
-    while (1) {
-        if (hum_temp_sensor_get_string(buffer, sizeof(buffer)) > 0) {
-            fs_file_t_init(&file);
-            if (fs_open(&file, MOUNT_POINT_HUM "/humidity.txt",FS_O_CREATE | FS_O_WRITE | FS_O_APPEND) == 0) {
-                fs_write(&file, buffer, strlen(buffer));
-                fs_close(&file);
-            }
-        }
-        k_sleep(K_SECONDS(2));
-    }
-}
+enum { STREAM_HUM, STREAM_PRESS, STREAM_IMU };
 
-void press_thread(void *a, void *b, void *c)
+static struct acq_stream streams[] = {
+    [STREAM_HUM]   = ACQ_STREAM_INIT("hum", &hum_log, read_hum, 2000, hum_stack),
+    [STREAM_PRESS] = ACQ_STREAM_INIT("press", &press_log, read_press, 3000, press_stack),
+    [STREAM_IMU]   = ACQ_STREAM_INIT("imu", &imu_log, read_imu, 4000, imu_stack),
+};
+
+static struct acq_stream *stream_find(const char *name)
 {
-    struct fs_file_t file;
-    char buffer[128];
-
-    while (1) {
-        if (pressure_sensor_get_string(buffer, sizeof(buffer)) > 0) {
-            fs_file_t_init(&file);
-            if (fs_open(&file, MOUNT_POINT_PRESS "/pressure.txt",FS_O_CREATE | FS_O_WRITE | FS_O_APPEND) == 0) {
-                fs_write(&file, buffer, strlen(buffer));
-                fs_close(&file);
-            }
+    for (size_t i = 0; i < ARRAY_SIZE(streams); i++) {
+        if (strcmp(name, streams[i].name) == 0) {
+            return &streams[i];
         }
-        k_sleep(K_SECONDS(3));
     }
+    return NULL;
 }
 
-void imu_thread(void *a, void *b, void *c)
+/* --- Shell Commands --- */
+static int stream_cmd(const struct shell *sh, struct acq_stream *st, bool on)
 {
-    struct fs_file_t file;
-    char buffer[256];
-
-    while (1) {
-        if (imu_sensor_get_string(buffer, sizeof(buffer)) > 0) {
-            fs_file_t_init(&file);
-            if (fs_open(&file, MOUNT_POINT_TEMP "/imu.txt",FS_O_CREATE | FS_O_WRITE | FS_O_APPEND) == 0) {
-                fs_write(&file, buffer, strlen(buffer));
-                fs_close(&file);
-            }
-        }
-        k_sleep(K_SECONDS(4));
+    uint32_t us;
+    int rc = acq_set(st, on, &us);
+
+    if (rc == -EALREADY) {
+        shell_print(sh, "%s logging already %s.", st->name, on ? "running" : "stopped");
+        return 0;
     }
+    if (rc) {
+        shell_error(sh, "%s logging %s failed (%d)", st->name, on ? "start" : "stop", rc);
+        return rc;
+    }
+    shell_print(sh, "%s logging %s in %u us.", st->name, on ? "started" : "stopped", us);
+    return 0;
 }
 
-/* --- Shell Commands --- */
 static int cmd_start_hum(const struct shell *sh, size_t argc, char **argv)
 {
-    if (!hum_tid) {
-        hum_tid = k_thread_create(&hum_thread_data, hum_stack,K_THREAD_STACK_SIZEOF(hum_stack),hum_thread, NULL, NULL, NULL,5, 0, K_NO_WAIT);
-        shell_print(sh, "Humidity logging started.");
-    } else {
-        shell_print(sh, "Humidity logging already running.");
-    }
-    return 0;
+    return stream_cmd(sh, &streams[STREAM_HUM], true);
 }
 
 static int cmd_stop_hum(const struct shell *sh, size_t argc, char **argv)
 {
-    if (hum_tid) {
-        k_thread_abort(hum_tid);
-        hum_tid = NULL;
-        shell_print(sh, "Humidity logging stopped.");
-    } else {
-        shell_print(sh, "Humidity logging not running.");
-    }
-    return 0;
+    return stream_cmd(sh, &streams[STREAM_HUM], false);
 }
 
 static int cmd_start_press(const struct shell *sh, size_t argc, char **argv)
 {
-    if (!press_tid) {
-        press_tid = k_thread_create(&press_thread_data, press_stack,K_THREAD_STACK_SIZEOF(press_stack),press_thread, NULL, NULL, NULL,5, 0, K_NO_WAIT);
-        shell_print(sh, "Pressure logging started.");
-    } else {
-        shell_print(sh, "Pressure logging already running.");
-    }
-    return 0;
+    return stream_cmd(sh, &streams[STREAM_PRESS], true);
 }
 
 static int cmd_stop_press(const struct shell *sh, size_t argc, char **argv)
 {
-    if (press_tid) {
-        k_thread_abort(press_tid);
-        press_tid = NULL;
-        shell_print(sh, "Pressure logging stopped.");
-    } else {
-        shell_print(sh, "Pressure logging not running.");
-    }
-    return 0;
+    return stream_cmd(sh, &streams[STREAM_PRESS], false);
 }
 
 static int cmd_start_imu(const struct shell *sh, size_t argc, char **argv)
 {
-    if (!imu_tid) {
-        imu_tid = k_thread_create(&imu_thread_data, imu_stack,K_THREAD_STACK_SIZEOF(imu_stack),imu_thread, NULL, NULL, NULL,5, 0, K_NO_WAIT);
-        shell_print(sh, "IMU logging started.");
-    } else {
-        shell_print(sh, "IMU logging already running.");
+    return stream_cmd(sh, &streams[STREAM_IMU], true);
+}
+
+static int cmd_stop_imu(const struct shell *sh, size_t argc, char **argv)
+{
+    return stream_cmd(sh, &streams[STREAM_IMU], false);
+}
+
+static int cmd_acq(const struct shell *sh, size_t argc, char **argv)
+{
+    shell_print(sh, "stream  state    starts  stops  start us last/max  stop us last/max  rc");
+    for (size_t i = 0; i < ARRAY_SIZE(streams); i++) {
+        const struct acq_stream *st = &streams[i];
+
+        shell_print(sh, "%-6s  %-7s  %6u  %5u  %8u/%-8u  %7u/%-8u  %d", st->name,
+                    acq_running(st) ? "running" : "stopped", st->starts, st->stops,
+                    st->start_last_us, st->start_max_us, st->stop_last_us, st->stop_max_us,
+                    st->rc);
     }
     return 0;
 }
 
-static int cmd_stop_imu(const struct shell *sh, size_t argc, char **argv)
+/* Start/stop cycles with the stop landing at a different point of the
+ * sampling period each time; samples go to the stream's log as usual
+ */
+static int cmd_acq_bench(const struct shell *sh, size_t argc, char **argv)
 {
-    if (imu_tid) {
-        k_thread_abort(imu_tid);
-        imu_tid = NULL;
-        shell_print(sh, "IMU logging stopped.");
-    } else {
-        shell_print(sh, "IMU logging not running.");
+    struct acq_stream *st = stream_find(argv[1]);
+    int n = (argc > 2) ? atoi(argv[2]) : 10;
+    uint32_t lo[2] = { UINT32_MAX, UINT32_MAX }, hi[2] = { 0 };
+    uint64_t sum[2] = { 0 };
+    int rc = 0;
+
+    if (!st) {
+        shell_error(sh, "Unknown stream %s (hum|press|imu)", argv[1]);
+        return -EINVAL;
+    }
+    if (n <= 0) {
+        shell_error(sh, "count must be > 0");
+        return -EINVAL;
+    }
+    if (acq_running(st)) {
+        shell_error(sh, "Stop %s logging first", st->name);
+        return -EBUSY;
     }
+
+    for (int i = 0; i < n && rc == 0; i++) {
+        for (int on = 1; on >= 0; on--) {
+            uint32_t us;
+
+            rc = acq_set(st, on, &us);
+            if (rc) break;
+            lo[on] = MIN(lo[on], us);
+            hi[on] = MAX(hi[on], us);
+            sum[on] += us;
+            if (on) {
+                k_msleep(1 + (uint32_t)i * st->period_ms / n);
+            }
+        }
+    }
+    if (rc) {
+        shell_error(sh, "%s cycle failed (%d)", st->name, rc);
+        /* leave it stopped */
+        (void)acq_set(st, false, NULL);
+        return rc;
+    }
+
+    shell_print(sh, "%s, %d cycles", st->name, n);
+    shell_print(sh, "start us min=%u avg=%u max=%u", lo[1], (uint32_t)(sum[1] / n), hi[1]);
+    shell_print(sh, "stop  us min=%u avg=%u max=%u (sample in flight, sync, close)",
+                lo[0], (uint32_t)(sum[0] / n), hi[0]);
     return 0;
 }
 
@@ -184,6 +202,284 @@ static int cmd_fetch_all(const struct shell *sh, size_t argc, char **argv)
     return 0;
 }
 
+/* --- Export: binary records to text, only on demand --- */
+static void print_ht(const struct shell *sh, const void *p)
+{
+    const struct ht_record *r = p;
+    char t[FIXED_FMT_BUF], h[FIXED_FMT_BUF];
+
+    shell_print(sh, "%u,%s,%s", r->uptime_ms,
+                fmt_fixed(t, r->temp_centi, 2), fmt_fixed(h, r->hum_centi, 2));
+}
+
+static void print_press(const struct shell *sh, const void *p)
+{
+    const struct press_record *r = p;
+    shell_print(sh, "%u,%d", r->uptime_ms, r->press_pa);
+}
+
+static void print_imu(const struct shell *sh, const void *p)
+{
+    const struct imu_record *r = p;
+    char f[6][FIXED_FMT_BUF];
+
+    shell_print(sh, "%u,%s,%s,%s,%s,%s,%s", r->uptime_ms,
+                fmt_fixed(f[0], r->accel_centi[0], 2), fmt_fixed(f[1], r->accel_centi[1], 2),
+                fmt_fixed(f[2], r->accel_centi[2], 2), fmt_fixed(f[3], r->gyro_centi[0], 2),
+                fmt_fixed(f[4], r->gyro_centi[1], 2), fmt_fixed(f[5], r->gyro_centi[2], 2));
+}
+
+struct export_stream {
+    const char *name;
+    const struct record_log *log;
+    const char *header;
+    void (*print)(const struct shell *sh, const void *rec);
+};
+
+static const struct export_stream export_streams[] = {
+    { "hum",   &hum_log,   "uptime_ms,temp_C,hum_pct", print_ht },
+    { "press", &press_log, "uptime_ms,press_pa", print_press },
+    { "imu",   &imu_log,   "uptime_ms,ax_ms2,ay_ms2,az_ms2,gx_rads,gy_rads,gz_rads", print_imu },
+};
+
+static int cmd_export(const struct shell *sh, size_t argc, char **argv)
+{
+    const struct export_stream *st = NULL;
+
+    for (size_t i = 0; i < ARRAY_SIZE(export_streams); i++) {
+        if (strcmp(argv[1], export_streams[i].name) == 0) {
+            st = &export_streams[i];
+        }
+    }
+    if (!st) {
+        shell_error(sh, "Unknown stream %s (hum|press|imu)", argv[1]);
+        return -EINVAL;
+    }
+
+    /* whole records per read; only synced records are visible here */
+    uint8_t buf[8 * sizeof(struct imu_record)];
+    size_t rec_size = st->log->rec_size;
+    size_t chunk = (sizeof(buf) / rec_size) * rec_size;
+    struct fs_file_t file;
+
+    fs_file_t_init(&file);
+    int rc = fs_open(&file, st->log->path, FS_O_READ);
+    if (rc) {
+        shell_error(sh, "Failed to open %s (%d)", st->log->path, rc);
+        return rc;
+    }
+
+    shell_print(sh, "%s", st->header);
+    ssize_t r;
+    while ((r = fs_read(&file, buf, chunk)) > 0) {
+        for (size_t off = 0; off + rec_size <= (size_t)r; off += rec_size) {
+            st->print(sh, buf + off);
+        }
+    }
+    fs_close(&file);
+    return r < 0 ? (int)r : 0;
+}
+
+/* --- Benchmark: old text path vs binary record path --- */
+#define BENCH_TXT MOUNT_POINT "/bench.txt"
+#define BENCH_BIN MOUNT_POINT "/bench.bin"
+
+struct bench_result {
+    int64_t ticks;
+    off_t file_size;
+    unsigned long fs_bytes;   /* drop in free space on the mount */
+};
+
+static unsigned long fs_free_bytes(const char *mnt)
+{
+    struct fs_statvfs st;
+    if (fs_statvfs(mnt, &st) != 0) return 0;
+    return st.f_bfree * st.f_frsize;
+}
+
+static off_t fs_file_size(const char *path)
+{
+    struct fs_dirent ent;
+    if (fs_stat(path, &ent) != 0) return 0;
+    return ent.size;
+}
+
+/* Open, format, write, close per sample: the previous logger loop */
+static int bench_text(int n, struct bench_result *res)
+{
+    char line[64];
+    char t[FIXED_FMT_BUF], h[FIXED_FMT_BUF];
+    struct fs_file_t file;
+    unsigned long free0 = fs_free_bytes(MOUNT_POINT);
+    int64_t start = k_uptime_ticks();
+
+    for (int i = 0; i < n; i++) {
+        int len = snprintf(line, sizeof(line), "Temperature: %s C, Humidity: %s %%\n",
+                           fmt_fixed(t, 215 + i, 1), fmt_fixed(h, 402, 1));
+        fs_file_t_init(&file);
+        int rc = fs_open(&file, BENCH_TXT, FS_O_CREATE | FS_O_WRITE | FS_O_APPEND);
+        if (rc) return rc;
+        fs_write(&file, line, len);
+        fs_close(&file);
+    }
+
+    res->ticks = k_uptime_ticks() - start;
+    res->file_size = fs_file_size(BENCH_TXT);
+    res->fs_bytes = free0 - fs_free_bytes(MOUNT_POINT);
+    return 0;
+}
+
+/* Fixed-size records through a held-open handle with periodic sync */
+static int bench_binary(int n, struct bench_result *res)
+{
+    struct record_log log = RECORD_LOG_INIT(BENCH_BIN, struct ht_record);
+    unsigned long free0 = fs_free_bytes(MOUNT_POINT);
+    int64_t start = k_uptime_ticks();
+
+    int rc = record_log_open(&log);
+    if (rc) return rc;
+    for (int i = 0; i < n; i++) {
+        struct ht_record rec = {
+            .uptime_ms = k_uptime_get_32(),
+            .temp_centi = 2150 + i,
+            .hum_centi = 4025,
+        };
+        rc = record_log_append(&log, &rec);
+        if (rc) break;
+    }
+    record_log_close(&log);
+
+    res->ticks = k_uptime_ticks() - start;
+    res->file_size = fs_file_size(BENCH_BIN);
+    res->fs_bytes = free0 - fs_free_bytes(MOUNT_POINT);
+    return rc;
+}
+
+static void bench_report(const struct shell *sh, const char *name, int n,
+                         const struct bench_result *res)
+{
+    uint64_t us = k_ticks_to_us_floor64(res->ticks);
+    uint64_t rate = us ? (uint64_t)n * 1000000U / us : 0;
+
+    shell_print(sh, "%-6s n=%d %llu samples/s %llu us/sample %u B/sample file %lu B/sample fs",
+                name, n, (unsigned long long)rate, (unsigned long long)(us / n),
+                (unsigned int)(res->file_size / n), res->fs_bytes / n);
+}
+
+static int cmd_bench(const struct shell *sh, size_t argc, char **argv)
+{
+    int n = (argc > 1) ? atoi(argv[1]) : 100;
+    struct bench_result res;
+
+    if (n <= 0) {
+        shell_error(sh, "count must be > 0");
+        return -EINVAL;
+    }
+
+    fs_unlink(BENCH_TXT);
+    fs_unlink(BENCH_BIN);
+
+    if (bench_text(n, &res) == 0) {
+        bench_report(sh, "text", n, &res);
+    }
+    if (bench_binary(n, &res) == 0) {
+        bench_report(sh, "binary", n, &res);
+    }
+
+    fs_unlink(BENCH_TXT);
+    fs_unlink(BENCH_BIN);
+    return 0;
+}
+
+/* Cost of one LOG_INF() call as issued from the sensor modules */
+static int cmd_log_bench(const struct shell *sh, size_t argc, char **argv)
+{
+    /* stay below the deferred log buffer so no call takes the drop path */
+    int n = (argc > 1) ? atoi(argv[1]) : 32;
+    if (n <= 0) {
+        shell_error(sh, "count must be > 0");
+        return -EINVAL;
+    }
+
+    uint32_t start = k_cycle_get_32();
+    for (int i = 0; i < n; i++) {
+        LOG_INF("Accel: x=%d y=%d z=%d mm/s^2", i, -i, 9810);
+    }
+    uint32_t cyc = (k_cycle_get_32() - start) / n;
+
+    shell_print(sh, "%d log calls: %u cyc/call (%u ns/call)", n, cyc,
+                (uint32_t)k_cyc_to_ns_floor64(cyc));
+    return 0;
+}
+
+/* Cost of one fixed-point sensor_value rendering */
+static int cmd_fmt_bench(const struct shell *sh, size_t argc, char **argv)
+{
+    int n = (argc > 1) ? atoi(argv[1]) : 1000;
+    char out[FIXED_FMT_BUF];
+    struct sensor_value v = { .val1 = -9, .val2 = -806650 };
+
+    if (n <= 0) {
+        shell_error(sh, "count must be > 0");
+        return -EINVAL;
+    }
+
+    uint32_t start = k_cycle_get_32();
+    for (int i = 0; i < n; i++) {
+        v.val2 = -(int32_t)((806650 + i) % 1000000);
+        (void)fmt_sensor_value(out, &v, 2);
+    }
+    uint32_t cyc = (k_cycle_get_32() - start) / n;
+
+    shell_print(sh, "fmt_sensor_value: %u cyc/call (%u ns/call), last \"%s\"", cyc,
+                (uint32_t)k_cyc_to_ns_floor64(cyc), out);
+    return 0;
+}
+
+/* --- LittleFS parameter sweep on bench_fs --- */
+static void sweep_report(const struct fs_sweep_point *pt, void *ctx)
+{
+    const struct shell *sh = ctx;
+
+    if (pt->rc) {
+        shell_error(sh, "cache %u lookahead %u cycles %d: failed (%d)", pt->cache_size,
+                    pt->lookahead_size, pt->block_cycles, pt->rc);
+        return;
+    }
+    shell_print(sh, "%5u %9u %6d %7u %8u %10u %8u %6u%s", pt->cache_size, pt->lookahead_size,
+                pt->block_cycles, pt->records_per_s, pt->bytes_per_s, pt->append_max_us,
+                pt->fs_used, pt->ram,
+                (pt->cache_size == LFS_CACHE_SIZE && pt->lookahead_size == LFS_LOOKAHEAD_SIZE &&
+                 pt->block_cycles == CONFIG_FS_LITTLEFS_BLOCK_CYCLES) ? "  <- mounted" : "");
+}
+
+static int cmd_fs_sweep(const struct shell *sh, size_t argc, char **argv)
+{
+    int n = (argc > 1) ? atoi(argv[1]) : 300;
+    unsigned int mnt = fs_sweep_mount_overhead();
+
+    if (n <= 0) {
+        shell_error(sh, "count must be > 0");
+        return -EINVAL;
+    }
+    /* the log files share the file cache heap with the sweep's */
+    for (size_t i = 0; i < ARRAY_SIZE(streams); i++) {
+        if (acq_running(&streams[i])) {
+            shell_error(sh, "Stop all logging streams first");
+            return -EBUSY;
+        }
+    }
+
+    /* three default-config mounts with one file each, against this one */
+    shell_print(sh, "RAM: 3 default mounts %u B, tuned mount %u B (each incl. %u B of state)",
+                3 * (2 * CONFIG_FS_LITTLEFS_CACHE_SIZE + CONFIG_FS_LITTLEFS_LOOKAHEAD_SIZE +
+                     CONFIG_FS_LITTLEFS_CACHE_SIZE + mnt),
+                5 * LFS_CACHE_SIZE + LFS_LOOKAHEAD_SIZE + mnt, mnt);
+    shell_print(sh, "cache lookahead cycles  rec/s      B/s  append max us  fs B   RAM");
+    int failed = fs_sweep_run(n, sweep_report, (void *)sh);
+    return failed ? -EIO : 0;
+}
+
 /* Function to clear all log files */
 static int cmd_clear_logs(const struct shell *shell, size_t argc, char **argv)
 {
@@ -192,19 +488,27 @@ static int cmd_clear_logs(const struct shell *shell, size_t argc, char **argv)
 
     int ret;
 
-    ret = fs_unlink(MOUNT_POINT_HUM "/humidity.txt");
+    /* running streams hold their files open */
+    for (size_t i = 0; i < ARRAY_SIZE(streams); i++) {
+        if (acq_running(&streams[i])) {
+            shell_error(shell, "Stop all logging streams before clearing logs");
+            return -EBUSY;
+        }
+    }
+
+    ret = fs_unlink(MOUNT_POINT "/humidity.bin");
     if (ret < 0 && ret != -ENOENT) {
-        shell_fprintf(shell, SHELL_ERROR, "Failed to remove humidity.txt (%d)\n", ret);
+        shell_fprintf(shell, SHELL_ERROR, "Failed to remove humidity.bin (%d)\n", ret);
     }
 
-    ret = fs_unlink(MOUNT_POINT_PRESS "/pressure.txt");
+    ret = fs_unlink(MOUNT_POINT "/pressure.bin");
     if (ret < 0 && ret != -ENOENT) {
-        shell_fprintf(shell, SHELL_ERROR, "Failed to remove pressure.txt (%d)\n", ret);
+        shell_fprintf(shell, SHELL_ERROR, "Failed to remove pressure.bin (%d)\n", ret);
     }
 
-    ret = fs_unlink(MOUNT_POINT_TEMP "/imu.txt");
+    ret = fs_unlink(MOUNT_POINT "/imu.bin");
     if (ret < 0 && ret != -ENOENT) {
-        shell_fprintf(shell, SHELL_ERROR, "Failed to remove imu.txt (%d)\n", ret);
+        shell_fprintf(shell, SHELL_ERROR, "Failed to remove imu.bin (%d)\n", ret);
     }
 
     shell_fprintf(shell, SHELL_NORMAL, "All log files cleared!\n");
@@ -213,13 +517,22 @@ static int cmd_clear_logs(const struct shell *shell, size_t argc, char **argv)
 
 /* Shell command tree */
 SHELL_STATIC_SUBCMD_SET_CREATE(sub_sensors,
-    SHELL_CMD(start_hum, NULL, "Start humidity logging thread", cmd_start_hum),
-    SHELL_CMD(stop_hum, NULL, "Stop humidity logging thread", cmd_stop_hum),
-    SHELL_CMD(start_press, NULL, "Start pressure logging thread", cmd_start_press),
-    SHELL_CMD(stop_press, NULL, "Stop pressure logging thread", cmd_stop_press),
-    SHELL_CMD(start_imu, NULL, "Start IMU logging thread", cmd_start_imu),
-    SHELL_CMD(stop_imu, NULL, "Stop IMU logging thread", cmd_stop_imu),
+    SHELL_CMD(start_hum, NULL, "Start humidity logging", cmd_start_hum),
+    SHELL_CMD(stop_hum, NULL, "Stop humidity logging, sync and close its file", cmd_stop_hum),
+    SHELL_CMD(start_press, NULL, "Start pressure logging", cmd_start_press),
+    SHELL_CMD(stop_press, NULL, "Stop pressure logging, sync and close its file", cmd_stop_press),
+    SHELL_CMD(start_imu, NULL, "Start IMU logging", cmd_start_imu),
+    SHELL_CMD(stop_imu, NULL, "Stop IMU logging, sync and close its file", cmd_stop_imu),
+    SHELL_CMD(acq, NULL, "Stream states and start/stop latency", cmd_acq),
+    SHELL_CMD_ARG(acq_bench, NULL, "Start/stop latency: acq_bench <hum|press|imu> [cycles]",
+                  cmd_acq_bench, 2, 1),
     SHELL_CMD(fetch_all, NULL, "Fetch one-shot from all sensors", cmd_fetch_all),
+    SHELL_CMD_ARG(export, NULL, "Dump a binary log as CSV: export <hum|press|imu>", cmd_export, 2, 0),
+    SHELL_CMD_ARG(bench, NULL, "Text vs binary logging: bench [samples]", cmd_bench, 1, 1),
+    SHELL_CMD_ARG(fmt_bench, NULL, "Time fixed-point formatting: fmt_bench [count]", cmd_fmt_bench, 1, 1),
+    SHELL_CMD_ARG(log_bench, NULL, "Time LOG_INF calls: log_bench [count]", cmd_log_bench, 1, 1),
+    SHELL_CMD_ARG(fs_sweep, NULL, "LittleFS cache/lookahead/block-cycle sweep: fs_sweep [records]",
+                  cmd_fs_sweep, 1, 1),
     SHELL_SUBCMD_SET_END
 );
 
@@ -245,9 +558,12 @@ int main(void)
     pressure_sensor_init();
     imu_sensor_init();
 
-    mount_fs(&mount_hum);
-    mount_fs(&mount_press);
-    mount_fs(&mount_temp);
+    mount_fs(&mount_logs);
 
+    for (size_t i = 0; i < ARRAY_SIZE(streams); i++) {
+        if (acq_init(&streams[i], 5) != 0) {
+            LOG_ERR("stream %s not created", streams[i].name);
+        }
+    }
     return 0;
 }
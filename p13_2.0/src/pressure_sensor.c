@@ -1,4 +1,5 @@
 #include "pressure_sensor.h"
+#include "fixed_fmt.h"
 #include <zephyr/device.h>
 #include <zephyr/drivers/sensor.h>
 #include <zephyr/kernel.h>
@@ -14,18 +15,35 @@ const struct device *const pressure_dev = DEVICE_DT_GET(DT_ALIAS(pressure_sensor
 #error("Pressure sensor not found.");
 #endif
 
-int pressure_sensor_get_string(char *buf, size_t buf_len)
+static int pressure_fetch(struct sensor_value *pressure)
 {
     if (!device_is_ready(pressure_dev)) return -1;
     if (sensor_sample_fetch(pressure_dev) < 0) return -1;
+    if (sensor_channel_get(pressure_dev, SENSOR_CHAN_PRESS, pressure) < 0) return -1;
+
+    /* kPa in milli-units is Pa */
+    LOG_INF("Pressure: %d Pa", (int32_t)sensor_value_to_milli(pressure));
+    return 0;
+}
+
+int pressure_sensor_read(struct press_record *rec)
+{
+    struct sensor_value pressure;
+    if (pressure_fetch(&pressure) < 0) return -1;
+
+    rec->uptime_ms = k_uptime_get_32();
+    rec->press_pa = (int32_t)sensor_value_to_milli(&pressure);
+    return 0;
+}
 
+int pressure_sensor_get_string(char *buf, size_t buf_len)
+{
     struct sensor_value pressure;
-    if (sensor_channel_get(pressure_dev, SENSOR_CHAN_PRESS, &pressure) < 0) return -1;
+    if (pressure_fetch(&pressure) < 0) return -1;
 
-    double p = sensor_value_to_double(&pressure);
-   LOG_INF("Pressure: %.1f kPa", p);
+    char p[FIXED_FMT_BUF];
 
-    return snprintf(buf, buf_len, "Pressure: %.1f kPa\n", p);
+    return snprintf(buf, buf_len, "Pressure: %s kPa\n", fmt_sensor_value(p, &pressure, 1));
 }
 
 int pressure_sensor_init(void)
@@ -0,0 +1,21 @@
+/*
+ * native_sim runner side, built against the host C library: a host
+ * clock for measurements that simulated time cannot make, as it stands
+ * still while embedded code runs without sleeping. The IPC benchmark in
+ * ../new links this too, for nanoseconds.
+ */
+#include <stdint.h>
+#include <time.h>
+
+uint64_t app_host_time_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+uint64_t app_host_time_us(void)
+{
+    return app_host_time_ns() / 1000u;
+}
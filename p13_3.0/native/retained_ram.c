@@ -0,0 +1,29 @@
+/*
+ * native_sim runner side: retained RAM for the log stage as a host file
+ * mapped shared, so its contents outlive the process (a kill stands in
+ * for a warm reset) the way __noinit RAM outlives a reset on the board.
+ * Deleting the file is a power cycle.
+ */
+#include <fcntl.h>
+#include <stddef.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+void *app_retained_map(const char *path, size_t len)
+{
+    struct stat sb;
+    void *p;
+
+    int fd = open(path, O_RDWR | O_CREAT, 0600);
+    if (fd < 0) return NULL;
+
+    /* a new file is zeros, one of another size fails the layout check */
+    if (fstat(fd, &sb) != 0 || ((size_t)sb.st_size != len && ftruncate(fd, len) != 0)) {
+        close(fd);
+        return NULL;
+    }
+    p = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    return (p == MAP_FAILED) ? NULL : p;
+}
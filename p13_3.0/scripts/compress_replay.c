@@ -0,0 +1,310 @@
+/*
+ * Replay a snapshot trace through src/compress.c on the host and report
+ * the record reduction and the worst reconstruction error per channel.
+ *
+ * Build:
+ *     cc -O2 -I../src -o compress_replay compress_replay.c ../src/compress.c -lm
+ *
+ * Usage:
+ *     compress_replay [-m off|deadband|sdt] [-h heartbeat_ms]
+ *                     [-b channel=abs[/rel_permille]]... [trace.csv]
+ *
+ * The trace is CSV with a header row naming timestamp_ms and the channel
+ * columns as telemetry_decode.py writes them (temp_centi, hum_centi,
+ * press_pa, ax ... gz, roll_centi, pitch_centi, yaw_centi, alt_cm,
+ * vz_cm_s), so its output can be fed directly. Columns are found by
+ * name; others (valid, the group timestamps) are ignored and channels
+ * the header lacks stay zero. Other frame types and rows that do not
+ * parse are skipped. Without a file a synthetic 24 h trace at 500 ms is
+ * generated.
+ *
+ * Reconstruction is sample-and-hold for deadband and linear
+ * interpolation for sdt, matching what a reader of the log would do.
+ */
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "compress.h"
+
+struct trace {
+    struct all_sensors_data *rec;
+    size_t len;
+    size_t cap;
+};
+
+static void trace_push(struct trace *t, const struct all_sensors_data *d)
+{
+    if (t->len == t->cap) {
+        t->cap = t->cap ? t->cap * 2 : 4096;
+        t->rec = realloc(t->rec, t->cap * sizeof(*t->rec));
+        if (!t->rec) {
+            perror("realloc");
+            exit(1);
+        }
+    }
+    t->rec[t->len++] = *d;
+}
+
+#define MAX_FIELDS 64
+
+/* Decoder column of each channel, see telemetry_decode.py */
+static const char *const ch_names[SNAP_CH_COUNT] = {
+    "temp_centi", "hum_centi", "press_pa", "ax", "ay", "az", "gx", "gy", "gz",
+    "roll_centi", "pitch_centi", "yaw_centi", "alt_cm", "vz_cm_s",
+};
+
+/* From the last snapshot header: field index, -1 if absent */
+static int ts_idx = -1;
+static int ch_idx[SNAP_CH_COUNT];
+
+static int parse_line(char *line, struct all_sensors_data *d)
+{
+    char *field[MAX_FIELDS];
+    int n = 0;
+
+    /* split in place on commas; drop the line end */
+    field[n++] = line;
+    for (char *c = line; *c; c++) {
+        if (*c == '\r' || *c == '\n') {
+            *c = '\0';
+            break;
+        }
+        if (*c == ',' && n < MAX_FIELDS) {
+            *c = '\0';
+            field[n++] = c + 1;
+        }
+    }
+
+    /* a header names the columns; decoder output also has headers for
+     * other frame types, which name no channel and are ignored
+     */
+    for (int i = 0; i < n; i++) {
+        if (strcmp(field[i], "timestamp_ms") == 0) {
+            int idx[SNAP_CH_COUNT];
+            int found = 0;
+
+            for (int ch = 0; ch < SNAP_CH_COUNT; ch++) {
+                idx[ch] = -1;
+                for (int j = 0; j < n; j++) {
+                    if (strcmp(field[j], ch_names[ch]) == 0) idx[ch] = j;
+                }
+                found += idx[ch] >= 0;
+            }
+            if (found) {
+                ts_idx = i;
+                memcpy(ch_idx, idx, sizeof(ch_idx));
+            }
+            return -1;
+        }
+    }
+    if (ts_idx < 0 || ts_idx >= n) return -1;
+
+    long v[MAX_FIELDS];
+    for (int i = 0; i < n; i++) {
+        char *end;
+        v[i] = strtol(field[i], &end, 10);
+        if (end == field[i] || *end) v[i] = LONG_MIN;
+    }
+    if (v[ts_idx] == LONG_MIN) return -1;
+
+    memset(d, 0, sizeof(*d));
+    d->timestamp_ms = (uint32_t)v[ts_idx];
+    for (int ch = 0; ch < SNAP_CH_COUNT; ch++) {
+        if (ch_idx[ch] < 0) continue;
+        if (ch_idx[ch] >= n || v[ch_idx[ch]] == LONG_MIN) return -1;
+        snapshot_set(d, ch, (int32_t)v[ch_idx[ch]]);
+    }
+    return 0;
+}
+
+static void load_csv(const char *path, struct trace *t)
+{
+    FILE *fp = fopen(path, "r");
+    char line[512];
+
+    if (!fp) {
+        perror(path);
+        exit(1);
+    }
+    while (fgets(line, sizeof(line), fp)) {
+        struct all_sensors_data d;
+        /* decoder output interleaves vibration records with snapshots */
+        if (strncmp(line, "vib,", 4) == 0) continue;
+        if (parse_line(line, &d) == 0) {
+            trace_push(t, &d);
+        }
+    }
+    fclose(fp);
+}
+
+/* Slow diurnal drift plus sensor noise; IMU at rest with occasional bumps */
+static void synth(struct trace *t)
+{
+    unsigned seed = 1;
+
+    for (uint32_t ms = 0; ms < 24u * 3600u * 1000u; ms += 500) {
+        struct all_sensors_data d = { .timestamp_ms = ms };
+        double day = 2.0 * M_PI * ms / (24.0 * 3600.0 * 1000.0);
+        int bump = ((ms / 1000) % 900) < 5;
+
+        seed = seed * 1103515245u + 12345u;
+        int n = (int)((seed >> 16) % 5) - 2;    /* +-2 LSB */
+
+        d.ht.temperature = (int16_t)(2200 + 300 * sin(day) + n);
+        d.ht.humidity = (int16_t)(4500 - 800 * sin(day) + n);
+        d.press.pressure = 101325 + (int32_t)(150 * sin(day / 2)) + n;
+        d.imu.accel.x = (int16_t)(n + (bump ? 150 : 0));
+        d.imu.accel.y = (int16_t)(-n);
+        d.imu.accel.z = (int16_t)(981 + n);
+        d.imu.gyro.x = (int16_t)(bump ? 40 : n / 2);
+        d.imu.gyro.y = 0;
+        d.imu.gyro.z = (int16_t)(n / 2);
+        d.orient.roll = (int16_t)(bump ? 300 : n);
+        d.orient.pitch = (int16_t)(-n);
+        d.alt.altitude = (101325 - d.press.pressure) * 83 / 10;    /* ~8.3 cm/Pa */
+        d.alt.vspeed = (int16_t)(n / 2);
+        trace_push(t, &d);
+    }
+}
+
+static int parse_band(const char *arg)
+{
+    char name[16];
+    long abs_v;
+    unsigned rel = 0;
+
+    if (sscanf(arg, "%15[^=]=%ld/%u", name, &abs_v, &rel) < 2) return -1;
+    for (int ch = 0; ch < SNAP_CH_COUNT; ch++) {
+        if (strcmp(name, snapshot_channel_name(ch)) == 0) {
+            struct compress_band b = { .abs = (int32_t)abs_v, .rel_permille = (uint16_t)rel };
+            return compress_set_band(ch, &b);
+        }
+    }
+    return -1;
+}
+
+/* Band around the record a reader interpolates from, as compress.c applies it */
+static double band_at(const struct all_sensors_data *a, int ch)
+{
+    struct compress_band b;
+    double rel;
+
+    compress_get_band(ch, &b);
+    rel = fabs((double)snapshot_get(a, ch)) * b.rel_permille / 1000.0;
+    return floor(rel) > b.abs ? floor(rel) : b.abs;
+}
+
+static double reconstruct(enum compress_mode mode, const struct all_sensors_data *a,
+                          const struct all_sensors_data *b, int ch, uint32_t t)
+{
+    double va = snapshot_get(a, ch);
+
+    if (mode != COMPRESS_SDT || b->timestamp_ms == a->timestamp_ms) return va;
+    return va + (snapshot_get(b, ch) - va) * (double)(t - a->timestamp_ms) /
+                (double)(b->timestamp_ms - a->timestamp_ms);
+}
+
+int main(int argc, char **argv)
+{
+    enum compress_mode mode = COMPRESS_DEADBAND;
+    uint32_t heartbeat_ms = 60000;
+    const char *path = NULL;
+    struct trace in = { 0 }, out = { 0 };
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-m") && i + 1 < argc) {
+            const char *m = argv[++i];
+            mode = !strcmp(m, "off") ? COMPRESS_OFF :
+                   !strcmp(m, "sdt") ? COMPRESS_SDT : COMPRESS_DEADBAND;
+        } else if (!strcmp(argv[i], "-h") && i + 1 < argc) {
+            heartbeat_ms = (uint32_t)strtoul(argv[++i], NULL, 0);
+        } else if (!strcmp(argv[i], "-b") && i + 1 < argc) {
+            if (parse_band(argv[++i])) {
+                fprintf(stderr, "bad band %s\n", argv[i]);
+                return 2;
+            }
+        } else if (argv[i][0] != '-') {
+            path = argv[i];
+        } else {
+            fprintf(stderr, "usage: %s [-m off|deadband|sdt] [-h heartbeat_ms] "
+                    "[-b channel=abs[/rel]]... [trace.csv]\n", argv[0]);
+            return 2;
+        }
+    }
+    compress_init(mode, heartbeat_ms);
+
+    if (path) {
+        load_csv(path, &in);
+    } else {
+        synth(&in);
+    }
+    if (in.len == 0) {
+        fprintf(stderr, "empty trace\n");
+        return 1;
+    }
+
+    for (size_t i = 0; i < in.len; i++) {
+        struct all_sensors_data d;
+        if (compress_feed(&in.rec[i], &d)) {
+            trace_push(&out, &d);
+        }
+    }
+
+    /* Error is checked over the samples the written records cover; SDT
+     * holds the newest sample back until the next record closes it.
+     */
+    double max_err[SNAP_CH_COUNT] = { 0 };
+    uint32_t over[SNAP_CH_COUNT] = { 0 };
+    /* SDT may exceed by up to one LSB where the door is narrower than one */
+    double slack = (mode == COMPRESS_SDT) ? 1.0 : 0.0;
+    uint32_t max_gap = 0;
+    size_t seg = 0;
+    uint32_t covered_to = out.rec[out.len - 1].timestamp_ms;
+
+    for (size_t i = 0; i < in.len && in.rec[i].timestamp_ms <= covered_to; i++) {
+        uint32_t t = in.rec[i].timestamp_ms;
+
+        while (seg + 1 < out.len && out.rec[seg + 1].timestamp_ms <= t) seg++;
+        const struct all_sensors_data *a = &out.rec[seg];
+        const struct all_sensors_data *b = &out.rec[seg + 1 < out.len ? seg + 1 : seg];
+
+        for (int ch = 0; ch < SNAP_CH_COUNT; ch++) {
+            double e = fabs(snapshot_get(&in.rec[i], ch) - reconstruct(mode, a, b, ch, t));
+            if (e > max_err[ch]) max_err[ch] = e;
+            if (mode != COMPRESS_OFF && e > band_at(a, ch) + slack) over[ch]++;
+        }
+    }
+    for (size_t i = 1; i < out.len; i++) {
+        uint32_t gap = out.rec[i].timestamp_ms - out.rec[i - 1].timestamp_ms;
+        if (gap > max_gap) max_gap = gap;
+    }
+
+    struct compress_stats st;
+    compress_stats_get(&st);
+
+    printf("mode=%s records in=%u out=%u reduction=%.1f%% heartbeats=%u "
+           "max_gap_ms=%u bytes %zu -> %zu\n",
+           compress_mode_name(mode), st.in, st.out,
+           100.0 * (st.in - st.out) / st.in, st.heartbeats, max_gap,
+           in.len * sizeof(struct all_sensors_data), out.len * sizeof(struct all_sensors_data));
+
+    int fail = 0;
+    printf("%-6s %6s %5s %8s %9s %s\n", "ch", "abs", "rel", "max_err", "triggers", "bound");
+    for (int ch = 0; ch < SNAP_CH_COUNT; ch++) {
+        struct compress_band b;
+        compress_get_band(ch, &b);
+
+        fail |= over[ch] != 0;
+        printf("%-6s %6d %5u %8.2f %9u ", snapshot_channel_name(ch), b.abs, b.rel_permille,
+               max_err[ch], st.triggers[ch]);
+        if (over[ch]) {
+            printf("EXCEEDED x%u\n", over[ch]);
+        } else {
+            printf("ok\n");
+        }
+    }
+    return fail;
+}
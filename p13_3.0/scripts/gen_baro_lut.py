@@ -0,0 +1,51 @@
+#!/usr/bin/env python3
+"""Print the pressure -> altitude table used by src/baro_alt.c.
+
+ISA troposphere, 1013.25 hPa and 15 degC at sea level:
+    h = 44330.77 m * (1 - (p / 101325 Pa) ^ 0.190263)
+Entries are cm at every STEP Pa from MIN_PA; baro_alt.c interpolates
+linearly between them. Paste the output over the table in baro_alt.c
+after changing the range or step.
+
+Usage:
+    gen_baro_lut.py [--step 256] [--min 29952] [--max 110080]
+"""
+import argparse
+
+
+def altitude_cm(pa):
+    return 44330.77 * (1.0 - (pa / 101325.0) ** 0.190263) * 100.0
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__,
+                                 formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("--step", type=int, default=256, help="Pa, power of two")
+    ap.add_argument("--min", type=int, default=29952)
+    ap.add_argument("--max", type=int, default=110080)
+    args = ap.parse_args()
+    if args.step & (args.step - 1) or (args.max - args.min) % args.step:
+        raise SystemExit("step must be a power of two dividing the range")
+
+    vals = [int(round(altitude_cm(p))) for p in range(args.min, args.max + 1, args.step)]
+
+    # worst interpolation error over the range, for the comment
+    worst = 0.0
+    for pa in range(args.min, args.max):
+        i = (pa - args.min) // args.step
+        frac = pa - args.min - i * args.step
+        v = vals[i] + (vals[i + 1] - vals[i]) * frac // args.step
+        worst = max(worst, abs(v - altitude_cm(pa)))
+
+    print(f"/* Generated by scripts/gen_baro_lut.py; worst interpolation error {worst:.1f} cm */")
+    print(f"#define LUT_MIN_PA   {args.min}")
+    print(f"#define LUT_STEP_LOG2 {args.step.bit_length() - 1}")
+    print(f"#define LUT_LEN      {len(vals)}")
+    print("static const int32_t alt_lut_cm[LUT_LEN] = {")
+    for i in range(0, len(vals), 8):
+        print("    " + ", ".join(str(v) for v in vals[i:i + 8]) + ",")
+    print("};")
+
+
+if __name__ == "__main__":
+    main()
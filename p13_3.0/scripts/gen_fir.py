@@ -0,0 +1,223 @@
+#!/usr/bin/env python3
+"""Generate q15 IMU filter coefficients from a JSON spec.
+
+Run by CMake when CONFIG_APP_IMU_FILTER is set. Emits both designs:
+  - windowed-sinc FIR for arm_fir_decimate_q15
+  - Butterworth biquad cascade for arm_biquad_cascade_df1_q15
+The response of the quantized coefficients is checked against the spec.
+The build fails if the check does not pass. A table of expected gains
+is also emitted for "sensors filter resp" to compare against.
+
+Frequencies in the spec are fractions of the output Nyquist rate,
+fs / (2 * decimation). The stopband starts where signals would alias
+into the passband after decimation: fs / decimation - passband edge.
+
+Usage:
+    gen_fir.py --spec filters/imu_filter.json --period-ms 1 --out imu_filter_coeffs.h
+"""
+import argparse
+import cmath
+import json
+import math
+import os
+import sys
+
+Q15 = 32768
+
+# Test points in units of fs_out / 16; see response_points()
+RESP_PASS = [1, 2, 4]
+
+
+def q15(x):
+    v = int(round(x * Q15))
+    return max(-Q15, min(Q15 - 1, v))
+
+
+def window(name, n, taps):
+    if name == "hamming":
+        return 0.54 - 0.46 * math.cos(2 * math.pi * n / (taps - 1))
+    if name == "hann":
+        return 0.5 - 0.5 * math.cos(2 * math.pi * n / (taps - 1))
+    if name == "blackman":
+        return (0.42 - 0.5 * math.cos(2 * math.pi * n / (taps - 1)) +
+                0.08 * math.cos(4 * math.pi * n / (taps - 1)))
+    raise SystemExit(f"unknown window {name}")
+
+
+def design_fir(spec, decim):
+    """Taps for a DC gain of one, quantized so the q15 taps sum to 32767."""
+    taps = spec["taps"]
+    fc = spec["cutoff"] / (2.0 * decim)          # cycles per input sample
+    mid = (taps - 1) / 2.0
+    h = []
+    for n in range(taps):
+        x = n - mid
+        s = 2 * fc if x == 0 else math.sin(2 * math.pi * fc * x) / (math.pi * x)
+        h.append(s * window(spec.get("window", "hamming"), n, taps))
+    total = sum(h)
+    hq = [q15(v / total) for v in h]
+    # Put the rounding error in the centre; keep the taps symmetric (linear phase)
+    err = (Q15 - 1) - sum(hq)
+    if taps % 2:
+        hq[taps // 2] += err
+    else:
+        hq[taps // 2 - 1] += err // 2
+        hq[taps // 2] += err // 2
+    return hq
+
+
+def fir_response(hq, f):
+    """f in cycles per input sample."""
+    z = sum(c * cmath.exp(-2j * math.pi * f * n) for n, c in enumerate(hq)) / Q15
+    return abs(z)
+
+
+def design_biquad(spec, decim):
+    """Butterworth low-pass as RBJ sections; returns (coeffs, post_shift, float sections)."""
+    sections = spec["sections"]
+    order = 2 * sections
+    f0 = spec["cutoff"] / (2.0 * decim)
+    w0 = 2 * math.pi * f0
+    out = []
+    for k in range(sections):
+        q = 1.0 / (2.0 * math.sin(math.pi * (2 * k + 1) / (2 * order)))
+        alpha = math.sin(w0) / (2 * q)
+        cw = math.cos(w0)
+        a0 = 1 + alpha
+        b0 = (1 - cw) / 2 / a0
+        b1 = (1 - cw) / a0
+        b2 = b0
+        a1 = -2 * cw / a0
+        a2 = (1 - alpha) / a0
+        out.append((b0, b1, b2, a1, a2))
+
+    # CMSIS df1 q15: {b0, 0, b1, b2, -a1, -a2} scaled down by 2^post_shift
+    peak = max(max(abs(c) for c in s) for s in out)
+    shift = 0
+    while peak / (1 << shift) >= 1.0 - 1.0 / Q15:
+        shift += 1
+    coeffs = []
+    quant = []
+    for b0, b1, b2, a1, a2 in out:
+        c = [q15(b0 / (1 << shift)), 0, q15(b1 / (1 << shift)), q15(b2 / (1 << shift)),
+             q15(-a1 / (1 << shift)), q15(-a2 / (1 << shift))]
+        coeffs.extend(c)
+        s = float(1 << shift) / Q15
+        quant.append((c[0] * s, c[2] * s, c[3] * s, -c[4] * s, -c[5] * s))
+    return coeffs, shift, quant
+
+
+def biquad_response(sections, f):
+    z1 = cmath.exp(-2j * math.pi * f)
+    z2 = z1 * z1
+    h = 1.0
+    for b0, b1, b2, a1, a2 in sections:
+        h *= (b0 + b1 * z1 + b2 * z2) / (1 + a1 * z1 + a2 * z2)
+    return abs(h)
+
+
+def db(g):
+    return 20 * math.log10(max(g, 1e-6))
+
+
+def check(name, resp, spec, decim):
+    """Dense sweep of passband and alias-protected stopband."""
+    fs_out = 1.0 / decim
+    pass_edge = spec["passband_edge"] * fs_out / 2
+    stop_edge = fs_out - pass_edge
+    worst_pass = max(abs(db(resp(pass_edge * i / 200))) for i in range(201))
+    worst_stop = max(db(resp(stop_edge + (0.5 - stop_edge) * i / 400)) for i in range(401))
+    ok = worst_pass <= spec["passband_ripple_db"] and -worst_stop >= spec["stopband_atten_db"]
+    print(f"gen_fir: {name}: passband dev {worst_pass:.2f} dB, stopband {-worst_stop:.1f} dB "
+          f"-> {'ok' if ok else 'FAIL'}", file=sys.stderr)
+    return ok, worst_pass, -worst_stop
+
+
+def response_points(decim):
+    """fs_out/16 units. Above the passband use 0.75, 1.25, ... fs_out so the
+    aliased tone sits at fs_out/4 and a 64-sample window holds whole periods.
+    """
+    return RESP_PASS + [12 + 8 * k for k in range(decim) if (12 + 8 * k) < 8 * decim]
+
+
+def c_array(name, ctype, vals, per_line=8):
+    lines = []
+    for i in range(0, len(vals), per_line):
+        lines.append("    " + ", ".join(str(v) for v in vals[i:i + per_line]) + ",")
+    return f"static const {ctype} {name}[{len(vals)}] = {{\n" + "\n".join(lines) + "\n};\n"
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__,
+                                 formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("--spec", required=True)
+    ap.add_argument("--period-ms", type=int, default=1, help="IMU input sample period")
+    ap.add_argument("--out", required=True)
+    args = ap.parse_args()
+
+    with open(args.spec) as f:
+        spec = json.load(f)
+    decim = spec["decimation"]
+    if decim < 1 or decim > 255:
+        raise SystemExit("decimation must be 1..255")
+    fs = 1000.0 / args.period_ms
+
+    fir = design_fir(spec["fir"], decim)
+    bq, shift, bq_f = design_biquad(spec["biquad"], decim)
+
+    ok_f, fir_pass, fir_stop = check("fir", lambda f: fir_response(fir, f), spec, decim)
+    ok_b, bq_pass, bq_stop = check("biquad", lambda f: biquad_response(bq_f, f), spec, decim)
+    if not (ok_f and ok_b):
+        raise SystemExit("gen_fir: quantized design misses the spec in " + args.spec)
+
+    points = response_points(decim)
+    resp_rows = []
+    for p in points:
+        f = p / (16.0 * decim)
+        resp_rows.append("    { %d, %d, %d }," % (p, int(round(db(fir_response(fir, f)) * 1000)),
+                                                int(round(db(biquad_response(bq_f, f)) * 1000))))
+
+    hdr = f"""/* Generated by scripts/gen_fir.py from {os.path.basename(args.spec)}; do not edit */
+#ifndef IMU_FILTER_COEFFS_H
+#define IMU_FILTER_COEFFS_H
+
+#include <stdint.h>
+
+#define IMU_FILTER_DECIM           {decim}
+#define IMU_FILTER_INPUT_MHZ       {int(round(fs * 1000))}   /* design rate, 0.001 Hz */
+#define IMU_FILTER_PASS_EDGE_X1000 {int(round(spec['passband_edge'] * 1000))}   /* of output Nyquist */
+#define IMU_FILTER_SPEC_PASS_MDB   {int(round(spec['passband_ripple_db'] * 1000))}
+#define IMU_FILTER_SPEC_STOP_MDB   {int(round(spec['stopband_atten_db'] * 1000))}
+
+/* Windowed-sinc, symmetric so CMSIS' time-reversed order is the same */
+#define IMU_FILTER_FIR_TAPS        {len(fir)}
+{c_array('imu_filter_fir_q15', 'int16_t', fir)}
+/* Butterworth, df1 sections {{b0, 0, b1, b2, -a1, -a2}} >> post shift */
+#define IMU_FILTER_BIQUAD_STAGES   {spec['biquad']['sections']}
+#define IMU_FILTER_BIQUAD_SHIFT    {shift}
+{c_array('imu_filter_biquad_q15', 'int16_t', bq, 6)}
+/* Quantized design: worst passband deviation / stopband attenuation, 0.001 dB */
+#define IMU_FILTER_FIR_PASS_MDB    {int(round(fir_pass * 1000))}
+#define IMU_FILTER_FIR_STOP_MDB    {int(round(fir_stop * 1000))}
+#define IMU_FILTER_BIQUAD_PASS_MDB {int(round(bq_pass * 1000))}
+#define IMU_FILTER_BIQUAD_STOP_MDB {int(round(bq_stop * 1000))}
+
+/* Expected gain at test tones; freq in fs_out/16 units */
+struct imu_filter_resp_point {{
+    uint16_t freq_16th;
+    int32_t fir_mdb;
+    int32_t biquad_mdb;
+}};
+
+static const struct imu_filter_resp_point imu_filter_resp[] = {{
+{chr(10).join(resp_rows)}
+}};
+
+#endif /* IMU_FILTER_COEFFS_H */
+"""
+    with open(args.out, "w") as f:
+        f.write(hdr)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,218 @@
+#!/usr/bin/env python3
+"""Run the logging path benchmark on native_sim and track regressions.
+
+Build once with the benchmark running instead of the application:
+    west build -b native_sim p13_3.0 -- -DEXTRA_CONF_FILE=bench.conf
+
+Each run of the matrix (rate_hz:records:size) prints one "BENCH {json}"
+line, with CONFIG_APP_LOG_FAULT each power-cut phase one "FAULT {json}"
+line, with CONFIG_APP_LOG_QUERY each query scan one "QUERY {json}" line,
+with CONFIG_APP_LOG_STAGE each simulated reset of the log stage one
+"STAGE {json}" line and with CONFIG_APP_RAW_LOG each readback path one
+"RAW {json}" line. This collects them into a JSON file, fails if any
+cut lost an acknowledged record, a query got a wrong answer, a reset
+lost or repeated a staged record or a readback missed a record and,
+given a baseline from an earlier build, fails when a metric got worse
+by more than the tolerance.
+
+Usage:
+    log_bench.py build/zephyr/zephyr.exe --out results.json
+    log_bench.py build/zephyr/zephyr.exe --baseline results.json [--tolerance 10]
+    log_bench.py build/zephyr/zephyr.exe --matrix "0:500:60 0:500:128"
+"""
+import argparse
+import json
+import subprocess
+import sys
+
+# metric path -> True if higher is better
+METRICS = {
+    ("rps",): True,
+    ("capacity_rps",): True,
+    ("open_us", "fresh"): False,
+    ("open_us", "existing"): False,
+    ("write_us", "p50"): False,
+    ("write_us", "p99"): False,
+    ("write_us", "max"): False,
+    ("e2e_us", "p99"): False,
+    ("flash", "bytes"): False,
+    ("flash", "erases"): False,
+    ("ram", "consumer_stack"): False,
+}
+
+QUERY_METRICS = {
+    ("bps",): True,
+    ("bytes",): False,
+    ("probes",): False,
+}
+
+STAGE_METRICS = {
+    ("rps",): True,
+}
+
+RAW_METRICS = {
+    ("bps",): True,
+    ("calls",): False,
+}
+
+FAULT_METRICS = {
+    ("steps",): False,
+    ("recovery_us", "avg"): False,
+    ("recovery_us", "max"): False,
+    ("recovery_read_max",): False,
+}
+
+
+def run(exe, matrix, timeout):
+    cmd = [exe, "--no-rt", "-stop_at=36000"]
+    if matrix:
+        cmd.append("--log-bench=%s" % matrix)
+    out = subprocess.run(cmd, stdout=subprocess.PIPE, stderr=subprocess.STDOUT,
+                         timeout=timeout, check=False, text=True).stdout
+
+    results, done = {"bench": [], "fault": [], "query": [], "stage": [], "raw": []}, False
+    for line in out.splitlines():
+        if line.startswith("BENCH {"):
+            results["bench"].append(json.loads(line[len("BENCH "):]))
+        elif line.startswith("FAULT {"):
+            results["fault"].append(json.loads(line[len("FAULT "):]))
+        elif line.startswith("QUERY {"):
+            results["query"].append(json.loads(line[len("QUERY "):]))
+        elif line.startswith("STAGE {"):
+            results["stage"].append(json.loads(line[len("STAGE "):]))
+        elif line.startswith("RAW {"):
+            results["raw"].append(json.loads(line[len("RAW "):]))
+        elif line.startswith("BENCH done"):
+            done = True
+        elif line.startswith("BENCH "):
+            print(line, file=sys.stderr)
+    if not done:
+        sys.exit("benchmark did not finish:\n" + out[-2000:])
+    return results
+
+
+def every(results):
+    return [r for kind in ("bench", "fault", "query", "stage", "raw") for r in results[kind]]
+
+
+def key(r):
+    if "raw" in r:
+        return ("raw", r["raw"], r["record_size"])
+    if "stage" in r:
+        return ("stage", r["stage"])
+    if "query" in r:
+        return ("query", r["query"], r["chunk"])
+    if "phase" in r:
+        return (r["backend"], r["phase"], r["record_size"])
+    return (r["backend"], r["payload_max"], r["rate_hz"], r["records"], r["size"])
+
+
+def label(r):
+    if "raw" in r:
+        return "raw %s" % r["raw"]
+    if "stage" in r:
+        return "stage %s" % r["stage"]
+    if "query" in r:
+        return "query %s" % r["query"]
+    if "phase" in r:
+        return "%s %s" % (r["backend"], r["phase"])
+    return "%s:%s:%s" % (r["rate_hz"], r["records"], r["size"])
+
+
+def lookup(r, path):
+    for p in path:
+        if not isinstance(r, dict) or r.get(p) is None:
+            return None
+        r = r[p]
+    return r
+
+
+def compare(results, baseline, tolerance, metrics):
+    base = {key(r): r for r in baseline}
+    worse = 0
+    for r in results:
+        b = base.get(key(r))
+        if b is None:
+            continue
+        for path, higher_better in metrics.items():
+            new, old = lookup(r, path), lookup(b, path)
+            if new is None or old is None or old == 0:
+                continue
+            change = 100.0 * (new - old) / old
+            bad = change < -tolerance if higher_better else change > tolerance
+            if bad:
+                worse += 1
+            print("%-28s %-20s %10s -> %-10s %+7.1f%%%s" % (
+                label(r), ".".join(path),
+                old, new, change, "  REGRESSION" if bad else ""))
+    return worse
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__,
+                                 formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("exe", help="native_sim zephyr.exe built with bench.conf")
+    ap.add_argument("--matrix", help="override CONFIG_APP_LOG_BENCH_MATRIX")
+    ap.add_argument("--out", help="write the results here")
+    ap.add_argument("--baseline", help="results of an earlier build")
+    ap.add_argument("--tolerance", type=float, default=10.0, help="percent")
+    ap.add_argument("--timeout", type=int, default=600, help="seconds of host time")
+    args = ap.parse_args()
+
+    results = run(args.exe, args.matrix, args.timeout)
+    failed = False
+    for r in every(results):
+        if r["rc"]:
+            print("run %s failed (%d)" % (label(r), r["rc"]), file=sys.stderr)
+            failed = True
+    for r in results["fault"]:
+        if r["passed"] != r["cuts"]:
+            print("%s: %d of %d cuts failed, first at step %s (unmountable %d, header %d, lost %d)"
+                  % (label(r), r["cuts"] - r["passed"], r["cuts"], r["first_fail"],
+                     r["unmountable"], r["bad_header"], r["lost"]), file=sys.stderr)
+            failed = True
+    for r in results["query"]:
+        if not r["ok"]:
+            print("%s: wrong answer, %d matched of %d records" % (
+                label(r), r["matched"], r["records"]), file=sys.stderr)
+            failed = True
+    for r in results["stage"]:
+        if not r["ok"]:
+            print("%s: %d of %d records in the log (replayed %d, committed %d, corrupt %d)" % (
+                label(r), r["logged"], r["expected"], r["replayed"], r["committed"],
+                r["corrupt"]), file=sys.stderr)
+            failed = True
+    for r in results["raw"]:
+        if not r["ok"]:
+            print("%s: %d records read back, not all in order" % (label(r), r["records"]),
+                  file=sys.stderr)
+            failed = True
+
+    if args.out:
+        with open(args.out, "w") as f:
+            json.dump(results, f, indent=1)
+            f.write("\n")
+    else:
+        for r in every(results):
+            print(json.dumps(r))
+
+    if args.baseline:
+        with open(args.baseline) as f:
+            baseline = json.load(f)
+        worse = compare(results["bench"], baseline["bench"], args.tolerance, METRICS)
+        worse += compare(results["fault"], baseline.get("fault", []), args.tolerance,
+                         FAULT_METRICS)
+        worse += compare(results["query"], baseline.get("query", []), args.tolerance,
+                         QUERY_METRICS)
+        worse += compare(results["stage"], baseline.get("stage", []), args.tolerance,
+                         STAGE_METRICS)
+        worse += compare(results["raw"], baseline.get("raw", []), args.tolerance,
+                         RAW_METRICS)
+        if worse:
+            print("%d metric(s) regressed by more than %.0f%%" % (worse, args.tolerance))
+            failed = True
+    sys.exit(1 if failed else 0)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,205 @@
+#!/usr/bin/env python3
+"""Download logs over SMP (MCUmgr) serial and report the throughput.
+
+Build with mcumgr.conf (see there). Two ways to pull a log:
+
+  file  the fs group download (group 8): the file as stored, ring
+        header and 0xFF padding included
+  ring  the ordered read (group 64, src/smp_log.h): only the valid
+        records, oldest first
+
+Both request chunk after chunk from an offset. With --resume an
+interrupted transfer continues at the size of the local file; ring mode
+keeps the stream's base offset in <local>.base, so the records written
+since do not shift the layout.
+
+Usage:
+    smp_pull.py --exe build/zephyr/zephyr.exe ring /lfs/sensor_log.bin log.bin
+    smp_pull.py --port /dev/ttyACM0 --baud 115200 file /lfs/sensor_log.bin raw.bin
+    smp_pull.py --port /dev/pts/5 ring /lfs/sensor_log.bin log.bin --resume
+
+--exe starts native_sim and uses the pty it prints for uart_1. Needs
+pyserial and cbor2.
+"""
+import argparse
+import base64
+import json
+import os
+import re
+import struct
+import subprocess
+import sys
+import threading
+import time
+
+import cbor2
+import serial
+
+FS_GROUP = 8
+LOG_GROUP = 64      # SMP_LOG_GROUP
+OP_READ, OP_READ_RSP = 0, 1
+
+FRAME_FIRST = b"\x06\x09"
+FRAME_CONT = b"\x04\x14"
+FRAME_RAW = 93      # raw bytes per line: 124 base64 chars, 127 with marker and newline
+
+
+def crc16(data):
+    """CRC-16/XMODEM, as crc16_itu_t(0, ...) on the device."""
+    crc = 0
+    for b in data:
+        crc ^= b << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else crc << 1
+            crc &= 0xFFFF
+    return crc
+
+
+class SmpSerial:
+    def __init__(self, port, baud, timeout):
+        self.ser = serial.Serial(port, baud, timeout=timeout)
+        self.seq = 0
+        self.wire_tx = 0
+        self.wire_rx = 0
+
+    def _send(self, pkt):
+        body = struct.pack(">H", len(pkt) + 2) + pkt + struct.pack(">H", crc16(pkt))
+        for i in range(0, len(body), FRAME_RAW):
+            line = (FRAME_FIRST if i == 0 else FRAME_CONT) + \
+                base64.b64encode(body[i:i + FRAME_RAW]) + b"\n"
+            self.ser.write(line)
+            self.wire_tx += len(line)
+
+    def _recv(self):
+        body, want = b"", None
+        while want is None or len(body) < want:
+            line = self.ser.readline()
+            if not line:
+                raise TimeoutError("no SMP response")
+            self.wire_rx += len(line)
+            line = line.rstrip(b"\r\n")
+            if line.startswith(FRAME_FIRST):
+                body = base64.b64decode(line[2:])
+                want = struct.unpack(">H", body[:2])[0] + 2
+            elif line.startswith(FRAME_CONT) and want is not None:
+                body += base64.b64decode(line[2:])
+            # anything else is console output on a shared UART
+        pkt, crc = body[2:-2], struct.unpack(">H", body[-2:])[0]
+        if crc16(pkt) != crc:
+            raise IOError("SMP frame CRC mismatch")
+        return pkt
+
+    def request(self, group, cmd, payload):
+        data = cbor2.dumps(payload)
+        seq = self.seq
+        self.seq = (self.seq + 1) & 0xFF
+        self._send(struct.pack(">BBHHBB", OP_READ, 0, len(data), group, seq, cmd) + data)
+        while True:
+            pkt = self._recv()
+            op, _, length, rgroup, rseq, rcmd = struct.unpack(">BBHHBB", pkt[:8])
+            if (op & 7) == OP_READ_RSP and rgroup == group and rseq == seq and rcmd == cmd:
+                rsp = cbor2.loads(pkt[8:8 + length])
+                if rsp.get("rc"):
+                    raise IOError("SMP group %d id %d: rc %d" % (group, cmd, rsp["rc"]))
+                return rsp
+
+
+def native_sim_port(exe):
+    """Start zephyr.exe and return (process, pty of uart_1)."""
+    proc = subprocess.Popen([exe], stdout=subprocess.PIPE, stderr=subprocess.STDOUT,
+                            text=True)
+    pat = re.compile(r"uart_1 connected to pseudotty: (\S+)")
+    for line in proc.stdout:
+        m = pat.search(line)
+        if m:
+            # keep reading, or the log output fills the pipe and stalls it
+            threading.Thread(target=lambda: [None for _ in proc.stdout], daemon=True).start()
+            return proc, m.group(1)
+    sys.exit("zephyr.exe did not open a pty for uart_1; built with mcumgr.conf?")
+
+
+def pull(smp, mode, remote, local, resume):
+    off, base, total = 0, None, None
+    if resume and os.path.exists(local):
+        off = os.path.getsize(local)
+        if mode == "ring":
+            with open(local + ".base") as f:
+                base = int(f.read())
+
+    start, requests, t0 = off, 0, time.monotonic()
+    lat = []
+    with open(local, "ab" if off else "wb") as out:
+        while total is None or off < total:
+            req = {"name": remote, "off": off}
+            if mode == "ring" and base is not None:
+                req["base"] = base
+            t = time.monotonic()
+            if mode == "ring":
+                rsp = smp.request(LOG_GROUP, 0, req)
+                if base is None:
+                    base = rsp["base"]
+                    with open(local + ".base", "w") as f:
+                        f.write("%d\n" % base)
+                total = rsp["total"]
+            else:
+                rsp = smp.request(FS_GROUP, 0, req)
+                total = rsp.get("len", total)
+            lat.append(time.monotonic() - t)
+            requests += 1
+            data = rsp["data"]
+            if rsp["off"] != off:
+                raise IOError("asked for offset %d, got %d" % (off, rsp["off"]))
+            if not data:
+                break
+            out.write(data)
+            off += len(data)
+    elapsed = time.monotonic() - t0
+    if mode == "ring" and total is not None and off >= total:
+        os.remove(local + ".base")
+
+    lat.sort()
+    moved = off - start
+    return {
+        "mode": mode, "remote": remote, "bytes": moved, "offset": start, "total": total,
+        "requests": requests, "seconds": round(elapsed, 3),
+        "bps": int(moved / elapsed) if elapsed else 0,
+        "req_ms": {"p50": round(1000 * lat[len(lat) // 2], 2) if lat else None,
+                   "max": round(1000 * lat[-1], 2) if lat else None},
+        "wire_tx": smp.wire_tx, "wire_rx": smp.wire_rx,
+        "efficiency": round(moved / smp.wire_rx, 3) if smp.wire_rx else None,
+    }
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__,
+                                 formatter_class=argparse.RawDescriptionHelpFormatter)
+    src = ap.add_mutually_exclusive_group(required=True)
+    src.add_argument("--port", help="serial device with SMP on it")
+    src.add_argument("--exe", help="native_sim zephyr.exe built with mcumgr.conf")
+    ap.add_argument("--baud", type=int, default=115200)
+    ap.add_argument("--timeout", type=float, default=5.0, help="seconds per response")
+    ap.add_argument("--resume", action="store_true", help="continue a partial download")
+    ap.add_argument("mode", choices=("file", "ring"))
+    ap.add_argument("remote", help="path on the device, e.g. /lfs/sensor_log.bin")
+    ap.add_argument("local")
+    args = ap.parse_args()
+
+    proc, port = None, args.port
+    if args.exe:
+        proc, port = native_sim_port(args.exe)
+    try:
+        smp = SmpSerial(port, args.baud, args.timeout)
+        r = pull(smp, args.mode, args.remote, args.local, args.resume)
+    finally:
+        if proc:
+            proc.terminate()
+
+    print("%s %s: %d bytes in %.2f s, %d B/s, %d requests (p50 %s ms), %.0f%% of the "
+          "received bytes were data" % (r["mode"], r["remote"], r["bytes"], r["seconds"],
+                                        r["bps"], r["requests"], r["req_ms"]["p50"],
+                                        100 * (r["efficiency"] or 0)))
+    print("SMP " + json.dumps(r))
+
+
+if __name__ == "__main__":
+    main()
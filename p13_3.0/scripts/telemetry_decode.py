@@ -0,0 +1,134 @@
+#!/usr/bin/env python3
+"""Decode the CONFIG_APP_TELEMETRY binary stream into CSV.
+
+Frames are COBS encoded and 0x00 delimited. Decoded frame layout:
+    type u8 | seq u8 | uptime_ms le32 | payload | crc16 le16
+where crc16 is Zephyr's crc16_ccitt(0xFFFF, ...) over everything before it.
+
+Usage:
+    telemetry_decode.py /dev/ttyACM1 [--baud 115200]
+    telemetry_decode.py capture.bin
+"""
+import argparse
+import os
+import struct
+import sys
+
+# type -> (name, struct format, column names)
+FRAME_TYPES = {
+    1: ("snapshot", "<IHxxIhhIiIhhhhhhhhhxxIihxx",
+        ["timestamp_ms", "valid",
+         "ht_ts_ms", "temp_centi", "hum_centi",
+         "press_ts_ms", "press_pa",
+         "imu_ts_ms", "ax", "ay", "az", "gx", "gy", "gz",
+         "roll_centi", "pitch_centi", "yaw_centi",
+         "alt_ts_ms", "alt_cm", "vz_cm_s"]),
+    2: ("vib", None, None),     # variable length, see vib_layout()
+}
+
+
+def vib_layout(payload):
+    """struct vib_features: the band count is carried in the record."""
+    if len(payload) < 16:
+        return None, None
+    n = struct.unpack_from("<H", payload, 14)[0]
+    fmt = "<IIHHHH%dH%s" % (n, "xx" if n % 2 else "")
+    cols = (["timestamp_ms", "peak_freq_mhz", "rms_centi", "peak_centi", "crest_x100", "bands"] +
+            ["band%d_centi" % b for b in range(n)])
+    return fmt, cols
+
+
+def crc16_ccitt(seed, data):
+    """Bit-exact port of Zephyr's crc16_ccitt()."""
+    for b in data:
+        e = (seed ^ b) & 0xFF
+        f = (e ^ (e << 4)) & 0xFF
+        seed = ((seed >> 8) ^ (f << 8) ^ (f << 3) ^ (f >> 4)) & 0xFFFF
+    return seed
+
+
+def cobs_decode(buf):
+    out = bytearray()
+    i = 0
+    while i < len(buf):
+        code = buf[i]
+        if code == 0 or i + code > len(buf) + 1:
+            raise ValueError("bad COBS code")
+        out += buf[i + 1:i + code]
+        i += code
+        if code < 0xFF and i < len(buf):
+            out.append(0)
+    return bytes(out)
+
+
+def frames(stream):
+    pending = bytearray()
+    while True:
+        chunk = stream.read(256)
+        if not chunk:
+            return
+        pending += chunk
+        while True:
+            end = pending.find(b"\x00")
+            if end < 0:
+                break
+            raw = bytes(pending[:end])
+            del pending[:end + 1]
+            if raw:
+                yield raw
+
+
+def open_source(path, baud):
+    if os.path.exists(path) and not path.startswith("/dev/"):
+        return open(path, "rb")
+    import serial  # pyserial, only needed for live capture
+    return serial.Serial(path, baud, timeout=1)
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__,
+                                 formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("source", help="serial port or capture file")
+    ap.add_argument("--baud", type=int, default=115200)
+    args = ap.parse_args()
+
+    bad = 0
+    last_seq = None
+    lost = 0
+    header_done = set()
+    with open_source(args.source, args.baud) as src:
+        try:
+            for enc in frames(src):
+                try:
+                    raw = cobs_decode(enc)
+                except ValueError:
+                    bad += 1
+                    continue
+                if len(raw) < 8 or crc16_ccitt(0xFFFF, raw[:-2]) != struct.unpack("<H", raw[-2:])[0]:
+                    bad += 1
+                    continue
+                ftype, seq, uptime = struct.unpack("<BBI", raw[:6])
+                if last_seq is not None:
+                    lost += (seq - last_seq - 1) & 0xFF
+                last_seq = seq
+                if ftype not in FRAME_TYPES:
+                    continue
+                name, fmt, cols = FRAME_TYPES[ftype]
+                payload = raw[6:-2]
+                if fmt is None:
+                    fmt, cols = vib_layout(payload)
+                if fmt is None or len(payload) != struct.calcsize(fmt):
+                    bad += 1
+                    continue
+                if ftype not in header_done:
+                    print("type,seq,uptime_ms," + ",".join(cols))
+                    header_done.add(ftype)
+                vals = struct.unpack(fmt, payload)
+                print(f"{name},{seq},{uptime}," + ",".join(str(v) for v in vals))
+        except KeyboardInterrupt:
+            pass
+    print(f"# bad frames: {bad}, sequence gaps: {lost}", file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,127 @@
+#!/usr/bin/env python3
+"""Capture a CTF trace of the sensor pipeline on native_sim and summarise it.
+
+Build with the pipeline events and the POSIX tracing backend:
+    west build -b native_sim p13_3.0 -- -DEXTRA_CONF_FILE=trace.conf
+
+This runs zephyr.exe for a stretch of simulated time with the trace going
+to <out>/channel0_0, copies Zephyr's CTF metadata next to it so the
+directory opens as-is in Trace Compass or babeltrace2, then, if babeltrace2
+is installed, pairs the pipeline's _start/_end events into per-stage
+durations and counts enqueues, drops and queue depth.
+
+Usage:
+    trace_stages.py build/zephyr/zephyr.exe --out trace [--seconds 20]
+    trace_stages.py --analyze trace
+"""
+import argparse
+import os
+import re
+import shutil
+import subprocess
+import sys
+from collections import defaultdict
+
+SOURCES = {0: "ht", 1: "press", 2: "imu"}
+# stages whose arg0 is the source
+PER_SOURCE = {"fetch", "merge"}
+
+EVENT = re.compile(r'^\[([0-9.]+)\].*named_event:.*name = "([^"]*)"')
+ARG = re.compile(r'\barg([01]) = (-?\d+)')
+
+
+def capture(exe, out, seconds, zephyr_base, timeout):
+    os.makedirs(out, exist_ok=True)
+    metadata = os.path.join(zephyr_base, "subsys", "tracing", "ctf", "tsdl", "metadata")
+    shutil.copy(metadata, os.path.join(out, "metadata"))
+    cmd = [exe, "--no-rt", "-stop_at=%d" % seconds,
+           "-trace-file=%s" % os.path.join(out, "channel0_0")]
+    subprocess.run(cmd, stdout=subprocess.DEVNULL, stderr=subprocess.STDOUT,
+                   timeout=timeout, check=False)
+
+
+def events(trace_dir):
+    """(time s, name, arg0, arg1) of the pipeline events, in order"""
+    out = subprocess.run(["babeltrace2", "--clock-seconds", trace_dir],
+                         stdout=subprocess.PIPE, check=True, text=True).stdout
+    for line in out.splitlines():
+        m = EVENT.match(line)
+        if not m:
+            continue
+        args = {int(k): int(v) for k, v in ARG.findall(line)}
+        yield float(m.group(1)), m.group(2), args.get(0, 0), args.get(1, 0)
+
+
+def pct(values, p):
+    values = sorted(values)
+    return values[min(len(values) - 1, len(values) * p // 100)]
+
+
+def summarise(trace_dir):
+    open_at = {}
+    spans = defaultdict(list)
+    counts = defaultdict(int)
+    depth = []
+    first = last = None
+
+    for t, name, a0, a1 in events(trace_dir):
+        first = t if first is None else first
+        last = t
+        stage, _, edge = name.rpartition("_")
+        if edge in ("start", "end"):
+            label = stage
+            if stage in PER_SOURCE:
+                label = "%s %s" % (stage, SOURCES.get(a0, a0))
+            if edge == "start":
+                open_at[label] = t
+            elif label in open_at:
+                spans[label].append(1e6 * (t - open_at.pop(label)))
+            continue
+        label = name
+        if name in ("enqueue", "drop"):
+            label = "%s %s" % (name, SOURCES.get(a0, a0))
+        counts[label] += 1
+        if name in ("enqueue", "dequeue"):
+            depth.append(a1)
+
+    if first is None:
+        sys.exit("no pipeline events in %s (CONFIG_APP_TRACE, tracing on?)" % trace_dir)
+    print("%.3f s of trace" % (last - first))
+    print("%-16s %8s %10s %10s %10s" % ("stage", "count", "mean us", "p99 us", "max us"))
+    for label in sorted(spans):
+        v = spans[label]
+        print("%-16s %8d %10.1f %10.1f %10.1f" % (label, len(v), sum(v) / len(v),
+                                                   pct(v, 99), max(v)))
+    for label in sorted(counts):
+        print("%-16s %8d" % (label, counts[label]))
+    if depth:
+        print("queue depth: mean %.1f, max %d" % (sum(depth) / len(depth), max(depth)))
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__,
+                                 formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("exe", nargs="?", help="native_sim zephyr.exe built with trace.conf")
+    ap.add_argument("--out", default="trace", help="trace directory")
+    ap.add_argument("--seconds", type=int, default=20, help="simulated time to run")
+    ap.add_argument("--analyze", metavar="DIR", help="summarise an existing trace only")
+    ap.add_argument("--zephyr-base", default=os.environ.get("ZEPHYR_BASE"))
+    ap.add_argument("--timeout", type=int, default=600, help="seconds of host time")
+    args = ap.parse_args()
+
+    trace_dir = args.analyze
+    if trace_dir is None:
+        if not args.exe or not args.zephyr_base:
+            ap.error("need zephyr.exe and ZEPHYR_BASE (or --analyze)")
+        capture(args.exe, args.out, args.seconds, args.zephyr_base, args.timeout)
+        trace_dir = args.out
+        print("trace in %s/" % trace_dir)
+
+    if shutil.which("babeltrace2") is None:
+        print("babeltrace2 not found; open %s in Trace Compass" % trace_dir)
+        return
+    summarise(trace_dir)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,317 @@
+#include "align.h"
+
+#if defined(CONFIG_APP_ALIGN)
+
+#include <string.h>
+#include <zephyr/kernel.h>
+#include <zephyr/spinlock.h>
+
+#define PERIOD_MS   CONFIG_APP_ALIGN_PERIOD_MS
+#define GRP_CH_MAX  6
+
+#if defined(CONFIG_APP_ALIGN_LINEAR)
+#define MAX_DELAY_MS CONFIG_APP_ALIGN_MAX_DELAY_MS
+/* frames waiting for readings after their time, plus the one being built */
+#define PENDING     (MAX_DELAY_MS / PERIOD_MS + 2)
+#endif
+
+/* -------- Groups -------- */
+
+static const uint8_t grp_n[SNAP_GRP_COUNT] = { 2, 1, 6, 3, 2 };
+static const uint8_t grp_ch[SNAP_GRP_COUNT][GRP_CH_MAX] = {
+    [SNAP_GRP_HT]     = { SNAP_CH_TEMP, SNAP_CH_HUM },
+    [SNAP_GRP_PRESS]  = { SNAP_CH_PRESS },
+    [SNAP_GRP_IMU]    = { SNAP_CH_AX, SNAP_CH_AY, SNAP_CH_AZ, SNAP_CH_GX, SNAP_CH_GY, SNAP_CH_GZ },
+    [SNAP_GRP_ORIENT] = { SNAP_CH_ROLL, SNAP_CH_PITCH, SNAP_CH_YAW },
+    [SNAP_GRP_ALT]    = { SNAP_CH_ALT, SNAP_CH_VZ },
+};
+
+struct sample {
+    uint32_t ts;
+    int32_t v[GRP_CH_MAX];
+};
+
+/* The two newest readings of a group */
+struct history {
+    struct sample prev, cur;
+    uint8_t n;
+};
+
+/* -------- State -------- */
+
+static struct k_spinlock lock;
+static struct history hist[SNAP_GRP_COUNT];
+static uint16_t groups_on;
+static align_emit_t emit_cb;
+static struct k_work_delayable tick_work;
+static int64_t next_ms;             /* time of the next frame */
+static struct align_stats acc;
+
+#if defined(CONFIG_APP_ALIGN_LINEAR)
+struct pending {
+    uint16_t resolved;              /* groups filled in or given up on */
+    struct all_sensors_data f;
+};
+
+static struct pending pend[PENDING];
+static uint32_t pend_head, pend_count;
+#endif
+
+/* a - b on the wrapping uptime */
+static inline int32_t ms_diff(uint32_t a, uint32_t b)
+{
+    return (int32_t)(a - b);
+}
+
+/* -------- Resampling -------- */
+
+static void put(struct all_sensors_data *f, enum snapshot_group g, const struct sample *s,
+                uint32_t ts)
+{
+    for (uint8_t i = 0; i < grp_n[g]; i++) {
+        snapshot_set(f, grp_ch[g][i], s->v[i]);
+    }
+    snapshot_group_ts_set(f, g, ts);
+    f->valid |= SNAP_VALID(g);
+}
+
+/* The latest reading at or before t */
+static const struct sample *at_or_before(const struct history *h, uint32_t t)
+{
+    if (h->n >= 1 && ms_diff(h->cur.ts, t) <= 0) return &h->cur;
+    if (h->n >= 2 && ms_diff(h->prev.ts, t) <= 0) return &h->prev;
+    return NULL;
+}
+
+static void hold(struct all_sensors_data *f, enum snapshot_group g)
+{
+    const struct sample *s = at_or_before(&hist[g], f->timestamp_ms);
+
+    if (s) {
+        put(f, g, s, s->ts);
+        acc.held++;
+    } else {
+        acc.missing++;
+    }
+}
+
+#if defined(CONFIG_APP_ALIGN_LINEAR)
+static int32_t lerp(enum snapshot_channel ch, int32_t a, int32_t b, int32_t num, int32_t den)
+{
+    int32_t d = b - a;
+
+    if (ch == SNAP_CH_ROLL || ch == SNAP_CH_YAW) {
+        /* +-180 deg: across the seam the short way is the other one */
+        if (d > 18000) d -= 36000;
+        if (d < -18000) d += 36000;
+        int32_t v = a + (int32_t)((int64_t)d * num / den);
+        if (v > 18000) v -= 36000;
+        if (v <= -18000) v += 36000;
+        return v;
+    }
+    return a + (int32_t)((int64_t)d * num / den);
+}
+
+static void interpolate(struct all_sensors_data *f, enum snapshot_group g,
+                        const struct sample *a, const struct sample *b)
+{
+    struct sample s = { .ts = f->timestamp_ms };
+    int32_t den = ms_diff(b->ts, a->ts);
+    int32_t num = ms_diff(f->timestamp_ms, a->ts);
+
+    for (uint8_t i = 0; i < grp_n[g]; i++) {
+        s.v[i] = den ? lerp(grp_ch[g][i], a->v[i], b->v[i], num, den) : b->v[i];
+    }
+    put(f, g, &s, f->timestamp_ms);
+    acc.interpolated++;
+}
+
+/* A new reading s of group g resolves the frames it brackets */
+static void resolve(enum snapshot_group g, const struct sample *s)
+{
+    const struct history *h = &hist[g];
+
+    for (uint32_t i = 0; i < pend_count; i++) {
+        struct pending *p = &pend[(pend_head + i) % PENDING];
+
+        if (p->resolved & SNAP_VALID(g)) continue;
+        if (ms_diff(s->ts, p->f.timestamp_ms) < 0) continue;
+
+        if (h->n && ms_diff(h->cur.ts, p->f.timestamp_ms) <= 0) {
+            interpolate(&p->f, g, &h->cur, s);
+        } else {
+            /* first reading came after the frame time */
+            acc.missing++;
+        }
+        p->resolved |= SNAP_VALID(g);
+    }
+}
+
+/* Oldest frame if it is complete, overdue or forced out; caller holds lock */
+static bool pop_ready(struct all_sensors_data *out, int64_t now, bool force)
+{
+    if (pend_count == 0) return false;
+
+    struct pending *p = &pend[pend_head];
+    bool done = (p->resolved & groups_on) == groups_on;
+    bool late = now - (int64_t)p->f.timestamp_ms >= MAX_DELAY_MS;
+
+    if (!done && !late && !force) return false;
+
+    for (int g = 0; g < SNAP_GRP_COUNT; g++) {
+        if ((groups_on & ~p->resolved) & SNAP_VALID(g)) {
+            hold(&p->f, g);
+        }
+    }
+    *out = p->f;
+    pend_head = (pend_head + 1) % PENDING;
+    pend_count--;
+    return true;
+}
+#endif
+
+/* -------- Frames -------- */
+
+static void account_emit(const struct all_sensors_data *f, int64_t now)
+{
+    uint32_t lat = (uint32_t)(now - (int64_t)f->timestamp_ms);
+
+    acc.frames++;
+    acc.latency_total_ms += lat;
+    acc.latency_max_ms = MAX(acc.latency_max_ms, lat);
+}
+
+static void tick(struct k_work *work)
+{
+    struct all_sensors_data f;
+    int64_t now = k_uptime_get();
+    k_spinlock_key_t key = k_spin_lock(&lock);
+
+    memset(&f, 0, sizeof(f));
+    f.timestamp_ms = (uint32_t)next_ms;
+    next_ms += PERIOD_MS;
+
+#if defined(CONFIG_APP_ALIGN_LINEAR)
+    bool force = pend_count == PENDING;
+    if (force) {
+        struct all_sensors_data old;
+        if (pop_ready(&old, now, true)) {
+            acc.forced++;
+            account_emit(&old, now);
+            k_spin_unlock(&lock, key);
+            emit_cb(&old);
+            key = k_spin_lock(&lock);
+        }
+    }
+
+    struct pending *p = &pend[(pend_head + pend_count) % PENDING];
+    p->f = f;
+    p->resolved = 0;
+    pend_count++;
+    acc.pending_max = MAX(acc.pending_max, pend_count);
+
+    /* a late tick may find both readings already in */
+    for (int g = 0; g < SNAP_GRP_COUNT; g++) {
+        const struct history *h = &hist[g];
+
+        if (!(groups_on & SNAP_VALID(g)) || h->n < 2) continue;
+        if (ms_diff(h->prev.ts, f.timestamp_ms) <= 0 && ms_diff(h->cur.ts, f.timestamp_ms) >= 0) {
+            interpolate(&p->f, g, &h->prev, &h->cur);
+            p->resolved |= SNAP_VALID(g);
+        }
+    }
+
+    while (pop_ready(&f, now, false)) {
+        account_emit(&f, now);
+        k_spin_unlock(&lock, key);
+        emit_cb(&f);
+        key = k_spin_lock(&lock);
+    }
+#else
+    for (int g = 0; g < SNAP_GRP_COUNT; g++) {
+        if (groups_on & SNAP_VALID(g)) {
+            hold(&f, g);
+        }
+    }
+    account_emit(&f, now);
+    k_spin_unlock(&lock, key);
+    emit_cb(&f);
+    key = k_spin_lock(&lock);
+#endif
+
+    /* skip frames the work queue was too late for */
+    if (next_ms <= now) {
+        next_ms = (now / PERIOD_MS + 1) * PERIOD_MS;
+    }
+    int64_t next = next_ms;
+    k_spin_unlock(&lock, key);
+
+    k_work_schedule(k_work_delayable_from_work(work), K_TIMEOUT_ABS_MS(next));
+}
+
+/* -------- API -------- */
+
+void align_init(align_emit_t emit)
+{
+    emit_cb = emit;
+    groups_on = SNAP_VALID(SNAP_GRP_HT) | SNAP_VALID(SNAP_GRP_PRESS);
+#if !defined(CONFIG_APP_VIB_FEATURES_ONLY)
+    groups_on |= SNAP_VALID(SNAP_GRP_IMU);
+#if defined(CONFIG_APP_FUSION)
+    groups_on |= SNAP_VALID(SNAP_GRP_ORIENT);
+#endif
+#endif
+#if defined(CONFIG_APP_BARO_ALT)
+    groups_on |= SNAP_VALID(SNAP_GRP_ALT);
+#endif
+
+    next_ms = (k_uptime_get() / PERIOD_MS + 1) * PERIOD_MS;
+    k_work_init_delayable(&tick_work, tick);
+    k_work_schedule(&tick_work, K_TIMEOUT_ABS_MS(next_ms));
+}
+
+void align_push(const struct all_sensors_data *snap, uint16_t groups)
+{
+    uint32_t t0 = k_cycle_get_32();
+    k_spinlock_key_t key = k_spin_lock(&lock);
+
+    groups &= groups_on & snap->valid;
+    for (int g = 0; g < SNAP_GRP_COUNT; g++) {
+        if (!(groups & SNAP_VALID(g))) continue;
+
+        struct history *h = &hist[g];
+        struct sample s = { .ts = snapshot_group_ts(snap, g) };
+
+        for (uint8_t i = 0; i < grp_n[g]; i++) {
+            s.v[i] = snapshot_get(snap, grp_ch[g][i]);
+        }
+#if defined(CONFIG_APP_ALIGN_LINEAR)
+        resolve(g, &s);
+#endif
+        h->prev = h->cur;
+        h->cur = s;
+        if (h->n < 2) h->n++;
+    }
+
+    uint32_t cyc = k_cycle_get_32() - t0;
+    acc.pushes++;
+    acc.push_cycles_total += cyc;
+    acc.push_cycles_max = MAX(acc.push_cycles_max, cyc);
+    k_spin_unlock(&lock, key);
+}
+
+void align_stats_get(struct align_stats *st)
+{
+    k_spinlock_key_t key = k_spin_lock(&lock);
+    *st = acc;
+    k_spin_unlock(&lock, key);
+}
+
+void align_stats_reset(void)
+{
+    k_spinlock_key_t key = k_spin_lock(&lock);
+    memset(&acc, 0, sizeof(acc));
+    k_spin_unlock(&lock, key);
+}
+
+#endif /* CONFIG_APP_ALIGN */
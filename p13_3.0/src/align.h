@@ -0,0 +1,47 @@
+#ifndef ALIGN_H
+#define ALIGN_H
+
+#include <stdint.h>
+
+#include "sensors_common.h"
+
+/*
+ * Time-aligned snapshots (CONFIG_APP_ALIGN). The producers hand every
+ * merged snapshot to align_push() with the groups they updated; at
+ * each multiple of CONFIG_APP_ALIGN_PERIOD_MS a frame is built with
+ * every group's value at that instant, from the readings already taken:
+ *
+ *   linear  interpolated between the readings either side of the frame
+ *           time. The frame waits for each group's next reading, at most
+ *           CONFIG_APP_ALIGN_MAX_DELAY_MS, then holds the groups still
+ *           missing one. Roll and yaw take the short way round.
+ *   hold    the latest reading at or before the frame time, at once.
+ *
+ * An interpolated group is stamped with the frame time, a held one
+ * keeps its acquisition time; a group with no reading before the frame
+ * time is left out of the valid mask. Frames leave in time order
+ * through the emit callback, on the system work queue.
+ */
+typedef void (*align_emit_t)(const struct all_sensors_data *frame);
+
+struct align_stats {
+    uint32_t frames;
+    uint32_t interpolated;          /* group values */
+    uint32_t held;
+    uint32_t missing;               /* no reading at or before the frame time */
+    uint32_t forced;                /* frames emitted early, pending ring full */
+    uint32_t latency_max_ms;        /* frame time to emit */
+    uint64_t latency_total_ms;
+    uint32_t push_cycles_max;
+    uint64_t push_cycles_total;
+    uint32_t pushes;
+    uint32_t pending_max;
+};
+
+void align_init(align_emit_t emit);
+/* groups: SNAP_VALID() bits of the groups this merge updated */
+void align_push(const struct all_sensors_data *snap, uint16_t groups);
+void align_stats_get(struct align_stats *st);
+void align_stats_reset(void);
+
+#endif /* ALIGN_H */
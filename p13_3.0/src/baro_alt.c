@@ -0,0 +1,323 @@
+#include "baro_alt.h"
+#include <zephyr/kernel.h>
+#include <math.h>
+#include <string.h>
+
+#if defined(CONFIG_APP_BARO_ALT)
+
+#define US_PER_S        1000000
+#define DT_MAX_US       2000000u    /* longer gaps are treated as this */
+#define BIAS_TAU_US     60000000    /* vertical accel mean: 60 s */
+#define Q16_ONE         65536
+#define Q30_ONE         (1 << 30)
+
+/* Self test: synthetic vertical motion */
+#define TEST_SECONDS    60
+#define TEST_SETTLE_S   10
+#define TEST_ACCEL_US   10000       /* 100 Hz */
+#define TEST_BARO_EVERY 50          /* accel samples per pressure sample: 2 Hz */
+#define TEST_AMPL_CM    300
+#define TEST_PERIOD_S   20
+#define TEST_BARO_NOISE 25          /* +-cm, about +-3 Pa */
+#define TEST_ACC_NOISE  3           /* +-0.03 m/s^2 */
+#define TEST_ACC_BIAS   7
+
+/* Generated by scripts/gen_baro_lut.py; worst interpolation error 5.1 cm */
+#define LUT_MIN_PA   29952
+#define LUT_STEP_LOG2 8
+#define LUT_LEN      314
+static const int32_t alt_lut_cm[LUT_LEN] = {
+    917466, 911769, 906110, 900490, 894908, 889363, 883855, 878383,
+    872946, 867545, 862178, 856845, 851546, 846280, 841047, 835846,
+    830677, 825539, 820432, 815356, 810310, 805293, 800306, 795348,
+    790419, 785517, 780644, 775798, 770979, 766187, 761422, 756683,
+    751969, 747282, 742619, 737981, 733368, 728780, 724215, 719674,
+    715157, 710663, 706192, 701744, 697318, 692914, 688532, 684172,
+    679834, 675516, 671220, 666944, 662690, 658455, 654240, 650046,
+    645871, 641715, 637579, 633462, 629364, 625285, 621224, 617181,
+    613157, 609150, 605162, 601191, 597237, 593301, 589382, 585479,
+    581594, 577725, 573872, 570036, 566216, 562412, 558624, 554851,
+    551094, 547353, 543626, 539915, 536219, 532538, 528871, 525219,
+    521582, 517959, 514350, 510755, 507174, 503607, 500054, 496514,
+    492988, 489475, 485975, 482489, 479016, 475555, 472108, 468673,
+    465250, 461841, 458443, 455058, 451686, 448325, 444976, 441639,
+    438315, 435001, 431700, 428410, 425131, 421864, 418608, 415364,
+    412130, 408908, 405696, 402496, 399306, 396126, 392958, 389800,
+    386652, 383515, 380388, 377271, 374165, 371068, 367982, 364906,
+    361839, 358782, 355735, 352698, 349670, 346652, 343643, 340643,
+    337653, 334672, 331701, 328738, 325785, 322840, 319905, 316978,
+    314060, 311151, 308251, 305360, 302477, 299602, 296736, 293878,
+    291029, 288188, 285356, 282531, 279715, 276907, 274107, 271315,
+    268530, 265754, 262986, 260225, 257472, 254727, 251990, 249260,
+    246537, 243823, 241115, 238415, 235723, 233037, 230359, 227689,
+    225025, 222369, 219720, 217077, 214442, 211814, 209193, 206579,
+    203971, 201371, 198777, 196190, 193609, 191036, 188469, 185908,
+    183354, 180807, 178266, 175731, 173203, 170681, 168166, 165657,
+    163154, 160657, 158167, 155683, 153205, 150733, 148267, 145807,
+    143353, 140905, 138463, 136026, 133596, 131172, 128753, 126340,
+    123933, 121531, 119136, 116745, 114361, 111982, 109609, 107241,
+    104879, 102522, 100170, 97824, 95484, 93148, 90819, 88494,
+    86175, 83861, 81552, 79248, 76950, 74656, 72368, 70085,
+    67807, 65534, 63266, 61003, 58745, 56492, 54244, 52001,
+    49763, 47529, 45301, 43077, 40858, 38643, 36434, 34229,
+    32029, 29834, 27643, 25457, 23275, 21098, 18926, 16758,
+    14594, 12435, 10281, 8131, 5986, 3845, 1708, -424,
+    -2552, -4676, -6795, -8910, -11021, -13128, -15230, -17328,
+    -19422, -21511, -23597, -25678, -27755, -29828, -31897, -33962,
+    -36023, -38080, -40133, -42182, -44226, -46267, -48304, -50337,
+    -52366, -54391, -56413, -58430, -60444, -62453, -64459, -66461,
+    -68460, -70454,
+};
+
+/* -------- Altitude table -------- */
+
+int32_t baro_alt_from_pa(int32_t pa)
+{
+    const int32_t max_pa = LUT_MIN_PA + ((LUT_LEN - 1) << LUT_STEP_LOG2);
+
+    if (pa <= LUT_MIN_PA) return alt_lut_cm[0];
+    if (pa >= max_pa) return alt_lut_cm[LUT_LEN - 1];
+
+    int32_t off = pa - LUT_MIN_PA;
+    int32_t i = off >> LUT_STEP_LOG2;
+    int32_t frac = off & ((1 << LUT_STEP_LOG2) - 1);
+
+    return alt_lut_cm[i] + (((alt_lut_cm[i + 1] - alt_lut_cm[i]) * frac) >> LUT_STEP_LOG2);
+}
+
+/* -------- Vertical acceleration -------- */
+
+int32_t baro_alt_vertical(const int16_t acc[3], const int32_t q[4])
+{
+    if (!q) return acc[2];
+
+    int64_t w = q[0], x = q[1], y = q[2], z = q[3];
+
+    /* third row of the body-to-world rotation, Q1.30 */
+    int64_t r0 = 2 * ((x * z - w * y) >> 30);
+    int64_t r1 = 2 * ((y * z + w * x) >> 30);
+    int64_t r2 = (w * w - x * x - y * y + z * z) >> 30;
+
+    return (int32_t)((r0 * acc[0] + r1 * acc[1] + r2 * acc[2]) >> 30);
+}
+
+/* -------- Filter -------- */
+
+void alt_filter_init(struct alt_filter *f, uint32_t tau_ms)
+{
+    memset(f, 0, sizeof(*f));
+    f->w_q16 = (uint32_t)((uint64_t)Q16_ONE * 1000 / MAX(tau_ms, 1u));
+}
+
+void alt_filter_accel(struct alt_filter *f, int32_t az, uint32_t dt_us)
+{
+    int64_t az_q16 = (int64_t)az << 16;
+
+    dt_us = MIN(dt_us, DT_MAX_US);
+    if (!f->have_accel) {
+        f->g_q16 = az_q16;
+        f->have_accel = true;
+    }
+    /* over minutes vertical acceleration averages to zero; what is left
+     * is gravity plus the sensor's offset along the vertical
+     */
+    f->g_q16 += (az_q16 - f->g_q16) * dt_us / BIAS_TAU_US;
+    if (!f->have_baro) return;
+
+    /* 0.01 m/s^2 -> um/s^2 */
+    int64_t a = (az_q16 - f->g_q16) * 10000 / Q16_ONE;
+
+    f->h_um += f->v_ums * dt_us / US_PER_S + (a * dt_us / US_PER_S) * dt_us / (2 * US_PER_S);
+    f->v_ums += a * dt_us / US_PER_S;
+    f->predicted = true;
+}
+
+void alt_filter_baro(struct alt_filter *f, int32_t alt_cm, uint32_t dt_us)
+{
+    int64_t hb = (int64_t)alt_cm * 10000;
+
+    if (!f->have_baro) {
+        f->h_um = hb;
+        f->v_ums = 0;
+        f->have_baro = true;
+        return;
+    }
+
+    dt_us = MIN(dt_us, DT_MAX_US);
+    if (!f->predicted) {
+        /* no accel since the last sample: constant-speed prediction */
+        f->h_um += f->v_ums * dt_us / US_PER_S;
+    }
+    f->predicted = false;
+
+    /* gains of the critically damped complementary filter, k1 = 2/tau and
+     * k2 = 1/tau^2, applied over the interval since the last correction
+     */
+    int64_t e = hb - f->h_um;
+    int64_t k1 = MIN((int64_t)2 * f->w_q16 * dt_us / US_PER_S, (int64_t)Q16_ONE);
+    int64_t k2 = ((int64_t)f->w_q16 * f->w_q16 / Q16_ONE) * dt_us / US_PER_S;
+
+    f->h_um += e * k1 / Q16_ONE;
+    f->v_ums += e * k2 / Q16_ONE;
+}
+
+/* -------- Live instance -------- */
+
+static struct k_spinlock alt_lock;
+static struct alt_filter live;
+static struct baro_alt_stats stats;
+static int32_t last_baro_cm;
+static uint32_t last_baro_ms;
+
+void baro_alt_init(void)
+{
+    k_spinlock_key_t key = k_spin_lock(&alt_lock);
+    alt_filter_init(&live, CONFIG_APP_BARO_ALT_TAU_MS);
+    memset(&stats, 0, sizeof(stats));
+    last_baro_cm = 0;
+    last_baro_ms = 0;
+    k_spin_unlock(&alt_lock, key);
+}
+
+void baro_alt_pressure(int32_t pa, uint32_t ts_ms)
+{
+    uint32_t t0 = k_cycle_get_32();
+    int32_t alt = baro_alt_from_pa(pa);
+
+    k_spinlock_key_t key = k_spin_lock(&alt_lock);
+    alt_filter_baro(&live, alt, (ts_ms - last_baro_ms) * 1000u);
+    last_baro_cm = alt;
+    last_baro_ms = ts_ms;
+    uint32_t cyc = k_cycle_get_32() - t0;
+    stats.baro_updates++;
+    stats.baro_cycles_max = MAX(stats.baro_cycles_max, cyc);
+    stats.baro_cycles_total += cyc;
+    k_spin_unlock(&alt_lock, key);
+}
+
+void baro_alt_accel(const int16_t acc[3], const int32_t q[4], uint32_t dt_us)
+{
+    uint32_t t0 = k_cycle_get_32();
+    int32_t az = baro_alt_vertical(acc, q);
+
+    k_spinlock_key_t key = k_spin_lock(&alt_lock);
+    alt_filter_accel(&live, az, dt_us);
+    uint32_t cyc = k_cycle_get_32() - t0;
+    stats.accel_updates++;
+    stats.accel_cycles_max = MAX(stats.accel_cycles_max, cyc);
+    stats.accel_cycles_total += cyc;
+    k_spin_unlock(&alt_lock, key);
+}
+
+bool baro_alt_get(struct baro_alt_out *out)
+{
+    k_spinlock_key_t key = k_spin_lock(&alt_lock);
+    bool ok = live.have_baro;
+    int64_t v = live.v_ums / 10000;
+
+    out->altitude = (int32_t)(live.h_um / 10000);
+    out->baro_altitude = last_baro_cm;
+    out->vspeed = (int16_t)CLAMP(v, INT16_MIN, INT16_MAX);
+    k_spin_unlock(&alt_lock, key);
+    return ok;
+}
+
+void baro_alt_stats_get(struct baro_alt_stats *st)
+{
+    k_spinlock_key_t key = k_spin_lock(&alt_lock);
+    *st = stats;
+    k_spin_unlock(&alt_lock, key);
+}
+
+/* -------- Self test (shell thread) -------- */
+
+static volatile int32_t test_sink;
+static volatile double test_sink_d;
+
+static int32_t noise(uint32_t *seed, int32_t ampl)
+{
+    *seed = *seed * 1103515245u + 12345u;
+    return (int32_t)((*seed >> 16) % (2 * ampl + 1)) - ampl;
+}
+
+static void test_lut(struct baro_alt_test *out)
+{
+    uint32_t n = 0, max_err = 0;
+    uint32_t t0, c_lut = 0, c_pow = 0;
+
+    for (int32_t pa = 30000; pa <= 110000; pa += 37, n++) {
+        t0 = k_cycle_get_32();
+        int32_t h = baro_alt_from_pa(pa);
+        c_lut += k_cycle_get_32() - t0;
+
+        t0 = k_cycle_get_32();
+        double ref_mm = 44330.77e3 * (1.0 - pow(pa / 101325.0, 0.190263));
+        c_pow += k_cycle_get_32() - t0;
+
+        test_sink = h;
+        test_sink_d = ref_mm;
+        uint32_t err = (uint32_t)lrint(fabs(h * 10.0 - ref_mm));
+        max_err = MAX(max_err, err);
+    }
+
+    out->lut_points = n;
+    out->lut_max_err_mm = max_err;
+    out->lut_cycles = c_lut / n;
+    out->pow_cycles = c_pow / n;
+}
+
+static void test_filter(struct baro_alt_test *out)
+{
+    static struct alt_filter f;
+    const float w = 2.0f * 3.14159265f / TEST_PERIOD_S;
+    uint32_t seed = 1;
+    int32_t prev_baro = 0;
+    uint64_t e_vf = 0, e_vb = 0, e_hf = 0, e_hb = 0;
+    uint32_t n = 0;
+
+    alt_filter_init(&f, CONFIG_APP_BARO_ALT_TAU_MS);
+
+    for (uint32_t i = 0; i < TEST_SECONDS * (US_PER_S / TEST_ACCEL_US); i++) {
+        float t = (float)i * TEST_ACCEL_US / US_PER_S;
+        int32_t h_true = (int32_t)lrintf(TEST_AMPL_CM * sinf(w * t));
+        int32_t v_true = (int32_t)lrintf(TEST_AMPL_CM * w * cosf(w * t) * 10.0f);   /* mm/s */
+        int32_t a_true = (int32_t)lrintf(-TEST_AMPL_CM * w * w * sinf(w * t));      /* cm/s^2 */
+
+        alt_filter_accel(&f, 981 + TEST_ACC_BIAS + a_true + noise(&seed, TEST_ACC_NOISE),
+                         TEST_ACCEL_US);
+        if (i % TEST_BARO_EVERY) continue;
+
+        int32_t baro = h_true + noise(&seed, TEST_BARO_NOISE);
+        alt_filter_baro(&f, baro, TEST_BARO_EVERY * TEST_ACCEL_US);
+
+        /* what a host does with the raw stream: difference consecutive samples */
+        int32_t v_baro = (baro - prev_baro) * 10 * US_PER_S / (TEST_BARO_EVERY * TEST_ACCEL_US);
+        prev_baro = baro;
+        if (t < TEST_SETTLE_S) continue;
+
+        int64_t dvf = f.v_ums / 1000 - v_true;
+        int64_t dvb = v_baro - v_true;
+        int64_t dhf = f.h_um / 1000 - h_true * 10;
+        int64_t dhb = (baro - h_true) * 10;
+        e_vf += dvf * dvf;
+        e_vb += dvb * dvb;
+        e_hf += dhf * dhf;
+        e_hb += dhb * dhb;
+        n++;
+    }
+
+    out->vs_rms_fused_mms = (uint32_t)lrint(sqrt((double)e_vf / n));
+    out->vs_rms_baro_mms = (uint32_t)lrint(sqrt((double)e_vb / n));
+    out->alt_rms_fused_mm = (uint32_t)lrint(sqrt((double)e_hf / n));
+    out->alt_rms_baro_mm = (uint32_t)lrint(sqrt((double)e_hb / n));
+}
+
+int baro_alt_selftest(struct baro_alt_test *out)
+{
+    memset(out, 0, sizeof(*out));
+    test_lut(out);
+    test_filter(out);
+    return 0;
+}
+
+#endif /* CONFIG_APP_BARO_ALT */
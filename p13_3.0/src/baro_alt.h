@@ -0,0 +1,81 @@
+#ifndef BARO_ALT_H
+#define BARO_ALT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Derived vertical channels: barometric altitude and vertical speed.
+ * Altitude comes from an integer table of the ISA barometric formula
+ * (scripts/gen_baro_lut.py) with linear interpolation. A two-state
+ * complementary filter (a steady-state Kalman filter for altitude and
+ * vertical speed) integrates vertical acceleration between pressure
+ * samples and is pulled towards the barometric altitude at each one.
+ * All filter arithmetic is integer: um, um/s, Q16 gains.
+ */
+
+/* ISA altitude for a pressure in Pa, cm; clamped to 300..1100 hPa */
+int32_t baro_alt_from_pa(int32_t pa);
+
+/* Vertical (world z) component of a body-frame accel sample, 0.01 m/s^2.
+ * q is the fusion quaternion in Q1.30 (w, x, y, z); NULL assumes the
+ * board is level with +z up.
+ */
+int32_t baro_alt_vertical(const int16_t acc[3], const int32_t q[4]);
+
+struct alt_filter {
+    int64_t h_um;           /* altitude */
+    int64_t v_ums;          /* vertical speed */
+    int64_t g_q16;          /* running mean of vertical accel (gravity + bias), 0.01 m/s^2 << 16 */
+    uint32_t w_q16;         /* crossover 1/tau, Q16 per second */
+    bool have_baro;
+    bool have_accel;
+    bool predicted;         /* accel integrated since the last correction */
+};
+
+void alt_filter_init(struct alt_filter *f, uint32_t tau_ms);
+/* Predict: vertical accel incl. gravity, 0.01 m/s^2, over dt_us */
+void alt_filter_accel(struct alt_filter *f, int32_t az, uint32_t dt_us);
+/* Correct: barometric altitude in cm, dt_us since the previous one */
+void alt_filter_baro(struct alt_filter *f, int32_t alt_cm, uint32_t dt_us);
+
+/* -------- Live instance, fed by the pressure and IMU threads -------- */
+
+struct baro_alt_out {
+    int32_t altitude;       /* filtered, cm */
+    int32_t baro_altitude;  /* table only, cm */
+    int16_t vspeed;         /* cm/s */
+};
+
+struct baro_alt_stats {
+    uint32_t baro_updates;
+    uint32_t accel_updates;
+    uint32_t baro_cycles_max;   /* table lookup + correction */
+    uint32_t accel_cycles_max;  /* rotation + prediction */
+    uint64_t baro_cycles_total;
+    uint64_t accel_cycles_total;
+};
+
+struct baro_alt_test {
+    /* table against the double-precision formula over 300..1100 hPa */
+    uint32_t lut_points;
+    uint32_t lut_max_err_mm;
+    uint32_t lut_cycles;        /* per call */
+    uint32_t pow_cycles;        /* per call of the reference */
+    /* synthetic 60 s climb/descent, 2 Hz pressure with noise, 100 Hz accel */
+    uint32_t vs_rms_fused_mms;  /* vertical speed error of the filter */
+    uint32_t vs_rms_baro_mms;   /* differencing the pressure altitude instead */
+    uint32_t alt_rms_fused_mm;
+    uint32_t alt_rms_baro_mm;
+};
+
+void baro_alt_init(void);
+void baro_alt_pressure(int32_t pa, uint32_t ts_ms);
+void baro_alt_accel(const int16_t acc[3], const int32_t q[4], uint32_t dt_us);
+/* false until the first pressure sample */
+bool baro_alt_get(struct baro_alt_out *out);
+void baro_alt_stats_get(struct baro_alt_stats *st);
+/* Private filter instance; live state is untouched */
+int baro_alt_selftest(struct baro_alt_test *out);
+
+#endif /* BARO_ALT_H */
@@ -0,0 +1,274 @@
+#include "compress.h"
+#include <errno.h>
+#include <string.h>
+
+/* Always built on the host (scripts/compress_replay.c) */
+#if defined(CONFIG_APP_COMPRESS) || !defined(__ZEPHYR__)
+
+/* Slope as a fraction num/den with den (a time delta in ms) > 0 */
+struct slope {
+    int64_t num;
+    int64_t den;
+};
+
+struct sdt_chan {
+    int32_t origin;     /* value recorded at origin_ms */
+    struct slope up;    /* door upper bound */
+    struct slope lo;    /* door lower bound */
+};
+
+static struct {
+    enum compress_mode mode;
+    uint32_t heartbeat_ms;
+    struct compress_band band[SNAP_CH_COUNT];
+
+    bool started;       /* a first record has been written */
+    uint32_t origin_ms; /* time of the last written record */
+    struct all_sensors_data ref;    /* last written record */
+
+    /* SDT only */
+    bool have_prev;
+    struct all_sensors_data prev;
+    struct sdt_chan sdt[SNAP_CH_COUNT];
+
+    struct compress_stats stats;
+} cz = {
+    .band = {
+        [SNAP_CH_TEMP]  = { 5, 0 },     /* 0.05 degC */
+        [SNAP_CH_HUM]   = { 20, 0 },    /* 0.2 %RH */
+        [SNAP_CH_PRESS] = { 5, 0 },     /* 5 Pa */
+        [SNAP_CH_AX]    = { 5, 0 },     /* 0.05 m/s^2 */
+        [SNAP_CH_AY]    = { 5, 0 },
+        [SNAP_CH_AZ]    = { 5, 0 },
+        [SNAP_CH_GX]    = { 2, 0 },     /* 0.02 rad/s */
+        [SNAP_CH_GY]    = { 2, 0 },
+        [SNAP_CH_GZ]    = { 2, 0 },
+        [SNAP_CH_ROLL]  = { 50, 0 },    /* 0.5 deg */
+        [SNAP_CH_PITCH] = { 50, 0 },
+        [SNAP_CH_YAW]   = { 50, 0 },
+        [SNAP_CH_ALT]   = { 50, 0 },    /* 0.5 m */
+        [SNAP_CH_VZ]    = { 10, 0 },    /* 0.1 m/s */
+    },
+};
+
+static int32_t band_of(enum snapshot_channel ch, int32_t ref)
+{
+    int64_t mag = ref < 0 ? -(int64_t)ref : ref;
+    int64_t rel = mag * cz.band[ch].rel_permille / 1000;
+
+    return (int32_t)(rel > cz.band[ch].abs ? rel : cz.band[ch].abs);
+}
+
+/* a < b for fractions with positive denominators */
+static bool slope_lt(struct slope a, struct slope b)
+{
+    return a.num * b.den < b.num * a.den;
+}
+
+static int64_t floor_div(int64_t n, int64_t d)
+{
+    return (n >= 0) ? n / d : -((-n + d - 1) / d);
+}
+
+static int64_t ceil_div(int64_t n, int64_t d)
+{
+    return -floor_div(-n, d);
+}
+
+static uint32_t dt_since_origin(uint32_t t)
+{
+    uint32_t dt = t - cz.origin_ms;
+    return dt ? dt : 1;     /* two producers can merge in the same ms */
+}
+
+static void restart(const struct all_sensors_data *rec)
+{
+    cz.started = true;
+    cz.origin_ms = rec->timestamp_ms;
+    cz.ref = *rec;
+    cz.have_prev = false;
+    for (int ch = 0; ch < SNAP_CH_COUNT; ch++) {
+        cz.sdt[ch].origin = snapshot_get(rec, ch);
+    }
+}
+
+static bool deadband_feed(const struct all_sensors_data *in, struct all_sensors_data *out)
+{
+    bool emit = false;
+
+    for (int ch = 0; ch < SNAP_CH_COUNT; ch++) {
+        int32_t ref = snapshot_get(&cz.ref, ch);
+        int64_t diff = (int64_t)snapshot_get(in, ch) - ref;
+
+        if (diff > band_of(ch, ref) || -diff > band_of(ch, ref)) {
+            cz.stats.triggers[ch]++;
+            emit = true;
+        }
+    }
+    if (!emit && in->timestamp_ms - cz.origin_ms >= cz.heartbeat_ms) {
+        cz.stats.heartbeats++;
+        emit = true;
+    }
+    if (emit) {
+        *out = *in;
+        restart(in);
+    }
+    return emit;
+}
+
+/* Door bounds of channel ch after also covering value v at dt */
+static void sdt_bounds(int ch, int32_t v, uint32_t dt, struct slope *up, struct slope *lo)
+{
+    const struct sdt_chan *c = &cz.sdt[ch];
+    int32_t e = band_of(ch, c->origin);
+
+    up->num = (int64_t)v + e - c->origin;
+    up->den = dt;
+    lo->num = (int64_t)v - e - c->origin;
+    lo->den = dt;
+}
+
+/* Record prev, snapped onto a line that is inside every channel's door */
+static void sdt_close(struct all_sensors_data *out)
+{
+    int64_t dt = dt_since_origin(cz.prev.timestamp_ms);
+
+    *out = cz.prev;
+    for (int ch = 0; ch < SNAP_CH_COUNT; ch++) {
+        const struct sdt_chan *c = &cz.sdt[ch];
+        int64_t lo = c->origin + ceil_div(c->lo.num * dt, c->lo.den);
+        int64_t hi = c->origin + floor_div(c->up.num * dt, c->up.den);
+        int64_t v = snapshot_get(&cz.prev, ch);
+
+        /* keep the real value whenever it already lies on a valid line */
+        if (lo <= hi) {
+            v = v < lo ? lo : (v > hi ? hi : v);
+        }
+        snapshot_set(out, ch, (int32_t)v);
+    }
+    restart(out);
+}
+
+static void sdt_open(const struct all_sensors_data *in)
+{
+    uint32_t dt = dt_since_origin(in->timestamp_ms);
+
+    for (int ch = 0; ch < SNAP_CH_COUNT; ch++) {
+        sdt_bounds(ch, snapshot_get(in, ch), dt, &cz.sdt[ch].up, &cz.sdt[ch].lo);
+    }
+    cz.prev = *in;
+    cz.have_prev = true;
+}
+
+static bool sdt_feed(const struct all_sensors_data *in, struct all_sensors_data *out)
+{
+    if (!cz.have_prev) {
+        sdt_open(in);
+        return false;
+    }
+
+    uint32_t dt = dt_since_origin(in->timestamp_ms);
+    struct slope up[SNAP_CH_COUNT], lo[SNAP_CH_COUNT];
+    bool close = false;
+
+    for (int ch = 0; ch < SNAP_CH_COUNT; ch++) {
+        sdt_bounds(ch, snapshot_get(in, ch), dt, &up[ch], &lo[ch]);
+        if (slope_lt(cz.sdt[ch].up, up[ch])) up[ch] = cz.sdt[ch].up;
+        if (slope_lt(lo[ch], cz.sdt[ch].lo)) lo[ch] = cz.sdt[ch].lo;
+        if (slope_lt(up[ch], lo[ch])) {
+            cz.stats.triggers[ch]++;
+            close = true;
+        }
+    }
+    if (!close && in->timestamp_ms - cz.origin_ms >= cz.heartbeat_ms) {
+        cz.stats.heartbeats++;
+        close = true;
+    }
+
+    if (close) {
+        sdt_close(out);
+        sdt_open(in);
+        return true;
+    }
+
+    for (int ch = 0; ch < SNAP_CH_COUNT; ch++) {
+        cz.sdt[ch].up = up[ch];
+        cz.sdt[ch].lo = lo[ch];
+    }
+    cz.prev = *in;
+    return false;
+}
+
+void compress_init(enum compress_mode mode, uint32_t heartbeat_ms)
+{
+    cz.heartbeat_ms = heartbeat_ms;
+    memset(&cz.stats, 0, sizeof(cz.stats));
+    compress_set_mode(mode);
+}
+
+void compress_set_mode(enum compress_mode mode)
+{
+    cz.mode = mode;
+    cz.started = false;
+    cz.have_prev = false;
+}
+
+enum compress_mode compress_get_mode(void)
+{
+    return cz.mode;
+}
+
+int compress_set_band(enum snapshot_channel ch, const struct compress_band *band)
+{
+    if (ch >= SNAP_CH_COUNT || band->abs < 0) return -EINVAL;
+
+    cz.band[ch] = *band;
+    cz.started = false;
+    cz.have_prev = false;
+    return 0;
+}
+
+int compress_get_band(enum snapshot_channel ch, struct compress_band *band)
+{
+    if (ch >= SNAP_CH_COUNT) return -EINVAL;
+
+    *band = cz.band[ch];
+    return 0;
+}
+
+bool compress_feed(const struct all_sensors_data *in, struct all_sensors_data *out)
+{
+    bool emit;
+
+    cz.stats.in++;
+    if (cz.mode == COMPRESS_OFF || !cz.started) {
+        *out = *in;
+        restart(in);
+        emit = true;
+    } else if (cz.mode == COMPRESS_DEADBAND) {
+        emit = deadband_feed(in, out);
+    } else {
+        emit = sdt_feed(in, out);
+    }
+    if (emit) {
+        cz.stats.out++;
+    }
+    return emit;
+}
+
+void compress_stats_get(struct compress_stats *st)
+{
+    *st = cz.stats;
+}
+
+const char *compress_mode_name(enum compress_mode mode)
+{
+    switch (mode) {
+    case COMPRESS_OFF:      return "off";
+    case COMPRESS_DEADBAND: return "deadband";
+    case COMPRESS_SDT:      return "sdt";
+    default:                return "?";
+    }
+}
+
+#endif /* CONFIG_APP_COMPRESS */
@@ -0,0 +1,49 @@
+#ifndef COMPRESS_H
+#define COMPRESS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "sensors_common.h"
+
+/*
+ * Per-channel compression between the queue and ring_log_write().
+ * Plain C with no kernel dependencies so scripts/compress_replay.c can
+ * run the same code on the host. Not thread-safe: callers serialize.
+ *
+ * Reconstruction from the written records:
+ *   DEADBAND: sample-and-hold from the previous record
+ *   SDT:      linear interpolation between consecutive records
+ * Either way every fed sample is within its channel band of the
+ * reconstruction (SDT: +1 LSB when the door is narrower than one LSB).
+ */
+enum compress_mode {
+    COMPRESS_OFF,
+    COMPRESS_DEADBAND,
+    COMPRESS_SDT,       /* swinging door trending */
+};
+
+/* band = max(abs, |reference| * rel_permille / 1000), in channel units */
+struct compress_band {
+    int32_t abs;
+    uint16_t rel_permille;
+};
+
+struct compress_stats {
+    uint32_t in;
+    uint32_t out;
+    uint32_t heartbeats;
+    uint32_t triggers[SNAP_CH_COUNT];   /* records forced by this channel */
+};
+
+void compress_init(enum compress_mode mode, uint32_t heartbeat_ms);
+/* Changing mode or bands restarts compression from the next sample */
+void compress_set_mode(enum compress_mode mode);
+enum compress_mode compress_get_mode(void);
+int compress_set_band(enum snapshot_channel ch, const struct compress_band *band);
+int compress_get_band(enum snapshot_channel ch, struct compress_band *band);
+/* Returns true and fills *out when a record must be written */
+bool compress_feed(const struct all_sensors_data *in, struct all_sensors_data *out);
+void compress_stats_get(struct compress_stats *st);
+const char *compress_mode_name(enum compress_mode mode);
+
+#endif /* COMPRESS_H */
@@ -0,0 +1,147 @@
+#include "duty.h"
+#include <zephyr/kernel.h>
+#include <zephyr/spinlock.h>
+#include <string.h>
+#if defined(CONFIG_PM)
+#include <zephyr/pm/pm.h>
+#endif
+
+#if defined(CONFIG_APP_DUTY_CYCLE)
+
+static struct k_spinlock lock;
+static struct duty_stats acc;
+static int64_t since;               /* start of the counting period */
+
+static uint32_t busy;               /* sampling threads awake */
+static int64_t awake_since;
+static int64_t sensor_since[DUTY_SENSOR_COUNT];
+static bool sensor_on[DUTY_SENSOR_COUNT];
+
+/* -------- PM state residency -------- */
+
+#if defined(CONFIG_PM)
+static int64_t pm_since;
+static uint8_t pm_substate;
+
+static void pm_entry(enum pm_state state)
+{
+    ARG_UNUSED(state);
+    pm_substate = pm_state_next_get(0)->substate_id;
+    pm_since = k_uptime_ticks();
+}
+
+/* Exit runs with the system timer already resynchronised */
+static void pm_exit(enum pm_state state)
+{
+    k_spinlock_key_t key = k_spin_lock(&lock);
+    struct duty_pm_slot *slot = NULL;
+
+    for (uint32_t i = 0; i < acc.n_pm; i++) {
+        if (acc.pm[i].state == state && acc.pm[i].substate == pm_substate) {
+            slot = &acc.pm[i];
+        }
+    }
+    if (!slot && acc.n_pm < DUTY_PM_SLOTS) {
+        slot = &acc.pm[acc.n_pm++];
+        slot->state = state;
+        slot->substate = pm_substate;
+    }
+    if (slot) {
+        slot->ticks += k_uptime_ticks() - pm_since;
+        slot->entries++;
+    }
+    k_spin_unlock(&lock, key);
+}
+
+static struct pm_notifier notifier = {
+    .state_entry = pm_entry,
+    .state_exit = pm_exit,
+};
+#endif
+
+/* -------- Counting -------- */
+
+void duty_init(void)
+{
+    since = k_uptime_ticks();
+#if defined(CONFIG_PM)
+    pm_notifier_register(&notifier);
+#endif
+}
+
+void duty_thread_start(void)
+{
+    k_spinlock_key_t key = k_spin_lock(&lock);
+    if (busy++ == 0) {
+        awake_since = k_uptime_ticks();
+        acc.windows++;
+    }
+    k_spin_unlock(&lock, key);
+}
+
+void duty_sleep(uint32_t period_ms)
+{
+    k_spinlock_key_t key = k_spin_lock(&lock);
+    if (--busy == 0) {
+        acc.awake_ticks += k_uptime_ticks() - awake_since;
+    }
+    k_spin_unlock(&lock, key);
+
+    /* the next boundary, not now + period: every thread lands on it */
+    int64_t now = k_uptime_get();
+    k_sleep(K_TIMEOUT_ABS_MS((now / period_ms + 1) * period_ms));
+
+    duty_thread_start();
+}
+
+void duty_sensor_power(enum duty_sensor s, bool on)
+{
+    k_spinlock_key_t key = k_spin_lock(&lock);
+    int64_t now = k_uptime_ticks();
+
+    if (on && !sensor_on[s]) {
+        sensor_since[s] = now;
+        acc.sensor_powerups[s]++;
+    } else if (!on && sensor_on[s]) {
+        acc.sensor_on_ticks[s] += now - sensor_since[s];
+    }
+    sensor_on[s] = on;
+    k_spin_unlock(&lock, key);
+}
+
+/* -------- Stats -------- */
+
+void duty_stats_get(struct duty_stats *st)
+{
+    k_spinlock_key_t key = k_spin_lock(&lock);
+    int64_t now = k_uptime_ticks();
+
+    *st = acc;
+    st->total_ticks = now - since;
+    /* count the running intervals up to now */
+    if (busy) {
+        st->awake_ticks += now - awake_since;
+    }
+    for (int s = 0; s < DUTY_SENSOR_COUNT; s++) {
+        if (sensor_on[s]) {
+            st->sensor_on_ticks[s] += now - sensor_since[s];
+        }
+    }
+    k_spin_unlock(&lock, key);
+}
+
+void duty_stats_reset(void)
+{
+    k_spinlock_key_t key = k_spin_lock(&lock);
+    int64_t now = k_uptime_ticks();
+
+    memset(&acc, 0, sizeof(acc));
+    since = now;
+    awake_since = now;
+    for (int s = 0; s < DUTY_SENSOR_COUNT; s++) {
+        sensor_since[s] = now;
+    }
+    k_spin_unlock(&lock, key);
+}
+
+#endif /* CONFIG_APP_DUTY_CYCLE */
@@ -0,0 +1,54 @@
+#ifndef DUTY_H
+#define DUTY_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Duty cycling (CONFIG_APP_DUTY_CYCLE). The sampling threads sleep to
+ * absolute multiples of their period on one time base, so with periods
+ * that divide each other they all wake on the same tick; between those
+ * windows the SoC is free to enter its PM states and the HTS221/LPS22HB
+ * sit in power-down, converting only on a one-shot request.
+ *
+ * Residency is kept in kernel ticks per state:
+ *   awake/idle   any sampling thread between its wake and its next sleep
+ *   sensor on    from power-up (runtime PM get, one-shot start) to power-down
+ *   PM state     time in each SoC low-power state (CONFIG_PM)
+ */
+enum duty_sensor {
+    DUTY_SENSOR_HT,
+    DUTY_SENSOR_PRESS,
+    DUTY_SENSOR_COUNT,
+};
+
+#define DUTY_PM_SLOTS   4   /* state/substate pairs seen, e.g. STM32 STOP0..2 */
+
+struct duty_pm_slot {
+    uint8_t state;                  /* enum pm_state */
+    uint8_t substate;
+    uint32_t entries;
+    uint64_t ticks;
+};
+
+struct duty_stats {
+    uint64_t total_ticks;           /* since the last reset */
+    uint64_t awake_ticks;
+    uint32_t windows;               /* idle to awake transitions */
+    uint64_t sensor_on_ticks[DUTY_SENSOR_COUNT];
+    uint32_t sensor_powerups[DUTY_SENSOR_COUNT];
+    struct duty_pm_slot pm[DUTY_PM_SLOTS];
+    uint32_t n_pm;
+};
+
+void duty_init(void);
+/* A sampling thread is running; pairs with the sleep in duty_sleep() */
+void duty_thread_start(void);
+/* Sleep until the next multiple of period_ms since boot */
+void duty_sleep(uint32_t period_ms);
+void duty_sensor_power(enum duty_sensor s, bool on);
+
+void duty_stats_get(struct duty_stats *st);
+void duty_stats_reset(void);
+
+#endif /* DUTY_H */
@@ -0,0 +1,205 @@
+/*
+ * app,fault-flash: RAM-backed NOR flash that can lose power at a chosen
+ * program/erase step. See dts/bindings/app,fault-flash.yaml.
+ */
+#define DT_DRV_COMPAT app_fault_flash
+
+#include "fault_flash.h"
+#include <zephyr/device.h>
+#include <zephyr/drivers/flash.h>
+#include <zephyr/kernel.h>
+#include <string.h>
+
+#if DT_HAS_COMPAT_STATUS_OKAY(DT_DRV_COMPAT)
+
+#define MEM_NODE        DT_CHILD(DT_DRV_INST(0), flash_0)
+#define MEM_SIZE        DT_REG_SIZE(MEM_NODE)
+#define ERASE_BLOCK     DT_PROP(MEM_NODE, erase_block_size)
+#define WRITE_BLOCK     DT_PROP(MEM_NODE, write_block_size)
+#define READ_NS         DT_INST_PROP(0, read_ns_per_byte)
+#define PROGRAM_US      DT_INST_PROP(0, program_time_us)
+#define ERASE_US        DT_INST_PROP(0, erase_time_us)
+
+BUILD_ASSERT(DT_NUM_INST_STATUS_OKAY(DT_DRV_COMPAT) == 1, "one app,fault-flash instance");
+BUILD_ASSERT(MEM_SIZE % ERASE_BLOCK == 0, "size must be whole erase blocks");
+BUILD_ASSERT(ERASE_BLOCK % WRITE_BLOCK == 0, "erase block must be whole write blocks");
+
+struct fault_data {
+    uint32_t cut_at;        /* step that loses power, 0: never */
+    bool powered;
+    uint32_t read_ns;       /* modelled read time not yet waited for */
+    struct fault_flash_counts counts;
+};
+
+static uint8_t mem[MEM_SIZE];
+static struct fault_data fault_data;
+
+static const struct flash_parameters params = {
+    .write_block_size = WRITE_BLOCK,
+    .erase_value = 0xff,
+};
+
+/* -------- Control -------- */
+
+void fault_flash_arm(const struct device *dev, uint32_t step)
+{
+    struct fault_data *d = dev->data;
+
+    memset(&d->counts, 0, sizeof(d->counts));
+    d->cut_at = step;
+}
+
+bool fault_flash_powered(const struct device *dev)
+{
+    const struct fault_data *d = dev->data;
+
+    return d->powered;
+}
+
+void fault_flash_power_on(const struct device *dev)
+{
+    struct fault_data *d = dev->data;
+
+    d->cut_at = 0;
+    d->powered = true;
+}
+
+void fault_flash_counts_get(const struct device *dev, struct fault_flash_counts *c)
+{
+    const struct fault_data *d = dev->data;
+
+    *c = d->counts;
+}
+
+uint8_t *fault_flash_memory(const struct device *dev, size_t *size)
+{
+    ARG_UNUSED(dev);
+
+    *size = MEM_SIZE;
+    return mem;
+}
+
+/* -------- Flash API -------- */
+
+static bool in_range(off_t offset, size_t len)
+{
+    return offset >= 0 && (size_t)offset <= MEM_SIZE && len <= MEM_SIZE - (size_t)offset;
+}
+
+/* Counts one step; true if it is the one that loses power */
+static bool step_cut(struct fault_data *d)
+{
+    d->counts.steps++;
+    if (d->cut_at != 0 && d->counts.steps == d->cut_at) {
+        d->powered = false;
+        return true;
+    }
+    return false;
+}
+
+static int fault_read(const struct device *dev, off_t offset, void *data, size_t len)
+{
+    struct fault_data *d = dev->data;
+
+    if (!d->powered) return -EIO;
+    if (!in_range(offset, len)) return -EINVAL;
+
+    memcpy(data, &mem[offset], len);
+    d->counts.read_bytes += len;
+    if (READ_NS) {
+        d->read_ns += READ_NS * len;
+        k_busy_wait(d->read_ns / 1000);
+        d->read_ns %= 1000;
+    }
+    return 0;
+}
+
+static int fault_write(const struct device *dev, off_t offset, const void *data, size_t len)
+{
+    struct fault_data *d = dev->data;
+    const uint8_t *src = data;
+
+    if (!d->powered) return -EIO;
+    if (!in_range(offset, len)) return -EINVAL;
+    if (offset % WRITE_BLOCK || len % WRITE_BLOCK) return -EINVAL;
+
+    /* a cut lands halfway through, on a write block boundary */
+    bool cut = step_cut(d);
+    size_t n = cut ? ROUND_DOWN(len / 2, WRITE_BLOCK) : len;
+
+    /* NOR: programming can only clear bits */
+    for (size_t i = 0; i < n; i++) {
+        mem[offset + i] &= src[i];
+    }
+    d->counts.prog_bytes += n;
+    if (PROGRAM_US) {
+        k_busy_wait(PROGRAM_US * (n / WRITE_BLOCK));
+    }
+    return cut ? -EIO : 0;
+}
+
+static int fault_erase(const struct device *dev, off_t offset, size_t size)
+{
+    struct fault_data *d = dev->data;
+
+    if (!d->powered) return -EIO;
+    if (!in_range(offset, size)) return -EINVAL;
+    if (offset % ERASE_BLOCK || size % ERASE_BLOCK) return -EINVAL;
+
+    bool cut = step_cut(d);
+    size_t n = cut ? ROUND_DOWN(size / 2, WRITE_BLOCK) : size;
+
+    memset(&mem[offset], 0xff, n);
+    d->counts.erases += size / ERASE_BLOCK;
+    if (ERASE_US) {
+        k_busy_wait(ERASE_US * (size / ERASE_BLOCK));
+    }
+    return cut ? -EIO : 0;
+}
+
+static const struct flash_parameters *fault_get_parameters(const struct device *dev)
+{
+    ARG_UNUSED(dev);
+
+    return &params;
+}
+
+#if defined(CONFIG_FLASH_PAGE_LAYOUT)
+static const struct flash_pages_layout layout = {
+    .pages_count = MEM_SIZE / ERASE_BLOCK,
+    .pages_size = ERASE_BLOCK,
+};
+
+static void fault_page_layout(const struct device *dev, const struct flash_pages_layout **l,
+                              size_t *n)
+{
+    ARG_UNUSED(dev);
+
+    *l = &layout;
+    *n = 1;
+}
+#endif
+
+static const struct flash_driver_api fault_api = {
+    .read = fault_read,
+    .write = fault_write,
+    .erase = fault_erase,
+    .get_parameters = fault_get_parameters,
+#if defined(CONFIG_FLASH_PAGE_LAYOUT)
+    .page_layout = fault_page_layout,
+#endif
+};
+
+static int fault_init(const struct device *dev)
+{
+    struct fault_data *d = dev->data;
+
+    memset(mem, 0xff, sizeof(mem));
+    d->powered = true;
+    return 0;
+}
+
+DEVICE_DT_INST_DEFINE(0, fault_init, NULL, &fault_data, NULL, POST_KERNEL,
+                      CONFIG_FLASH_INIT_PRIORITY, &fault_api);
+
+#endif /* DT_HAS_COMPAT_STATUS_OKAY(DT_DRV_COMPAT) */
@@ -0,0 +1,31 @@
+#ifndef FAULT_FLASH_H
+#define FAULT_FLASH_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <zephyr/device.h>
+
+/*
+ * Control interface of the app,fault-flash driver. A step is one
+ * program or erase call. Arming with step k lets k - 1 steps complete;
+ * step k programs only the first half of its data (or erases only the
+ * first half of its range) and cuts the power: it and every later read,
+ * program or erase return -EIO until fault_flash_power_on().
+ */
+struct fault_flash_counts {
+    uint32_t steps;         /* program + erase calls since arming */
+    uint32_t read_bytes;
+    uint32_t prog_bytes;
+    uint32_t erases;        /* blocks */
+};
+
+/* k = 0 disarms; counts restart either way */
+void fault_flash_arm(const struct device *dev, uint32_t step);
+bool fault_flash_powered(const struct device *dev);
+void fault_flash_power_on(const struct device *dev);
+void fault_flash_counts_get(const struct device *dev, struct fault_flash_counts *c);
+/* Backing memory, for saving and restoring images while unmounted */
+uint8_t *fault_flash_memory(const struct device *dev, size_t *size);
+
+#endif /* FAULT_FLASH_H */
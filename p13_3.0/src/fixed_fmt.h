@@ -0,0 +1,19 @@
+#ifndef FIXED_FMT_H
+#define FIXED_FMT_H
+
+#include <stdint.h>
+#include <zephyr/drivers/sensor.h>
+
+/* Big enough for "-2147483648.999999" */
+#define FIXED_FMT_BUF 24
+
+/* Integer-only number rendering, so CONFIG_CBPRINTF_FP_SUPPORT can stay off.
+ * Both write into out (FIXED_FMT_BUF bytes) and return it for use with "%s".
+ */
+
+/* value / 10^decimals, e.g. fmt_fixed(buf, -205, 2) -> "-2.05" (decimals <= 9) */
+const char *fmt_fixed(char *out, int32_t value, unsigned int decimals);
+/* val1 + val2 * 1e-6 rounded to decimals (<= 6) places */
+const char *fmt_sensor_value(char *out, const struct sensor_value *v, unsigned int decimals);
+
+#endif /* FIXED_FMT_H */
@@ -2,6 +2,12 @@
 #include <zephyr/device.h>
 #include <zephyr/devicetree.h>
 #include <zephyr/drivers/sensor.h>
+#if defined(CONFIG_APP_DUTY_CYCLE)
+#include <zephyr/kernel.h>
+#include <zephyr/drivers/i2c.h>
+#include <zephyr/pm/device_runtime.h>
+#include "duty.h"
+#endif
 
 /* alias in overlay: ht-sensor */
 #define HT_NODE DT_ALIAS(ht_sensor)
@@ -11,17 +17,89 @@
 
 static const struct device *ht_dev;
 
+#if defined(CONFIG_APP_DUTY_CYCLE) && DT_ON_BUS(HT_NODE, i2c)
+#define HTS221_CTRL_REG1    0x20
+#define HTS221_CTRL_REG2    0x21
+#define HTS221_STATUS_REG   0x27
+#define HTS221_PD           BIT(7)
+#define HTS221_BDU          BIT(2)
+#define HTS221_ONE_SHOT     BIT(0)
+#define HTS221_DA           (BIT(0) | BIT(1))   /* T_DA | H_DA */
+#define HTS221_CONV_POLLS   20                  /* 1 ms each */
+
+static const struct i2c_dt_spec ht_i2c = I2C_DT_SPEC_GET(HT_NODE);
+
+/* ODR "one-shot": a conversion per ONE_SHOT, then the driver reads the
+ * output registers as usual
+ */
+static int ht_oneshot(void)
+{
+    int rc = i2c_reg_write_byte_dt(&ht_i2c, HTS221_CTRL_REG1, HTS221_PD | HTS221_BDU);
+    if (rc) return rc;
+    rc = i2c_reg_write_byte_dt(&ht_i2c, HTS221_CTRL_REG2, HTS221_ONE_SHOT);
+
+    for (int i = 0; rc == 0 && i < HTS221_CONV_POLLS; i++) {
+        uint8_t st;
+
+        k_msleep(1);
+        rc = i2c_reg_read_byte_dt(&ht_i2c, HTS221_STATUS_REG, &st);
+        if (rc == 0 && (st & HTS221_DA) == HTS221_DA) return 0;
+    }
+    return rc ? rc : -ETIMEDOUT;
+}
+
+static int ht_power_down(void)
+{
+    return i2c_reg_write_byte_dt(&ht_i2c, HTS221_CTRL_REG1, HTS221_BDU);
+}
+#elif defined(CONFIG_APP_DUTY_CYCLE)
+/* no registers behind a stand-in; runtime PM is its whole power state */
+static int ht_oneshot(void) { return 0; }
+static int ht_power_down(void) { return 0; }
+#endif
+
 int hum_temp_sensor_init(void)
 {
     ht_dev = DEVICE_DT_GET(HT_NODE);
-    return device_is_ready(ht_dev) ? 0 : -ENODEV;
+    if (!device_is_ready(ht_dev)) return -ENODEV;
+#if defined(CONFIG_APP_DUTY_CYCLE)
+    /* drivers without PM support stay on; the one-shot mode still applies */
+    int rc = pm_device_runtime_enable(ht_dev);
+    if (rc && rc != -ENOTSUP) return rc;
+    /* the driver left it converting continuously */
+    return ht_power_down();
+#else
+    return 0;
+#endif
+}
+
+/* One conversion into the driver's buffers */
+static int ht_sample(void)
+{
+#if defined(CONFIG_APP_DUTY_CYCLE)
+    int rc = pm_device_runtime_get(ht_dev);
+    if (rc) return rc;
+
+    duty_sensor_power(DUTY_SENSOR_HT, true);
+    rc = ht_oneshot();
+    if (rc == 0) {
+        rc = sensor_sample_fetch(ht_dev);
+    }
+    (void)ht_power_down();
+    duty_sensor_power(DUTY_SENSOR_HT, false);
+
+    (void)pm_device_runtime_put(ht_dev);
+    return rc;
+#else
+    return sensor_sample_fetch(ht_dev);
+#endif
 }
 
 int hum_temp_sensor_fetch(int16_t *temp, int16_t *hum)
 {
     if (!ht_dev) return -ENODEV;
 
-    int rc = sensor_sample_fetch(ht_dev);
+    int rc = ht_sample();
     if (rc) return rc;
 
     struct sensor_value t, h;
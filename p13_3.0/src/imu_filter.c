@@ -0,0 +1,268 @@
+#include "imu_filter.h"
+#include <zephyr/kernel.h>
+#include <math.h>
+#include <string.h>
+
+#if defined(CONFIG_APP_IMU_FILTER)
+
+#include <arm_math.h>
+#include "imu_filter_coeffs.h"      /* generated into the build directory */
+
+#define BLOCK       CONFIG_APP_IMU_FILTER_BLOCK
+#define DECIM       IMU_FILTER_DECIM
+#define OUT         (BLOCK / DECIM)
+
+BUILD_ASSERT(BLOCK % DECIM == 0, "CONFIG_APP_IMU_FILTER_BLOCK must be a multiple of the decimation");
+
+/* Response test: amplitude and number of decimated samples measured */
+#define RESP_AMPLITUDE  16000
+#define RESP_SETTLE     16      /* blocks discarded before measuring */
+#define RESP_OUTPUTS    64
+
+/* One axis: CMSIS instance plus its private state */
+struct filter_chan {
+#if defined(CONFIG_APP_IMU_FILTER_FIR)
+    arm_fir_decimate_instance_q15 inst;
+    q15_t state[IMU_FILTER_FIR_TAPS + BLOCK - 1];
+#else
+    arm_biquad_casd_df1_inst_q15 inst;
+    q15_t state[4 * IMU_FILTER_BIQUAD_STAGES];
+#endif
+};
+
+static int chan_init(struct filter_chan *c)
+{
+    memset(c->state, 0, sizeof(c->state));
+#if defined(CONFIG_APP_IMU_FILTER_FIR)
+    arm_status st = arm_fir_decimate_init_q15(&c->inst, IMU_FILTER_FIR_TAPS, DECIM,
+                                              imu_filter_fir_q15, c->state, BLOCK);
+    return (st == ARM_MATH_SUCCESS) ? 0 : -EINVAL;
+#else
+    arm_biquad_cascade_df1_init_q15(&c->inst, IMU_FILTER_BIQUAD_STAGES, imu_filter_biquad_q15,
+                                    c->state, IMU_FILTER_BIQUAD_SHIFT);
+    return 0;
+#endif
+}
+
+/* BLOCK samples in, OUT samples out */
+static void chan_process(struct filter_chan *c, const q15_t *in, q15_t *out)
+{
+#if defined(CONFIG_APP_IMU_FILTER_FIR)
+    arm_fir_decimate_q15(&c->inst, in, out, BLOCK);
+#else
+    /* the cascade runs at the input rate; keep the sample the FIR path would */
+    q15_t full[BLOCK];
+
+    arm_biquad_cascade_df1_q15(&c->inst, in, full, BLOCK);
+    for (int k = 0; k < OUT; k++) {
+        out[k] = full[k * DECIM + DECIM - 1];
+    }
+#endif
+}
+
+/* -------- Live pipeline -------- */
+
+static struct filter_chan live[IMU_FILTER_AXES];
+static q15_t in_buf[IMU_FILTER_AXES][BLOCK];
+static uint32_t ts_buf[BLOCK];
+static uint16_t fill;
+
+static struct k_spinlock filter_lock;
+static struct imu_filter_stats stats;
+
+void imu_filter_init(void)
+{
+    for (int a = 0; a < IMU_FILTER_AXES; a++) {
+        (void)chan_init(&live[a]);
+    }
+    fill = 0;
+
+    k_spinlock_key_t key = k_spin_lock(&filter_lock);
+    memset(&stats, 0, sizeof(stats));
+    k_spin_unlock(&filter_lock, key);
+}
+
+void imu_filter_push(const int16_t acc[3], const int16_t gyr[3], uint32_t ts_ms,
+                     imu_filter_sink_t sink)
+{
+    for (int i = 0; i < 3; i++) {
+        in_buf[i][fill] = acc[i];
+        in_buf[3 + i][fill] = gyr[i];
+    }
+    ts_buf[fill] = ts_ms;
+    if (++fill < BLOCK) return;
+    fill = 0;
+
+    q15_t out[IMU_FILTER_AXES][OUT];
+
+    uint32_t t0 = k_cycle_get_32();
+    for (int a = 0; a < IMU_FILTER_AXES; a++) {
+        chan_process(&live[a], in_buf[a], out[a]);
+    }
+    uint32_t cyc = k_cycle_get_32() - t0;
+
+    k_spinlock_key_t key = k_spin_lock(&filter_lock);
+    stats.blocks++;
+    stats.outputs += OUT;
+    stats.cycles_last = cyc;
+    stats.cycles_max = MAX(stats.cycles_max, cyc);
+    stats.cycles_total += cyc;
+    k_spin_unlock(&filter_lock, key);
+
+    for (int k = 0; k < OUT; k++) {
+        const int16_t a[3] = { out[0][k], out[1][k], out[2][k] };
+        const int16_t g[3] = { out[3][k], out[4][k], out[5][k] };
+        sink(a, g, ts_buf[k * DECIM + DECIM - 1]);
+    }
+}
+
+void imu_filter_info_get(struct imu_filter_info *info)
+{
+    info->decim = DECIM;
+    info->block = BLOCK;
+    info->input_mhz = IMU_FILTER_INPUT_MHZ;
+#if defined(CONFIG_APP_IMU_FILTER_FIR)
+    info->type = "fir";
+    info->order = IMU_FILTER_FIR_TAPS;
+    info->pass_mdb = IMU_FILTER_FIR_PASS_MDB;
+    info->stop_mdb = IMU_FILTER_FIR_STOP_MDB;
+#else
+    info->type = "biquad";
+    info->order = IMU_FILTER_BIQUAD_STAGES;
+    info->pass_mdb = IMU_FILTER_BIQUAD_PASS_MDB;
+    info->stop_mdb = IMU_FILTER_BIQUAD_STOP_MDB;
+#endif
+}
+
+void imu_filter_stats_get(struct imu_filter_stats *st)
+{
+    k_spinlock_key_t key = k_spin_lock(&filter_lock);
+    *st = stats;
+    k_spin_unlock(&filter_lock, key);
+}
+
+/* -------- Response and throughput (shell thread) -------- */
+
+#if defined(CONFIG_BOARD_NATIVE_SIM)
+/* native/host_clock.c */
+uint64_t app_host_time_us(void);
+
+static uint64_t now_us(void)
+{
+    return app_host_time_us();
+}
+#else
+static uint64_t now_us(void)
+{
+    return k_ticks_to_us_floor64(k_uptime_ticks());
+}
+#endif
+
+static struct filter_chan test_chan;
+static q15_t test_in[BLOCK];
+static q15_t test_out[OUT];
+
+/* Sine at p/16 of the output rate; index kept modulo the exact period */
+static void tone_block(uint32_t p, uint32_t *n)
+{
+    const uint32_t period = 16u * DECIM;
+
+    for (int i = 0; i < BLOCK; i++, (*n)++) {
+        float ph = 2.0f * 3.14159265f * (float)((p * *n) % period) / (float)period;
+        test_in[i] = (q15_t)lrintf(RESP_AMPLITUDE * sinf(ph));
+    }
+}
+
+static int32_t measure_mdb(uint32_t p)
+{
+    uint32_t n = 0;
+    uint32_t blocks = 1;
+    uint64_t sx = 0, sy = 0;
+
+    /* whole periods of both the input tone and its alias in the window */
+    while ((blocks * OUT) % RESP_OUTPUTS) blocks++;
+
+    (void)chan_init(&test_chan);
+    for (int b = 0; b < RESP_SETTLE; b++) {
+        tone_block(p, &n);
+        chan_process(&test_chan, test_in, test_out);
+    }
+    for (uint32_t b = 0; b < blocks; b++) {
+        tone_block(p, &n);
+        chan_process(&test_chan, test_in, test_out);
+        for (int i = 0; i < BLOCK; i++) sx += (int32_t)test_in[i] * test_in[i];
+        for (int k = 0; k < OUT; k++) sy += (int32_t)test_out[k] * test_out[k];
+    }
+    if (sy == 0) return -120000;
+
+    float ratio = ((float)sy / (blocks * OUT)) / ((float)sx / (blocks * BLOCK));
+    return (int32_t)lrintf(10000.0f * log10f(ratio));
+}
+
+int imu_filter_response(struct imu_filter_resp *rows, size_t max_rows)
+{
+    size_t n = MIN(max_rows, ARRAY_SIZE(imu_filter_resp));
+
+    for (size_t i = 0; i < n; i++) {
+        const struct imu_filter_resp_point *pt = &imu_filter_resp[i];
+        struct imu_filter_resp *r = &rows[i];
+
+        r->freq_16th = pt->freq_16th;
+        r->freq_mhz = (uint32_t)((uint64_t)IMU_FILTER_INPUT_MHZ * pt->freq_16th / (16u * DECIM));
+#if defined(CONFIG_APP_IMU_FILTER_FIR)
+        r->expected_mdb = pt->fir_mdb;
+#else
+        r->expected_mdb = pt->biquad_mdb;
+#endif
+        r->measured_mdb = measure_mdb(pt->freq_16th);
+
+        /* q15 output noise hides gains far below the spec; there only the
+         * spec itself is checked
+         */
+        int32_t d = r->measured_mdb - r->expected_mdb;
+        r->pass = (d >= -500 && d <= 500) ||
+                  (r->expected_mdb <= -IMU_FILTER_SPEC_STOP_MDB &&
+                   r->measured_mdb <= -IMU_FILTER_SPEC_STOP_MDB);
+    }
+    return (int)n;
+}
+
+int imu_filter_bench(uint32_t blocks, struct imu_filter_bench *out)
+{
+    uint32_t seed = 1;
+    uint64_t cyc = 0;
+
+    if (blocks == 0) return -EINVAL;
+    memset(out, 0, sizeof(*out));
+
+    (void)chan_init(&test_chan);
+    for (int i = 0; i < BLOCK; i++) {
+        seed = seed * 1103515245u + 12345u;
+        test_in[i] = (q15_t)(seed >> 16);
+    }
+
+    uint64_t us0 = now_us();
+    for (uint32_t b = 0; b < blocks; b++) {
+        uint32_t t0 = k_cycle_get_32();
+        /* same work as a live block: one pass per axis */
+        for (int a = 0; a < IMU_FILTER_AXES; a++) {
+            chan_process(&test_chan, test_in, test_out);
+        }
+        cyc += k_cycle_get_32() - t0;
+    }
+    uint64_t us = now_us() - us0;
+
+    out->blocks = blocks;
+    out->cycles_per_block = (uint32_t)(cyc / blocks);
+    out->cycles_per_sample = out->cycles_per_block / BLOCK;
+    out->us = (uint32_t)MIN(us, UINT32_MAX);
+#if defined(CONFIG_BOARD_NATIVE_SIM)
+    out->max_rate_hz = us ? (uint32_t)MIN((uint64_t)blocks * BLOCK * 1000000u / us, UINT32_MAX) : 0;
+#else
+    out->max_rate_hz = out->cycles_per_block ?
+        (uint32_t)((uint64_t)sys_clock_hw_cycles_per_sec() * BLOCK / out->cycles_per_block) : 0;
+#endif
+    return 0;
+}
+
+#endif /* CONFIG_APP_IMU_FILTER */
@@ -0,0 +1,68 @@
+#ifndef IMU_FILTER_H
+#define IMU_FILTER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Per-axis low-pass + decimate stage for oversampled IMU data.
+ * Samples are buffered into blocks of CONFIG_APP_IMU_FILTER_BLOCK and
+ * processed with CMSIS-DSP q15 kernels; coefficients come from
+ * filters/imu_filter.json via scripts/gen_fir.py at build time.
+ */
+#define IMU_FILTER_AXES 6   /* ax, ay, az, gx, gy, gz */
+
+/* Receives each decimated sample; ts_ms is the uptime of its last input */
+typedef void (*imu_filter_sink_t)(const int16_t acc[3], const int16_t gyr[3], uint32_t ts_ms);
+
+struct imu_filter_info {
+    const char *type;       /* "fir" or "biquad" */
+    uint16_t decim;
+    uint16_t block;
+    uint16_t order;         /* FIR taps or biquad stages */
+    uint32_t input_mhz;     /* design input rate, 0.001 Hz */
+    int32_t pass_mdb;       /* design passband deviation, 0.001 dB */
+    int32_t stop_mdb;       /* design stopband attenuation */
+};
+
+struct imu_filter_stats {
+    uint32_t blocks;
+    uint32_t outputs;
+    uint32_t cycles_last;   /* per block, all axes */
+    uint32_t cycles_max;
+    uint64_t cycles_total;
+};
+
+struct imu_filter_resp {
+    uint32_t freq_mhz;      /* test tone at the design input rate */
+    uint16_t freq_16th;     /* same, in output-rate / 16 units */
+    int32_t expected_mdb;
+    int32_t measured_mdb;
+    bool pass;
+};
+
+/*
+ * Cycles stand still while the kernels run on native_sim, so there the
+ * run is timed on the host clock (native/host_clock.c) and max_rate_hz
+ * comes from that.
+ */
+struct imu_filter_bench {
+    uint32_t blocks;
+    uint32_t cycles_per_block;
+    uint32_t cycles_per_sample; /* one 6-axis input sample */
+    uint32_t us;                /* whole run */
+    uint32_t max_rate_hz;       /* input rate that would use the whole CPU */
+};
+
+void imu_filter_init(void);
+/* Called from the IMU thread only */
+void imu_filter_push(const int16_t acc[3], const int16_t gyr[3], uint32_t ts_ms,
+                     imu_filter_sink_t sink);
+void imu_filter_info_get(struct imu_filter_info *info);
+void imu_filter_stats_get(struct imu_filter_stats *st);
+/* Tones through a private instance; returns rows filled or -errno */
+int imu_filter_response(struct imu_filter_resp *rows, size_t max_rows);
+int imu_filter_bench(uint32_t blocks, struct imu_filter_bench *out);
+
+#endif /* IMU_FILTER_H */
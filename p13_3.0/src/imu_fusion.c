@@ -0,0 +1,450 @@
+#include "imu_fusion.h"
+#include <zephyr/kernel.h>
+#include <math.h>
+#include <string.h>
+
+#if defined(CONFIG_APP_FUSION)
+
+#if defined(CONFIG_APP_FUSION_Q31)
+#include <arm_math.h>
+#endif
+
+#define FUSION_BETA_MILLI  CONFIG_APP_FUSION_BETA_MILLI
+#define FUSION_TARGET_HZ   1000
+#define FUSION_DT_MAX_US   1000000u
+
+#define Q30_ONE            (1 << 30)
+#define RAD_TO_CDEG        (18000.0f / 3.14159265f)
+#define RAD_TO_MDEG        (180000.0f / 3.14159265f)
+
+/* Float reference; also the only path on targets without CMSIS-DSP */
+struct madgwick_f32 {
+    float q[4];
+};
+
+/* -------- Shared helpers -------- */
+
+/* Split dt so each step's half angle stays <= 0.25 rad on every axis.
+ * Q1.30 needs the headroom; the float path uses the same split so the
+ * two stay comparable.
+ */
+static uint32_t substeps(const int16_t gyro[3], uint32_t dt_us)
+{
+    int32_t m = 0;
+
+    for (int i = 0; i < 3; i++) {
+        int32_t g = gyro[i] < 0 ? -gyro[i] : gyro[i];
+        if (g > m) m = g;
+    }
+
+    /* half angle = g/100 * dt_us/1e6 / 2 <= 0.25  <=>  g * dt_us <= 5e7 */
+    uint64_t t = (uint64_t)m * dt_us;
+    uint32_t n = 1;
+    while (t > 50000000ull * n) n *= 2;
+    return n;
+}
+
+static void tilt_from_accel(const int16_t accel[3], float q[4])
+{
+    float roll = atan2f(accel[1], accel[2]);
+    float pitch = atan2f(-accel[0], sqrtf((float)accel[1] * accel[1] + (float)accel[2] * accel[2]));
+    float cr = cosf(roll / 2), sr = sinf(roll / 2);
+    float cp = cosf(pitch / 2), sp = sinf(pitch / 2);
+
+    q[0] = cr * cp;
+    q[1] = sr * cp;
+    q[2] = cr * sp;
+    q[3] = -sr * sp;
+}
+
+static void quat_from_q30(const int32_t in[4], float out[4])
+{
+    for (int i = 0; i < 4; i++) out[i] = (float)in[i] / Q30_ONE;
+}
+
+static void quat_to_q30(const float in[4], int32_t out[4])
+{
+    for (int i = 0; i < 4; i++) out[i] = (int32_t)lrintf(in[i] * Q30_ONE);
+}
+
+/* Rotation angle between two unit quaternions, 0.001 deg */
+static uint32_t quat_angle_mdeg(const float a[4], const float b[4])
+{
+    /* conj(a) * b; atan2 keeps small angles accurate where acos would not */
+    float w = a[0] * b[0] + a[1] * b[1] + a[2] * b[2] + a[3] * b[3];
+    float x = a[0] * b[1] - b[0] * a[1] - (a[2] * b[3] - a[3] * b[2]);
+    float y = a[0] * b[2] - b[0] * a[2] - (a[3] * b[1] - a[1] * b[3]);
+    float z = a[0] * b[3] - b[0] * a[3] - (a[1] * b[2] - a[2] * b[1]);
+
+    return (uint32_t)(2.0f * atan2f(sqrtf(x * x + y * y + z * z), fabsf(w)) * RAD_TO_MDEG + 0.5f);
+}
+
+/* -------- Float reference -------- */
+
+static void madgwick_f32_step(struct madgwick_f32 *m, const float a[3], bool have_a,
+                              const float th[3], float beta_dt)
+{
+    float *q = m->q;
+    float dq[4] = {
+        -q[1] * th[0] - q[2] * th[1] - q[3] * th[2],
+         q[0] * th[0] + q[2] * th[2] - q[3] * th[1],
+         q[0] * th[1] - q[1] * th[2] + q[3] * th[0],
+         q[0] * th[2] + q[1] * th[1] - q[2] * th[0],
+    };
+
+    if (have_a) {
+        /* gradient of |predicted gravity - measured|^2, i.e. J^T f */
+        float f1 = 2.0f * (q[1] * q[3] - q[0] * q[2]) - a[0];
+        float f2 = 2.0f * (q[0] * q[1] + q[2] * q[3]) - a[1];
+        float f3 = 1.0f - 2.0f * (q[1] * q[1] + q[2] * q[2]) - a[2];
+        float s[4] = {
+            -2.0f * q[2] * f1 + 2.0f * q[1] * f2,
+             2.0f * q[3] * f1 + 2.0f * q[0] * f2 - 4.0f * q[1] * f3,
+            -2.0f * q[0] * f1 + 2.0f * q[3] * f2 - 4.0f * q[2] * f3,
+             2.0f * q[1] * f1 + 2.0f * q[2] * f2,
+        };
+        float n = sqrtf(s[0] * s[0] + s[1] * s[1] + s[2] * s[2] + s[3] * s[3]);
+
+        if (n > 0.0f) {
+            for (int i = 0; i < 4; i++) dq[i] -= beta_dt * s[i] / n;
+        }
+    }
+
+    float n = 0.0f;
+    for (int i = 0; i < 4; i++) {
+        q[i] += dq[i];
+        n += q[i] * q[i];
+    }
+    n = 1.0f / sqrtf(n);
+    for (int i = 0; i < 4; i++) q[i] *= n;
+}
+
+static void madgwick_f32_update(struct madgwick_f32 *m, const int16_t accel[3],
+                                const int16_t gyro[3], uint32_t dt_us)
+{
+    uint32_t n = substeps(gyro, dt_us);
+    float dt = (float)dt_us / ((float)n * 1e6f);
+    float an = sqrtf((float)accel[0] * accel[0] + (float)accel[1] * accel[1] +
+                     (float)accel[2] * accel[2]);
+    float a[3], th[3];
+
+    for (int i = 0; i < 3; i++) {
+        a[i] = (an > 0.0f) ? accel[i] / an : 0.0f;
+        th[i] = gyro[i] * 0.01f * dt * 0.5f;
+    }
+    for (uint32_t k = 0; k < n; k++) {
+        madgwick_f32_step(m, a, an > 0.0f, th, FUSION_BETA_MILLI * 0.001f * dt);
+    }
+}
+
+/* -------- Q1.30 on CMSIS-DSP -------- */
+#if defined(CONFIG_APP_FUSION_Q31)
+
+/* Same filter in Q1.30: one bit of headroom above the unit quaternion.
+ * q15 is not enough: a 1 kHz gyro increment is below its LSB.
+ */
+struct madgwick_q31 {
+    q31_t q[4];
+};
+
+static uint32_t isqrt64(uint64_t v)
+{
+    uint64_t r = 0, bit = 1ull << 62;
+
+    while (bit > v) bit >>= 2;
+    while (bit) {
+        if (v >= r + bit) {
+            v -= r + bit;
+            r = (r >> 1) + bit;
+        } else {
+            r >>= 1;
+        }
+        bit >>= 2;
+    }
+    return (uint32_t)r;
+}
+
+/* v *= 1/|v|, giving a unit vector in Q1.30 whatever the input scale */
+static void q30_normalize(q31_t *v, uint32_t n)
+{
+    q31_t peak = 0;
+    q63_t sumsq;
+
+    for (uint32_t i = 0; i < n; i++) {
+        q31_t a = v[i] < 0 ? -v[i] : v[i];
+        if (a > peak) peak = a;
+    }
+    if (peak == 0) return;
+
+    /* use the full Q1.30 range before squaring for precision */
+    int8_t up = 0;
+    while ((peak << up) < (Q30_ONE >> 1)) up++;
+    if (up) arm_shift_q31(v, up, v, n);
+
+    arm_dot_prod_q31(v, v, n, &sumsq);     /* |v|^2 in Q46 */
+    uint64_t norm = isqrt64((uint64_t)sumsq);  /* |v| in Q23 */
+
+    /* 1/|v| = 2^23 / norm = frac * 2^shift, frac in [0.5, 1) as Q31 */
+    uint64_t frac = (1ull << 54) / norm;
+    int8_t shift = 0;
+    while (frac >= (1ull << 31)) {
+        frac >>= 1;
+        shift++;
+    }
+    while (frac < (1ull << 30)) {
+        frac <<= 1;
+        shift--;
+    }
+    arm_scale_q31(v, (q31_t)frac, shift, v, n);
+}
+
+static inline int64_t mul_q30(int64_t a, int64_t b)
+{
+    return (a * b) >> 30;
+}
+
+static void madgwick_q31_step(struct madgwick_q31 *m, const q31_t a[3], bool have_a,
+                              const q31_t th[3], q31_t beta_dt)
+{
+    const q31_t *q = m->q;
+    q31_t dq[4] = {
+        (q31_t)((-(int64_t)q[1] * th[0] - (int64_t)q[2] * th[1] - (int64_t)q[3] * th[2]) >> 30),
+        (q31_t)(( (int64_t)q[0] * th[0] + (int64_t)q[2] * th[2] - (int64_t)q[3] * th[1]) >> 30),
+        (q31_t)(( (int64_t)q[0] * th[1] - (int64_t)q[1] * th[2] + (int64_t)q[3] * th[0]) >> 30),
+        (q31_t)(( (int64_t)q[0] * th[2] + (int64_t)q[1] * th[1] - (int64_t)q[2] * th[0]) >> 30),
+    };
+
+    if (have_a) {
+        int64_t f1 = 2 * (mul_q30(q[1], q[3]) - mul_q30(q[0], q[2])) - a[0];
+        int64_t f2 = 2 * (mul_q30(q[0], q[1]) + mul_q30(q[2], q[3])) - a[1];
+        int64_t f3 = Q30_ONE - 2 * (mul_q30(q[1], q[1]) + mul_q30(q[2], q[2])) - a[2];
+        /* |s| <= 16; scaled down to fit, direction is all that matters */
+        q31_t s[4] = {
+            (q31_t)((-2 * mul_q30(q[2], f1) + 2 * mul_q30(q[1], f2)) >> 4),
+            (q31_t)(( 2 * mul_q30(q[3], f1) + 2 * mul_q30(q[0], f2) - 4 * mul_q30(q[1], f3)) >> 4),
+            (q31_t)((-2 * mul_q30(q[0], f1) + 2 * mul_q30(q[3], f2) - 4 * mul_q30(q[2], f3)) >> 4),
+            (q31_t)(( 2 * mul_q30(q[1], f1) + 2 * mul_q30(q[2], f2)) >> 4),
+        };
+
+        q30_normalize(s, 4);
+        arm_scale_q31(s, beta_dt, 0, s, 4);
+        arm_sub_q31(dq, s, dq, 4);
+    }
+
+    arm_add_q31(m->q, dq, m->q, 4);
+    q30_normalize(m->q, 4);
+}
+
+static void madgwick_q31_update(struct madgwick_q31 *m, const int16_t accel[3],
+                                const int16_t gyro[3], uint32_t dt_us)
+{
+    uint32_t n = substeps(gyro, dt_us);
+    uint64_t dt_sub = dt_us / n;
+    q31_t a[3], th[3];
+
+    for (int i = 0; i < 3; i++) {
+        a[i] = (q31_t)accel[i] << 15;
+        /* g/100 rad/s * dt/1e6 s / 2 in Q1.30 = g * dt * 2^21 / 390625 */
+        th[i] = (q31_t)(((int64_t)gyro[i] * (int64_t)dt_sub << 21) / 390625);
+    }
+    bool have_a = a[0] | a[1] | a[2];
+    q30_normalize(a, 3);
+
+    /* beta * dt in Q31 = beta_milli * dt_us * 2^22 / 1953125 */
+    uint64_t bdt = ((uint64_t)FUSION_BETA_MILLI * dt_sub << 22) / 1953125u;
+    q31_t beta_dt = (q31_t)MIN(bdt, (uint64_t)INT32_MAX);
+
+    for (uint32_t k = 0; k < n; k++) {
+        madgwick_q31_step(m, a, have_a, th, beta_dt);
+    }
+}
+#endif /* CONFIG_APP_FUSION_Q31 */
+
+/* -------- Live instance -------- */
+
+static struct k_spinlock fusion_lock;
+static bool seeded;
+static int32_t pub_q[4];            /* last result, Q1.30 */
+static struct fusion_stats stats;
+
+#if defined(CONFIG_APP_FUSION_Q31)
+static struct madgwick_q31 live_q31;
+#endif
+#if !defined(CONFIG_APP_FUSION_Q31) || defined(CONFIG_APP_FUSION_VERIFY)
+static struct madgwick_f32 live_f32;
+#endif
+
+void imu_fusion_init(void)
+{
+    k_spinlock_key_t key = k_spin_lock(&fusion_lock);
+    seeded = false;
+    pub_q[0] = Q30_ONE;
+    pub_q[1] = pub_q[2] = pub_q[3] = 0;
+    memset(&stats, 0, sizeof(stats));
+    k_spin_unlock(&fusion_lock, key);
+}
+
+/* Called from the IMU thread only; readers see pub_q under the lock */
+void imu_fusion_update(const int16_t accel[3], const int16_t gyro[3], uint32_t dt_us)
+{
+    float qf[4];
+
+    if (!seeded) {
+        /* start both paths from the accel tilt instead of converging from identity */
+        if (!(accel[0] | accel[1] | accel[2])) return;
+        tilt_from_accel(accel, qf);
+#if defined(CONFIG_APP_FUSION_Q31)
+        quat_to_q30(qf, live_q31.q);
+#endif
+#if !defined(CONFIG_APP_FUSION_Q31) || defined(CONFIG_APP_FUSION_VERIFY)
+        memcpy(live_f32.q, qf, sizeof(qf));
+#endif
+        seeded = true;
+        return;
+    }
+    if (dt_us == 0) return;
+    dt_us = MIN(dt_us, FUSION_DT_MAX_US);
+
+    uint32_t t0 = k_cycle_get_32();
+#if defined(CONFIG_APP_FUSION_Q31)
+    madgwick_q31_update(&live_q31, accel, gyro, dt_us);
+#else
+    madgwick_f32_update(&live_f32, accel, gyro, dt_us);
+#endif
+    uint32_t cyc = k_cycle_get_32() - t0;
+
+    uint32_t dev = 0;
+#if defined(CONFIG_APP_FUSION_VERIFY)
+    madgwick_f32_update(&live_f32, accel, gyro, dt_us);
+    quat_from_q30(live_q31.q, qf);
+    dev = quat_angle_mdeg(qf, live_f32.q);
+#endif
+
+    k_spinlock_key_t key = k_spin_lock(&fusion_lock);
+#if defined(CONFIG_APP_FUSION_Q31)
+    memcpy(pub_q, live_q31.q, sizeof(pub_q));
+#else
+    quat_to_q30(live_f32.q, pub_q);
+#endif
+    stats.updates++;
+    stats.cycles_last = cyc;
+    stats.cycles_max = MAX(stats.cycles_max, cyc);
+    stats.cycles_total += cyc;
+    stats.max_dev_mdeg = MAX(stats.max_dev_mdeg, dev);
+    k_spin_unlock(&fusion_lock, key);
+}
+
+void imu_fusion_get(struct fusion_orientation *out)
+{
+    k_spinlock_key_t key = k_spin_lock(&fusion_lock);
+    memcpy(out->q, pub_q, sizeof(out->q));
+    k_spin_unlock(&fusion_lock, key);
+
+    float qf[4];
+    quat_from_q30(out->q, qf);
+
+    float w = qf[0], x = qf[1], y = qf[2], z = qf[3];
+    float sp = CLAMP(2.0f * (w * y - z * x), -1.0f, 1.0f);
+
+    out->roll = (int16_t)lrintf(atan2f(2.0f * (w * x + y * z), 1.0f - 2.0f * (x * x + y * y)) * RAD_TO_CDEG);
+    out->pitch = (int16_t)lrintf(asinf(sp) * RAD_TO_CDEG);
+    out->yaw = (int16_t)lrintf(atan2f(2.0f * (w * z + x * y), 1.0f - 2.0f * (y * y + z * z)) * RAD_TO_CDEG);
+}
+
+void imu_fusion_stats_get(struct fusion_stats *st)
+{
+    k_spinlock_key_t key = k_spin_lock(&fusion_lock);
+    *st = stats;
+    k_spin_unlock(&fusion_lock, key);
+}
+
+/* -------- Bench -------- */
+
+/* Gravity in the body frame for orientation q, 0.01 m/s^2 */
+static void synth_accel(const float q[4], int16_t accel[3])
+{
+    accel[0] = (int16_t)lrintf(981.0f * 2.0f * (q[1] * q[3] - q[0] * q[2]));
+    accel[1] = (int16_t)lrintf(981.0f * 2.0f * (q[0] * q[1] + q[2] * q[3]));
+    accel[2] = (int16_t)lrintf(981.0f * (q[0] * q[0] - q[1] * q[1] - q[2] * q[2] + q[3] * q[3]));
+}
+
+static void quat_mul(const float a[4], const float b[4], float out[4])
+{
+    float r[4] = {
+        a[0] * b[0] - a[1] * b[1] - a[2] * b[2] - a[3] * b[3],
+        a[0] * b[1] + a[1] * b[0] + a[2] * b[3] - a[3] * b[2],
+        a[0] * b[2] - a[1] * b[3] + a[2] * b[0] + a[3] * b[1],
+        a[0] * b[3] + a[1] * b[2] - a[2] * b[1] + a[3] * b[0],
+    };
+    memcpy(out, r, sizeof(r));
+}
+
+/* Constant body rate from a tilted start, sampled at FUSION_TARGET_HZ with
+ * exact gyro and gravity-only accel; truth is integrated in closed form.
+ */
+int imu_fusion_bench(uint32_t updates, struct fusion_bench *out)
+{
+    static const int16_t gyro[3] = { 30, -20, 100 };   /* rad/s * 100 */
+    const uint32_t dt_us = 1000000u / FUSION_TARGET_HZ;
+    const float start[3] = { 0.35f, -0.17f, 0.0f };     /* roll, pitch, yaw: about 20, -10, 0 deg */
+    float truth[4], step[4], qf[4];
+    int16_t accel[3];
+    uint64_t cyc_f32 = 0;
+
+    if (updates == 0) return -EINVAL;
+    memset(out, 0, sizeof(*out));
+
+    truth[0] = cosf(start[0] / 2) * cosf(start[1] / 2);
+    truth[1] = sinf(start[0] / 2) * cosf(start[1] / 2);
+    truth[2] = cosf(start[0] / 2) * sinf(start[1] / 2);
+    truth[3] = -sinf(start[0] / 2) * sinf(start[1] / 2);
+
+    float wx = gyro[0] * 0.01f, wy = gyro[1] * 0.01f, wz = gyro[2] * 0.01f;
+    float wn = sqrtf(wx * wx + wy * wy + wz * wz);
+    float half = wn * dt_us * 1e-6f / 2;
+    step[0] = cosf(half);
+    step[1] = sinf(half) * wx / wn;
+    step[2] = sinf(half) * wy / wn;
+    step[3] = sinf(half) * wz / wn;
+
+    synth_accel(truth, accel);
+    struct madgwick_f32 f32;
+    tilt_from_accel(accel, f32.q);
+#if defined(CONFIG_APP_FUSION_Q31)
+    struct madgwick_q31 q31;
+    uint64_t cyc_q31 = 0;
+    quat_to_q30(f32.q, q31.q);
+#endif
+
+    for (uint32_t i = 0; i < updates; i++) {
+        quat_mul(truth, step, truth);
+        synth_accel(truth, accel);
+
+        uint32_t t0 = k_cycle_get_32();
+        madgwick_f32_update(&f32, accel, gyro, dt_us);
+        cyc_f32 += k_cycle_get_32() - t0;
+
+#if defined(CONFIG_APP_FUSION_Q31)
+        t0 = k_cycle_get_32();
+        madgwick_q31_update(&q31, accel, gyro, dt_us);
+        cyc_q31 += k_cycle_get_32() - t0;
+
+        quat_from_q30(q31.q, qf);
+        out->max_dev_mdeg = MAX(out->max_dev_mdeg, quat_angle_mdeg(qf, f32.q));
+#endif
+    }
+
+    out->updates = updates;
+    out->f32_cycles = (uint32_t)(cyc_f32 / updates);
+    out->budget_cycles = sys_clock_hw_cycles_per_sec() / FUSION_TARGET_HZ;
+#if defined(CONFIG_APP_FUSION_Q31)
+    out->q31_cycles = (uint32_t)(cyc_q31 / updates);
+    out->final_err_mdeg = quat_angle_mdeg(qf, truth);
+#else
+    memcpy(qf, f32.q, sizeof(qf));
+    out->final_err_mdeg = quat_angle_mdeg(qf, truth);
+#endif
+    return 0;
+}
+
+#endif /* CONFIG_APP_FUSION */
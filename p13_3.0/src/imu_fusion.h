@@ -0,0 +1,47 @@
+#ifndef IMU_FUSION_H
+#define IMU_FUSION_H
+
+#include <stdint.h>
+
+/*
+ * Madgwick orientation filter (IMU variant, no magnetometer) fed from
+ * imu_sensor_fetch() units: accel 0.01 m/s^2, gyro 0.01 rad/s.
+ *
+ * CONFIG_APP_FUSION_Q31 runs the filter in Q1.30 fixed point on
+ * CMSIS-DSP q31 kernels; otherwise the float reference runs.
+ * CONFIG_APP_FUSION_VERIFY runs both on every sample and tracks how far
+ * they drift apart.
+ */
+
+struct fusion_orientation {
+    int32_t q[4];       /* unit quaternion w, x, y, z in Q1.30 */
+    int16_t roll;       /* 0.01 deg */
+    int16_t pitch;
+    int16_t yaw;        /* relative to the start-up heading */
+};
+
+struct fusion_stats {
+    uint32_t updates;
+    uint32_t cycles_last;
+    uint32_t cycles_max;
+    uint64_t cycles_total;
+    uint32_t max_dev_mdeg;  /* CONFIG_APP_FUSION_VERIFY: worst q31 vs float, 0.001 deg */
+};
+
+struct fusion_bench {
+    uint32_t updates;
+    uint32_t q31_cycles;    /* per update, 0 without CONFIG_APP_FUSION_Q31 */
+    uint32_t f32_cycles;    /* per update */
+    uint32_t budget_cycles; /* one sample period at 1 kHz */
+    uint32_t max_dev_mdeg;  /* q31 vs float over the run */
+    uint32_t final_err_mdeg; /* active path vs the synthetic truth at the end */
+};
+
+void imu_fusion_init(void);
+void imu_fusion_update(const int16_t accel[3], const int16_t gyro[3], uint32_t dt_us);
+void imu_fusion_get(struct fusion_orientation *out);
+void imu_fusion_stats_get(struct fusion_stats *st);
+/* Runs private filter instances on a synthetic rotation; live state is untouched */
+int imu_fusion_bench(uint32_t updates, struct fusion_bench *out);
+
+#endif /* IMU_FUSION_H */
@@ -17,6 +17,17 @@ int imu_sensor_init(void)
     return device_is_ready(imu_dev) ? 0 : -ENODEV;
 }
 
+int imu_sensor_set_odr(uint16_t hz)
+{
+    if (!imu_dev) return -ENODEV;
+
+    struct sensor_value odr = { .val1 = hz, .val2 = 0 };
+
+    int rc = sensor_attr_set(imu_dev, SENSOR_CHAN_ACCEL_XYZ, SENSOR_ATTR_SAMPLING_FREQUENCY, &odr);
+    if (rc) return rc;
+    return sensor_attr_set(imu_dev, SENSOR_CHAN_GYRO_XYZ, SENSOR_ATTR_SAMPLING_FREQUENCY, &odr);
+}
+
 int imu_sensor_fetch(int16_t *ax, int16_t *ay, int16_t *az,
                      int16_t *gx, int16_t *gy, int16_t *gz)
 {
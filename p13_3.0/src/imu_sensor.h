@@ -4,6 +4,8 @@
 #include <stdint.h>
 
 int imu_sensor_init(void);
+/* Accel and gyro output data rate; -ENOTSUP when the driver fixes it at build time */
+int imu_sensor_set_odr(uint16_t hz);
 /* returns 0 on success; raw milli-units (e.g., mg, mdps) or scaled small ints */
 int imu_sensor_fetch(int16_t *ax, int16_t *ay, int16_t *az,
                      int16_t *gx, int16_t *gy, int16_t *gz);
@@ -0,0 +1,438 @@
+#include "log_bench.h"
+#include "log_fault.h"
+#include "log_query.h"
+#include "log_stage.h"
+#include "raw_log.h"
+#include "ring_log.h"
+#include "sensors_common.h"
+#include <zephyr/kernel.h>
+#include <zephyr/sys/printk.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(CONFIG_APP_LOG_BENCH)
+
+#if defined(CONFIG_FLASH_SIMULATOR_STATS) && defined(CONFIG_STATS_NAMES)
+#include <zephyr/stats/stats.h>
+#define HAVE_FLASH_COUNTS 1
+#endif
+
+#if defined(CONFIG_ARCH_POSIX)
+#include <cmdline.h>
+#include <posix_native_task.h>
+#include <posix_board_if.h>
+#endif
+
+#define BENCH_PATH          LOG_MOUNT_POINT "/bench.bin"
+#define BENCH_MAGIC         0x424E4348u /* 'BNCH' */
+/* fits beside the 64KB snapshot log in the 128KB partition */
+#define BENCH_PAYLOAD_MAX   (16 * 1024)
+#define BENCH_Q_DEPTH       32          /* as sensor_q */
+#define MAX_RECORDS         CONFIG_APP_LOG_BENCH_MAX_RECORDS
+#define STACK_SZ            2048
+
+struct bench_rec {
+    uint32_t seq;
+    uint32_t t_enq;     /* cycles */
+    uint8_t fill[LOG_BENCH_REC_MAX - LOG_BENCH_REC_MIN];
+};
+
+K_MSGQ_DEFINE(bench_q, sizeof(struct bench_rec), BENCH_Q_DEPTH, 4);
+static K_TIMER_DEFINE(pace, NULL, NULL);
+static K_MUTEX_DEFINE(bench_lock);
+
+K_THREAD_STACK_DEFINE(prod_stack, STACK_SZ);
+K_THREAD_STACK_DEFINE(cons_stack, STACK_SZ);
+static struct k_thread prod_thread_data;
+static struct k_thread cons_thread_data;
+
+/* Per-record latencies in cycles, sorted after the run */
+static uint32_t write_cyc[MAX_RECORDS];
+static uint32_t e2e_cyc[MAX_RECORDS];
+
+/* Run state shared by the two threads; bench_lock serialises runs */
+static struct ring_log bench_log = RING_LOG_INIT(BENCH_PATH, BENCH_MAGIC, BENCH_PAYLOAD_MAX);
+static const struct log_bench_cfg *run_cfg;
+static uint32_t t_first;
+static int64_t tick_first;
+static uint32_t dropped;
+static uint32_t queue_peak;
+static uint32_t written;
+static uint64_t write_total;
+static int write_rc;
+
+/* -------- Flash simulator counters -------- */
+
+struct flash_counts {
+    uint32_t bytes;
+    uint32_t writes;
+    uint32_t erases;
+};
+
+#if defined(HAVE_FLASH_COUNTS)
+static int flash_walk(struct stats_hdr *hdr, void *arg, const char *name, uint16_t off)
+{
+    struct flash_counts *c = arg;
+    uint32_t v = *(uint32_t *)((uint8_t *)hdr + off);
+
+    if (strcmp(name, "bytes_written") == 0) {
+        c->bytes = v;
+    } else if (strcmp(name, "flash_write_calls") == 0) {
+        c->writes = v;
+    } else if (strcmp(name, "flash_erase_calls") == 0) {
+        c->erases = v;
+    }
+    return 0;
+}
+#endif
+
+static bool flash_counts_get(struct flash_counts *c)
+{
+    memset(c, 0, sizeof(*c));
+#if defined(HAVE_FLASH_COUNTS)
+    struct stats_hdr *hdr = stats_group_find("flash_sim_stats");
+    if (hdr == NULL) return false;
+    stats_walk(hdr, flash_walk, c);
+    return true;
+#else
+    return false;
+#endif
+}
+
+/* -------- Threads -------- */
+
+/* 32-bit cycles wrap within a minute at 80 MHz; long runs use ticks */
+static uint32_t since_first_us(void)
+{
+    int64_t ticks = k_uptime_ticks() - tick_first;
+
+    if (k_ticks_to_ms_floor64(ticks) > 10000) {
+        return (uint32_t)k_ticks_to_us_floor64(ticks);
+    }
+    return k_cyc_to_us_floor32(k_cycle_get_32() - t_first);
+}
+
+static void producer(void *, void *, void *)
+{
+    const struct log_bench_cfg *cfg = run_cfg;
+    struct bench_rec rec;
+
+    memset(&rec, 0x5A, sizeof(rec));
+    if (cfg->rate_hz) {
+        k_timeout_t period = K_USEC(1000000 / cfg->rate_hz);
+        k_timer_start(&pace, period, period);
+    }
+
+    for (uint32_t seq = 0; seq < cfg->records; seq++) {
+        if (cfg->rate_hz) {
+            k_timer_status_sync(&pace);
+        }
+        rec.seq = seq;
+        rec.t_enq = k_cycle_get_32();
+        if (seq == 0) {
+            t_first = rec.t_enq;
+            tick_first = k_uptime_ticks();
+        }
+
+        if (cfg->rate_hz == 0) {
+            k_msgq_put(&bench_q, &rec, K_FOREVER);
+        } else if (k_msgq_put(&bench_q, &rec, K_NO_WAIT) != 0) {
+            /* as enqueue_snapshot(): drop oldest then put */
+            struct bench_rec trash;
+            k_msgq_get(&bench_q, &trash, K_NO_WAIT);
+            k_msgq_put(&bench_q, &rec, K_NO_WAIT);
+            dropped++;
+        }
+        queue_peak = MAX(queue_peak, k_msgq_num_used_get(&bench_q));
+    }
+    k_timer_stop(&pace);
+}
+
+static void consumer(void *, void *, void *)
+{
+    const struct log_bench_cfg *cfg = run_cfg;
+    struct bench_rec rec;
+
+    /* the newest record is never dropped, so the last one always arrives */
+    do {
+        k_msgq_get(&bench_q, &rec, K_FOREVER);
+        if (write_rc) continue;     /* keep draining so the producer finishes */
+
+        uint32_t t0 = k_cycle_get_32();
+        int rc = ring_log_write(&bench_log, &rec, cfg->size);
+        uint32_t t1 = k_cycle_get_32();
+
+        if (rc) {
+            write_rc = rc;
+            continue;
+        }
+        write_cyc[written] = t1 - t0;
+        e2e_cyc[written] = t1 - rec.t_enq;
+        write_total += t1 - t0;
+        written++;
+    } while (rec.seq != cfg->records - 1);
+}
+
+/* -------- Run -------- */
+
+static int cmp_u32(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+
+    return (x > y) - (x < y);
+}
+
+/* Nearest-rank percentile of n sorted cycle counts, us */
+static uint32_t pct_us(const uint32_t *v, uint32_t n, uint32_t p)
+{
+    if (n == 0) return 0;
+    uint32_t rank = (n * p + 99) / 100;
+    return k_cyc_to_us_ceil32(v[MAX(rank, 1u) - 1]);
+}
+
+static size_t stack_used(struct k_thread *t, size_t size)
+{
+    size_t unused = size;
+
+    (void)k_thread_stack_space_get(t, &unused);
+    return size - unused;
+}
+
+static int open_timed(uint32_t *us)
+{
+    uint32_t t0 = k_cycle_get_32();
+    int rc = ring_log_open(&bench_log);
+
+    *us = k_cyc_to_us_ceil32(k_cycle_get_32() - t0);
+    return rc;
+}
+
+static int run_locked(const struct log_bench_cfg *cfg, struct log_bench_result *out)
+{
+    struct flash_counts f0, f1;
+
+    int rc = log_fs_mount();
+    if (rc) return rc;
+
+    /* create-and-preallocate, then reopen the now valid file */
+    (void)fs_unlink(BENCH_PATH);
+    rc = open_timed(&out->open_fresh_us);
+    if (rc) return rc;
+    ring_log_close(&bench_log);
+    rc = open_timed(&out->open_us);
+    if (rc) return rc;
+
+    run_cfg = cfg;
+    dropped = 0;
+    queue_peak = 0;
+    written = 0;
+    write_total = 0;
+    write_rc = 0;
+    k_msgq_purge(&bench_q);
+    flash_counts_get(&f0);
+
+    /* producer at the sensor threads' priority, consumer at the logger's */
+    k_thread_create(&cons_thread_data, cons_stack, K_THREAD_STACK_SIZEOF(cons_stack),
+                    consumer, NULL, NULL, NULL, 6, 0, K_NO_WAIT);
+    k_thread_name_set(&cons_thread_data, "bench_cons");
+    k_thread_create(&prod_thread_data, prod_stack, K_THREAD_STACK_SIZEOF(prod_stack),
+                    producer, NULL, NULL, NULL, 5, 0, K_NO_WAIT);
+    k_thread_name_set(&prod_thread_data, "bench_prod");
+
+    k_thread_join(&prod_thread_data, K_FOREVER);
+    k_thread_join(&cons_thread_data, K_FOREVER);
+
+    /* close flushes what LittleFS still caches */
+    rc = ring_log_close(&bench_log);
+    out->elapsed_us = since_first_us();
+    out->have_flash = flash_counts_get(&f1);
+    (void)fs_unlink(BENCH_PATH);
+
+    out->rc = write_rc ? write_rc : rc;
+    out->written = written;
+    out->dropped = dropped;
+    out->queue_peak = queue_peak;
+    out->flash_bytes = f1.bytes - f0.bytes;
+    out->flash_writes = f1.writes - f0.writes;
+    out->flash_erases = f1.erases - f0.erases;
+
+    uint32_t write_us = (uint32_t)k_cyc_to_us_ceil64(write_total);
+    out->achieved_rps = out->elapsed_us ? (uint32_t)(1000000ull * written / out->elapsed_us) : 0;
+    out->capacity_rps = write_us ? (uint32_t)(1000000ull * written / write_us) : 0;
+
+    qsort(write_cyc, written, sizeof(write_cyc[0]), cmp_u32);
+    qsort(e2e_cyc, written, sizeof(e2e_cyc[0]), cmp_u32);
+    out->write_p50_us = pct_us(write_cyc, written, 50);
+    out->write_p99_us = pct_us(write_cyc, written, 99);
+    out->write_max_us = pct_us(write_cyc, written, 100);
+    out->e2e_p50_us = pct_us(e2e_cyc, written, 50);
+    out->e2e_p99_us = pct_us(e2e_cyc, written, 99);
+    out->e2e_max_us = pct_us(e2e_cyc, written, 100);
+
+    out->ram_static = sizeof(struct bench_rec) * BENCH_Q_DEPTH + sizeof(write_cyc) +
+                      sizeof(e2e_cyc);
+    out->producer_stack_used = stack_used(&prod_thread_data, K_THREAD_STACK_SIZEOF(prod_stack));
+    out->consumer_stack_used = stack_used(&cons_thread_data, K_THREAD_STACK_SIZEOF(cons_stack));
+    return 0;
+}
+
+int log_bench_run(const struct log_bench_cfg *cfg, struct log_bench_result *out)
+{
+    memset(out, 0, sizeof(*out));
+    out->cfg = *cfg;
+
+    if (cfg->records == 0 || cfg->records > MAX_RECORDS) return -EINVAL;
+    if (cfg->size < LOG_BENCH_REC_MIN || cfg->size > LOG_BENCH_REC_MAX) return -EINVAL;
+    if (cfg->rate_hz > 1000000) return -EINVAL;
+
+    k_mutex_lock(&bench_lock, K_FOREVER);
+    int rc = run_locked(cfg, out);
+    k_mutex_unlock(&bench_lock);
+    if (rc) {
+        out->rc = rc;
+    }
+    return rc ? rc : out->rc;
+}
+
+/* -------- Output -------- */
+
+int log_bench_json(const struct log_bench_result *r, char *buf, size_t len)
+{
+    char flash[80] = "null";
+    int n;
+
+    if (r->have_flash) {
+        snprintf(flash, sizeof(flash), "{\"bytes\":%u,\"writes\":%u,\"erases\":%u}",
+                 r->flash_bytes, r->flash_writes, r->flash_erases);
+    }
+
+    n = snprintf(buf, len,
+                 "{\"board\":\"%s\",\"backend\":\"ring_log\",\"payload_max\":%u,"
+                 "\"rate_hz\":%u,\"records\":%u,\"size\":%u,\"rc\":%d,"
+                 "\"written\":%u,\"dropped\":%u,\"elapsed_us\":%u,"
+                 "\"rps\":%u,\"capacity_rps\":%u,"
+                 "\"open_us\":{\"fresh\":%u,\"existing\":%u},"
+                 "\"write_us\":{\"p50\":%u,\"p99\":%u,\"max\":%u},"
+                 "\"e2e_us\":{\"p50\":%u,\"p99\":%u,\"max\":%u},"
+                 "\"queue_peak\":%u,\"flash\":%s,"
+                 "\"ram\":{\"static\":%u,\"producer_stack\":%u,\"consumer_stack\":%u}}",
+                 CONFIG_BOARD, BENCH_PAYLOAD_MAX, r->cfg.rate_hz, r->cfg.records, r->cfg.size,
+                 r->rc, r->written, r->dropped, r->elapsed_us, r->achieved_rps,
+                 r->capacity_rps, r->open_fresh_us, r->open_us, r->write_p50_us,
+                 r->write_p99_us, r->write_max_us, r->e2e_p50_us, r->e2e_p99_us, r->e2e_max_us,
+                 r->queue_peak, flash, (unsigned)r->ram_static,
+                 (unsigned)r->producer_stack_used, (unsigned)r->consumer_stack_used);
+    return (n < 0 || (size_t)n >= len) ? -ENOMEM : n;
+}
+
+int log_bench_matrix_next(const char **p, struct log_bench_cfg *cfg)
+{
+    const char *s = *p;
+    char *end;
+
+    while (*s == ' ') s++;
+    *p = s;
+    if (*s == '\0') return 0;
+
+    cfg->rate_hz = strtoul(s, &end, 0);
+    if (*end != ':') return -EINVAL;
+    cfg->records = strtoul(end + 1, &end, 0);
+    if (*end != ':') return -EINVAL;
+    cfg->size = strtoul(end + 1, &end, 0);
+    if (*end != ' ' && *end != '\0') return -EINVAL;
+    *p = end;
+    return 1;
+}
+
+/* -------- Autorun -------- */
+
+#if defined(CONFIG_APP_LOG_BENCH_AUTORUN)
+static const char *matrix = CONFIG_APP_LOG_BENCH_MATRIX;
+
+#if defined(CONFIG_ARCH_POSIX)
+static void bench_options(void)
+{
+    static struct args_struct_t opts[] = {
+        { .option = "log-bench", .name = "matrix", .type = 's', .dest = (void *)&matrix,
+          .descript = "Log bench runs as rate_hz:records:size, space separated" },
+        ARG_TABLE_ENDMARKER
+    };
+
+    native_add_command_line_opts(opts);
+}
+
+NATIVE_TASK(bench_options, PRE_BOOT_1, 1);
+#endif
+
+void log_bench_autorun(void)
+{
+    static char json[512];
+    const char *p = matrix;
+    struct log_bench_cfg cfg;
+    int more;
+
+    while ((more = log_bench_matrix_next(&p, &cfg)) > 0) {
+        struct log_bench_result r;
+
+        (void)log_bench_run(&cfg, &r);
+        if (log_bench_json(&r, json, sizeof(json)) > 0) {
+            printk("BENCH %s\n", json);
+        }
+    }
+    if (more) {
+        printk("BENCH bad matrix at \"%s\"\n", p);
+    }
+
+#if defined(CONFIG_APP_LOG_FAULT)
+    for (int ph = LOG_FAULT_CREATE; ph < LOG_FAULT_PHASES; ph++) {
+        struct log_fault_result f;
+
+        (void)log_fault_run(ph, &f);
+        if (log_fault_json(&f, json, sizeof(json)) > 0) {
+            printk("FAULT %s\n", json);
+        }
+    }
+#endif
+#if defined(CONFIG_APP_LOG_QUERY)
+    static struct log_query_bench_result qb[LOG_QUERY_BENCH_RUNS];
+
+    (void)log_query_bench(qb);
+    for (int i = 0; i < LOG_QUERY_BENCH_RUNS; i++) {
+        if (log_query_bench_json(&qb[i], json, sizeof(json)) > 0) {
+            printk("QUERY %s\n", json);
+        }
+    }
+#endif
+#if defined(CONFIG_APP_LOG_STAGE)
+    static struct log_stage_check_result sc[LOG_STAGE_CHECK_RUNS];
+
+    (void)log_stage_check(sc);
+    for (int i = 0; i < LOG_STAGE_CHECK_RUNS; i++) {
+        if (log_stage_check_json(&sc[i], json, sizeof(json)) > 0) {
+            printk("STAGE %s\n", json);
+        }
+    }
+#endif
+#if defined(CONFIG_APP_RAW_LOG)
+    static struct raw_log raw;
+    static struct raw_log_bench_result rb[RAW_LOG_BENCH_RUNS];
+
+    /* an open failure comes back as every run's rc */
+    (void)raw_log_open(&raw, FIXED_PARTITION_ID(logs_raw), sizeof(struct all_sensors_data));
+    (void)raw_log_bench(&raw, rb);
+    for (int i = 0; i < RAW_LOG_BENCH_RUNS; i++) {
+        if (raw_log_bench_json(&rb[i], json, sizeof(json)) > 0) {
+            printk("RAW %s\n", json);
+        }
+    }
+#endif
+    printk("BENCH done\n");
+
+#if defined(CONFIG_ARCH_POSIX)
+    posix_exit(more ? 1 : 0);
+#endif
+}
+#endif /* CONFIG_APP_LOG_BENCH_AUTORUN */
+
+#endif /* CONFIG_APP_LOG_BENCH */
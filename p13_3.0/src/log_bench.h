@@ -0,0 +1,67 @@
+#ifndef LOG_BENCH_H
+#define LOG_BENCH_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Logging path benchmark. A producer thread puts records into a message
+ * queue shaped like sensor_q at a fixed rate; a consumer at the logger's
+ * priority writes them through ring_log_write() to a separate circular
+ * file, /lfs/bench.bin. Reports throughput, latency percentiles, flash
+ * traffic and stack high-water as one JSON line per run.
+ *
+ * On native_sim k_cycle_get_32() follows simulated time, which only
+ * advances in the flash simulator's modelled program/erase delays
+ * (FLASH_SIMULATOR_SIMULATE_TIMING); latencies there track flash
+ * traffic, not CPU time.
+ */
+#define LOG_BENCH_REC_MIN   8       /* sequence number + enqueue time */
+#define LOG_BENCH_REC_MAX   128
+
+struct log_bench_cfg {
+    uint32_t rate_hz;       /* 0: producer blocks on a full queue, measures capacity */
+    uint32_t records;
+    uint32_t size;          /* bytes per record */
+};
+
+struct log_bench_result {
+    struct log_bench_cfg cfg;
+    int rc;
+    uint32_t written;
+    uint32_t dropped;           /* oldest discarded on a full queue, as enqueue_snapshot() */
+    uint32_t elapsed_us;        /* first enqueue to last write */
+    uint32_t achieved_rps;      /* written / elapsed */
+    uint32_t capacity_rps;      /* written / time spent in ring_log_write() */
+    uint32_t open_fresh_us;     /* create and preallocate */
+    uint32_t open_us;           /* reopen an existing file */
+    uint32_t write_p50_us, write_p99_us, write_max_us;
+    uint32_t e2e_p50_us, e2e_p99_us, e2e_max_us;   /* enqueue to written */
+    uint32_t queue_peak;        /* messages */
+    bool have_flash;            /* flash simulator counters available */
+    uint32_t flash_bytes;       /* programmed during the write phase */
+    uint32_t flash_writes;
+    uint32_t flash_erases;
+    size_t ram_static;          /* queue, record and latency buffers */
+    size_t producer_stack_used;
+    size_t consumer_stack_used;
+};
+
+int log_bench_run(const struct log_bench_cfg *cfg, struct log_bench_result *out);
+/* One line of JSON, no newline; returns the length or -ENOMEM */
+int log_bench_json(const struct log_bench_result *r, char *buf, size_t len);
+/*
+ * The next rate_hz:records:size run of a space separated matrix such as
+ * CONFIG_APP_LOG_BENCH_MATRIX: 1 with *p past it, 0 at the end, or
+ * -EINVAL with *p left on the bad entry
+ */
+int log_bench_matrix_next(const char **p, struct log_bench_cfg *cfg);
+/* CONFIG_APP_LOG_BENCH_AUTORUN: run the matrix, print BENCH lines (and
+ * FAULT lines with CONFIG_APP_LOG_FAULT, QUERY lines with
+ * CONFIG_APP_LOG_QUERY, STAGE lines with CONFIG_APP_LOG_STAGE, RAW lines
+ * with CONFIG_APP_RAW_LOG), exit on native_sim
+ */
+void log_bench_autorun(void);
+
+#endif /* LOG_BENCH_H */
@@ -0,0 +1,342 @@
+#include "log_fault.h"
+#include "ring_log.h"
+#include "raw_log.h"
+#include "fault_flash.h"
+#include "sensors_common.h"
+#include <zephyr/kernel.h>
+#include <zephyr/fs/fs.h>
+#include <zephyr/fs/littlefs.h>
+#include <zephyr/storage/flash_map.h>
+#include <stdio.h>
+#include <string.h>
+
+#if defined(CONFIG_APP_LOG_FAULT)
+
+#define FAULT_NODE          DT_INST(0, app_fault_flash)
+#define FAULT_MEM_SIZE      DT_REG_SIZE(DT_CHILD(FAULT_NODE, flash_0))
+
+#define FAULT_MOUNT_POINT   "/fault"
+#define FAULT_PATH          FAULT_MOUNT_POINT "/sensor_log.bin"
+#define FAULT_MAGIC         0x464C5431u /* 'FLT1' */
+/* several flash pages, yet few enough steps to cut at every one */
+#define FAULT_PAYLOAD_MAX   (8 * 1024)
+#define REC_SIZE            sizeof(struct all_sensors_data)
+#define RING_RECORDS        (FAULT_PAYLOAD_MAX / REC_SIZE)
+
+#define CREATE_RECORDS      2
+#define WRITE_RECORDS       3   /* last slot, wrap, first slot again */
+
+#if defined(CONFIG_APP_RAW_LOG)
+#define FAULT_RAW_ID        FIXED_PARTITION_ID(fault_raw)
+#else
+#define FAULT_RAW_ID        0
+#endif
+
+static const struct device *const flash_dev = DEVICE_DT_GET(FAULT_NODE);
+
+FS_LITTLEFS_DECLARE_DEFAULT_CONFIG(fault_lfs);
+static struct fs_mount_t fault_mnt = {
+    .type = FS_LITTLEFS,
+    .fs_data = &fault_lfs,
+    .storage_dev = (void *)FIXED_PARTITION_ID(fault_fs),
+    .mnt_point = FAULT_MOUNT_POINT,
+};
+
+static struct ring_log flog = RING_LOG_INIT(FAULT_PATH, FAULT_MAGIC, FAULT_PAYLOAD_MAX);
+/* the fault_raw partition beside fault_fs, opened without a mount */
+static struct raw_log rlog;
+
+/* Flash contents before the sequence, and the log file read back */
+static uint8_t image[FAULT_MEM_SIZE];
+static uint8_t file_buf[LOG_HEADER_SIZE + FAULT_PAYLOAD_MAX];
+
+static K_MUTEX_DEFINE(fault_lock);
+
+/* -------- Helpers -------- */
+
+static void rec_fill(uint8_t *rec, uint32_t seq)
+{
+    memcpy(rec, &seq, sizeof(seq));
+    for (size_t i = sizeof(seq); i < REC_SIZE; i++) {
+        rec[i] = (uint8_t)(seq * 31u + i);
+    }
+}
+
+static bool phase_raw(enum log_fault_phase phase)
+{
+    return IS_ENABLED(CONFIG_APP_RAW_LOG) && phase >= LOG_FAULT_RAW_CREATE;
+}
+
+static int mount(bool raw, bool format)
+{
+    if (raw) return 0;
+
+    /* after a cut, a partition LittleFS cannot mount must not be reformatted */
+    fault_mnt.flags = format ? 0 : FS_MOUNT_FLAG_NO_FORMAT;
+    return fs_mount(&fault_mnt);
+}
+
+static void unmount(bool raw)
+{
+    if (!raw) {
+        fs_unmount(&fault_mnt);
+    }
+}
+
+/* The log as at boot */
+static int log_open(bool raw)
+{
+    return raw ? raw_log_open(&rlog, FAULT_RAW_ID, REC_SIZE) : ring_log_open(&flog);
+}
+
+static void log_close(bool raw)
+{
+    if (raw) {
+        raw_log_close(&rlog);
+    } else {
+        (void)ring_log_close(&flog);
+    }
+}
+
+/* Records the ring holds, counting the slot the writer erases into */
+static uint32_t ring_records(bool raw, int *rc)
+{
+    if (!raw) return RING_RECORDS;
+
+    *rc = log_open(true);
+    log_close(true);
+    return rlog.slots;
+}
+
+static void image_copy(bool save)
+{
+    size_t size;
+    uint8_t *mem = fault_flash_memory(flash_dev, &size);
+
+    if (save) {
+        memcpy(image, mem, size);
+    } else {
+        memcpy(mem, image, size);
+    }
+}
+
+/* Open the log and append n records from seq, up to the first error;
+ * returns the number acknowledged
+ */
+static uint32_t sequence(bool raw, uint32_t seq, uint32_t n, int *rc)
+{
+    uint8_t rec[REC_SIZE];
+    uint32_t acked = 0;
+
+    *rc = log_open(raw);
+    while (*rc == 0 && acked < n) {
+        rec_fill(rec, seq + acked);
+        *rc = raw ? raw_log_append(&rlog, rec) : ring_log_write(&flog, rec, REC_SIZE);
+        if (*rc == 0) acked++;
+    }
+    /* after a cut this fails too, but releases the file */
+    log_close(raw);
+    return acked;
+}
+
+enum verdict { V_OK, V_HEADER, V_LOST };
+
+/* The reopened log against lo acknowledged and at most hi attempted records */
+static enum verdict verify(uint32_t lo, uint32_t hi)
+{
+    struct log_header hdr;
+    uint8_t rec[REC_SIZE];
+
+    if (fs_seek(&flog.file, 0, FS_SEEK_SET) != 0 ||
+        fs_read(&flog.file, file_buf, sizeof(file_buf)) != sizeof(file_buf)) {
+        return V_HEADER;
+    }
+    memcpy(&hdr, file_buf, sizeof(hdr));
+
+    /* record count the header stands for */
+    uint32_t n = lo;
+    while (n <= hi && (n % RING_RECORDS) * REC_SIZE != hdr.write_off) {
+        n++;
+    }
+    if (hdr.magic != FAULT_MAGIC || n > hi) return V_HEADER;
+
+    /* every acknowledged record the ring still holds */
+    for (uint32_t s = (n > RING_RECORDS) ? n - RING_RECORDS : 0; s < lo; s++) {
+        rec_fill(rec, s);
+        if (memcmp(&file_buf[LOG_HEADER_SIZE + (s % RING_RECORDS) * REC_SIZE], rec,
+                   REC_SIZE) != 0) {
+            return V_LOST;
+        }
+    }
+    return V_OK;
+}
+
+/* The same for the raw log: the write position it found stands for the
+ * record count, and the records it lets readers see are the ring. The
+ * attempted record may be a hole, but a reader must never see it torn.
+ */
+static enum verdict verify_raw(uint32_t lo, uint32_t hi)
+{
+    uint8_t __aligned(4) slot[RAW_LOG_SLOT_MAX];
+    uint8_t rec[REC_SIZE];
+    struct raw_log_iter it;
+
+    if (raw_log_iter_init(&it, &rlog, RAW_LOG_ITER_COPY, slot, sizeof(slot)) != 0) {
+        return V_HEADER;
+    }
+    uint32_t n = it.base + it.records;
+    if (n < lo || n > hi) return V_HEADER;
+
+    for (uint32_t s = it.base; s < n; s++) {
+        const void *p;
+
+        int rc = raw_log_iter_at(&it, s - it.base, &p);
+        if (rc == -ENODATA && s >= lo) continue;
+        rec_fill(rec, s);
+        if (rc != 0 || memcmp(p, rec, REC_SIZE) != 0) return V_LOST;
+    }
+    return V_OK;
+}
+
+/* -------- Run -------- */
+
+static int run_locked(enum log_fault_phase phase, struct log_fault_result *out)
+{
+    bool raw = phase_raw(phase);
+    uint32_t base = 0, n = CREATE_RECORDS;
+    struct fault_flash_counts c;
+    uint64_t rec_total = 0;
+    int rc = 0;
+
+    /* erased partition, formatted; the write phase fills the ring up to
+     * its last slot so the sequence crosses the wrap (for the raw log
+     * also a page erase)
+     */
+    size_t size;
+    uint8_t *mem = fault_flash_memory(flash_dev, &size);
+
+    memset(mem, 0xff, size);
+    fault_flash_power_on(flash_dev);
+    fault_flash_arm(flash_dev, 0);
+    rc = mount(raw, true);
+    if (rc) return rc;
+    if (phase == LOG_FAULT_WRITE || phase == LOG_FAULT_RAW_WRITE) {
+        base = ring_records(raw, &rc) - 1;
+        n = WRITE_RECORDS;
+        if (rc == 0) (void)sequence(raw, 0, base, &rc);
+    }
+    unmount(raw);
+    if (rc) return rc;
+    image_copy(true);
+
+    /* uninterrupted run: number of steps */
+    rc = mount(raw, false);
+    if (rc) return rc;
+    fault_flash_arm(flash_dev, 0);
+    (void)sequence(raw, base, n, &rc);
+    fault_flash_counts_get(flash_dev, &c);
+    unmount(raw);
+    if (rc) return rc;
+    out->steps = c.steps;
+
+    for (uint32_t k = 1; k <= out->steps; k++) {
+        image_copy(false);
+        fault_flash_power_on(flash_dev);
+        rc = mount(raw, false);
+        if (rc) return rc;
+
+        fault_flash_arm(flash_dev, k);
+        uint32_t acked = sequence(raw, base, n, &rc);
+        unmount(raw);
+
+        /* boot again */
+        fault_flash_power_on(flash_dev);
+        fault_flash_arm(flash_dev, 0);
+        uint32_t t0 = k_cycle_get_32();
+        rc = mount(raw, false);
+        bool mounted = (rc == 0);
+        if (mounted) {
+            rc = log_open(raw);
+        }
+        uint32_t us = k_cyc_to_us_ceil32(k_cycle_get_32() - t0);
+        fault_flash_counts_get(flash_dev, &c);
+
+        enum verdict v = V_OK;
+        if (rc) {
+            out->unmountable++;
+        } else {
+            uint32_t lo = base + acked, hi = MIN(base + acked + 1, base + n);
+
+            v = raw ? verify_raw(lo, hi) : verify(lo, hi);
+            out->bad_header += (v == V_HEADER);
+            out->lost += (v == V_LOST);
+        }
+        log_close(raw);
+        if (mounted) {
+            unmount(raw);
+        }
+
+        out->cuts++;
+        if (rc == 0 && v == V_OK) {
+            out->passed++;
+        } else if (out->first_fail == 0) {
+            out->first_fail = k;
+        }
+        rec_total += us;
+        out->recovery_max_us = MAX(out->recovery_max_us, us);
+        out->recovery_read_max = MAX(out->recovery_read_max, c.read_bytes);
+    }
+    out->recovery_avg_us = out->cuts ? (uint32_t)(rec_total / out->cuts) : 0;
+    return 0;
+}
+
+int log_fault_run(enum log_fault_phase phase, struct log_fault_result *out)
+{
+    memset(out, 0, sizeof(*out));
+    out->backend = phase_raw(phase) ? "raw_log" : "littlefs";
+    out->phase = phase;
+    out->record_size = REC_SIZE;
+
+    if (phase >= LOG_FAULT_PHASES) {
+        out->rc = -ENOTSUP;
+        return out->rc;
+    }
+    if (!device_is_ready(flash_dev)) {
+        out->rc = -ENODEV;
+        return out->rc;
+    }
+
+    k_mutex_lock(&fault_lock, K_FOREVER);
+    out->rc = run_locked(phase, out);
+    k_mutex_unlock(&fault_lock);
+    return out->rc;
+}
+
+/* -------- Output -------- */
+
+const char *log_fault_phase_name(enum log_fault_phase phase)
+{
+    return (phase == LOG_FAULT_CREATE || phase == LOG_FAULT_RAW_CREATE) ? "create" : "write";
+}
+
+int log_fault_json(const struct log_fault_result *r, char *buf, size_t len)
+{
+    char first[12] = "null";
+
+    if (r->first_fail) {
+        snprintf(first, sizeof(first), "%u", r->first_fail);
+    }
+
+    int n = snprintf(buf, len,
+                     "{\"backend\":\"%s\",\"phase\":\"%s\",\"record_size\":%u,\"rc\":%d,"
+                     "\"steps\":%u,\"cuts\":%u,\"passed\":%u,\"unmountable\":%u,"
+                     "\"bad_header\":%u,\"lost\":%u,\"first_fail\":%s,"
+                     "\"recovery_us\":{\"avg\":%u,\"max\":%u},\"recovery_read_max\":%u}",
+                     r->backend, log_fault_phase_name(r->phase),
+                     r->record_size, r->rc, r->steps, r->cuts, r->passed, r->unmountable,
+                     r->bad_header, r->lost, first, r->recovery_avg_us, r->recovery_max_us,
+                     r->recovery_read_max);
+    return (n < 0 || (size_t)n >= len) ? -ENOMEM : n;
+}
+
+#endif /* CONFIG_APP_LOG_FAULT */
@@ -0,0 +1,61 @@
+#ifndef LOG_FAULT_H
+#define LOG_FAULT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Power-cut harness for the snapshot log on an app,fault-flash device
+ * (native_sim). A write sequence is first run once to count its program
+ * and erase steps; then, for every step k, the flash image from before
+ * the sequence is restored, the sequence runs again with power lost at
+ * step k, and the partition is remounted (without formatting) and the
+ * log reopened as at boot. A record counts as acknowledged once
+ * ring_log_write() returned 0; each one still inside the ring must read
+ * back intact, and the header must match a record count between the
+ * acknowledged and the attempted ones.
+ *
+ * With CONFIG_APP_RAW_LOG the same runs again for a raw_log on the
+ * fault_raw partition, reopened with raw_log_open(): there the write
+ * position it finds stands for the record count, and the records its
+ * readers see must hold every acknowledged one still in the ring.
+ */
+enum log_fault_phase {
+    LOG_FAULT_CREATE,       /* empty file system: create the log, two records */
+    LOG_FAULT_WRITE,        /* full log: records across the wrap */
+    LOG_FAULT_RAW_CREATE,   /* erased fault_raw: the first page erase, two records */
+    LOG_FAULT_RAW_WRITE,    /* up to the last slot: a page erase and the wrap */
+};
+
+/* The phases this build runs */
+#if defined(CONFIG_APP_RAW_LOG)
+#define LOG_FAULT_PHASES    4
+#else
+#define LOG_FAULT_PHASES    2
+#endif
+
+struct log_fault_result {
+    const char *backend;
+    enum log_fault_phase phase;
+    int rc;                     /* harness error, not a finding */
+    uint32_t record_size;
+    uint32_t steps;             /* program/erase calls in the sequence */
+    uint32_t cuts;              /* one per step */
+    uint32_t passed;
+    uint32_t unmountable;       /* remount or reopen failed */
+    uint32_t bad_header;        /* includes a wiped log */
+    uint32_t lost;              /* acknowledged record missing or corrupt, or one torn */
+    uint32_t first_fail;        /* step, 0 if none */
+    uint32_t recovery_avg_us;   /* remount + reopen (raw: reopen), modelled flash time */
+    uint32_t recovery_max_us;
+    uint32_t recovery_read_max; /* bytes */
+};
+
+int log_fault_run(enum log_fault_phase phase, struct log_fault_result *out);
+/* "create" or "write" */
+const char *log_fault_phase_name(enum log_fault_phase phase);
+/* One line of JSON, no newline; returns the length or -ENOMEM */
+int log_fault_json(const struct log_fault_result *r, char *buf, size_t len);
+
+#endif /* LOG_FAULT_H */
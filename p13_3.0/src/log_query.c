@@ -0,0 +1,492 @@
+#include "log_query.h"
+
+#if defined(CONFIG_APP_LOG_QUERY)
+
+#include <stdio.h>
+#include <string.h>
+#include <zephyr/kernel.h>
+#include <zephyr/fs/fs.h>
+
+#define REC_SIZE        sizeof(struct all_sensors_data)
+#define CHUNK_RECORDS   (CONFIG_APP_LOG_QUERY_CHUNK_SIZE / REC_SIZE)
+/* two producers can enqueue a few records out of merge order */
+#define SLACK           8
+
+BUILD_ASSERT(CHUNK_RECORDS >= 1, "query chunk smaller than a record");
+
+/* -------- Chunk iterator -------- */
+
+int log_iter_init(struct log_iter *it, const struct ring_log *log, size_t rec_size,
+                  void *buf, size_t len)
+{
+    uint32_t total = 0;
+
+    if (rec_size == 0 || len < rec_size) return -EINVAL;
+
+    memset(it, 0, sizeof(*it));
+    it->log = log;
+    it->rec_size = rec_size;
+    it->buf = buf;
+    it->cap = len / rec_size;
+    it->base = RING_LOG_BASE_CURRENT;
+
+    /* reads nothing: fixes the layout and gives the length */
+    int rc = ring_log_read_ordered(log, rec_size, &it->base, 0, buf, 0, &total);
+    if (rc < 0) return rc;
+
+    it->records = total / rec_size;
+    return 0;
+}
+
+#if defined(CONFIG_APP_RAW_LOG)
+int log_iter_init_raw(struct log_iter *it, const struct raw_log *raw, void *buf, size_t len)
+{
+    memset(it, 0, sizeof(*it));
+
+    int rc = raw_log_iter_init(&it->views, raw, 0, buf, len);
+    if (rc) return rc;
+
+    it->raw = raw;
+    it->rec_size = raw->rec_size;
+    it->records = it->views.records;
+    return 0;
+}
+#endif
+
+void log_iter_seek(struct log_iter *it, uint32_t rec)
+{
+    it->next = MIN(rec, it->records);
+    it->views.next = it->next;
+}
+
+int log_iter_next(struct log_iter *it, const void **rec)
+{
+    if (IS_ENABLED(CONFIG_APP_RAW_LOG) && it->raw) {
+        int r = raw_log_iter_next(&it->views, rec);
+
+        it->next = it->views.next;
+        if (r > 0) it->bytes += it->rec_size;
+        return r;
+    }
+    if (it->next >= it->records) return 0;
+
+    if (it->next < it->first || it->next >= it->first + it->fill) {
+        uint32_t n = MIN(it->cap, it->records - it->next);
+        uint32_t total;
+
+        int r = ring_log_read_ordered(it->log, it->rec_size, &it->base,
+                                      it->next * it->rec_size, it->buf, n * it->rec_size,
+                                      &total);
+        if (r < 0) return r;
+        it->bytes += r;
+        it->chunks++;
+        it->first = it->next;
+        it->fill = r / it->rec_size;
+        if (it->fill == 0) return 0;
+    }
+
+    *rec = it->buf + (it->next - it->first) * it->rec_size;
+    it->next++;
+    return 1;
+}
+
+/* -------- P-square quantile sketch -------- */
+
+struct p2 {
+    uint32_t n;
+    float q[5];             /* marker heights; the first n values, sorted, while n < 5 */
+    int32_t pos[5];         /* marker positions, from 0 */
+    float want[5];          /* desired positions */
+};
+
+static const float pct_p[LOG_QUERY_PCT_COUNT] = { 0.50f, 0.90f, 0.99f };
+
+static float p2_parabolic(const struct p2 *s, int i, int d)
+{
+    float n0 = s->pos[i - 1], n1 = s->pos[i], n2 = s->pos[i + 1];
+
+    return s->q[i] + d / (n2 - n0) *
+           ((n1 - n0 + d) * (s->q[i + 1] - s->q[i]) / (n2 - n1) +
+            (n2 - n1 - d) * (s->q[i] - s->q[i - 1]) / (n1 - n0));
+}
+
+static void p2_add(struct p2 *s, float p, float x)
+{
+    if (s->n < 5) {
+        int i = s->n++;
+
+        while (i > 0 && s->q[i - 1] > x) {
+            s->q[i] = s->q[i - 1];
+            i--;
+        }
+        s->q[i] = x;
+        if (s->n == 5) {
+            for (i = 0; i < 5; i++) s->pos[i] = i;
+            s->want[0] = 0.0f;
+            s->want[1] = 2.0f * p;
+            s->want[2] = 4.0f * p;
+            s->want[3] = 2.0f + 2.0f * p;
+            s->want[4] = 4.0f;
+        }
+        return;
+    }
+
+    s->n++;
+    int k = 0;
+    if (x < s->q[0]) {
+        s->q[0] = x;
+    } else if (x >= s->q[4]) {
+        s->q[4] = x;
+        k = 3;
+    } else {
+        while (x >= s->q[k + 1]) k++;
+    }
+    for (int i = k + 1; i < 5; i++) s->pos[i]++;
+    s->want[1] += p / 2.0f;
+    s->want[2] += p;
+    s->want[3] += (1.0f + p) / 2.0f;
+    s->want[4] += 1.0f;
+
+    for (int i = 1; i <= 3; i++) {
+        float d = s->want[i] - s->pos[i];
+
+        if ((d >= 1.0f && s->pos[i + 1] - s->pos[i] > 1) ||
+            (d <= -1.0f && s->pos[i - 1] - s->pos[i] < -1)) {
+            int ds = d > 0 ? 1 : -1;
+            float qp = p2_parabolic(s, i, ds);
+
+            if (s->q[i - 1] < qp && qp < s->q[i + 1]) {
+                s->q[i] = qp;
+            } else {
+                s->q[i] += ds * (s->q[i + ds] - s->q[i]) / (s->pos[i + ds] - s->pos[i]);
+            }
+            s->pos[i] += ds;
+        }
+    }
+}
+
+static int32_t p2_get(const struct p2 *s, float p)
+{
+    float v;
+
+    if (s->n == 0) return 0;
+    if (s->n < 5) {
+        /* nearest rank */
+        uint32_t r = (uint32_t)(p * s->n + 0.999f);
+        v = s->q[CLAMP(r, 1u, s->n) - 1];
+    } else {
+        v = s->q[2];
+    }
+    return (int32_t)(v < 0 ? v - 0.5f : v + 0.5f);
+}
+
+/* -------- Query -------- */
+
+static K_MUTEX_DEFINE(query_lock);
+static uint8_t __aligned(4) chunk[CHUNK_RECORDS * REC_SIZE];
+static int64_t sum[SNAP_CH_COUNT];
+static struct p2 sketch[SNAP_CH_COUNT][LOG_QUERY_PCT_COUNT];
+
+#if defined(CONFIG_BOARD_NATIVE_SIM)
+/* native/host_clock.c */
+uint64_t app_host_time_us(void);
+
+static uint64_t now_us(void)
+{
+    return app_host_time_us();
+}
+#else
+static uint64_t now_us(void)
+{
+    return k_ticks_to_us_floor64(k_uptime_ticks());
+}
+#endif
+
+static void add(const struct log_query *q, const struct all_sensors_data *d,
+                struct log_query_result *out)
+{
+    if (out->matched++ == 0) out->first_ms = d->timestamp_ms;
+    out->last_ms = d->timestamp_ms;
+
+    for (int ch = 0; ch < SNAP_CH_COUNT; ch++) {
+        if (!(q->channels & BIT(ch))) continue;
+        if (!(d->valid & SNAP_VALID(snapshot_channel_group(ch)))) continue;
+
+        struct log_query_agg *a = &out->ch[ch];
+        int32_t v = snapshot_get(d, ch);
+
+        if (a->count++ == 0) {
+            a->min = a->max = v;
+        } else {
+            a->min = MIN(a->min, v);
+            a->max = MAX(a->max, v);
+        }
+        sum[ch] += v;
+        if (q->flags & LOG_QUERY_PCT) {
+            for (int k = 0; k < LOG_QUERY_PCT_COUNT; k++) {
+                p2_add(&sketch[ch][k], pct_p[k], (float)v);
+            }
+        }
+    }
+}
+
+/* Records [from, to) of the stream; sorted: stop once past the range */
+static int scan(struct log_iter *it, uint32_t from, uint32_t to, bool sorted,
+                const struct log_query *q, struct log_query_result *out)
+{
+    uint32_t past = 0;
+    const void *p;
+
+    log_iter_seek(it, from);
+    while (it->next < to) {
+        int rc = log_iter_next(it, &p);
+        if (rc <= 0) return rc;
+        /* past the range over a raw log's hole */
+        if (it->next > to) break;
+
+        const struct all_sensors_data *d = p;
+        out->scanned++;
+        if (d->timestamp_ms > q->to_ms) {
+            if (sorted && ++past >= SLACK) break;
+            continue;
+        }
+        past = 0;
+        if (d->timestamp_ms >= q->from_ms) add(q, d, out);
+    }
+    return 0;
+}
+
+static int probe_ts(struct log_iter *it, uint32_t rec, uint32_t *ts,
+                    struct log_query_result *out)
+{
+    struct all_sensors_data d;
+    uint32_t total;
+
+    if (IS_ENABLED(CONFIG_APP_RAW_LOG) && it->raw) {
+        /* a hole takes the stamp of the record after it */
+        for (; rec < it->records; rec++) {
+            const void *p;
+
+            int r = raw_log_iter_at(&it->views, rec, &p);
+            if (r == -ENODATA) continue;
+            if (r) return r;
+            out->probes++;
+            out->bytes += REC_SIZE;
+            *ts = ((const struct all_sensors_data *)p)->timestamp_ms;
+            return 0;
+        }
+        *ts = UINT32_MAX;
+        return 0;
+    }
+
+    int r = ring_log_read_ordered(it->log, REC_SIZE, &it->base, rec * REC_SIZE, &d,
+                                  sizeof(d), &total);
+    if (r < 0) return r;
+    if (r != sizeof(d)) return -ENODATA;
+    out->probes++;
+    out->bytes += r;
+    *ts = d.timestamp_ms;
+    return 0;
+}
+
+/* First record of [lo, hi) stamped at or after t */
+static int lower_bound(struct log_iter *it, uint32_t lo, uint32_t hi, uint32_t t,
+                       uint32_t *at, struct log_query_result *out)
+{
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        uint32_t ts;
+
+        int rc = probe_ts(it, mid, &ts, out);
+        if (rc) return rc;
+        if (ts < t) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    *at = lo;
+    return 0;
+}
+
+/* One of log and raw */
+static int run_locked(const struct ring_log *log, const struct raw_log *raw,
+                      const struct log_query *q, struct log_query_result *out)
+{
+    struct log_iter it;
+    /* before the layout is fixed: the stream holds at least these */
+    uint32_t appended = raw ? raw->appended : log->appended;
+    int rc;
+
+    if (IS_ENABLED(CONFIG_APP_RAW_LOG) && raw) {
+        if (raw->rec_size != REC_SIZE) return -EINVAL;
+        rc = log_iter_init_raw(&it, raw, chunk, sizeof(chunk));
+    } else {
+        rc = log_iter_init(&it, log, REC_SIZE, chunk, sizeof(chunk));
+    }
+    if (rc) return rc;
+
+    uint32_t boot_first = it.records - MIN(appended, it.records);
+    out->records = it.records;
+    out->boot_records = it.records - boot_first;
+
+    if (q->flags & LOG_QUERY_ALL) {
+        rc = scan(&it, 0, boot_first, false, q, out);
+        if (rc) return rc;
+    }
+
+    uint32_t start = boot_first;
+    bool sorted = !(q->flags & LOG_QUERY_NO_INDEX);
+    if (sorted && q->from_ms > 0) {
+        rc = lower_bound(&it, boot_first, it.records, q->from_ms, &start, out);
+        if (rc) return rc;
+        start -= MIN(start - boot_first, SLACK);
+    }
+    rc = scan(&it, start, it.records, sorted, q, out);
+
+    out->bytes += it.bytes;
+    out->chunks = it.chunks;
+    return rc;
+}
+
+static int query(const struct ring_log *log, const struct raw_log *raw,
+                 const struct log_query *q, struct log_query_result *out)
+{
+    memset(out, 0, sizeof(*out));
+    if (q->from_ms > q->to_ms) return -EINVAL;
+
+    k_mutex_lock(&query_lock, K_FOREVER);
+    memset(sum, 0, sizeof(sum));
+    memset(sketch, 0, sizeof(sketch));
+
+    uint64_t t0 = now_us();
+    int rc = run_locked(log, raw, q, out);
+
+    for (int ch = 0; ch < SNAP_CH_COUNT; ch++) {
+        struct log_query_agg *a = &out->ch[ch];
+
+        if (a->count == 0) continue;
+        a->mean_x100 = (int32_t)(sum[ch] * 100 / a->count);
+        if (q->flags & LOG_QUERY_PCT) {
+            for (int k = 0; k < LOG_QUERY_PCT_COUNT; k++) {
+                a->pct[k] = p2_get(&sketch[ch][k], pct_p[k]);
+            }
+        }
+    }
+    out->elapsed_us = (uint32_t)(now_us() - t0);
+    k_mutex_unlock(&query_lock);
+    return rc;
+}
+
+int log_query_run(const struct ring_log *log, const struct log_query *q,
+                  struct log_query_result *out)
+{
+    return query(log, NULL, q, out);
+}
+
+#if defined(CONFIG_APP_RAW_LOG)
+int log_query_run_raw(const struct raw_log *log, const struct log_query *q,
+                      struct log_query_result *out)
+{
+    return query(NULL, log, q, out);
+}
+#endif
+
+/* -------- Benchmark -------- */
+
+#define BENCH_PATH          LOG_MOUNT_POINT "/qbench.bin"
+#define BENCH_MAGIC         0x51424E43u /* 'QBNC' */
+#define BENCH_PAYLOAD_MAX   (64 * 1024) /* as the snapshot log */
+#define BENCH_RECORDS       (BENCH_PAYLOAD_MAX / REC_SIZE)
+#define BENCH_PERIOD_MS     100
+
+static struct ring_log bench_log = RING_LOG_INIT(BENCH_PATH, BENCH_MAGIC, BENCH_PAYLOAD_MAX);
+
+/* Record i of a boot: temperature i, pressure 100000 + i */
+static int bench_boot(uint32_t records)
+{
+    struct all_sensors_data d;
+
+    int rc = ring_log_open(&bench_log);
+    if (rc) return rc;
+
+    memset(&d, 0, sizeof(d));
+    d.valid = SNAP_VALID(SNAP_GRP_HT) | SNAP_VALID(SNAP_GRP_PRESS) | SNAP_VALID(SNAP_GRP_IMU);
+    for (uint32_t i = 0; i < records && rc == 0; i++) {
+        d.timestamp_ms = d.ht.ts_ms = d.press.ts_ms = d.imu.ts_ms = i * BENCH_PERIOD_MS;
+        d.ht.temperature = (int16_t)i;
+        d.ht.humidity = 5000;
+        d.press.pressure = 100000 + (int32_t)i;
+        d.imu.accel.z = 981;
+        rc = ring_log_write(&bench_log, &d, sizeof(d));
+    }
+    int rc2 = ring_log_close(&bench_log);
+    return rc ? rc : rc2;
+}
+
+int log_query_bench(struct log_query_bench_result *out)
+{
+    /* the second boot is the last quarter of the ring */
+    const uint32_t boot2 = BENCH_RECORDS / 4;
+    const uint32_t tail = boot2 / 10;
+    const struct {
+        const char *name;
+        struct log_query q;
+    } runs[LOG_QUERY_BENCH_RUNS] = {
+        { "full", { 0, UINT32_MAX, BIT_MASK(SNAP_CH_COUNT), LOG_QUERY_ALL | LOG_QUERY_PCT } },
+        { "full_nopct", { 0, UINT32_MAX, BIT_MASK(SNAP_CH_COUNT), LOG_QUERY_ALL } },
+        { "tail", { (boot2 - tail) * BENCH_PERIOD_MS, UINT32_MAX, BIT(SNAP_CH_TEMP),
+                    LOG_QUERY_PCT } },
+        { "tail_noindex", { (boot2 - tail) * BENCH_PERIOD_MS, UINT32_MAX, BIT(SNAP_CH_TEMP),
+                            LOG_QUERY_PCT | LOG_QUERY_NO_INDEX } },
+    };
+
+    int rc = log_fs_mount();
+    if (rc) return rc;
+    (void)fs_unlink(BENCH_PATH);
+
+    /* one boot that wrapped half way round, then a short one */
+    rc = bench_boot(BENCH_RECORDS + BENCH_RECORDS / 2);
+    if (rc == 0) rc = bench_boot(boot2);
+
+    for (int i = 0; i < LOG_QUERY_BENCH_RUNS; i++) {
+        struct log_query_bench_result *b = &out[i];
+        const struct log_query_result *r = &b->r;
+
+        b->name = runs[i].name;
+        b->chunk = sizeof(chunk);
+        b->rc = rc ? rc : log_query_run(&bench_log, &runs[i].q, &b->r);
+
+        if (runs[i].q.flags & LOG_QUERY_ALL) {
+            b->ok = r->matched == r->records && r->ch[SNAP_CH_TEMP].count == r->records;
+        } else {
+            /* temperatures boot2 - tail .. boot2 - 1 */
+            b->ok = r->matched == tail &&
+                    r->ch[SNAP_CH_TEMP].mean_x100 == (int32_t)(2 * boot2 - tail - 1) * 50;
+        }
+        b->ok = b->ok && b->rc == 0 && r->boot_records == boot2;
+    }
+
+    (void)fs_unlink(BENCH_PATH);
+    return rc;
+}
+
+int log_query_bench_json(const struct log_query_bench_result *b, char *buf, size_t len)
+{
+    const struct log_query_result *r = &b->r;
+    uint32_t bps = r->elapsed_us ? (uint32_t)((uint64_t)r->bytes * 1000000u / r->elapsed_us) : 0;
+
+    int n = snprintf(buf, len,
+                     "{\"board\":\"%s\",\"query\":\"%s\",\"rc\":%d,\"ok\":%s,\"chunk\":%u,"
+                     "\"records\":%u,\"boot_records\":%u,\"scanned\":%u,\"matched\":%u,"
+                     "\"probes\":%u,\"chunks\":%u,\"bytes\":%u,\"us\":%u,\"bps\":%u,"
+                     "\"temp\":{\"mean_x100\":%d,\"p50\":%d,\"p99\":%d}}",
+                     CONFIG_BOARD, b->name, b->rc, b->ok ? "true" : "false", b->chunk,
+                     r->records, r->boot_records, r->scanned, r->matched, r->probes,
+                     r->chunks, r->bytes, r->elapsed_us, bps,
+                     r->ch[SNAP_CH_TEMP].mean_x100, r->ch[SNAP_CH_TEMP].pct[0],
+                     r->ch[SNAP_CH_TEMP].pct[2]);
+    return (n < 0 || (size_t)n >= len) ? -ENOMEM : n;
+}
+
+#endif /* CONFIG_APP_LOG_QUERY */
@@ -0,0 +1,129 @@
+#ifndef LOG_QUERY_H
+#define LOG_QUERY_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <zephyr/sys/util.h>
+
+#include "raw_log.h"
+#include "ring_log.h"
+#include "sensors_common.h"
+
+/*
+ * Aggregates over the snapshot log (CONFIG_APP_LOG_QUERY), computed on
+ * the device in one streaming pass: count, min, max, mean and p50/p90/
+ * p99 per channel over a range of timestamp_ms.
+ *
+ * The ring is read oldest first through a log_iter, one buffer of
+ * CONFIG_APP_LOG_QUERY_CHUNK_SIZE at a time. Records written since
+ * ring_log_open() share this boot's uptime and are in time order, so
+ * the first record of the range is found by bisection over them and the
+ * scan stops at the first chunk past the end. Records of earlier boots
+ * carry another boot's uptime and are only scanned with LOG_QUERY_ALL.
+ *
+ * A raw log (CONFIG_APP_RAW_LOG) is read the same way through record
+ * views, in place where the partition is mapped: no chunks and no
+ * copies, and a bisection probe is a pointer.
+ *
+ * Percentiles are P-square estimates (Jain and Chlamtac), five markers
+ * per quantile, exact up to five values. A query racing the writer can
+ * miss records overwritten while it runs.
+ */
+
+/* -------- Chunk iterator -------- */
+
+struct log_iter {
+    const struct ring_log *log;
+    const struct raw_log *raw;  /* instead of log, from log_iter_init_raw() */
+    struct raw_log_iter views;
+    size_t rec_size;
+    uint32_t base;          /* stream layout, fixed at init */
+    uint32_t records;       /* in the stream */
+    uint32_t next;          /* record returned by the next log_iter_next() */
+    uint32_t first;         /* record at buf[0] */
+    uint32_t fill;          /* records in buf */
+    uint8_t *buf;
+    uint32_t cap;           /* records buf holds */
+    uint32_t bytes;         /* read from the file, or viewed */
+    uint32_t chunks;
+};
+
+/* buf must hold at least one record */
+int log_iter_init(struct log_iter *it, const struct ring_log *log, size_t rec_size,
+                  void *buf, size_t len);
+/* Over a raw log; buf holds a slot when the partition is not mapped */
+int log_iter_init_raw(struct log_iter *it, const struct raw_log *raw, void *buf, size_t len);
+/* Position at record index rec of the stream */
+void log_iter_seek(struct log_iter *it, uint32_t rec);
+/* 1 with *rec pointing into the buffer or the view, 0 at the end, or -errno */
+int log_iter_next(struct log_iter *it, const void **rec);
+
+/* -------- Queries -------- */
+
+#define LOG_QUERY_PCT       BIT(0)  /* percentile sketches */
+#define LOG_QUERY_ALL       BIT(1)  /* earlier boots too, scanned in full */
+#define LOG_QUERY_NO_INDEX  BIT(2)  /* scan this boot in full, no bisection */
+
+#define LOG_QUERY_PCT_COUNT 3       /* p50, p90, p99 */
+
+struct log_query {
+    uint32_t from_ms;       /* inclusive */
+    uint32_t to_ms;         /* inclusive */
+    uint32_t channels;      /* BIT(SNAP_CH_x) */
+    uint32_t flags;
+};
+
+/* All values in the channel's own units */
+struct log_query_agg {
+    uint32_t count;         /* records with the channel's group valid */
+    int32_t min;
+    int32_t max;
+    int32_t mean_x100;      /* mean * 100 */
+    int32_t pct[LOG_QUERY_PCT_COUNT];
+};
+
+struct log_query_result {
+    uint32_t records;       /* in the log */
+    uint32_t boot_records;  /* of them, written this boot */
+    uint32_t scanned;       /* decoded */
+    uint32_t matched;       /* inside the range */
+    uint32_t first_ms;      /* of the first and last match */
+    uint32_t last_ms;
+    uint32_t probes;        /* single-record reads of the bisection */
+    uint32_t bytes;         /* read from the file, probes included */
+    uint32_t chunks;
+    uint32_t elapsed_us;
+    struct log_query_agg ch[SNAP_CH_COUNT];
+};
+
+int log_query_run(const struct ring_log *log, const struct log_query *q,
+                  struct log_query_result *out);
+int log_query_run_raw(const struct raw_log *log, const struct log_query *q,
+                      struct log_query_result *out);
+
+/*
+ * Scan throughput on a synthetic log, /lfs/qbench.bin: one boot that
+ * wrapped, then a shorter one. Runs a full scan with and without
+ * percentiles and a range at the end of the second boot with and
+ * without bisection; ok is set when the counts and the mean match the
+ * synthetic data. Simulated time does not advance while a scan runs on
+ * native_sim, so there the time is taken from the host clock
+ * (native/host_clock.c): host CPU and flash simulator copies.
+ */
+struct log_query_bench_result {
+    const char *name;
+    int rc;
+    bool ok;
+    uint32_t chunk;         /* CONFIG_APP_LOG_QUERY_CHUNK_SIZE */
+    struct log_query_result r;
+};
+
+#define LOG_QUERY_BENCH_RUNS 4
+
+/* Fills all of out[LOG_QUERY_BENCH_RUNS]; returns 0 or the setup's -errno */
+int log_query_bench(struct log_query_bench_result *out);
+/* One line of JSON, no newline; returns the length or -ENOMEM */
+int log_query_bench_json(const struct log_query_bench_result *b, char *buf, size_t len);
+
+#endif /* LOG_QUERY_H */
@@ -0,0 +1,489 @@
+#include "log_stage.h"
+
+#if defined(CONFIG_APP_LOG_STAGE)
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <zephyr/fs/fs.h>
+#include <zephyr/sys/crc.h>
+#include <zephyr/sys/util.h>
+
+#if defined(CONFIG_BOARD_NATIVE_SIM)
+#include <cmdline.h>
+#include <posix_native_task.h>
+#endif
+
+#define STAGE_MAGIC 0x53544732u /* 'STG2': flush stamped with the log's record count */
+
+/* -------- Area -------- */
+
+static uint32_t hdr_crc(const struct log_stage_hdr *h)
+{
+    return crc32_ieee((const uint8_t *)h, offsetof(struct log_stage_hdr, crc));
+}
+
+static bool hdr_valid(const struct log_stage *st, const struct log_stage_hdr *h)
+{
+    return h->magic == STAGE_MAGIC && h->crc == hdr_crc(h) && h->rec_size == st->rec_size &&
+           h->cap == st->cap && h->count <= st->cap;
+}
+
+/* Into the older copy, which becomes the newer */
+static int hdr_commit(struct log_stage *st)
+{
+    st->cur.seq++;
+    st->cur.crc = hdr_crc(&st->cur);
+
+    struct log_stage_hdr *h = &st->hdr[st->cur.seq & 1];
+
+    if (st->cut == LOG_STAGE_CUT_HEADER) {
+        memcpy(h, &st->cur, sizeof(*h) / 2);
+        return -EINTR;
+    }
+    *h = st->cur;
+    return 0;
+}
+
+static uint32_t slot_crc(const struct log_stage *st, uint32_t i)
+{
+    uint32_t key[2] = { st->cur.gen, i };
+    uint32_t crc = crc32_ieee((const uint8_t *)key, sizeof(key));
+
+    return crc32_ieee_update(crc, st->data + i * st->rec_size, st->rec_size);
+}
+
+static int empty(struct log_stage *st)
+{
+    st->cur.count = 0;
+    st->cur.flushing = 0;
+    st->cur.gen++;
+    return hdr_commit(st);
+}
+
+int log_stage_init(struct log_stage *st, struct ring_log *log, size_t rec_size, uint32_t cap,
+                   void *mem, size_t len)
+{
+    if (rec_size == 0 || rec_size > UINT16_MAX || cap == 0 || cap > UINT16_MAX) return -EINVAL;
+    /* a batch of the whole ring would overwrite its own start */
+    if (cap >= log->payload_max / rec_size) return -EINVAL;
+    if (len < LOG_STAGE_MEM_SIZE(rec_size, cap) || ((uintptr_t)mem & 3)) return -EINVAL;
+
+    memset(st, 0, sizeof(*st));
+    st->log = log;
+    st->rec_size = rec_size;
+    st->cap = cap;
+    st->hdr = mem;
+    st->crc = (uint32_t *)(st->hdr + 2);
+    st->data = (uint8_t *)(st->crc + cap);
+    k_mutex_init(&st->lock);
+    return 0;
+}
+
+/* -------- Flush -------- */
+
+static uint32_t now_us(void)
+{
+    return (uint32_t)k_ticks_to_us_floor64(k_uptime_ticks());
+}
+
+static int flush_locked(struct log_stage *st)
+{
+    uint32_t records;
+
+    if (st->cur.count == 0) return 0;
+
+    int rc = ring_log_records(st->log, &records);
+    if (rc) return rc;
+
+    /* recovery tells a committed batch by the moved count */
+    st->cur.flushing = 1;
+    st->cur.flush_records = records;
+    rc = hdr_commit(st);
+    if (rc) return rc;
+    if (st->cut == LOG_STAGE_CUT_MARKED) return -EINTR;
+
+    uint32_t t0 = now_us();
+    rc = ring_log_write_batch(st->log, st->data, st->cur.count, st->rec_size);
+    if (rc) {
+        st->flush_errors++;
+        st->cur.flushing = 0;
+        (void)hdr_commit(st);
+        return rc;
+    }
+    if (st->cut == LOG_STAGE_CUT_SYNCED) return -EINTR;
+
+    st->flush_last_us = now_us() - t0;
+    st->flush_max_us = MAX(st->flush_max_us, st->flush_last_us);
+    st->flushes++;
+    st->flushed += st->cur.count;
+    return empty(st);
+}
+
+int log_stage_flush(struct log_stage *st)
+{
+    k_mutex_lock(&st->lock, K_FOREVER);
+    int rc = flush_locked(st);
+    k_mutex_unlock(&st->lock);
+    return rc;
+}
+
+int log_stage_append(struct log_stage *st, const void *rec)
+{
+    int rc = 0;
+
+    k_mutex_lock(&st->lock, K_FOREVER);
+    if (st->cur.count == st->cap) {
+        rc = flush_locked(st);
+    }
+    if (rc == 0) {
+        uint32_t i = st->cur.count;
+
+        memcpy(st->data + i * st->rec_size, rec, st->rec_size);
+        st->crc[i] = slot_crc(st, i);
+        if (st->cut == LOG_STAGE_CUT_SLOT) {
+            rc = -EINTR;
+        } else {
+            st->cur.count++;
+            rc = hdr_commit(st);
+        }
+    }
+    k_mutex_unlock(&st->lock);
+    return rc;
+}
+
+uint32_t log_stage_pending(struct log_stage *st)
+{
+    k_mutex_lock(&st->lock, K_FOREVER);
+    uint32_t n = st->cur.count;
+    k_mutex_unlock(&st->lock);
+    return n;
+}
+
+void log_stage_stats_get(struct log_stage *st, struct log_stage_stats *out)
+{
+    k_mutex_lock(&st->lock, K_FOREVER);
+    out->cap = st->cap;
+    out->pending = st->cur.count;
+    out->flushes = st->flushes;
+    out->flushed = st->flushed;
+    out->flush_errors = st->flush_errors;
+    out->flush_last_us = st->flush_last_us;
+    out->flush_max_us = st->flush_max_us;
+    out->warm_boots = st->cur.warm_boots;
+    k_mutex_unlock(&st->lock);
+}
+
+/* -------- Recovery -------- */
+
+int log_stage_recover(struct log_stage *st, struct log_stage_recovery *out)
+{
+    const struct log_stage_hdr *a = &st->hdr[0], *b = &st->hdr[1];
+    bool va = hdr_valid(st, a), vb = hdr_valid(st, b);
+    int rc = 0;
+
+    memset(out, 0, sizeof(*out));
+    k_mutex_lock(&st->lock, K_FOREVER);
+
+    if (!va && !vb) {
+        /* power-on contents, another layout, or both copies torn */
+        memset(&st->cur, 0, sizeof(st->cur));
+        st->cur.magic = STAGE_MAGIC;
+        st->cur.rec_size = st->rec_size;
+        st->cur.cap = st->cap;
+        rc = empty(st);
+        goto out;
+    }
+
+    st->cur = (va && (!vb || (int32_t)(a->seq - b->seq) > 0)) ? *a : *b;
+    st->cur.warm_boots++;
+    out->warm = true;
+    out->warm_boots = st->cur.warm_boots;
+
+    uint32_t n = st->cur.count;
+
+    if (st->cur.flushing) {
+        uint32_t records;
+
+        rc = ring_log_records(st->log, &records);
+        if (rc) goto out;  /* leave the area for the next boot */
+        if (records != st->cur.flush_records) {
+            out->committed = n;
+            n = 0;
+        }
+    }
+    for (uint32_t i = 0; i < n; i++) {
+        if (st->crc[i] != slot_crc(st, i)) {
+            out->corrupt = n - i;
+            n = i;
+            break;
+        }
+    }
+
+    if (n) {
+        st->cur.count = n;
+        st->cur.flushing = 0;
+        rc = flush_locked(st);
+        if (rc == 0) out->replayed = n;
+    } else {
+        rc = empty(st);
+    }
+out:
+    k_mutex_unlock(&st->lock);
+    return rc;
+}
+
+/* -------- Retained memory -------- */
+
+#if defined(CONFIG_BOARD_NATIVE_SIM)
+/* native/retained_ram.c */
+void *app_retained_map(const char *path, size_t len);
+
+static const char *stage_ram_path = "retained.bin";
+
+static void stage_options(void)
+{
+    static struct args_struct_t opts[] = {
+        { .option = "stage-ram", .name = "file", .type = 's', .dest = (void *)&stage_ram_path,
+          .descript = "Host file standing in for the log stage's retained RAM" },
+        ARG_TABLE_ENDMARKER
+    };
+
+    native_add_command_line_opts(opts);
+}
+
+NATIVE_TASK(stage_options, PRE_BOOT_1, 1);
+
+void *log_stage_retained(void *noinit, size_t len)
+{
+    void *p = app_retained_map(stage_ram_path, len);
+
+    return p ? p : noinit;
+}
+#else
+void *log_stage_retained(void *noinit, size_t len)
+{
+    ARG_UNUSED(len);
+    return noinit;
+}
+#endif
+
+/* -------- Check -------- */
+
+#define CHECK_PATH      LOG_MOUNT_POINT "/stage.bin"
+#define CHECK_MAGIC     0x53434B31u /* 'SCK1' */
+#define CHECK_REC       32
+#define CHECK_CAP       16
+#define CHECK_PAYLOAD   (CHECK_REC * 128)
+#define CHECK_RATE_RECS 128
+
+struct check_rec {
+    uint32_t seq;
+    uint8_t fill[CHECK_REC - sizeof(uint32_t)];
+};
+
+BUILD_ASSERT(sizeof(struct check_rec) == CHECK_REC);
+
+enum check_kind {
+    CHECK_CLEAN,
+    CHECK_STAGED,
+    CHECK_SLOT,
+    CHECK_HEADER,
+    CHECK_MARKED,
+    CHECK_SYNCED,
+    CHECK_CORRUPT,
+    CHECK_COLD,
+};
+
+static const char *const check_names[] = {
+    "clean", "staged", "torn_slot", "torn_header", "marked", "synced", "corrupt", "cold",
+};
+
+/* the reset runs, then two throughput runs */
+BUILD_ASSERT(ARRAY_SIZE(check_names) + 2 == LOG_STAGE_CHECK_RUNS);
+
+static struct ring_log check_log = RING_LOG_INIT(CHECK_PATH, CHECK_MAGIC, CHECK_PAYLOAD);
+static struct log_stage check_stage;
+static uint8_t __aligned(4) check_mem[LOG_STAGE_MEM_SIZE(CHECK_REC, CHECK_CAP)];
+
+static void check_fill(struct check_rec *r, uint32_t seq)
+{
+    r->seq = seq;
+    memset(r->fill, (uint8_t)seq, sizeof(r->fill));
+}
+
+/* A fresh log and an area of power-on garbage */
+static int check_start(void)
+{
+    struct log_stage_recovery rec;
+
+    (void)fs_unlink(CHECK_PATH);
+    int rc = ring_log_open(&check_log);
+    if (rc) return rc;
+
+    memset(check_mem, 0xA5, sizeof(check_mem));
+    rc = log_stage_init(&check_stage, &check_log, CHECK_REC, CHECK_CAP, check_mem,
+                        sizeof(check_mem));
+    if (rc == 0) rc = log_stage_recover(&check_stage, &rec);
+    if (rc) (void)ring_log_close(&check_log);
+    return rc;
+}
+
+/* Records in the file, which must be 0, 1, 2... intact */
+static int check_read(uint32_t *logged)
+{
+    struct check_rec r, want;
+    uint32_t base = RING_LOG_BASE_CURRENT, total = 0, off = 0;
+    int n;
+
+    *logged = 0;
+    while ((n = ring_log_read_ordered(&check_log, CHECK_REC, &base, off, &r, sizeof(r),
+                                      &total)) > 0) {
+        check_fill(&want, *logged);
+        if (n != sizeof(r) || memcmp(&r, &want, sizeof(r)) != 0) return -EBADMSG;
+        (*logged)++;
+        off += n;
+    }
+    return n;
+}
+
+static int check_reset(enum check_kind kind, struct log_stage_check_result *out)
+{
+    struct check_rec r;
+    /* one flush on the way, a quarter of the area staged */
+    const uint32_t n = CHECK_CAP + CHECK_CAP / 4;
+    const uint32_t staged = n - CHECK_CAP;
+    struct log_stage_recovery want = { .warm = true, .replayed = staged };
+
+    int rc = check_start();
+    if (rc) return rc;
+
+    for (uint32_t i = 0; i < n && rc == 0; i++) {
+        check_fill(&r, i);
+        rc = log_stage_append(&check_stage, &r);
+        if (rc == 0) out->acked++;
+    }
+    out->expected = out->acked;
+
+    /* up to the reset */
+    switch (kind) {
+    case CHECK_CLEAN:
+        rc = log_stage_flush(&check_stage);
+        want.replayed = 0;
+        break;
+    case CHECK_STAGED:
+        break;
+    case CHECK_SLOT:
+    case CHECK_HEADER:
+        check_stage.cut = (kind == CHECK_SLOT) ? LOG_STAGE_CUT_SLOT : LOG_STAGE_CUT_HEADER;
+        check_fill(&r, n);
+        if (rc == 0) rc = (log_stage_append(&check_stage, &r) == -EINTR) ? 0 : -EFAULT;
+        break;
+    case CHECK_MARKED:
+    case CHECK_SYNCED:
+        check_stage.cut = (kind == CHECK_MARKED) ? LOG_STAGE_CUT_MARKED : LOG_STAGE_CUT_SYNCED;
+        if (rc == 0) rc = (log_stage_flush(&check_stage) == -EINTR) ? 0 : -EFAULT;
+        if (kind == CHECK_SYNCED) {
+            want.replayed = 0;
+            want.committed = staged;
+        }
+        break;
+    case CHECK_CORRUPT:
+        /* the second staged record and the two after it are lost */
+        check_stage.data[1 * CHECK_REC + 4] ^= 0xFF;
+        out->expected = CHECK_CAP + 1;
+        want.replayed = 1;
+        want.corrupt = staged - 1;
+        break;
+    case CHECK_COLD:
+        memset(check_mem, 0xA5, sizeof(check_mem));
+        out->expected = CHECK_CAP;
+        want = (struct log_stage_recovery){ 0 };
+        break;
+    }
+
+    /* reboot: the log reopened, the area as the reset left it */
+    int rc2 = ring_log_close(&check_log);
+    if (rc == 0) rc = rc2;
+    if (rc) return rc;
+    rc = ring_log_open(&check_log);
+    if (rc) return rc;
+    rc = log_stage_init(&check_stage, &check_log, CHECK_REC, CHECK_CAP, check_mem,
+                        sizeof(check_mem));
+    if (rc == 0) rc = log_stage_recover(&check_stage, &out->rec);
+    if (rc == 0) rc = check_read(&out->logged);
+    rc2 = ring_log_close(&check_log);
+    if (rc == 0) rc = rc2;
+
+    out->ok = rc == 0 && out->logged == out->expected && out->rec.warm == want.warm &&
+              out->rec.replayed == want.replayed && out->rec.committed == want.committed &&
+              out->rec.corrupt == want.corrupt;
+    return rc;
+}
+
+/* CHECK_RATE_RECS records with a sync each, or through the stage */
+static int check_rate(bool staged, struct log_stage_check_result *out)
+{
+    struct check_rec r;
+
+    int rc = check_start();
+    if (rc) return rc;
+
+    uint32_t t0 = now_us();
+    for (uint32_t i = 0; i < CHECK_RATE_RECS && rc == 0; i++) {
+        check_fill(&r, i);
+        rc = staged ? log_stage_append(&check_stage, &r)
+                    : ring_log_write(&check_log, &r, sizeof(r));
+        if (rc == 0) out->acked++;
+    }
+    if (rc == 0 && staged) rc = log_stage_flush(&check_stage);
+    uint32_t us = now_us() - t0;
+
+    if (rc == 0) rc = check_read(&out->logged);
+    int rc2 = ring_log_close(&check_log);
+    if (rc == 0) rc = rc2;
+
+    out->expected = CHECK_RATE_RECS;
+    out->rps = us ? (uint32_t)((uint64_t)out->acked * 1000000u / us) : 0;
+    out->ok = rc == 0 && out->logged == out->expected;
+    return rc;
+}
+
+int log_stage_check(struct log_stage_check_result *out)
+{
+    memset(out, 0, LOG_STAGE_CHECK_RUNS * sizeof(*out));
+
+    int rc = log_fs_mount();
+
+    for (size_t i = 0; i < LOG_STAGE_CHECK_RUNS; i++) {
+        struct log_stage_check_result *r = &out[i];
+
+        if (i < ARRAY_SIZE(check_names)) {
+            r->name = check_names[i];
+            r->rc = rc ? rc : check_reset(i, r);
+        } else {
+            bool staged = i > ARRAY_SIZE(check_names);
+
+            r->name = staged ? "rate_staged" : "rate_sync_each";
+            r->rc = rc ? rc : check_rate(staged, r);
+        }
+        check_stage.cut = LOG_STAGE_CUT_NONE;
+    }
+
+    (void)fs_unlink(CHECK_PATH);
+    return rc;
+}
+
+int log_stage_check_json(const struct log_stage_check_result *r, char *buf, size_t len)
+{
+    int n = snprintf(buf, len,
+                     "{\"board\":\"%s\",\"stage\":\"%s\",\"rc\":%d,\"ok\":%s,\"acked\":%u,"
+                     "\"logged\":%u,\"expected\":%u,\"warm\":%s,\"replayed\":%u,"
+                     "\"committed\":%u,\"corrupt\":%u,\"rps\":%u}",
+                     CONFIG_BOARD, r->name, r->rc, r->ok ? "true" : "false", r->acked,
+                     r->logged, r->expected, r->rec.warm ? "true" : "false", r->rec.replayed,
+                     r->rec.committed, r->rec.corrupt, r->rps);
+    return (n < 0 || (size_t)n >= len) ? -ENOMEM : n;
+}
+
+#endif /* CONFIG_APP_LOG_STAGE */
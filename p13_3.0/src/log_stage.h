@@ -0,0 +1,143 @@
+#ifndef LOG_STAGE_H
+#define LOG_STAGE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <zephyr/kernel.h>
+
+#include "ring_log.h"
+
+/*
+ * Retained-RAM staging for a ring_log (CONFIG_APP_LOG_STAGE). Records
+ * collect in memory that a warm reset leaves alone (__noinit; a host
+ * file on native_sim) and go to the log in batches, one header write and
+ * one fs_sync per flush instead of per record. At boot
+ * log_stage_recover() writes out whatever a reset left staged, before
+ * new records come in.
+ *
+ * The area starts with two copies of its header, each with a CRC and a
+ * sequence number, written in turn: a reset halfway through a header
+ * update leaves the previous copy. Every slot has a CRC over the
+ * staging generation, the slot index and the record, so slots left from
+ * before the area last emptied never pass. A flush first stamps the
+ * header with the log's record count; if the count has moved by the
+ * time recovery runs, the batch was committed (LittleFS commits at the
+ * sync) and is not written twice. A batch is smaller than the log's
+ * ring, so it never overwrites itself.
+ *
+ * A record survives a warm reset once log_stage_append() returns, and a
+ * power cut once it has been flushed. Readers of the log (query, export)
+ * see flushed records only.
+ */
+
+struct log_stage_hdr {
+    uint32_t magic;
+    uint32_t seq;           /* the valid copy with the higher one wins */
+    uint16_t rec_size;
+    uint16_t cap;
+    uint32_t gen;           /* bumped whenever the area empties */
+    uint32_t count;         /* records staged */
+    uint32_t flushing;      /* a flush began with the log at flush_records */
+    uint32_t flush_records;
+    uint32_t warm_boots;    /* recoveries that found the area valid */
+    uint32_t crc;           /* of the fields above */
+};
+
+/* Bytes of retained memory for cap records of rec_size */
+#define LOG_STAGE_MEM_SIZE(rec_size, cap) \
+    (2 * sizeof(struct log_stage_hdr) + (cap) * (sizeof(uint32_t) + (rec_size)))
+
+/* Check harness: where log_stage_check() stops, as a reset would */
+enum log_stage_cut {
+    LOG_STAGE_CUT_NONE,
+    LOG_STAGE_CUT_SLOT,     /* record in its slot, header not updated */
+    LOG_STAGE_CUT_HEADER,   /* half of the header copy written */
+    LOG_STAGE_CUT_MARKED,   /* flush stamped, nothing written to the log */
+    LOG_STAGE_CUT_SYNCED,   /* batch committed, area not emptied */
+};
+
+struct log_stage {
+    struct ring_log *log;
+    size_t rec_size;
+    uint32_t cap;
+    struct log_stage_hdr *hdr;  /* [2], retained */
+    uint32_t *crc;              /* [cap], retained */
+    uint8_t *data;              /* [cap * rec_size], retained */
+    struct log_stage_hdr cur;   /* the newest header */
+    struct k_mutex lock;
+    enum log_stage_cut cut;
+    uint32_t flushes;
+    uint32_t flushed;           /* records */
+    uint32_t flush_errors;
+    uint32_t flush_last_us;
+    uint32_t flush_max_us;
+};
+
+struct log_stage_recovery {
+    bool warm;              /* the area was valid */
+    uint32_t replayed;      /* records written to the log */
+    uint32_t committed;     /* dropped: their flush had been committed */
+    uint32_t corrupt;       /* dropped: slot CRC, and every slot after it */
+    uint32_t warm_boots;
+};
+
+struct log_stage_stats {
+    uint32_t cap;
+    uint32_t pending;
+    uint32_t flushes;
+    uint32_t flushed;
+    uint32_t flush_errors;
+    uint32_t flush_last_us;
+    uint32_t flush_max_us;
+    uint32_t warm_boots;
+};
+
+/*
+ * Binds the stage to an open log and its memory (len at least
+ * LOG_STAGE_MEM_SIZE(rec_size, cap)); cap must be below the records the
+ * log holds. The memory is not touched until log_stage_recover().
+ */
+int log_stage_init(struct log_stage *st, struct ring_log *log, size_t rec_size, uint32_t cap,
+                   void *mem, size_t len);
+/* Replays what the area holds into the log, then empties it */
+int log_stage_recover(struct log_stage *st, struct log_stage_recovery *out);
+/* Flushes first when the area is full; on a flush error the record is not staged */
+int log_stage_append(struct log_stage *st, const void *rec);
+int log_stage_flush(struct log_stage *st);
+uint32_t log_stage_pending(struct log_stage *st);
+void log_stage_stats_get(struct log_stage *st, struct log_stage_stats *out);
+
+/*
+ * The memory for a stage: noinit itself on hardware; on native_sim a
+ * host file mapped in its place (--stage-ram, retained.bin by default),
+ * which outlives the process the way __noinit RAM outlives a warm reset.
+ */
+void *log_stage_retained(void *noinit, size_t len);
+
+/*
+ * Simulated resets on /lfs/stage.bin: records are staged and flushed,
+ * the run stops at a cut point, the log is reopened and recovered as at
+ * boot, and the file must then hold every acknowledged record once and
+ * in order. Then record throughput with a sync per record against
+ * staged batches.
+ */
+struct log_stage_check_result {
+    const char *name;
+    int rc;
+    bool ok;
+    uint32_t acked;         /* append returned 0 */
+    uint32_t logged;        /* in the file after recovery */
+    uint32_t expected;
+    struct log_stage_recovery rec;
+    uint32_t rps;           /* throughput runs only */
+};
+
+#define LOG_STAGE_CHECK_RUNS 10
+
+/* Fills all of out[LOG_STAGE_CHECK_RUNS]; returns 0 or the setup's -errno */
+int log_stage_check(struct log_stage_check_result *out);
+/* One line of JSON, no newline; returns the length or -ENOMEM */
+int log_stage_check_json(const struct log_stage_check_result *r, char *buf, size_t len);
+
+#endif /* LOG_STAGE_H */
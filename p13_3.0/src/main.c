@@ -1,10 +1,9 @@
 #include <zephyr/kernel.h>
 #include <zephyr/fs/fs.h>
-#include <zephyr/fs/littlefs.h>
-#include <zephyr/storage/flash_map.h>
 #include <zephyr/logging/log.h>
 #include <zephyr/device.h>
 #include <zephyr/drivers/sensor.h>
+#include <stdlib.h>
 #include <string.h>
 #include <zephyr/shell/shell.h>
 
@@ -12,34 +11,61 @@
 #include "hum_temp_sensor.h"
 #include "pressure_sensor.h"
 #include "imu_sensor.h"
+#include "telemetry.h"
+#include "fixed_fmt.h"
+#include "sensor_stats.h"
+#include "compress.h"
+#include "imu_fusion.h"
+#include "imu_filter.h"
+#include "vib_fft.h"
+#include "baro_alt.h"
+#include "ring_log.h"
+#include "log_bench.h"
+#include "log_fault.h"
+#include "pipe_trace.h"
+#include "duty.h"
+#include "sensor_engine.h"
+#include "smp_log.h"
+#include "align.h"
+#include "log_query.h"
+#include "log_stage.h"
+#include "raw_log.h"
 
 /* -------- Logging -------- */
 LOG_MODULE_REGISTER(app, LOG_LEVEL_INF);
 
-/* Mount point & partition */
-static int littlefs_mount(void);
-static int log_open(void);
-static int log_write_snapshot(const struct all_sensors_data *d);
-
-/* Avoid symbol clash with littlefs function lfs_mount() */
-static struct fs_mount_t lfs_mnt;
+#define LOG_FILE_PATH     LOG_MOUNT_POINT "/sensor_log.bin"
 
-/* LittleFS backing storage descriptor */
-static struct fs_file_t log_file;
+/* Window statistics log (CONFIG_APP_STATS_LOG_ONLY): two rotating files */
+#define STATS_LOG_PATH     LOG_MOUNT_POINT "/stats_log.bin"
+#define STATS_LOG_OLD_PATH LOG_MOUNT_POINT "/stats_log.old"
+#define STATS_LOG_MAX      (16 * 1024)
 
-#define LOG_MOUNT_POINT   "/lfs"
-#define LOG_FILE_PATH     LOG_MOUNT_POINT "/sensor_log.bin"
+/* Vibration features (CONFIG_APP_VIB): same scheme, one record per window */
+#define VIB_LOG_PATH       LOG_MOUNT_POINT "/vib_log.bin"
+#define VIB_LOG_OLD_PATH   LOG_MOUNT_POINT "/vib_log.old"
+#define VIB_LOG_MAX        (16 * 1024)
 
 /* Circular logging parameters */
-#define LOG_HEADER_MAGIC  0x53454E31u /* 'SEN1' */
-struct log_header {
-    uint32_t magic;
-    uint32_t write_off; /* offset within payload area (not counting header) */
-};
+#define LOG_HEADER_MAGIC  0x53454E35u /* 'SEN5': per-group acquisition times + valid mask */
 
 /* Upper bound for file payload; keep conservative inside 128KB partition */
 #define LOG_PAYLOAD_MAX   (64 * 1024) /* 64KB for payload */
-#define LOG_HEADER_SIZE   (sizeof(struct log_header))
+
+static struct ring_log snap_log = RING_LOG_INIT(LOG_FILE_PATH, LOG_HEADER_MAGIC, LOG_PAYLOAD_MAX);
+
+#if defined(CONFIG_APP_RAW_LOG)
+/* The logs_raw partition as a record log, read in place (raw_log.h); it
+ * takes the snapshots with CONFIG_APP_RAW_LOG_SNAP
+ */
+#define RAW_LOG_NAME      "logs_raw"
+static struct raw_log snap_raw;
+
+static int raw_open(void)
+{
+    return raw_log_open(&snap_raw, FIXED_PARTITION_ID(logs_raw), sizeof(struct all_sensors_data));
+}
+#endif
 
 /* -------- IPC: message queue -------- */
 K_MSGQ_DEFINE(sensor_q, sizeof(struct all_sensors_data), 32, 4);
@@ -48,6 +74,11 @@ K_MSGQ_DEFINE(sensor_q, sizeof(struct all_sensors_data), 32, 4);
 static struct all_sensors_data g_last;
 static struct k_mutex g_last_lock;
 
+#if defined(CONFIG_APP_COMPRESS)
+/* Logger thread feeds, shell reconfigures */
+static K_MUTEX_DEFINE(compress_lock);
+#endif
+
 /* -------- Threads & stacks -------- */
 #define STACK_SZ 2048
 K_THREAD_STACK_DEFINE(ht_stack,    STACK_SZ);
@@ -60,120 +91,478 @@ static struct k_thread press_thread_data;
 static struct k_thread imu_thread_data;
 static struct k_thread log_thread_data;
 
+/* -------- Sample output accounting -------- */
+/* Time the sampling loops spend emitting output (printk or telemetry) */
+static struct k_spinlock emit_lock;
+static uint64_t emit_cycles;
+static uint32_t emit_calls;
+
+static void emit_account(uint32_t start)
+{
+    uint32_t d = k_cycle_get_32() - start;
+
+    k_spinlock_key_t key = k_spin_lock(&emit_lock);
+    emit_cycles += d;
+    emit_calls++;
+    k_spin_unlock(&emit_lock, key);
+}
+
 /* -------- Sensor producer threads -------- */
+#if defined(CONFIG_APP_BARO_ALT)
+/* Caller holds g_last_lock */
+static void merge_alt(struct all_sensors_data *snap)
+{
+    struct baro_alt_out a;
+
+    if (baro_alt_get(&a)) {
+        snap->alt.ts_ms = snap->timestamp_ms;
+        snap->alt.altitude = a.altitude;
+        snap->alt.vspeed = a.vspeed;
+        snap->valid |= SNAP_VALID(SNAP_GRP_ALT);
+    }
+}
+#endif
+
+static void enqueue_snapshot(const struct all_sensors_data *snap, enum pipe_src src)
+{
+#if defined(CONFIG_APP_STATS_LOG_ONLY)
+    /* only window statistics are persisted */
+    ARG_UNUSED(snap);
+    ARG_UNUSED(src);
+#else
+    /* try to queue; if full, drop oldest then put */
+    if (k_msgq_put(&sensor_q, snap, K_NO_WAIT) != 0) {
+        struct all_sensors_data trash;
+        k_msgq_get(&sensor_q, &trash, K_NO_WAIT);
+        PIPE_TRACE(drop, src, 0);
+        k_msgq_put(&sensor_q, snap, K_NO_WAIT);
+    }
+    PIPE_TRACE(enqueue, src, k_msgq_num_used_get(&sensor_q));
+#endif
+}
+
+/* A merged snapshot; groups: SNAP_VALID() bits it updated */
+static void publish_snapshot(const struct all_sensors_data *snap, enum pipe_src src,
+                             uint16_t groups)
+{
+#if defined(CONFIG_APP_ALIGN)
+    /* the log gets the aligned frames instead */
+    ARG_UNUSED(src);
+    align_push(snap, groups);
+#else
+    ARG_UNUSED(groups);
+    enqueue_snapshot(snap, src);
+#endif
+}
+
+#if defined(CONFIG_APP_ALIGN)
+/* System work queue, once per frame */
+static void align_emit(const struct all_sensors_data *frame)
+{
+    enqueue_snapshot(frame, PIPE_SRC_ALIGN);
+}
+#endif
+
 static void ht_thread(void *, void *, void *)
 {
     (void)hum_temp_sensor_init();
+#if defined(CONFIG_APP_DUTY_CYCLE)
+    duty_thread_start();
+#endif
     while (1) {
         int16_t t=0, h=0;
-        if (hum_temp_sensor_fetch(&t, &h) == 0) {
+        PIPE_TRACE(fetch_start, PIPE_SRC_HT, 0);
+        int rc = hum_temp_sensor_fetch(&t, &h);
+        PIPE_TRACE(fetch_end, PIPE_SRC_HT, rc);
+        if (rc == 0) {
             struct all_sensors_data snap;
+            uint32_t now = k_uptime_get_32();
 
+            PIPE_TRACE(merge_start, PIPE_SRC_HT, 0);
             k_mutex_lock(&g_last_lock, K_FOREVER);
             /* start from last, update our fields */
             snap = g_last;
+            snap.timestamp_ms = now;
+            snap.ht.ts_ms = now;
             snap.ht.temperature = t;
             snap.ht.humidity    = h;
+            snap.valid |= SNAP_VALID(SNAP_GRP_HT);
             g_last = snap;
             k_mutex_unlock(&g_last_lock);
+            PIPE_TRACE(merge_end, PIPE_SRC_HT, 0);
 
-            /* try to queue; if full, drop oldest then put */
-            if (k_msgq_put(&sensor_q, &snap, K_NO_WAIT) != 0) {
-                struct all_sensors_data trash;
-                k_msgq_get(&sensor_q, &trash, K_NO_WAIT);
-                k_msgq_put(&sensor_q, &snap, K_NO_WAIT);
-            }
+#if defined(CONFIG_APP_STATS)
+            sensor_stats_add(STATS_CH_TEMP, t);
+            sensor_stats_add(STATS_CH_HUM, h);
+#endif
+
+            publish_snapshot(&snap, PIPE_SRC_HT, SNAP_VALID(SNAP_GRP_HT));
 
+            uint32_t t0 = k_cycle_get_32();
+#if defined(CONFIG_APP_TELEMETRY)
+            (void)telemetry_send(TELEMETRY_SNAPSHOT, &snap, sizeof(snap));
+#else
             /* minimal UART prints (constant strings only) */
             printk("HT T=");
             printk("%d", (int)snap.ht.temperature);
             printk(" H=");
             printk("%d\n", (int)snap.ht.humidity);
+#endif
+            emit_account(t0);
         }
+#if defined(CONFIG_APP_DUTY_CYCLE)
+        duty_sleep(CONFIG_APP_DUTY_PERIOD_MS);
+#else
         k_sleep(K_MSEC(500));
+#endif
     }
 }
 
 static void press_thread(void *, void *, void *)
 {
     (void)pressure_sensor_init();
+#if defined(CONFIG_APP_DUTY_CYCLE)
+    duty_thread_start();
+#endif
     while (1) {
         int32_t p=0;
-        if (pressure_sensor_fetch(&p) == 0) {
+        PIPE_TRACE(fetch_start, PIPE_SRC_PRESS, 0);
+        int rc = pressure_sensor_fetch(&p);
+        PIPE_TRACE(fetch_end, PIPE_SRC_PRESS, rc);
+        if (rc == 0) {
             struct all_sensors_data snap;
+            uint32_t now = k_uptime_get_32();
 
+#if defined(CONFIG_APP_BARO_ALT)
+            baro_alt_pressure(p, now);
+#endif
+
+            PIPE_TRACE(merge_start, PIPE_SRC_PRESS, 0);
             k_mutex_lock(&g_last_lock, K_FOREVER);
             snap = g_last;
+            snap.timestamp_ms = now;
+            snap.press.ts_ms = now;
             snap.press.pressure = p;
+            snap.valid |= SNAP_VALID(SNAP_GRP_PRESS);
+#if defined(CONFIG_APP_BARO_ALT)
+            merge_alt(&snap);
+#endif
             g_last = snap;
             k_mutex_unlock(&g_last_lock);
+            PIPE_TRACE(merge_end, PIPE_SRC_PRESS, 0);
 
-            if (k_msgq_put(&sensor_q, &snap, K_NO_WAIT) != 0) {
-                struct all_sensors_data trash;
-                k_msgq_get(&sensor_q, &trash, K_NO_WAIT);
-                k_msgq_put(&sensor_q, &snap, K_NO_WAIT);
-            }
+#if defined(CONFIG_APP_STATS)
+            sensor_stats_add(STATS_CH_PRESS, p);
+#if defined(CONFIG_APP_BARO_ALT)
+            sensor_stats_add(STATS_CH_ALT, snap.alt.altitude);
+            sensor_stats_add(STATS_CH_VZ, snap.alt.vspeed);
+#endif
+#endif
 
+            publish_snapshot(&snap, PIPE_SRC_PRESS,
+                             SNAP_VALID(SNAP_GRP_PRESS) | SNAP_VALID(SNAP_GRP_ALT));
+
+            uint32_t t0 = k_cycle_get_32();
+#if defined(CONFIG_APP_TELEMETRY)
+            (void)telemetry_send(TELEMETRY_SNAPSHOT, &snap, sizeof(snap));
+#else
             printk("P ");
             printk("%d\n", (int)snap.press.pressure);
+#endif
+            emit_account(t0);
         }
+#if defined(CONFIG_APP_DUTY_CYCLE)
+        duty_sleep(CONFIG_APP_DUTY_PERIOD_MS);
+#else
         k_sleep(K_MSEC(500));
+#endif
     }
 }
 
+/* Merge one IMU sample into the snapshot and pass it on like the other producers */
+static void imu_publish(const int16_t acc[3], const int16_t gyr[3], uint32_t ts_ms)
+{
+    struct all_sensors_data snap;
+
+    PIPE_TRACE(merge_start, PIPE_SRC_IMU, 0);
+    k_mutex_lock(&g_last_lock, K_FOREVER);
+    snap = g_last;
+    snap.timestamp_ms = ts_ms;
+    snap.imu.ts_ms = ts_ms;
+    snap.valid |= SNAP_VALID(SNAP_GRP_IMU);
+    snap.imu.accel.x = acc[0];
+    snap.imu.accel.y = acc[1];
+    snap.imu.accel.z = acc[2];
+    snap.imu.gyro.x  = gyr[0];
+    snap.imu.gyro.y  = gyr[1];
+    snap.imu.gyro.z  = gyr[2];
+#if defined(CONFIG_APP_FUSION)
+    struct fusion_orientation o;
+    imu_fusion_get(&o);
+    snap.orient.roll  = o.roll;
+    snap.orient.pitch = o.pitch;
+    snap.orient.yaw   = o.yaw;
+    snap.valid |= SNAP_VALID(SNAP_GRP_ORIENT);
+#endif
+#if defined(CONFIG_APP_BARO_ALT)
+    merge_alt(&snap);
+#endif
+    g_last = snap;
+    k_mutex_unlock(&g_last_lock);
+    PIPE_TRACE(merge_end, PIPE_SRC_IMU, 0);
+
+#if defined(CONFIG_APP_STATS)
+    sensor_stats_add(STATS_CH_AX, acc[0]);
+    sensor_stats_add(STATS_CH_AY, acc[1]);
+    sensor_stats_add(STATS_CH_AZ, acc[2]);
+    sensor_stats_add(STATS_CH_GX, gyr[0]);
+    sensor_stats_add(STATS_CH_GY, gyr[1]);
+    sensor_stats_add(STATS_CH_GZ, gyr[2]);
+#if defined(CONFIG_APP_FUSION)
+    sensor_stats_add(STATS_CH_ROLL, snap.orient.roll);
+    sensor_stats_add(STATS_CH_PITCH, snap.orient.pitch);
+    sensor_stats_add(STATS_CH_YAW, snap.orient.yaw);
+#endif
+#endif
+
+    publish_snapshot(&snap, PIPE_SRC_IMU, SNAP_VALID(SNAP_GRP_IMU) |
+                     SNAP_VALID(SNAP_GRP_ORIENT) | SNAP_VALID(SNAP_GRP_ALT));
+
+    uint32_t t0 = k_cycle_get_32();
+#if defined(CONFIG_APP_TELEMETRY)
+    (void)telemetry_send(TELEMETRY_SNAPSHOT, &snap, sizeof(snap));
+#else
+    printk("IMU A:");
+    printk("%d", (int)snap.imu.accel.x); printk(",");
+    printk("%d", (int)snap.imu.accel.y); printk(",");
+    printk("%d", (int)snap.imu.accel.z); printk(" G:");
+    printk("%d", (int)snap.imu.gyro.x);  printk(",");
+    printk("%d", (int)snap.imu.gyro.y);  printk(",");
+    printk("%d\n", (int)snap.imu.gyro.z);
+#endif
+    emit_account(t0);
+}
+
+/* Raw samples (or filter outputs) per published snapshot */
+static void imu_decimate(const int16_t acc[3], const int16_t gyr[3], uint32_t ts_ms)
+{
+    static uint32_t since_publish;
+
+    if (++since_publish >= CONFIG_APP_IMU_PUBLISH_EVERY) {
+        since_publish = 0;
+        imu_publish(acc, gyr, ts_ms);
+    }
+}
+
+#if defined(CONFIG_APP_VIB)
+/* Worker thread context, once per FFT window */
+static void vib_publish(const struct vib_features *f)
+{
+    /* the window is long; the file system is mounted by then unless it failed */
+    int rc = log_append_rotating(VIB_LOG_PATH, VIB_LOG_OLD_PATH, VIB_LOG_MAX, f, sizeof(*f));
+    if (rc) {
+        LOG_ERR("vib log write err %d", rc);
+    }
+#if defined(CONFIG_APP_TELEMETRY)
+    (void)telemetry_send(TELEMETRY_VIB, f, sizeof(*f));
+#endif
+}
+#endif
+
 static void imu_thread(void *, void *, void *)
 {
     (void)imu_sensor_init();
-    while (1) {
-        int16_t ax=0, ay=0, az=0, gx=0, gy=0, gz=0;
-        if (imu_sensor_fetch(&ax, &ay, &az, &gx, &gy, &gz) == 0) {
-            struct all_sensors_data snap;
+    if (CONFIG_APP_IMU_PERIOD_MS < 100) {
+        /* the driver's default ODR would repeat samples at this period */
+        int rc = imu_sensor_set_odr(1000 / CONFIG_APP_IMU_PERIOD_MS);
+        if (rc) {
+            LOG_WRN("IMU ODR not set (%d)", rc);
+        }
+    }
 
-            k_mutex_lock(&g_last_lock, K_FOREVER);
-            snap = g_last;
-            snap.imu.accel.x = ax;
-            snap.imu.accel.y = ay;
-            snap.imu.accel.z = az;
-            snap.imu.gyro.x  = gx;
-            snap.imu.gyro.y  = gy;
-            snap.imu.gyro.z  = gz;
-            g_last = snap;
-            k_mutex_unlock(&g_last_lock);
+    int64_t next = k_uptime_get();
+    int64_t last_ticks = k_uptime_ticks();
+#if defined(CONFIG_APP_DUTY_CYCLE)
+    duty_thread_start();
+#endif
 
-            if (k_msgq_put(&sensor_q, &snap, K_NO_WAIT) != 0) {
-                struct all_sensors_data trash;
-                k_msgq_get(&sensor_q, &trash, K_NO_WAIT);
-                k_msgq_put(&sensor_q, &snap, K_NO_WAIT);
-            }
+    while (1) {
+        int16_t acc[3] = { 0 }, gyr[3] = { 0 };
+        PIPE_TRACE(fetch_start, PIPE_SRC_IMU, 0);
+        int frc = imu_sensor_fetch(&acc[0], &acc[1], &acc[2], &gyr[0], &gyr[1], &gyr[2]);
+        PIPE_TRACE(fetch_end, PIPE_SRC_IMU, frc);
+        if (frc == 0) {
+            int64_t now = k_uptime_ticks();
+            uint32_t dt_us = k_ticks_to_us_near32((uint32_t)(now - last_ticks));
+            last_ticks = now;
+            ARG_UNUSED(dt_us);
 
-            printk("IMU A:");
-            printk("%d", (int)snap.imu.accel.x); printk(",");
-            printk("%d", (int)snap.imu.accel.y); printk(",");
-            printk("%d", (int)snap.imu.accel.z); printk(" G:");
-            printk("%d", (int)snap.imu.gyro.x);  printk(",");
-            printk("%d", (int)snap.imu.gyro.y);  printk(",");
-            printk("%d\n", (int)snap.imu.gyro.z);
+#if defined(CONFIG_APP_FUSION)
+            imu_fusion_update(acc, gyr, dt_us);
+#endif
+#if defined(CONFIG_APP_BARO_ALT) && defined(CONFIG_APP_FUSION)
+            struct fusion_orientation o;
+            imu_fusion_get(&o);
+            baro_alt_accel(acc, o.q, dt_us);
+#elif defined(CONFIG_APP_BARO_ALT)
+            /* no attitude: assume the board is level */
+            baro_alt_accel(acc, NULL, dt_us);
+#endif
+#if defined(CONFIG_APP_VIB)
+            /* full-rate accel: the spectrum needs the unfiltered band */
+            vib_fft_push(acc, k_uptime_get_32());
+#endif
+#if defined(CONFIG_APP_VIB_FEATURES_ONLY)
+            /* features replace the raw stream */
+#elif defined(CONFIG_APP_IMU_FILTER)
+            imu_filter_push(acc, gyr, k_uptime_get_32(), imu_decimate);
+#else
+            imu_decimate(acc, gyr, k_uptime_get_32());
+#endif
         }
-        k_sleep(K_MSEC(500));
+
+#if defined(CONFIG_APP_DUTY_CYCLE)
+        /* on the same boundaries as the other sensors */
+        ARG_UNUSED(next);
+        duty_sleep(CONFIG_APP_IMU_PERIOD_MS);
+#else
+        /* absolute deadlines so the period does not stretch by the loop time */
+        next += CONFIG_APP_IMU_PERIOD_MS;
+        if (next < k_uptime_get()) {
+            next = k_uptime_get();
+        }
+        k_sleep(K_TIMEOUT_ABS_MS(next));
+#endif
     }
 }
 
 /* -------- Logger consumer thread -------- */
+static int snap_open(void)
+{
+#if defined(CONFIG_APP_RAW_LOG_SNAP)
+    return raw_open();
+#else
+    return ring_log_open(&snap_log);
+#endif
+}
+
+#if defined(CONFIG_APP_LOG_STAGE)
+/* Staged snapshots; a warm reset leaves this RAM alone (log_stage.h) */
+#define STAGE_MEM_SIZE LOG_STAGE_MEM_SIZE(sizeof(struct all_sensors_data), CONFIG_APP_LOG_STAGE_RECORDS)
+/* log_stage_init() refuses a batch that is not smaller than the ring */
+BUILD_ASSERT(CONFIG_APP_LOG_STAGE_RECORDS < LOG_PAYLOAD_MAX / sizeof(struct all_sensors_data));
+static __noinit uint8_t __aligned(4) snap_stage_mem[STAGE_MEM_SIZE];
+static struct log_stage snap_stage;
+static bool staged;
+static int64_t stage_flush_at;   /* the oldest staged snapshot's deadline */
+
+/* Before any new snapshot: write out what a reset left staged */
+static void stage_start(void)
+{
+    struct log_stage_recovery rec;
+
+    int rc = log_stage_init(&snap_stage, &snap_log, sizeof(struct all_sensors_data),
+                            CONFIG_APP_LOG_STAGE_RECORDS,
+                            log_stage_retained(snap_stage_mem, STAGE_MEM_SIZE), STAGE_MEM_SIZE);
+    if (rc == 0) rc = log_stage_recover(&snap_stage, &rec);
+    if (rc) {
+        LOG_ERR("log stage recovery failed (%d), writing through", rc);
+        return;
+    }
+    if (rec.warm) {
+        LOG_INF("Warm boot %u: %u staged snapshots replayed, %u already logged, %u corrupt",
+                rec.warm_boots, rec.replayed, rec.committed, rec.corrupt);
+    }
+    /* the replayed ones carry the last boot's uptime: not this boot's for log_query */
+    ring_log_mark_boot(&snap_log);
+    staged = true;
+}
+
+static k_timeout_t stage_wait(void)
+{
+    return (staged && log_stage_pending(&snap_stage)) ? K_TIMEOUT_ABS_MS(stage_flush_at)
+                                                     : K_FOREVER;
+}
+
+static int snap_write(const struct all_sensors_data *d)
+{
+    if (!staged) return ring_log_write(&snap_log, d, sizeof(*d));
+
+    int rc = log_stage_append(&snap_stage, d);
+    if (rc == 0 && log_stage_pending(&snap_stage) == 1) {
+        stage_flush_at = k_uptime_get() + CONFIG_APP_LOG_STAGE_FLUSH_MS;
+    }
+    return rc;
+}
+
+static void stage_flush_due(void)
+{
+    if (staged && log_stage_pending(&snap_stage) && k_uptime_get() >= stage_flush_at) {
+        int rc = log_stage_flush(&snap_stage);
+        if (rc) {
+            LOG_ERR("log stage flush err %d", rc);
+            stage_flush_at = k_uptime_get() + 1000;
+        }
+    }
+}
+#else
+static inline void stage_start(void) {}
+
+static inline k_timeout_t stage_wait(void)
+{
+    return K_FOREVER;
+}
+
+static inline int snap_write(const struct all_sensors_data *d)
+{
+#if defined(CONFIG_APP_RAW_LOG_SNAP)
+    return raw_log_append(&snap_raw, d);
+#else
+    return ring_log_write(&snap_log, d, sizeof(*d));
+#endif
+}
+
+static inline void stage_flush_due(void) {}
+#endif
+
 static void log_thread(void *, void *, void *)
 {
-    if (littlefs_mount() != 0) {
+    if (log_fs_mount() != 0) {
         LOG_ERR("FS mount failed");
         return;
     }
-    if (log_open() != 0) {
+    if (snap_open() != 0) {
         LOG_ERR("Open log failed");
         return;
     }
 
+#if defined(CONFIG_APP_STATS_LOG_ONLY)
+    while (1) {
+        struct stats_summary sum;
+        if (sensor_stats_wait_window(&sum, K_FOREVER) == 0) {
+            int rc = log_append_rotating(STATS_LOG_PATH, STATS_LOG_OLD_PATH, STATS_LOG_MAX,
+                                     &sum, sizeof(sum));
+            if (rc) {
+                LOG_ERR("stats log write err %d", rc);
+            }
+        }
+    }
+#else
+    stage_start();
     while (1) {
         struct all_sensors_data d;
-        if (k_msgq_get(&sensor_q, &d, K_FOREVER) == 0) {
-            int rc = log_write_snapshot(&d);
+
+        stage_flush_due();
+        if (k_msgq_get(&sensor_q, &d, stage_wait()) == 0) {
+            PIPE_TRACE(dequeue, 0, k_msgq_num_used_get(&sensor_q));
+#if defined(CONFIG_APP_COMPRESS)
+            struct all_sensors_data in = d;
+            k_mutex_lock(&compress_lock, K_FOREVER);
+            bool keep = compress_feed(&in, &d);
+            k_mutex_unlock(&compress_lock);
+            if (!keep) continue;
+#endif
+            int rc = snap_write(&d);
             if (rc) {
                 LOG_ERR("log write err %d", rc);
                 /* backoff a bit on error */
@@ -181,131 +570,1130 @@ static void log_thread(void *, void *, void *)
             }
         }
     }
+#endif
 }
 
-/* -------- LittleFS helpers -------- */
-static int littlefs_mount(void)
+static int cmd_clear_logs(const struct shell *shell, size_t argc, char **argv)
 {
-    /* Storage device: use the fixed partition from DTS */
-    static struct fs_littlefs lfs_data;
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
 
-    lfs_mnt.type = FS_LITTLEFS;
-    lfs_mnt.fs_data = &lfs_data;
-    lfs_mnt.storage_dev = (void *)FIXED_PARTITION_ID(logs_fs);
-    lfs_mnt.mnt_point = LOG_MOUNT_POINT;
+    int ret = fs_unlink(LOG_FILE_PATH);
+    if (ret == -ENOENT) {
+        shell_print(shell, "No log file to delete.");
+    } else if (ret) {
+        shell_error(shell, "Failed to delete log file (%d)", ret);
+        return ret;
+    } else {
+        shell_print(shell, "Log file deleted.");
+    }
+#if defined(CONFIG_APP_RAW_LOG_SNAP)
+    ret = raw_log_clear(&snap_raw);
+    if (ret) {
+        shell_error(shell, "Failed to erase %s (%d)", RAW_LOG_NAME, ret);
+        return ret;
+    }
+    shell_print(shell, "%s erased.", RAW_LOG_NAME);
+#endif
+    return 0;
+}
 
-    int rc = fs_mount(&lfs_mnt);
-    if (rc == 0) {
-        LOG_INF("Mounted at %s", LOG_MOUNT_POINT);
+SHELL_CMD_REGISTER(clear_logs, NULL, "Delete sensor_log.bin file", cmd_clear_logs);
+
+static int cmd_emit_stats(const struct shell *shell, size_t argc, char **argv)
+{
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    k_spinlock_key_t key = k_spin_lock(&emit_lock);
+    uint64_t cyc = emit_cycles;
+    uint32_t calls = emit_calls;
+    k_spin_unlock(&emit_lock, key);
+
+    uint64_t avg = calls ? cyc / calls : 0;
+    shell_print(shell, "emit calls=%u avg=%llu cyc (%llu ns)", calls,
+                (unsigned long long)avg,
+                (unsigned long long)k_cyc_to_ns_floor64(avg));
+
+#if defined(CONFIG_APP_TELEMETRY)
+    struct telemetry_stats st;
+    telemetry_stats_get(&st);
+    shell_print(shell, "telemetry frames=%u dropped=%u bytes=%u",
+                st.frames, st.dropped, st.bytes);
+#endif
+    return 0;
+}
+
+SHELL_CMD_REGISTER(emit_stats, NULL, "Time spent emitting samples in the sampling loops", cmd_emit_stats);
+
+static int cmd_sensors_last(const struct shell *shell, size_t argc, char **argv)
+{
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    struct all_sensors_data d;
+    char f[9][FIXED_FMT_BUF];
+
+    k_mutex_lock(&g_last_lock, K_FOREVER);
+    d = g_last;
+    k_mutex_unlock(&g_last_lock);
+
+    shell_print(shell, "T=%s C H=%s %%RH P=%s hPa",
+                fmt_fixed(f[0], d.ht.temperature, 2), fmt_fixed(f[1], d.ht.humidity, 2),
+                fmt_fixed(f[2], d.press.pressure, 2));
+    shell_print(shell, "A=%s,%s,%s m/s^2 G=%s,%s,%s rad/s",
+                fmt_fixed(f[3], d.imu.accel.x, 2), fmt_fixed(f[4], d.imu.accel.y, 2),
+                fmt_fixed(f[5], d.imu.accel.z, 2), fmt_fixed(f[6], d.imu.gyro.x, 2),
+                fmt_fixed(f[7], d.imu.gyro.y, 2), fmt_fixed(f[8], d.imu.gyro.z, 2));
+#if defined(CONFIG_APP_FUSION)
+    shell_print(shell, "roll=%s pitch=%s yaw=%s deg",
+                fmt_fixed(f[0], d.orient.roll, 2), fmt_fixed(f[1], d.orient.pitch, 2),
+                fmt_fixed(f[2], d.orient.yaw, 2));
+#endif
+#if defined(CONFIG_APP_BARO_ALT)
+    shell_print(shell, "alt=%s m vz=%s m/s",
+                fmt_fixed(f[0], d.alt.altitude, 2), fmt_fixed(f[1], d.alt.vspeed, 2));
+#endif
+
+    /* age of each group against the merge time, "-" before its first reading */
+    static const char *const grp[SNAP_GRP_COUNT] = { "ht", "press", "imu", "orient", "alt" };
+    shell_fprintf(shell, SHELL_NORMAL, "age ms:");
+    for (int g = 0; g < SNAP_GRP_COUNT; g++) {
+        if (d.valid & SNAP_VALID(g)) {
+            shell_fprintf(shell, SHELL_NORMAL, " %s=%u", grp[g],
+                          d.timestamp_ms - snapshot_group_ts(&d, g));
+        } else {
+            shell_fprintf(shell, SHELL_NORMAL, " %s=-", grp[g]);
+        }
     }
-    return rc;
+    shell_fprintf(shell, SHELL_NORMAL, "\n");
+    return 0;
 }
 
-static int read_header(struct log_header *hdr)
+#if defined(CONFIG_APP_STATS)
+static void print_stats_row(const struct shell *shell, const char *name, const char *win,
+                            uint8_t dec, const struct stats_result *r)
 {
-    int rc = fs_seek(&log_file, 0, FS_SEEK_SET);
-    if (rc) return rc;
+    char mean[FIXED_FMT_BUF], min[FIXED_FMT_BUF], max[FIXED_FMT_BUF], var[FIXED_FMT_BUF];
+
+    if (r->count == 0) {
+        shell_print(shell, "%-6s %-7s n=0", name, win);
+        return;
+    }
+    shell_print(shell, "%-6s %-7s n=%-6u mean=%s min=%s max=%s var=%s", name, win, r->count,
+                fmt_fixed(mean, r->mean_x100, dec + 2), fmt_fixed(min, r->min, dec),
+                fmt_fixed(max, r->max, dec),
+                fmt_fixed(var, (int32_t)MIN(r->variance, INT32_MAX), 2 * dec));
+}
+
+static int cmd_sensors_stats(const struct shell *shell, size_t argc, char **argv)
+{
+    static const char *const win_names[] = { "current", "last", "sliding" };
+    bool any = false;
 
-    ssize_t r = fs_read(&log_file, hdr, sizeof(*hdr));
-    if (r < 0) return (int)r;
-    if (r != sizeof(*hdr)) return -EIO;
+    for (int ch = 0; ch < STATS_CH_COUNT; ch++) {
+        const struct stats_channel_info *info = sensor_stats_channel_info(ch);
 
-    if (hdr->magic != LOG_HEADER_MAGIC) return -EINVAL;
-    if (hdr->write_off >= LOG_PAYLOAD_MAX) return -EINVAL;
+        if (argc > 1 && strcmp(argv[1], info->name) != 0) continue;
+        any = true;
+
+        for (int w = STATS_WIN_CURRENT; w <= STATS_WIN_SLIDING; w++) {
+            struct stats_result r;
+            if (sensor_stats_get(ch, w, &r) == 0) {
+                print_stats_row(shell, info->name, win_names[w], info->decimals, &r);
+            }
+        }
+    }
+    if (!any) {
+        shell_error(shell, "Unknown channel %s", argv[1]);
+        return -EINVAL;
+    }
     return 0;
 }
+#endif
+
+#if defined(CONFIG_APP_FUSION)
+static int cmd_fusion_show(const struct shell *shell, size_t argc, char **argv)
+{
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    struct fusion_orientation o;
+    struct fusion_stats st;
+    char f[3][FIXED_FMT_BUF];
+
+    imu_fusion_get(&o);
+    imu_fusion_stats_get(&st);
+
+    shell_print(shell, "%s q=%d,%d,%d,%d (Q30) roll=%s pitch=%s yaw=%s deg",
+                IS_ENABLED(CONFIG_APP_FUSION_Q31) ? "q31" : "f32",
+                o.q[0], o.q[1], o.q[2], o.q[3], fmt_fixed(f[0], o.roll, 2),
+                fmt_fixed(f[1], o.pitch, 2), fmt_fixed(f[2], o.yaw, 2));
+
+    uint64_t avg = st.updates ? st.cycles_total / st.updates : 0;
+    shell_print(shell, "updates=%u cycles avg=%llu last=%u max=%u (%llu ns avg)", st.updates,
+                (unsigned long long)avg, st.cycles_last, st.cycles_max,
+                (unsigned long long)k_cyc_to_ns_floor64(avg));
+#if defined(CONFIG_APP_FUSION_VERIFY)
+    shell_print(shell, "q31 vs float max deviation=%s deg",
+                fmt_fixed(f[0], (int32_t)MIN(st.max_dev_mdeg, INT32_MAX), 3));
+#endif
+    return 0;
+}
+
+static int cmd_fusion_bench(const struct shell *shell, size_t argc, char **argv)
+{
+    uint32_t n = (argc > 1) ? strtoul(argv[1], NULL, 0) : 1000;
+    struct fusion_bench b;
+    char f[2][FIXED_FMT_BUF];
+
+    int rc = imu_fusion_bench(n, &b);
+    if (rc) {
+        shell_error(shell, "bench failed (%d)", rc);
+        return rc;
+    }
+
+    /* load in 0.1 % of one 1 kHz period */
+    uint32_t active = IS_ENABLED(CONFIG_APP_FUSION_Q31) ? b.q31_cycles : b.f32_cycles;
+    uint32_t load = b.budget_cycles ? (uint32_t)(1000ull * active / b.budget_cycles) : 0;
+
+    shell_print(shell, "updates=%u q31=%u cyc f32=%u cyc budget@1kHz=%u cyc load=%u.%u%%",
+                b.updates, b.q31_cycles, b.f32_cycles, b.budget_cycles, load / 10, load % 10);
+    shell_print(shell, "q31 vs float max=%s deg, vs truth at end=%s deg",
+                fmt_fixed(f[0], (int32_t)MIN(b.max_dev_mdeg, INT32_MAX), 3),
+                fmt_fixed(f[1], (int32_t)MIN(b.final_err_mdeg, INT32_MAX), 3));
+    return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(sub_fusion,
+    SHELL_CMD_ARG(bench, NULL, "bench [updates]: synthetic 1 kHz run, cycles and error",
+                  cmd_fusion_bench, 1, 1),
+    SHELL_SUBCMD_SET_END
+);
+#endif
 
-static int write_header(const struct log_header *hdr)
+#if defined(CONFIG_APP_IMU_FILTER)
+static int cmd_filter_show(const struct shell *shell, size_t argc, char **argv)
 {
-    int rc = fs_seek(&log_file, 0, FS_SEEK_SET);
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    struct imu_filter_info info;
+    struct imu_filter_stats st;
+    char f[3][FIXED_FMT_BUF];
+
+    imu_filter_info_get(&info);
+    imu_filter_stats_get(&st);
+
+    shell_print(shell, "%s order=%u decim=%u block=%u design=%s Hz pass=+-%s dB stop=-%s dB",
+                info.type, info.order, info.decim, info.block, fmt_fixed(f[0], info.input_mhz, 3),
+                fmt_fixed(f[1], info.pass_mdb, 3), fmt_fixed(f[2], info.stop_mdb, 3));
+
+    uint64_t avg = st.blocks ? st.cycles_total / st.blocks : 0;
+    shell_print(shell, "blocks=%u outputs=%u cycles/block avg=%llu last=%u max=%u",
+                st.blocks, st.outputs, (unsigned long long)avg, st.cycles_last, st.cycles_max);
+    return 0;
+}
+
+static int cmd_filter_resp(const struct shell *shell, size_t argc, char **argv)
+{
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    struct imu_filter_resp rows[16];
+    char f[3][FIXED_FMT_BUF];
+    bool all = true;
+
+    int n = imu_filter_response(rows, ARRAY_SIZE(rows));
+    if (n < 0) return n;
+
+    shell_print(shell, "%12s %10s %10s", "freq Hz", "expect dB", "meas dB");
+    for (int i = 0; i < n; i++) {
+        shell_print(shell, "%12s %10s %10s %s", fmt_fixed(f[0], rows[i].freq_mhz, 3),
+                    fmt_fixed(f[1], rows[i].expected_mdb, 3),
+                    fmt_fixed(f[2], rows[i].measured_mdb, 3), rows[i].pass ? "ok" : "FAIL");
+        all &= rows[i].pass;
+    }
+    shell_print(shell, "response %s", all ? "PASS" : "FAIL");
+    return all ? 0 : -EIO;
+}
+
+static int cmd_filter_bench(const struct shell *shell, size_t argc, char **argv)
+{
+    uint32_t blocks = (argc > 1) ? strtoul(argv[1], NULL, 0) : 100;
+    struct imu_filter_bench b;
+    struct imu_filter_info info;
+
+    int rc = imu_filter_bench(blocks, &b);
     if (rc) return rc;
-    ssize_t w = fs_write(&log_file, hdr, sizeof(*hdr));
-    return (w == sizeof(*hdr)) ? 0 : -EIO;
+    imu_filter_info_get(&info);
+
+    /* load at the design input rate, 0.1 % */
+    uint32_t load = b.max_rate_hz ? info.input_mhz / b.max_rate_hz : 0;
+
+    shell_print(shell, "blocks=%u cycles/block=%u cycles/sample(6 axes)=%u %u us max rate=%u Hz load=%u.%u%%",
+                b.blocks, b.cycles_per_block, b.cycles_per_sample, b.us, b.max_rate_hz,
+                load / 10, load % 10);
+    return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(sub_filter,
+    SHELL_CMD(resp, NULL, "Measure gain at test tones against the generated design",
+              cmd_filter_resp),
+    SHELL_CMD_ARG(bench, NULL, "bench [blocks]: cycles per block and max input rate",
+                  cmd_filter_bench, 1, 1),
+    SHELL_SUBCMD_SET_END
+);
+#endif
+
+#if defined(CONFIG_APP_VIB)
+static int cmd_vib_show(const struct shell *shell, size_t argc, char **argv)
+{
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    struct vib_features v;
+    struct vib_stats st;
+    struct vib_mem m;
+    char f[4][FIXED_FMT_BUF];
+
+    vib_fft_stats_get(&st);
+    vib_fft_mem_get(&m);
+
+    shell_print(shell, "fft=%u rate=%s Hz bands=%u windows=%u dropped=%u",
+                CONFIG_APP_VIB_FFT_LEN, fmt_fixed(f[0], vib_fft_rate_mhz(), 3), VIB_BANDS,
+                st.windows, st.dropped);
+
+    uint64_t avg = st.windows ? st.cycles_total / st.windows : 0;
+    shell_print(shell, "cycles/window avg=%llu last=%u max=%u (%llu us avg)",
+                (unsigned long long)avg, st.cycles_last, st.cycles_max,
+                (unsigned long long)k_cyc_to_us_floor64(avg));
+    shell_print(shell, "memory: samples=%u work=%u stack=%u (unused %u) bytes",
+                (unsigned)m.samples, (unsigned)m.work, (unsigned)m.stack_size,
+                (unsigned)m.stack_unused);
+
+    if (!vib_fft_last(&v)) {
+        shell_print(shell, "no window yet");
+        return 0;
+    }
+    shell_print(shell, "t=%u ms rms=%s peak=%s m/s^2 crest=%s peak freq=%s Hz",
+                v.timestamp_ms, fmt_fixed(f[0], v.rms, 2), fmt_fixed(f[1], v.peak, 2),
+                fmt_fixed(f[2], v.crest_x100, 2), fmt_fixed(f[3], v.peak_freq_mhz, 3));
+
+    /* band b spans (b .. b+1) * nyquist / bands */
+    uint32_t nyq = vib_fft_rate_mhz() / 2;
+    for (int b = 0; b < v.bands; b++) {
+        shell_print(shell, "band %2d %10s..%-10s Hz rms=%s", b,
+                    fmt_fixed(f[0], nyq * b / v.bands, 3),
+                    fmt_fixed(f[1], nyq * (b + 1) / v.bands, 3),
+                    fmt_fixed(f[2], v.band_rms[b], 2));
+    }
+    return 0;
+}
+
+static int cmd_vib_bench(const struct shell *shell, size_t argc, char **argv)
+{
+    uint32_t n = (argc > 1) ? strtoul(argv[1], NULL, 0) : 20;
+    struct vib_bench b;
+    char f[4][FIXED_FMT_BUF];
+
+    int rc = vib_fft_bench(n, &b);
+    if (rc) {
+        shell_error(shell, "bench failed (%d)", rc);
+        return rc;
+    }
+
+    /* share of the CPU at the live rate, 0.1 % */
+    uint32_t load = b.budget_cycles ? (uint32_t)(1000ull * b.cycles_per_window / b.budget_cycles) : 0;
+    shell_print(shell, "windows=%u cycles/window=%u (%llu us) budget=%u cyc load=%u.%u%%",
+                b.windows, b.cycles_per_window,
+                (unsigned long long)k_cyc_to_us_floor64(b.cycles_per_window),
+                b.budget_cycles, load / 10, load % 10);
+    shell_print(shell, "tone=%s Hz peak=%s Hz rms expected=%s got=%s m/s^2",
+                fmt_fixed(f[0], b.tone_mhz, 3), fmt_fixed(f[1], b.peak_freq_mhz, 3),
+                fmt_fixed(f[2], b.rms_expected, 2), fmt_fixed(f[3], b.rms, 2));
+    return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(sub_vib,
+    SHELL_CMD_ARG(bench, NULL, "bench [windows]: synthetic tone, cycles and accuracy",
+                  cmd_vib_bench, 1, 1),
+    SHELL_SUBCMD_SET_END
+);
+#endif
+
+#if defined(CONFIG_APP_BARO_ALT)
+static int cmd_alt_show(const struct shell *shell, size_t argc, char **argv)
+{
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    struct baro_alt_out a;
+    struct baro_alt_stats st;
+    char f[3][FIXED_FMT_BUF];
+
+    baro_alt_stats_get(&st);
+    if (!baro_alt_get(&a)) {
+        shell_print(shell, "no pressure sample yet");
+    } else {
+        shell_print(shell, "alt=%s m (baro %s m) vz=%s m/s tau=%u ms",
+                    fmt_fixed(f[0], a.altitude, 2), fmt_fixed(f[1], a.baro_altitude, 2),
+                    fmt_fixed(f[2], a.vspeed, 2), CONFIG_APP_BARO_ALT_TAU_MS);
+    }
+
+    uint64_t bavg = st.baro_updates ? st.baro_cycles_total / st.baro_updates : 0;
+    uint64_t aavg = st.accel_updates ? st.accel_cycles_total / st.accel_updates : 0;
+    shell_print(shell, "baro updates=%u cycles avg=%llu max=%u", st.baro_updates,
+                (unsigned long long)bavg, st.baro_cycles_max);
+    shell_print(shell, "accel updates=%u cycles avg=%llu max=%u", st.accel_updates,
+                (unsigned long long)aavg, st.accel_cycles_max);
+    return 0;
 }
 
-static int log_open(void)
+static int cmd_alt_test(const struct shell *shell, size_t argc, char **argv)
 {
-    fs_file_t_init(&log_file);
-    int rc = fs_open(&log_file, LOG_FILE_PATH, FS_O_CREATE | FS_O_RDWR);
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    struct baro_alt_test t;
+    char f[4][FIXED_FMT_BUF];
+
+    int rc = baro_alt_selftest(&t);
     if (rc) return rc;
 
-    struct log_header hdr;
-    rc = read_header(&hdr);
+    shell_print(shell, "table: %u points max err=%s m, %u cyc/call (pow %u cyc)",
+                t.lut_points, fmt_fixed(f[0], t.lut_max_err_mm, 3), t.lut_cycles, t.pow_cycles);
+    shell_print(shell, "vz rms err: fused=%s baro diff=%s m/s",
+                fmt_fixed(f[0], t.vs_rms_fused_mms, 3), fmt_fixed(f[1], t.vs_rms_baro_mms, 3));
+    shell_print(shell, "alt rms err: fused=%s baro=%s m",
+                fmt_fixed(f[2], t.alt_rms_fused_mm, 3), fmt_fixed(f[3], t.alt_rms_baro_mm, 3));
+    return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(sub_alt,
+    SHELL_CMD(test, NULL, "Table accuracy and cost, filter error on a synthetic climb",
+              cmd_alt_test),
+    SHELL_SUBCMD_SET_END
+);
+#endif
+
+#if defined(CONFIG_APP_COMPRESS)
+static int parse_channel(const char *name)
+{
+    for (int ch = 0; ch < SNAP_CH_COUNT; ch++) {
+        if (strcmp(name, snapshot_channel_name(ch)) == 0) return ch;
+    }
+    return -EINVAL;
+}
+
+static int cmd_compress_show(const struct shell *shell, size_t argc, char **argv)
+{
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    struct compress_stats st;
+    struct compress_band band[SNAP_CH_COUNT];
+
+    k_mutex_lock(&compress_lock, K_FOREVER);
+    compress_stats_get(&st);
+    enum compress_mode mode = compress_get_mode();
+    for (int ch = 0; ch < SNAP_CH_COUNT; ch++) {
+        compress_get_band(ch, &band[ch]);
+    }
+    k_mutex_unlock(&compress_lock);
+
+    /* reduction in 0.1 % */
+    uint32_t red = st.in ? (uint32_t)(1000ull * (st.in - st.out) / st.in) : 0;
+    shell_print(shell, "mode=%s in=%u out=%u heartbeats=%u reduction=%u.%u%%",
+                compress_mode_name(mode), st.in, st.out, st.heartbeats,
+                red / 10, red % 10);
+
+    for (int ch = 0; ch < SNAP_CH_COUNT; ch++) {
+        shell_print(shell, "%-6s abs=%d rel=%u permille triggers=%u",
+                    snapshot_channel_name(ch), band[ch].abs, band[ch].rel_permille,
+                    st.triggers[ch]);
+    }
+    return 0;
+}
+
+static int cmd_compress_mode(const struct shell *shell, size_t argc, char **argv)
+{
+    ARG_UNUSED(argc);
+
+    for (int m = COMPRESS_OFF; m <= COMPRESS_SDT; m++) {
+        if (strcmp(argv[1], compress_mode_name(m)) == 0) {
+            k_mutex_lock(&compress_lock, K_FOREVER);
+            compress_set_mode(m);
+            k_mutex_unlock(&compress_lock);
+            return 0;
+        }
+    }
+    shell_error(shell, "Unknown mode %s (off|deadband|sdt)", argv[1]);
+    return -EINVAL;
+}
+
+static int cmd_compress_band(const struct shell *shell, size_t argc, char **argv)
+{
+    int ch = parse_channel(argv[1]);
+    if (ch < 0) {
+        shell_error(shell, "Unknown channel %s", argv[1]);
+        return ch;
+    }
+
+    struct compress_band b = {
+        .abs = strtol(argv[2], NULL, 0),
+        .rel_permille = (argc > 3) ? (uint16_t)strtoul(argv[3], NULL, 0) : 0,
+    };
+    k_mutex_lock(&compress_lock, K_FOREVER);
+    int rc = compress_set_band(ch, &b);
+    k_mutex_unlock(&compress_lock);
     if (rc) {
-        /* initialize */
-        hdr.magic = LOG_HEADER_MAGIC;
-        hdr.write_off = 0;
-
-        /* Preallocate payload area with 0xFF */
-        rc = fs_seek(&log_file, LOG_HEADER_SIZE, FS_SEEK_SET);
-        if (rc) return rc;
-
-        uint8_t buf[64];
-        memset(buf, 0xFF, sizeof(buf));
-        size_t total = 0;
-        while (total < LOG_PAYLOAD_MAX) {
-            size_t chunk = MIN(sizeof(buf), LOG_PAYLOAD_MAX - total);
-            ssize_t w = fs_write(&log_file, buf, chunk);
-            if (w != chunk) return -EIO;
-            total += w;
+        shell_error(shell, "Invalid band");
+    }
+    return rc;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(sub_compress,
+    SHELL_CMD_ARG(mode, NULL, "mode <off|deadband|sdt>", cmd_compress_mode, 2, 0),
+    SHELL_CMD_ARG(band, NULL, "band <channel> <abs> [rel_permille]", cmd_compress_band, 3, 1),
+    SHELL_SUBCMD_SET_END
+);
+#endif
+
+#if defined(CONFIG_APP_LOG_BENCH)
+static int cmd_sensors_logbench(const struct shell *shell, size_t argc, char **argv)
+{
+    static char json[512];
+    struct log_bench_cfg cfg = {
+        .rate_hz = (argc > 1) ? strtoul(argv[1], NULL, 0) : 0,
+        .records = (argc > 2) ? strtoul(argv[2], NULL, 0) : 200,
+        .size = (argc > 3) ? strtoul(argv[3], NULL, 0) : sizeof(struct all_sensors_data),
+    };
+    struct log_bench_result r;
+
+    int rc = log_bench_run(&cfg, &r);
+    if (rc) {
+        shell_error(shell, "bench failed (%d)", rc);
+    }
+    shell_print(shell, "written=%u dropped=%u rps=%u capacity=%u rps open fresh=%u us existing=%u us",
+                r.written, r.dropped, r.achieved_rps, r.capacity_rps, r.open_fresh_us, r.open_us);
+    shell_print(shell, "write us p50=%u p99=%u max=%u, enqueue to written p50=%u p99=%u max=%u",
+                r.write_p50_us, r.write_p99_us, r.write_max_us, r.e2e_p50_us, r.e2e_p99_us,
+                r.e2e_max_us);
+    /* the live logger shares the file system; AUTORUN builds run alone */
+    if (log_bench_json(&r, json, sizeof(json)) > 0) {
+        shell_print(shell, "BENCH %s", json);
+    }
+    return rc;
+}
+#endif
+
+#if defined(CONFIG_APP_LOG_FAULT)
+static int cmd_sensors_logfault(const struct shell *shell, size_t argc, char **argv)
+{
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    static char json[512];
+    int fails = 0;
+
+    for (int ph = LOG_FAULT_CREATE; ph < LOG_FAULT_PHASES; ph++) {
+        struct log_fault_result f;
+
+        int rc = log_fault_run(ph, &f);
+        if (rc) {
+            shell_error(shell, "harness failed (%d)", rc);
+            return rc;
+        }
+        shell_print(shell, "%s %s: %u cuts, %u passed, unmountable=%u header=%u lost=%u, "
+                    "recovery avg=%u max=%u us", f.backend, log_fault_phase_name(ph), f.cuts,
+                    f.passed, f.unmountable, f.bad_header, f.lost, f.recovery_avg_us,
+                    f.recovery_max_us);
+        if (log_fault_json(&f, json, sizeof(json)) > 0) {
+            shell_print(shell, "FAULT %s", json);
         }
+        fails += f.cuts - f.passed;
+    }
+    return fails ? -EIO : 0;
+}
+#endif
+
+#if defined(CONFIG_APP_TRACE)
+static int cmd_trace_show(const struct shell *shell, size_t argc, char **argv)
+{
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    struct pipe_trace_stats st;
+    pipe_trace_stats_get(&st);
+    shell_print(shell, "pipeline events %s, %u emitted in %u ms, %u/s", st.on ? "on" : "off",
+                st.events, st.on_ms, st.rate_eps);
+    return 0;
+}
 
-        /* write header at start */
-        rc = write_header(&hdr);
-        if (rc) return rc;
+static int cmd_trace_on(const struct shell *shell, size_t argc, char **argv)
+{
+    pipe_trace_enable(true);
+    return cmd_trace_show(shell, argc, argv);
+}
+
+static int cmd_trace_off(const struct shell *shell, size_t argc, char **argv)
+{
+    pipe_trace_enable(false);
+    return cmd_trace_show(shell, argc, argv);
+}
+
+static int cmd_trace_bench(const struct shell *shell, size_t argc, char **argv)
+{
+    uint32_t n = (argc > 1) ? strtoul(argv[1], NULL, 0) : 1000;
+    struct pipe_trace_bench b;
+    struct pipe_trace_stats st;
+
+    /* rate first: the bench's own events count too */
+    pipe_trace_stats_get(&st);
+    int rc = pipe_trace_bench(n, &b);
+    if (rc) {
+        shell_error(shell, "bench failed (%d)", rc);
+        return rc;
+    }
+
+    uint32_t hz = sys_clock_hw_cycles_per_sec();
+    shell_print(shell, "per event: off %u.%02u cycles, on %u.%02u cycles (%u calls)",
+                b.off_cycles_x100 / 100, b.off_cycles_x100 % 100,
+                b.on_cycles_x100 / 100, b.on_cycles_x100 % 100, b.calls);
+    /* CPU share at the pipeline's event rate, in parts per million */
+    if (st.rate_eps && hz) {
+        shell_print(shell, "at %u events/s: idle %u ppm, tracing %u ppm of the CPU", st.rate_eps,
+                    (uint32_t)((uint64_t)st.rate_eps * b.off_cycles_x100 * 10000 / hz),
+                    (uint32_t)((uint64_t)st.rate_eps * b.on_cycles_x100 * 10000 / hz));
+    } else {
+        shell_print(shell, "event rate unknown: run with tracing on first");
     }
     return 0;
 }
 
+SHELL_STATIC_SUBCMD_SET_CREATE(sub_trace,
+    SHELL_CMD(on, NULL, "Emit pipeline events", cmd_trace_on),
+    SHELL_CMD(off, NULL, "Stop pipeline events, compiled-in hooks stay", cmd_trace_off),
+    SHELL_CMD_ARG(bench, NULL, "bench [events]: cycles per hook off and on, idle CPU share",
+                  cmd_trace_bench, 1, 1),
+    SHELL_SUBCMD_SET_END
+);
+#endif
 
-static int log_write_snapshot(const struct all_sensors_data *d)
+#if defined(CONFIG_APP_DUTY_CYCLE)
+/* Share of total in 0.01 % */
+static uint32_t pct100(uint64_t part, uint64_t total)
 {
-    struct log_header hdr;
-    int rc = read_header(&hdr);
-    if (rc) return rc;
+    return total ? (uint32_t)(part * 10000 / total) : 0;
+}
+
+static int cmd_duty_show(const struct shell *shell, size_t argc, char **argv)
+{
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
 
-    /* Where to write: header + write_off */
-    off_t pos = LOG_HEADER_SIZE + hdr.write_off;
+    static const char *const names[DUTY_SENSOR_COUNT] = { "HTS221", "LPS22HB" };
+    struct duty_stats st;
+    duty_stats_get(&st);
 
-    rc = fs_seek(&log_file, pos, FS_SEEK_SET);
-    if (rc) return rc;
+    uint32_t p = pct100(st.awake_ticks, st.total_ticks);
+    shell_print(shell, "window %u ms, %u wakes, awake %u.%02u%% (%llu of %llu ms)",
+                CONFIG_APP_DUTY_PERIOD_MS, st.windows, p / 100, p % 100,
+                (unsigned long long)k_ticks_to_ms_floor64(st.awake_ticks),
+                (unsigned long long)k_ticks_to_ms_floor64(st.total_ticks));
+    for (int i = 0; i < DUTY_SENSOR_COUNT; i++) {
+        p = pct100(st.sensor_on_ticks[i], st.total_ticks);
+        shell_print(shell, "%-8s on %u.%02u%% (%llu ms), %u power-ups", names[i], p / 100, p % 100,
+                    (unsigned long long)k_ticks_to_ms_floor64(st.sensor_on_ticks[i]),
+                    st.sensor_powerups[i]);
+    }
+#if defined(CONFIG_PM)
+    for (uint32_t i = 0; i < st.n_pm; i++) {
+        p = pct100(st.pm[i].ticks, st.total_ticks);
+        shell_print(shell, "pm state %u/%u %u.%02u%% (%llu ms), %u entries", st.pm[i].state,
+                    st.pm[i].substate, p / 100, p % 100,
+                    (unsigned long long)k_ticks_to_ms_floor64(st.pm[i].ticks), st.pm[i].entries);
+    }
+#else
+    shell_print(shell, "no SoC PM states (CONFIG_PM off)");
+#endif
+    return 0;
+}
 
-    ssize_t w = fs_write(&log_file, d, sizeof(*d));
-    if (w != sizeof(*d)) return -EIO;
+static int cmd_duty_reset(const struct shell *shell, size_t argc, char **argv)
+{
+    duty_stats_reset();
+    return cmd_duty_show(shell, argc, argv);
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(sub_duty,
+    SHELL_CMD(reset, NULL, "Restart the residency counters", cmd_duty_reset),
+    SHELL_SUBCMD_SET_END
+);
+#endif
+
+#if defined(CONFIG_APP_SENSOR_ENGINE)
+static int cmd_table_show(const struct shell *shell, size_t argc, char **argv)
+{
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    struct sensor_record rec;
+    struct sensor_engine_stats st;
+    bool have = sensor_engine_last(&rec) == 0;
 
-    /* advance write_off with wrap */
-    uint32_t next = hdr.write_off + sizeof(*d);
-    if (next + sizeof(*d) > LOG_PAYLOAD_MAX) {
-        next = 0; /* wrap to start of payload */
+    sensor_engine_stats_get(&st);
+    for (int i = 0; i < SENSOR_TABLE_COUNT; i++) {
+        const struct sensor_desc *d = &sensor_table[i];
+
+        shell_print(shell, "%-6s %s every %u ms, %u x int%u at offset %u%s", d->name,
+                    d->dev->name, d->period_ms, d->n_chan, d->width * 8, d->offset,
+                    have && (rec.updated & BIT(i)) ? ", read in the last pass" : "");
+        for (uint8_t c = 0; have && c < d->n_chan; c++) {
+            shell_print(shell, "  %-14s x%-5d %d", d->chan_name[c], d->scale[c],
+                        sensor_record_get(&rec, d, c));
+        }
     }
-    hdr.write_off = next;
+    shell_print(shell, "record %u bytes at %u ms, static RAM %u bytes",
+                (unsigned)st.record_size, have ? rec.timestamp_ms : 0,
+                (unsigned)st.ram_static);
+    shell_print(shell, "passes %u, errors %u, written %u, dropped %u", st.passes, st.errors,
+                st.written, st.dropped);
+    if (st.passes) {
+        shell_print(shell, "cycles per pass avg %llu max %u, outside drivers avg %llu",
+                    (unsigned long long)(st.pass_cycles / st.passes), st.pass_cycles_max,
+                    (unsigned long long)((st.pass_cycles - st.driver_cycles) / st.passes));
+    }
+    return 0;
+}
+#endif
 
-    return write_header(&hdr);
+#if defined(CONFIG_APP_SMP_LOG)
+static int cmd_smp_show(const struct shell *shell, size_t argc, char **argv)
+{
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    struct smp_log_stats st;
+    smp_log_stats_get(&st);
+
+    uint64_t us = k_cyc_to_us_floor64(st.cycles);
+    shell_print(shell, "ordered reads %u (%u failed), %llu bytes in %llu us of handler time",
+                st.requests, st.errors, (unsigned long long)st.bytes, (unsigned long long)us);
+    if (us) {
+        shell_print(shell, "handler throughput %llu B/s, %llu us per request",
+                    (unsigned long long)(st.bytes * 1000000 / us),
+                    (unsigned long long)(us / st.requests));
+    }
+    return 0;
 }
-static int cmd_clear_logs(const struct shell *shell, size_t argc, char **argv)
+#endif
+
+#if defined(CONFIG_APP_LOG_QUERY)
+/* "all", "boot", seconds back from now, or from_ms-to_ms of this boot */
+static int parse_range(const char *s, struct log_query *q)
+{
+    char *end;
+    unsigned long a = strtoul(s, &end, 0);
+
+    q->from_ms = 0;
+    q->to_ms = UINT32_MAX;
+    if (strcmp(s, "all") == 0) {
+        q->flags |= LOG_QUERY_ALL;
+        return 0;
+    }
+    if (strcmp(s, "boot") == 0) return 0;
+    if (end == s) return -EINVAL;
+    if (*end == '-') {
+        q->from_ms = a;
+        q->to_ms = strtoul(end + 1, &end, 0);
+        return (*end || q->to_ms < q->from_ms) ? -EINVAL : 0;
+    }
+    if (*end) return -EINVAL;
+
+    int64_t from = k_uptime_get() - (int64_t)a * 1000;
+    q->from_ms = (from > 0) ? (uint32_t)from : 0;
+    return 0;
+}
+
+static int cmd_sensors_query(const struct shell *shell, size_t argc, char **argv)
+{
+    static struct log_query_result r;
+    struct log_query q = { .flags = LOG_QUERY_PCT };
+    char f[6][FIXED_FMT_BUF];
+
+    if (parse_range(argv[1], &q)) {
+        shell_error(shell, "Range: all, boot, <seconds back> or <from_ms>-<to_ms>");
+        return -EINVAL;
+    }
+    for (size_t i = 2; i < argc; i++) {
+        int ch = 0;
+
+        while (ch < SNAP_CH_COUNT && strcmp(argv[i], snapshot_channel_name(ch)) != 0) ch++;
+        if (ch == SNAP_CH_COUNT) {
+            shell_error(shell, "Unknown channel %s", argv[i]);
+            return -EINVAL;
+        }
+        q.channels |= BIT(ch);
+    }
+    if (q.channels == 0) q.channels = BIT_MASK(SNAP_CH_COUNT);
+
+#if defined(CONFIG_APP_RAW_LOG_SNAP)
+    int rc = log_query_run_raw(&snap_raw, &q, &r);
+#else
+    int rc = log_query_run(&snap_log, &q, &r);
+#endif
+    if (rc) {
+        shell_error(shell, "query failed (%d)", rc);
+        return rc;
+    }
+
+    shell_print(shell, "%u of %u records (%u this boot) in %u..%u ms", r.matched, r.records,
+                r.boot_records, r.first_ms, r.last_ms);
+    shell_print(shell, "scanned %u, read %u B in %u chunks and %u probes, %u us", r.scanned,
+                r.bytes, r.chunks, r.probes, r.elapsed_us);
+    for (int ch = 0; ch < SNAP_CH_COUNT; ch++) {
+        const struct log_query_agg *a = &r.ch[ch];
+        const char *name = snapshot_channel_name(ch);
+        uint8_t dec = snapshot_channel_decimals(ch);
+
+        if (!(q.channels & BIT(ch))) continue;
+        if (a->count == 0) {
+            shell_print(shell, "%-6s n=0", name);
+            continue;
+        }
+        shell_print(shell, "%-6s n=%-6u min=%s max=%s mean=%s p50=%s p90=%s p99=%s", name,
+                    a->count, fmt_fixed(f[0], a->min, dec), fmt_fixed(f[1], a->max, dec),
+                    fmt_fixed(f[2], a->mean_x100, dec + 2), fmt_fixed(f[3], a->pct[0], dec),
+                    fmt_fixed(f[4], a->pct[1], dec), fmt_fixed(f[5], a->pct[2], dec));
+    }
+    return 0;
+}
+
+static int cmd_sensors_querybench(const struct shell *shell, size_t argc, char **argv)
 {
     ARG_UNUSED(argc);
     ARG_UNUSED(argv);
 
-    int ret = fs_unlink(LOG_FILE_PATH);
-    if (ret == -ENOENT) {
-        shell_print(shell, "No log file to delete.");
-    } else if (ret) {
-        shell_error(shell, "Failed to delete log file (%d)", ret);
-        return ret;
-    } else {
-        shell_print(shell, "Log file deleted.");
+    static struct log_query_bench_result b[LOG_QUERY_BENCH_RUNS];
+    static char json[512];
+
+    int rc = log_query_bench(b);
+    if (rc) {
+        shell_error(shell, "bench failed (%d)", rc);
+    }
+    for (int i = 0; i < LOG_QUERY_BENCH_RUNS; i++) {
+        const struct log_query_result *r = &b[i].r;
+
+        shell_print(shell, "%-12s %s: %u B in %u us, %u of %u records scanned", b[i].name,
+                    b[i].ok ? "ok" : "WRONG", r->bytes, r->elapsed_us, r->scanned, r->records);
+        if (log_query_bench_json(&b[i], json, sizeof(json)) > 0) {
+            shell_print(shell, "QUERY %s", json);
+        }
     }
+    return rc;
+}
+#endif
+
+#if defined(CONFIG_APP_LOG_STAGE)
+static int cmd_stage_show(const struct shell *shell, size_t argc, char **argv)
+{
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    struct log_stage_stats st;
+
+    if (!staged) {
+        shell_print(shell, "not staging: writing through");
+        return 0;
+    }
+    log_stage_stats_get(&snap_stage, &st);
+    shell_print(shell, "%u of %u staged, flush after %u ms; %u warm boots", st.pending, st.cap,
+                CONFIG_APP_LOG_STAGE_FLUSH_MS, st.warm_boots);
+    shell_print(shell, "%u flushes, %u snapshots, %u errors; last %u us, max %u us", st.flushes,
+                st.flushed, st.flush_errors, st.flush_last_us, st.flush_max_us);
     return 0;
 }
 
-SHELL_CMD_REGISTER(clear_logs, NULL, "Delete sensor_log.bin file", cmd_clear_logs);
+static int cmd_stage_flush(const struct shell *shell, size_t argc, char **argv)
+{
+    if (!staged) return cmd_stage_show(shell, argc, argv);
+
+    int rc = log_stage_flush(&snap_stage);
+    if (rc) {
+        shell_error(shell, "flush failed (%d)", rc);
+        return rc;
+    }
+    return cmd_stage_show(shell, argc, argv);
+}
+
+static int cmd_stage_check(const struct shell *shell, size_t argc, char **argv)
+{
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    static struct log_stage_check_result r[LOG_STAGE_CHECK_RUNS];
+    static char json[256];
+
+    int rc = log_stage_check(r);
+    if (rc) {
+        shell_error(shell, "check failed (%d)", rc);
+    }
+    for (int i = 0; i < LOG_STAGE_CHECK_RUNS; i++) {
+        shell_print(shell, "%-14s %s: %u of %u in the log, %u replayed, %u committed, %u corrupt",
+                    r[i].name, r[i].ok ? "ok" : "FAIL", r[i].logged, r[i].expected,
+                    r[i].rec.replayed, r[i].rec.committed, r[i].rec.corrupt);
+        if (log_stage_check_json(&r[i], json, sizeof(json)) > 0) {
+            shell_print(shell, "STAGE %s", json);
+        }
+    }
+    return rc;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(sub_stage,
+    SHELL_CMD(flush, NULL, "Write the staged snapshots to the log now", cmd_stage_flush),
+    SHELL_CMD(check, NULL, "Simulated resets at each staging step, then record throughput",
+              cmd_stage_check),
+    SHELL_SUBCMD_SET_END
+);
+#endif
+
+#if defined(CONFIG_APP_RAW_LOG)
+static int cmd_raw_show(const struct shell *shell, size_t argc, char **argv)
+{
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    struct raw_log_stats st;
+
+    int rc = raw_open();
+    if (rc) {
+        shell_error(shell, "%s open failed (%d)", RAW_LOG_NAME, rc);
+        return rc;
+    }
+    raw_log_stats_get(&snap_raw, &st);
+    shell_print(shell, "%s: %u pages of %u B, %u B slots, read %s", RAW_LOG_NAME, st.pages,
+                st.page_size, st.slot, st.mapped ? "in place" : "through the flash driver");
+    shell_print(shell, "%u of %u records, next seq %u; %u appended this boot, %u errors, "
+                "%u page erases", st.records, st.capacity, st.next, st.appended,
+                st.append_errors, st.erases);
+    shell_print(shell, "at open: %u half-written slots stepped over, %u failing CRC", st.stepped,
+                st.corrupt);
+    return 0;
+}
+
+static int cmd_raw_bench(const struct shell *shell, size_t argc, char **argv)
+{
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    static struct raw_log_bench_result b[RAW_LOG_BENCH_RUNS];
+    static char json[256];
+
+    int rc = raw_open();
+    if (rc == 0) {
+        if (IS_ENABLED(CONFIG_APP_RAW_LOG_SNAP)) {
+            shell_warn(shell, "Erasing the logged snapshots; the logger waits meanwhile");
+        }
+        rc = raw_log_bench(&snap_raw, b);
+    }
+    if (rc) {
+        shell_error(shell, "bench failed (%d)", rc);
+        return rc;
+    }
+    for (int i = 0; i < RAW_LOG_BENCH_RUNS; i++) {
+        shell_print(shell, "%-10s %s: %u records, %u B in %u us, %u reads", b[i].name,
+                    b[i].ok ? "ok" : "WRONG", b[i].records, b[i].bytes, b[i].us, b[i].calls);
+        if (raw_log_bench_json(&b[i], json, sizeof(json)) > 0) {
+            shell_print(shell, "RAW %s", json);
+        }
+    }
+    return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(sub_raw,
+    SHELL_CMD(bench, NULL, "Readback throughput, file reads against views; erases the raw log",
+              cmd_raw_bench),
+    SHELL_SUBCMD_SET_END
+);
+#endif
+
+#if defined(CONFIG_APP_ALIGN)
+static int cmd_align_show(const struct shell *shell, size_t argc, char **argv)
+{
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    struct align_stats st;
+    align_stats_get(&st);
+
+    shell_print(shell, "%s every %u ms: %u frames, latency avg %u max %u ms",
+                IS_ENABLED(CONFIG_APP_ALIGN_LINEAR) ? "linear" : "hold",
+                CONFIG_APP_ALIGN_PERIOD_MS, st.frames,
+                st.frames ? (uint32_t)(st.latency_total_ms / st.frames) : 0, st.latency_max_ms);
+    shell_print(shell, "group values: %u interpolated, %u held, %u missing; %u forced out, "
+                "%u pending max", st.interpolated, st.held, st.missing, st.forced,
+                st.pending_max);
+    shell_print(shell, "push: %u, cycles avg %u max %u", st.pushes,
+                st.pushes ? (uint32_t)(st.push_cycles_total / st.pushes) : 0,
+                st.push_cycles_max);
+    return 0;
+}
+
+static int cmd_align_reset(const struct shell *shell, size_t argc, char **argv)
+{
+    align_stats_reset();
+    return cmd_align_show(shell, argc, argv);
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(sub_align,
+    SHELL_CMD(reset, NULL, "Clear the counters", cmd_align_reset),
+    SHELL_SUBCMD_SET_END
+);
+#endif
+
+SHELL_STATIC_SUBCMD_SET_CREATE(sub_sensors,
+    SHELL_CMD(last, NULL, "Show the latest merged snapshot", cmd_sensors_last),
+#if defined(CONFIG_APP_STATS)
+    SHELL_CMD_ARG(stats, NULL, "Window statistics: stats [temp|hum|press|ax|ay|az|gx|gy|gz|roll|pitch|yaw|alt|vz]",
+                  cmd_sensors_stats, 1, 1),
+#endif
+#if defined(CONFIG_APP_IMU_FILTER)
+    SHELL_CMD(filter, &sub_filter, "IMU filter design, counters, response and bench",
+              cmd_filter_show),
+#endif
+#if defined(CONFIG_APP_FUSION)
+    SHELL_CMD(fusion, &sub_fusion, "Orientation, cycles per update and q31/float agreement",
+              cmd_fusion_show),
+#endif
+#if defined(CONFIG_APP_BARO_ALT)
+    SHELL_CMD(alt, &sub_alt, "Altitude, vertical speed and update cycles", cmd_alt_show),
+#endif
+#if defined(CONFIG_APP_VIB)
+    SHELL_CMD(vib, &sub_vib, "Vibration features, cycles per window and memory",
+              cmd_vib_show),
+#endif
+#if defined(CONFIG_APP_COMPRESS)
+    SHELL_CMD(compress, &sub_compress, "Log compression mode, bands and reduction",
+              cmd_compress_show),
+#endif
+#if defined(CONFIG_APP_LOG_BENCH)
+    SHELL_CMD_ARG(logbench, NULL, "logbench [rate_hz] [records] [size]: log path throughput and latency",
+                  cmd_sensors_logbench, 1, 3),
+#endif
+#if defined(CONFIG_APP_LOG_FAULT)
+    SHELL_CMD(logfault, NULL, "Cut power at every flash step of a log write, then verify",
+              cmd_sensors_logfault),
+#endif
+#if defined(CONFIG_APP_DUTY_CYCLE)
+    SHELL_CMD(duty, &sub_duty, "Awake, sensor-on and PM state residency", cmd_duty_show),
+#endif
+#if defined(CONFIG_APP_ALIGN)
+    SHELL_CMD(align, &sub_align, "Aligned frames: resampled values, latency and cost",
+              cmd_align_show),
+#endif
+#if defined(CONFIG_APP_SENSOR_ENGINE)
+    SHELL_CMD(table, NULL, "Sensor table, record layout, latest values and pass cost",
+              cmd_table_show),
+#endif
+#if defined(CONFIG_APP_SMP_LOG)
+    SHELL_CMD(smp, NULL, "Ordered log reads served over SMP and their cost", cmd_smp_show),
+#endif
+#if defined(CONFIG_APP_LOG_QUERY)
+    SHELL_CMD_ARG(query, NULL, "query <all|boot|seconds|from_ms-to_ms> [channel...]: "
+                  "aggregates over the log", cmd_sensors_query, 2, SNAP_CH_COUNT),
+    SHELL_CMD(querybench, NULL, "Query scan throughput on a synthetic log",
+              cmd_sensors_querybench),
+#endif
+#if defined(CONFIG_APP_RAW_LOG)
+    SHELL_CMD(raw, &sub_raw, "Raw flash log: layout, records, erases and read path",
+              cmd_raw_show),
+#endif
+#if defined(CONFIG_APP_LOG_STAGE)
+    SHELL_CMD(stage, &sub_stage, "Snapshots staged in retained RAM, flushes and recovery",
+              cmd_stage_show),
+#endif
+#if defined(CONFIG_APP_TRACE)
+    SHELL_CMD(trace, &sub_trace, "Pipeline trace events, rate and cost per hook",
+              cmd_trace_show),
+#endif
+    SHELL_SUBCMD_SET_END
+);
+
+SHELL_CMD_REGISTER(sensors, &sub_sensors, "Sensor pipeline commands", NULL);
 /* -------- main -------- */
 void main(void)
 {
+#if defined(CONFIG_APP_LOG_BENCH_AUTORUN)
+    /* benchmark build: nothing else touches the file system */
+    log_bench_autorun();
+    return;
+#endif
+
     k_mutex_init(&g_last_lock);
     memset(&g_last, 0, sizeof(g_last));
 
+#if defined(CONFIG_APP_SMP_LOG) && defined(CONFIG_APP_RAW_LOG_SNAP)
+    /* opened here so the export has the layout; the logger finds it open */
+    if (raw_open() != 0 || smp_log_export_raw(&snap_raw, RAW_LOG_NAME) != 0) {
+        LOG_ERR("SMP export of %s failed", RAW_LOG_NAME);
+    }
+#elif defined(CONFIG_APP_SMP_LOG)
+    if (smp_log_export(&snap_log, sizeof(struct all_sensors_data)) != 0) {
+        LOG_ERR("SMP export of %s failed", LOG_FILE_PATH);
+    }
+#endif
+
+#if defined(CONFIG_APP_SENSOR_ENGINE)
+    /* the devicetree sensor table replaces the producers and the logger */
+    if (sensor_engine_start() != 0) {
+        LOG_ERR("Sensor engine start failed");
+    }
+    return;
+#endif
+
+#if defined(CONFIG_APP_STATS)
+    sensor_stats_init();
+#endif
+
+#if defined(CONFIG_APP_FUSION)
+    imu_fusion_init();
+#endif
+
+#if defined(CONFIG_APP_IMU_FILTER)
+    imu_filter_init();
+#endif
+
+#if defined(CONFIG_APP_BARO_ALT)
+    baro_alt_init();
+#endif
+
+#if defined(CONFIG_APP_VIB)
+    if (vib_fft_init(vib_publish) != 0) {
+        LOG_ERR("vib FFT init failed");
+    }
+#endif
+
+#if defined(CONFIG_APP_COMPRESS)
+    compress_init(IS_ENABLED(CONFIG_APP_COMPRESS_MODE_SDT) ? COMPRESS_SDT : COMPRESS_DEADBAND,
+                  CONFIG_APP_COMPRESS_HEARTBEAT_MS);
+#endif
+
+#if defined(CONFIG_APP_TELEMETRY)
+    if (telemetry_init() != 0) {
+        LOG_ERR("Telemetry UART not ready");
+    }
+#endif
+
+#if defined(CONFIG_APP_DUTY_CYCLE)
+    duty_init();
+#endif
+
+#if defined(CONFIG_APP_ALIGN)
+    align_init(align_emit);
+#endif
+
     /* Start producers */
     k_thread_create(&ht_thread_data, ht_stack, K_THREAD_STACK_SIZEOF(ht_stack),
                     ht_thread, NULL, NULL, NULL, 5, 0, K_NO_WAIT);
@@ -0,0 +1,81 @@
+#include "pipe_trace.h"
+#include <zephyr/kernel.h>
+
+#if defined(CONFIG_APP_TRACE)
+
+atomic_t pipe_trace_on = ATOMIC_INIT(IS_ENABLED(CONFIG_APP_TRACE_START_ON));
+atomic_t pipe_trace_count;
+static int64_t on_since;
+static uint32_t last_rate;
+
+static uint32_t rate_now(void)
+{
+    int64_t ms = k_uptime_get() - on_since;
+
+    return (ms > 0) ? (uint32_t)(1000ll * atomic_get(&pipe_trace_count) / ms) : 0;
+}
+
+void pipe_trace_enable(bool on)
+{
+    bool was_on = atomic_get(&pipe_trace_on);
+
+    if (on && !was_on) {
+        atomic_clear(&pipe_trace_count);
+        on_since = k_uptime_get();
+    } else if (!on && was_on) {
+        last_rate = rate_now();
+    }
+    atomic_set(&pipe_trace_on, on);
+}
+
+void pipe_trace_stats_get(struct pipe_trace_stats *st)
+{
+    st->on = atomic_get(&pipe_trace_on);
+    st->events = (uint32_t)atomic_get(&pipe_trace_count);
+    st->on_ms = st->on ? (uint32_t)(k_uptime_get() - on_since) : 0;
+    st->rate_eps = st->on ? rate_now() : last_rate;
+}
+
+static uint32_t per_call_x100(uint32_t cyc, uint32_t base, uint32_t calls)
+{
+    return (cyc > base) ? (uint32_t)(100ull * (cyc - base) / calls) : 0;
+}
+
+int pipe_trace_bench(uint32_t calls, struct pipe_trace_bench *out)
+{
+    bool was_on = atomic_get(&pipe_trace_on);
+    uint32_t t0, base, off, on;
+
+    if (calls == 0) return -EINVAL;
+
+    /* the loop alone */
+    t0 = k_cycle_get_32();
+    for (uint32_t i = 0; i < calls; i++) {
+        __asm__ volatile("" ::: "memory");
+    }
+    base = k_cycle_get_32() - t0;
+
+    atomic_set(&pipe_trace_on, 0);
+    t0 = k_cycle_get_32();
+    for (uint32_t i = 0; i < calls; i++) {
+        PIPE_TRACE(bench, i, 0);
+        __asm__ volatile("" ::: "memory");
+    }
+    off = k_cycle_get_32() - t0;
+
+    atomic_set(&pipe_trace_on, 1);
+    t0 = k_cycle_get_32();
+    for (uint32_t i = 0; i < calls; i++) {
+        PIPE_TRACE(bench, i, 1);
+        __asm__ volatile("" ::: "memory");
+    }
+    on = k_cycle_get_32() - t0;
+    atomic_set(&pipe_trace_on, was_on);
+
+    out->calls = calls;
+    out->off_cycles_x100 = per_call_x100(off, base, calls);
+    out->on_cycles_x100 = per_call_x100(on, base, calls);
+    return 0;
+}
+
+#endif /* CONFIG_APP_TRACE */
@@ -0,0 +1,84 @@
+#ifndef PIPE_TRACE_H
+#define PIPE_TRACE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <zephyr/toolchain.h>
+
+/*
+ * Pipeline stage events (CONFIG_APP_TRACE), written as CTF named_event
+ * records (name, arg0, arg1) among the kernel's own thread, mutex and
+ * queue events. Names stay within the 20 characters CTF keeps.
+ *
+ *   fetch_start/end    arg0 source, end: arg1 driver rc
+ *   merge_start/end    arg0 source; spans the g_last lock wait and copy
+ *   enqueue            arg0 source, arg1 queue depth after the put
+ *   drop               arg0 source; oldest snapshot discarded
+ *   dequeue            arg1 queue depth after the get
+ *   fs_write_start/end record and header writes; start: arg0 length,
+ *                      end: arg0 rc
+ *   fs_sync_start/end  end: arg0 rc
+ *
+ * Compiled in, the events cost one atomic load each until switched on.
+ * With CONFIG_APP_PROBE the same events also drive the GPIO timing
+ * probes (../led_cmd/src/probe.h), CTF or not; the event is a bare
+ * token, PIPE_TRACE(enqueue, ...), named the same in both.
+ */
+enum pipe_src {
+    PIPE_SRC_HT,
+    PIPE_SRC_PRESS,
+    PIPE_SRC_IMU,
+    PIPE_SRC_ALIGN,     /* CONFIG_APP_ALIGN frames */
+};
+
+#if defined(CONFIG_APP_TRACE)
+#include <zephyr/sys/atomic.h>
+#include <zephyr/tracing/tracing.h>
+
+extern atomic_t pipe_trace_on;
+extern atomic_t pipe_trace_count;
+
+#define PIPE_TRACE_CTF(name, a0, a1)                                            \
+    do {                                                                        \
+        if (unlikely(atomic_get(&pipe_trace_on))) {                             \
+            atomic_inc(&pipe_trace_count);                                      \
+            sys_trace_named_event(#name, (uint32_t)(a0), (uint32_t)(a1));       \
+        }                                                                       \
+    } while (0)
+#else
+#define PIPE_TRACE_CTF(name, a0, a1) do { } while (0)
+#endif
+
+#if defined(CONFIG_APP_PROBE)
+#include "probe.h"
+
+#define PIPE_TRACE_PROBE(name) probe_fire(PROBE_EV_##name)
+#else
+#define PIPE_TRACE_PROBE(name) do { } while (0)
+#endif
+
+#define PIPE_TRACE(name, a0, a1)                                                \
+    do {                                                                        \
+        PIPE_TRACE_PROBE(name);                                                 \
+        PIPE_TRACE_CTF(name, a0, a1);                                           \
+    } while (0)
+
+struct pipe_trace_stats {
+    bool on;
+    uint32_t events;        /* emitted since last switched on */
+    uint32_t on_ms;         /* time since then */
+    uint32_t rate_eps;      /* events per second while on, or over the last on period */
+};
+
+struct pipe_trace_bench {
+    uint32_t calls;
+    uint32_t off_cycles_x100;   /* per event, loop overhead removed */
+    uint32_t on_cycles_x100;
+};
+
+void pipe_trace_enable(bool on);
+void pipe_trace_stats_get(struct pipe_trace_stats *st);
+/* Times the hook switched off and on ("bench" events go to the trace) */
+int pipe_trace_bench(uint32_t calls, struct pipe_trace_bench *out);
+
+#endif /* PIPE_TRACE_H */
@@ -2,6 +2,12 @@
 #include <zephyr/device.h>
 #include <zephyr/devicetree.h>
 #include <zephyr/drivers/sensor.h>
+#if defined(CONFIG_APP_DUTY_CYCLE)
+#include <zephyr/kernel.h>
+#include <zephyr/drivers/i2c.h>
+#include <zephyr/pm/device_runtime.h>
+#include "duty.h"
+#endif
 
 /* alias in overlay: pressure-sensor */
 #define PRESS_NODE DT_ALIAS(pressure_sensor)
@@ -11,17 +17,85 @@
 
 static const struct device *press_dev;
 
+#if defined(CONFIG_APP_DUTY_CYCLE) && DT_ON_BUS(PRESS_NODE, i2c)
+#define LPS22HB_CTRL_REG1   0x10
+#define LPS22HB_CTRL_REG2   0x11
+#define LPS22HB_STATUS      0x27
+#define LPS22HB_BDU         BIT(1)
+#define LPS22HB_IF_ADD_INC  BIT(4)
+#define LPS22HB_ONE_SHOT    BIT(0)
+#define LPS22HB_P_DA        BIT(0)
+#define LPS22HB_CONV_POLLS  50                  /* 1 ms each */
+
+static const struct i2c_dt_spec press_i2c = I2C_DT_SPEC_GET(PRESS_NODE);
+
+/* ODR 0 is power-down; ONE_SHOT runs a single conversion and returns there */
+static int press_oneshot(void)
+{
+    int rc = i2c_reg_write_byte_dt(&press_i2c, LPS22HB_CTRL_REG2,
+                                   LPS22HB_IF_ADD_INC | LPS22HB_ONE_SHOT);
+
+    for (int i = 0; rc == 0 && i < LPS22HB_CONV_POLLS; i++) {
+        uint8_t st;
+
+        k_msleep(1);
+        rc = i2c_reg_read_byte_dt(&press_i2c, LPS22HB_STATUS, &st);
+        if (rc == 0 && (st & LPS22HB_P_DA)) return 0;
+    }
+    return rc ? rc : -ETIMEDOUT;
+}
+
+static int press_power_down(void)
+{
+    return i2c_reg_write_byte_dt(&press_i2c, LPS22HB_CTRL_REG1, LPS22HB_BDU);
+}
+#elif defined(CONFIG_APP_DUTY_CYCLE)
+/* no registers behind a stand-in; runtime PM is its whole power state */
+static int press_oneshot(void) { return 0; }
+static int press_power_down(void) { return 0; }
+#endif
+
 int pressure_sensor_init(void)
 {
     press_dev = DEVICE_DT_GET(PRESS_NODE);
-    return device_is_ready(press_dev) ? 0 : -ENODEV;
+    if (!device_is_ready(press_dev)) return -ENODEV;
+#if defined(CONFIG_APP_DUTY_CYCLE)
+    /* drivers without PM support stay on; the one-shot mode still applies */
+    int rc = pm_device_runtime_enable(press_dev);
+    if (rc && rc != -ENOTSUP) return rc;
+    /* the driver left it at its configured ODR */
+    return press_power_down();
+#else
+    return 0;
+#endif
+}
+
+/* One conversion into the driver's buffers */
+static int press_sample(void)
+{
+#if defined(CONFIG_APP_DUTY_CYCLE)
+    int rc = pm_device_runtime_get(press_dev);
+    if (rc) return rc;
+
+    duty_sensor_power(DUTY_SENSOR_PRESS, true);
+    rc = press_oneshot();
+    if (rc == 0) {
+        rc = sensor_sample_fetch(press_dev);
+    }
+    duty_sensor_power(DUTY_SENSOR_PRESS, false);
+
+    (void)pm_device_runtime_put(press_dev);
+    return rc;
+#else
+    return sensor_sample_fetch(press_dev);
+#endif
 }
 
 int pressure_sensor_fetch(int32_t *press)
 {
     if (!press_dev) return -ENODEV;
 
-    int rc = sensor_sample_fetch(press_dev);
+    int rc = press_sample();
     if (rc) return rc;
 
     struct sensor_value p;
@@ -0,0 +1,543 @@
+#include "raw_log.h"
+
+#if defined(CONFIG_APP_RAW_LOG)
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <zephyr/devicetree.h>
+#include <zephyr/drivers/flash.h>
+#include <zephyr/sys/crc.h>
+#include <zephyr/sys/util.h>
+
+#include "pipe_trace.h"
+#include "ring_log.h"
+#include "sensors_common.h"
+
+#if defined(CONFIG_FLASH_SIMULATOR)
+#include <zephyr/drivers/flash/flash_simulator.h>
+#endif
+
+#define COMMIT_SIZE sizeof(struct raw_log_commit)
+#define SEQ_ERASED  UINT32_MAX
+
+/* -------- Layout -------- */
+
+/* The partition's bytes in the address space, or NULL */
+static const uint8_t *map_area(const struct flash_area *fa)
+{
+    const struct device *dev = flash_area_get_device(fa);
+
+#if defined(CONFIG_FLASH_SIMULATOR) && DT_HAS_COMPAT_STATUS_OKAY(zephyr_sim_flash)
+    if (dev == DEVICE_DT_GET_ONE(zephyr_sim_flash)) {
+        size_t size;
+        uint8_t *mem = flash_simulator_get_memory(dev, &size);
+
+        return (mem && fa->fa_off + fa->fa_size <= size) ? mem + fa->fa_off : NULL;
+    }
+#endif
+#if defined(CONFIG_XIP) && DT_HAS_CHOSEN(zephyr_flash)
+    /* the internal flash the code runs from; the STM32 driver resets the
+     * flash data cache after an erase, so reads see the erased page
+     */
+    if (dev == DEVICE_DT_GET(DT_PARENT(DT_CHOSEN(zephyr_flash)))) {
+        return (const uint8_t *)DT_REG_ADDR(DT_CHOSEN(zephyr_flash)) + fa->fa_off;
+    }
+#endif
+    ARG_UNUSED(dev);
+    return NULL;
+}
+
+static inline off_t slot_off(const struct raw_log *log, uint32_t i)
+{
+    return (off_t)(i / log->per_page) * log->page_size + (i % log->per_page) * log->slot;
+}
+
+/* Oldest readable sequence: the pages behind the writer's, less the next one it erases */
+static uint32_t first_seq(const struct raw_log *log, uint32_t next)
+{
+    uint32_t span = (log->pages - 2) * log->per_page + next % log->per_page;
+
+    return next - MIN(next, span);
+}
+
+/* A slot of the partition, in place or read into buf */
+static int slot_get(const struct raw_log *log, uint32_t i, uint8_t *buf, const uint8_t **s)
+{
+    if (log->map) {
+        *s = log->map + slot_off(log, i);
+        return 0;
+    }
+    *s = buf;
+    return flash_area_read(log->fa, slot_off(log, i), buf, log->slot);
+}
+
+static bool slot_erased(const struct raw_log *log, const uint8_t *s)
+{
+    for (uint32_t k = 0; k < log->slot; k++) {
+        if (s[k] != log->erased) return false;
+    }
+    return true;
+}
+
+/* The newest committed record gives the write position; CRCs checked on the way */
+static int scan(struct raw_log *log)
+{
+    bool found = false;
+    uint32_t last = 0;
+    const uint8_t *s;
+
+    for (uint32_t i = 0; i < log->slots; i++) {
+        struct raw_log_commit c;
+
+        int rc = slot_get(log, i, log->buf, &s);
+        if (rc) return rc;
+        memcpy(&c, s + log->rec_span, sizeof(c));
+        if (c.seq == SEQ_ERASED || c.seq % log->slots != i) continue;
+        if (c.crc != crc32_ieee(s, log->rec_size)) {
+            log->corrupt++;
+            continue;
+        }
+        if (!found || c.seq > last) {
+            last = c.seq;
+            found = true;
+        }
+    }
+    log->next = found ? last + 1 : 0;
+
+    /* a reset between a record and its commit word; a page start is erased anyway */
+    while (log->next % log->per_page != 0) {
+        int rc = slot_get(log, log->next % log->slots, log->buf, &s);
+        if (rc) return rc;
+        if (slot_erased(log, s)) break;
+        log->next++;
+        log->stepped++;
+    }
+    return 0;
+}
+
+int raw_log_open(struct raw_log *log, uint8_t area_id, size_t rec_size)
+{
+    const struct flash_area *fa;
+    struct flash_pages_info info;
+
+    if (log->fa) return 0;
+    if (rec_size == 0 || rec_size > RAW_LOG_REC_MAX) return -EINVAL;
+
+    int rc = flash_area_open(area_id, &fa);
+    if (rc) return rc;
+
+    const struct device *dev = flash_area_get_device(fa);
+    size_t wbs = flash_get_write_block_size(dev);
+
+    /* pages of one size across the partition, as on the STM32L4 and the simulator */
+    rc = flash_get_page_info_by_offs(dev, fa->fa_off, &info);
+    if (rc == 0 && (wbs > COMMIT_SIZE || !IS_POWER_OF_TWO(wbs))) rc = -ENOTSUP;
+    if (rc) {
+        flash_area_close(fa);
+        return rc;
+    }
+
+    memset(log, 0, sizeof(*log));
+    log->rec_size = rec_size;
+    /* views are 4-aligned, records hold 32-bit fields */
+    log->rec_span = ROUND_UP(rec_size, MAX(wbs, 4));
+    log->slot = log->rec_span + COMMIT_SIZE;
+    log->page_size = info.size;
+    log->pages = fa->fa_size / info.size;
+    log->per_page = info.size / log->slot;
+    log->slots = log->pages * log->per_page;
+    log->erased = flash_get_parameters(dev)->erase_value;
+    if (log->pages < 3 || log->per_page == 0) {
+        flash_area_close(fa);
+        return -EINVAL;
+    }
+    log->map = map_area(fa);
+    log->fa = fa;
+    k_mutex_init(&log->lock);
+
+    rc = scan(log);
+    if (rc) {
+        flash_area_close(fa);
+        log->fa = NULL;
+    }
+    return rc;
+}
+
+void raw_log_close(struct raw_log *log)
+{
+    if (!log->fa) return;
+
+    k_mutex_lock(&log->lock, K_FOREVER);
+    flash_area_close(log->fa);
+    log->fa = NULL;
+    k_mutex_unlock(&log->lock);
+}
+
+int raw_log_append(struct raw_log *log, const void *rec)
+{
+    if (!log->fa) return -ENODEV;
+
+    k_mutex_lock(&log->lock, K_FOREVER);
+
+    uint32_t i = log->next % log->slots;
+    off_t off = slot_off(log, i);
+    struct raw_log_commit c = { log->next, crc32_ieee(rec, log->rec_size) };
+    int rc = 0;
+
+    PIPE_TRACE(fs_write_start, log->rec_size, 0);
+    if (i % log->per_page == 0) {
+        rc = flash_area_erase(log->fa, off, log->page_size);
+        if (rc == 0) log->erases++;
+    }
+    if (rc == 0) {
+        memcpy(log->buf, rec, log->rec_size);
+        memset(log->buf + log->rec_size, log->erased, log->rec_span - log->rec_size);
+        rc = flash_area_write(log->fa, off, log->buf, log->rec_span);
+        /* programmed or not, the slot is spent: without a commit word it is a hole */
+        if (rc == 0) rc = flash_area_write(log->fa, off + log->rec_span, &c, COMMIT_SIZE);
+        log->next++;
+        if (rc == 0) log->appended++;
+    }
+    PIPE_TRACE(fs_write_end, rc, 0);
+    if (rc) log->append_errors++;
+
+    k_mutex_unlock(&log->lock);
+    return rc;
+}
+
+int raw_log_clear(struct raw_log *log)
+{
+    if (!log->fa) return -ENODEV;
+
+    k_mutex_lock(&log->lock, K_FOREVER);
+    int rc = flash_area_erase(log->fa, 0, (size_t)log->pages * log->page_size);
+    if (rc == 0) {
+        log->erases += log->pages;
+        log->next = 0;
+        log->appended = 0;
+    }
+    k_mutex_unlock(&log->lock);
+    return rc;
+}
+
+bool raw_log_mapped(const struct raw_log *log)
+{
+    return log->map != NULL;
+}
+
+void raw_log_stats_get(struct raw_log *log, struct raw_log_stats *out)
+{
+    memset(out, 0, sizeof(*out));
+    if (!log->fa) return;
+
+    k_mutex_lock(&log->lock, K_FOREVER);
+    out->mapped = log->map != NULL;
+    out->pages = log->pages;
+    out->page_size = log->page_size;
+    out->slot = log->slot;
+    out->records = log->next - first_seq(log, log->next);
+    out->capacity = (log->pages - 1) * log->per_page - 1;
+    out->next = log->next;
+    out->appended = log->appended;
+    out->erases = log->erases;
+    out->append_errors = log->append_errors;
+    out->stepped = log->stepped;
+    out->corrupt = log->corrupt;
+    k_mutex_unlock(&log->lock);
+}
+
+/* -------- Record views -------- */
+
+int raw_log_iter_init(struct raw_log_iter *it, const struct raw_log *log, uint32_t flags,
+                      void *buf, size_t len)
+{
+    if (!log->fa) return -ENODEV;
+
+    bool copy = (flags & RAW_LOG_ITER_COPY) || !log->map;
+
+    if (copy && (!buf || len < log->slot)) return -EINVAL;
+
+    /* one aligned word: no lock against the writer */
+    uint32_t next = log->next;
+
+    memset(it, 0, sizeof(*it));
+    it->log = log;
+    it->buf = buf;
+    it->copy = copy;
+    it->base = first_seq(log, next);
+    it->records = next - it->base;
+    return 0;
+}
+
+void raw_log_iter_seek(struct raw_log_iter *it, uint32_t rec)
+{
+    it->next = MIN(rec, it->records);
+}
+
+/* The record of seq if its slot still holds it, else -ENODATA */
+static int view(struct raw_log_iter *it, uint32_t seq, const void **p)
+{
+    const struct raw_log *log = it->log;
+    uint32_t i = seq % log->slots;
+    const uint8_t *s;
+
+    if (it->copy) {
+        int rc = flash_area_read(log->fa, slot_off(log, i), it->buf, log->slot);
+        it->reads++;
+        if (rc) return rc;
+        s = it->buf;
+    } else {
+        s = log->map + slot_off(log, i);
+    }
+
+    const struct raw_log_commit *c = (const struct raw_log_commit *)(s + log->rec_span);
+
+    if (c->seq != seq) return -ENODATA;
+    *p = s;
+    return 0;
+}
+
+int raw_log_iter_next(struct raw_log_iter *it, const void **rec)
+{
+    while (it->next < it->records) {
+        int rc = view(it, it->base + it->next, rec);
+
+        it->next++;
+        if (rc == 0) return 1;
+        if (rc != -ENODATA) return rc;
+        it->holes++;
+    }
+    return 0;
+}
+
+int raw_log_iter_at(struct raw_log_iter *it, uint32_t rec, const void **p)
+{
+    if (rec >= it->records) return -EINVAL;
+    return view(it, it->base + rec, p);
+}
+
+int raw_log_read_ordered(const struct raw_log *log, uint32_t *base, uint32_t off, void *buf,
+                         size_t len, uint32_t *total)
+{
+    uint8_t __aligned(4) slot[RAW_LOG_SLOT_MAX];
+    struct raw_log_iter it;
+    uint8_t *out = buf;
+    size_t n = 0;
+
+    int rc = raw_log_iter_init(&it, log, 0, slot, sizeof(slot));
+    if (rc) return rc;
+    if (off % log->rec_size) return -EINVAL;
+
+    uint32_t next = it.base + it.records;
+    if (*base == RAW_LOG_BASE_CURRENT) *base = it.base;
+    if (*base > next) return -EINVAL;
+    *total = (next - *base) * log->rec_size;
+
+    for (uint32_t seq = *base + off / log->rec_size; seq < next && n + log->rec_size <= len;
+         seq++) {
+        const void *p;
+
+        rc = view(&it, seq, &p);
+        if (rc == 0) {
+            memcpy(out + n, p, log->rec_size);
+        } else if (rc == -ENODATA) {
+            memset(out + n, log->erased, log->rec_size);
+        } else {
+            return rc;
+        }
+        n += log->rec_size;
+    }
+    return n;
+}
+
+/* -------- Benchmark -------- */
+
+#define REC_SIZE            sizeof(struct all_sensors_data)
+#define BENCH_PATH          LOG_MOUNT_POINT "/rbench.bin"
+#define BENCH_MAGIC         0x52424E43u /* 'RBNC' */
+#define BENCH_BYTES         (32 * 1024)
+#define BENCH_BATCH         16
+#define BENCH_PASSES        8
+
+/* room to spare: the ring never wraps */
+static struct ring_log bench_ring =
+    RING_LOG_INIT(BENCH_PATH, BENCH_MAGIC, BENCH_BYTES + REC_SIZE);
+
+#if defined(CONFIG_BOARD_NATIVE_SIM)
+/* native/host_clock.c: simulated time stands still while this runs */
+uint64_t app_host_time_us(void);
+
+static uint32_t stamp(void)
+{
+    return (uint32_t)app_host_time_us();
+}
+
+static uint32_t since_us(uint32_t t0)
+{
+    return stamp() - t0;
+}
+#else
+static uint32_t stamp(void)
+{
+    return k_cycle_get_32();
+}
+
+static uint32_t since_us(uint32_t t0)
+{
+    return k_cyc_to_us_floor32(k_cycle_get_32() - t0);
+}
+#endif
+
+/* Record i is stamped i; every pass must see 0..n-1 in order */
+static void bench_check(struct raw_log_bench_result *r, const void *p, uint32_t *want)
+{
+    const struct all_sensors_data *d = p;
+
+    if (d->timestamp_ms != *want) r->ok = false;
+    (*want)++;
+    r->records++;
+}
+
+static int bench_fill(struct raw_log *log, uint32_t n)
+{
+    static struct all_sensors_data batch[BENCH_BATCH];
+
+    int rc = raw_log_clear(log);
+    if (rc) return rc;
+
+    (void)fs_unlink(BENCH_PATH);
+    rc = ring_log_open(&bench_ring);
+    if (rc) return rc;
+
+    memset(batch, 0, sizeof(batch));
+    for (uint32_t i = 0; i < n && rc == 0;) {
+        uint32_t k = 0;
+
+        for (; k < BENCH_BATCH && i < n; k++, i++) {
+            batch[k].timestamp_ms = i;
+            batch[k].valid = SNAP_VALID(SNAP_GRP_HT);
+            batch[k].ht.temperature = (int16_t)i;
+            rc = raw_log_append(log, &batch[k]);
+            if (rc) break;
+        }
+        if (rc == 0) rc = ring_log_write_batch(&bench_ring, batch, k, REC_SIZE);
+    }
+    int rc2 = ring_log_close(&bench_ring);
+    return rc ? rc : rc2;
+}
+
+static void bench_fs(struct raw_log_bench_result *r, size_t chunk)
+{
+    static uint8_t __aligned(4) buf[RAW_LOG_BENCH_CHUNK];
+    size_t len = ROUND_DOWN(chunk, REC_SIZE);
+
+    uint32_t t0 = stamp();
+    for (int pass = 0; pass < BENCH_PASSES && r->rc == 0; pass++) {
+        uint32_t base = RING_LOG_BASE_CURRENT;
+        uint32_t off = 0;
+        uint32_t want = 0;
+        uint32_t total;
+        int got;
+
+        while ((got = ring_log_read_ordered(&bench_ring, REC_SIZE, &base, off, buf, len,
+                                            &total)) > 0) {
+            r->calls++;
+            for (size_t k = 0; k + REC_SIZE <= (size_t)got; k += REC_SIZE) {
+                bench_check(r, buf + k, &want);
+            }
+            off += got;
+        }
+        if (got < 0) r->rc = got;
+    }
+    r->us = since_us(t0);
+}
+
+static void bench_raw(struct raw_log_bench_result *r, struct raw_log *log, uint32_t flags)
+{
+    static uint8_t __aligned(4) slot[RAW_LOG_SLOT_MAX];
+
+    uint32_t t0 = stamp();
+    for (int pass = 0; pass < BENCH_PASSES && r->rc == 0; pass++) {
+        struct raw_log_iter it = { 0 };
+        uint32_t want = 0;
+        const void *p;
+
+        int rc = raw_log_iter_init(&it, log, flags, slot, sizeof(slot));
+        while (rc == 0 && (rc = raw_log_iter_next(&it, &p)) == 1) {
+            bench_check(r, p, &want);
+            rc = 0;
+        }
+        r->rc = rc;
+        r->calls += it.reads;
+        r->mapped = !it.copy;
+    }
+    r->us = since_us(t0);
+}
+
+int raw_log_bench(struct raw_log *log, struct raw_log_bench_result *out)
+{
+    static const char *const names[RAW_LOG_BENCH_RUNS] = {
+        "fs_record", "fs_chunk", "raw_copy", "raw_view",
+    };
+    struct raw_log_stats st;
+    int rc = log->fa ? 0 : -ENODEV;
+
+    if (rc == 0 && log->rec_size != REC_SIZE) rc = -EINVAL;
+    if (rc == 0) rc = log_fs_mount();
+
+    memset(out, 0, RAW_LOG_BENCH_RUNS * sizeof(*out));
+    for (int i = 0; i < RAW_LOG_BENCH_RUNS; i++) {
+        out[i].name = names[i];
+        out[i].rc = rc;
+        out[i].ok = (rc == 0);
+    }
+    /* nothing ran, so the logged records stay */
+    if (rc) return rc;
+
+    /* the log's writer waits until the benchmark is done; the mutex nests */
+    k_mutex_lock(&log->lock, K_FOREVER);
+
+    raw_log_stats_get(log, &st);
+    uint32_t n = MIN(BENCH_BYTES / REC_SIZE, st.capacity);
+
+    rc = bench_fill(log, n);
+    if (rc == 0) {
+        bench_fs(&out[0], REC_SIZE);
+        bench_fs(&out[1], RAW_LOG_BENCH_CHUNK);
+        bench_raw(&out[2], log, RAW_LOG_ITER_COPY);
+        bench_raw(&out[3], log, 0);
+    }
+
+    for (int i = 0; i < RAW_LOG_BENCH_RUNS; i++) {
+        struct raw_log_bench_result *r = &out[i];
+
+        if (rc) r->rc = rc;
+        r->bytes = r->records * REC_SIZE;
+        r->ok = r->ok && r->rc == 0 && r->records == n * BENCH_PASSES;
+    }
+
+    /* bench_fill() erased the log; leave it empty, not full of bench records */
+    (void)fs_unlink(BENCH_PATH);
+    (void)raw_log_clear(log);
+    k_mutex_unlock(&log->lock);
+    return rc;
+}
+
+int raw_log_bench_json(const struct raw_log_bench_result *r, char *buf, size_t len)
+{
+    /* a view pass on the host can top 4 GB/s */
+    uint64_t bps = r->us ? (uint64_t)r->bytes * 1000000u / r->us : 0;
+    uint64_t rps = r->us ? (uint64_t)r->records * 1000000u / r->us : 0;
+
+    int n = snprintf(buf, len,
+                     "{\"board\":\"%s\",\"raw\":\"%s\",\"rc\":%d,\"ok\":%s,\"mapped\":%s,"
+                     "\"record_size\":%u,\"records\":%u,\"bytes\":%u,\"calls\":%u,\"us\":%u,"
+                     "\"bps\":%llu,\"rps\":%llu}",
+                     CONFIG_BOARD, r->name, r->rc, r->ok ? "true" : "false",
+                     r->mapped ? "true" : "false", (unsigned)REC_SIZE, r->records, r->bytes,
+                     r->calls, r->us, (unsigned long long)bps, (unsigned long long)rps);
+    return (n < 0 || (size_t)n >= len) ? -ENOMEM : n;
+}
+
+#endif /* CONFIG_APP_RAW_LOG */
@@ -0,0 +1,158 @@
+#ifndef RAW_LOG_H
+#define RAW_LOG_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <zephyr/kernel.h>
+#include <zephyr/storage/flash_map.h>
+
+/*
+ * Fixed-size records straight on a flash partition, no file system
+ * (CONFIG_APP_RAW_LOG), read where they lie. The partition is a ring
+ * of erase pages, each a row of slots: the record, padded to the write
+ * block and to 4 bytes, then a commit word with the record's sequence
+ * number and CRC. Sequence s lives in slot s % slots, so a slot holds
+ * the record readers expect exactly when its commit word names it. The
+ * record is programmed before its commit word; a reset in between
+ * leaves a slot without one, which readers skip and the writer steps
+ * over. The writer erases a page as it enters it.
+ *
+ * Where the partition sits in the address space (internal flash with
+ * XIP on STM32, the flash simulator's backing store on native_sim)
+ * readers get pointers into it: no copy, no driver call. Elsewhere an
+ * iterator reads each slot into a buffer and returns that.
+ *
+ * A view stays valid until the writer erases its page. Readers are
+ * kept one page clear of the next erase, so they have a page worth of
+ * appends to finish with a record before it can change under them.
+ */
+
+#define RAW_LOG_REC_MAX     256
+#define RAW_LOG_SLOT_MAX    (RAW_LOG_REC_MAX + sizeof(struct raw_log_commit))
+
+/* After the record, at the end of its slot */
+struct raw_log_commit {
+    uint32_t seq;
+    uint32_t crc;           /* crc32_ieee of the record */
+};
+
+struct raw_log {
+    const struct flash_area *fa;
+    const uint8_t *map;     /* the partition in the address space, or NULL */
+    size_t rec_size;
+    uint32_t rec_span;      /* record and padding */
+    uint32_t slot;          /* rec_span + commit */
+    uint32_t page_size;
+    uint32_t pages;
+    uint32_t per_page;      /* slots in a page */
+    uint32_t slots;
+    uint8_t erased;         /* the flash's erased byte */
+    uint32_t next;          /* sequence of the next record */
+    uint32_t appended;      /* records written since raw_log_open() */
+    struct k_mutex lock;
+    uint32_t erases;
+    uint32_t append_errors;
+    uint32_t stepped;       /* slots left half written, stepped over at open */
+    uint32_t corrupt;       /* committed slots failing their CRC at open */
+    uint8_t buf[RAW_LOG_SLOT_MAX] __aligned(8);
+};
+
+struct raw_log_stats {
+    bool mapped;
+    uint32_t pages;
+    uint32_t page_size;
+    uint32_t slot;
+    uint32_t records;       /* readable now */
+    uint32_t capacity;      /* readable at most */
+    uint32_t next;
+    uint32_t appended;
+    uint32_t erases;
+    uint32_t append_errors;
+    uint32_t stepped;
+    uint32_t corrupt;
+};
+
+/*
+ * Opens a fixed partition (FIXED_PARTITION_ID()) as a log of rec_size
+ * records and finds the write position; 0 if already open. The
+ * partition needs at least three pages.
+ */
+int raw_log_open(struct raw_log *log, uint8_t area_id, size_t rec_size);
+/* Releases the partition; raw_log_open() scans it again */
+void raw_log_close(struct raw_log *log);
+int raw_log_append(struct raw_log *log, const void *rec);
+/* Erases the partition; sequence numbers start again from 0 */
+int raw_log_clear(struct raw_log *log);
+bool raw_log_mapped(const struct raw_log *log);
+void raw_log_stats_get(struct raw_log *log, struct raw_log_stats *out);
+
+/* -------- Record views -------- */
+
+#define RAW_LOG_ITER_COPY   BIT(0)  /* read slots into the buffer even when mapped */
+
+struct raw_log_iter {
+    const struct raw_log *log;
+    uint32_t base;          /* sequence of stream record 0, fixed at init */
+    uint32_t records;       /* in the stream, holes included */
+    uint32_t next;          /* record returned by the next raw_log_iter_next() */
+    uint8_t *buf;           /* one slot, for unmapped or RAW_LOG_ITER_COPY reads */
+    bool copy;
+    uint32_t holes;         /* slots skipped */
+    uint32_t reads;         /* flash_area_read() calls */
+};
+
+/*
+ * The stream is the records readable now, oldest first. buf holds one
+ * slot (RAW_LOG_SLOT_MAX always does), 4-aligned; it may be NULL on a
+ * mapped partition. Views are checked against the commit word's
+ * sequence only; CRCs are checked once, at open.
+ */
+int raw_log_iter_init(struct raw_log_iter *it, const struct raw_log *log, uint32_t flags,
+                      void *buf, size_t len);
+void raw_log_iter_seek(struct raw_log_iter *it, uint32_t rec);
+/* 1 with *rec on the next record, holes skipped; 0 at the end, or -errno */
+int raw_log_iter_next(struct raw_log_iter *it, const void **rec);
+/* Stream record rec without moving; -ENODATA for a hole */
+int raw_log_iter_at(struct raw_log_iter *it, uint32_t rec, const void **p);
+
+/*
+ * ring_log_read_ordered() for a raw log, for readers that want bytes:
+ * records copied from their views, holes and records overwritten since
+ * *base was fixed filled with the erased byte. off is a multiple of the
+ * record size.
+ */
+#define RAW_LOG_BASE_CURRENT UINT32_MAX
+
+int raw_log_read_ordered(const struct raw_log *log, uint32_t *base, uint32_t off, void *buf,
+                         size_t len, uint32_t *total);
+
+/*
+ * Readback throughput, the same synthetic records through each path:
+ * ring_log_read_ordered() one record and CHUNK bytes at a time from
+ * /lfs/rbench.bin, then the raw log through flash_area_read() into a
+ * buffer and through views. Erases the raw log, unless the setup fails
+ * before any run. Time comes from the host clock on native_sim
+ * (native/host_clock.c), where the views read host memory and the other
+ * paths the flash simulator's copies.
+ */
+struct raw_log_bench_result {
+    const char *name;
+    int rc;
+    bool ok;                /* every record seen, in order */
+    bool mapped;
+    uint32_t records;
+    uint32_t bytes;
+    uint32_t calls;         /* fs_read() or flash_area_read() */
+    uint32_t us;
+};
+
+#define RAW_LOG_BENCH_RUNS  4
+#define RAW_LOG_BENCH_CHUNK 1024
+
+/* Fills all of out[RAW_LOG_BENCH_RUNS]; returns 0 or the setup's -errno */
+int raw_log_bench(struct raw_log *log, struct raw_log_bench_result *out);
+/* One line of JSON, no newline; returns the length or -ENOMEM */
+int raw_log_bench_json(const struct raw_log_bench_result *r, char *buf, size_t len);
+
+#endif /* RAW_LOG_H */
@@ -0,0 +1,300 @@
+#include "ring_log.h"
+#include "pipe_trace.h"
+#include <zephyr/kernel.h>
+#include <zephyr/fs/littlefs.h>
+#include <zephyr/storage/flash_map.h>
+#include <zephyr/logging/log.h>
+#include <string.h>
+
+LOG_MODULE_REGISTER(ring_log, LOG_LEVEL_INF);
+
+/* -------- Mount -------- */
+
+/* Avoid symbol clash with littlefs function lfs_mount() */
+static struct fs_mount_t lfs_mnt;
+static bool mounted;
+static K_MUTEX_DEFINE(mount_lock);
+
+int log_fs_mount(void)
+{
+    /* Storage device: use the fixed partition from DTS */
+    static struct fs_littlefs lfs_data;
+    int rc = 0;
+
+    k_mutex_lock(&mount_lock, K_FOREVER);
+    if (!mounted) {
+        lfs_mnt.type = FS_LITTLEFS;
+        lfs_mnt.fs_data = &lfs_data;
+        lfs_mnt.storage_dev = (void *)FIXED_PARTITION_ID(logs_fs);
+        lfs_mnt.mnt_point = LOG_MOUNT_POINT;
+
+        rc = fs_mount(&lfs_mnt);
+        if (rc == 0) {
+            mounted = true;
+            LOG_INF("Mounted at %s", LOG_MOUNT_POINT);
+        }
+    }
+    k_mutex_unlock(&mount_lock);
+    return rc;
+}
+
+/* -------- Circular record file -------- */
+
+static int read_header(struct ring_log *log, struct log_header *hdr)
+{
+    int rc = fs_seek(&log->file, 0, FS_SEEK_SET);
+    if (rc) return rc;
+
+    ssize_t r = fs_read(&log->file, hdr, sizeof(*hdr));
+    if (r < 0) return (int)r;
+    if (r != sizeof(*hdr)) return -ENODATA;
+
+    if (hdr->magic != log->magic) return -EINVAL;
+    if (hdr->write_off >= log->payload_max) return -EINVAL;
+    return 0;
+}
+
+/* The whole file: header, then payload_max bytes */
+static int check_size(struct ring_log *log)
+{
+    int rc = fs_seek(&log->file, 0, FS_SEEK_END);
+    if (rc) return rc;
+
+    off_t end = fs_tell(&log->file);
+    if (end < 0) return (int)end;
+    return (end == LOG_HEADER_SIZE + log->payload_max) ? 0 : -EINVAL;
+}
+
+static int write_header(struct ring_log *log, const struct log_header *hdr)
+{
+    int rc = fs_seek(&log->file, 0, FS_SEEK_SET);
+    if (rc) return rc;
+    ssize_t w = fs_write(&log->file, hdr, sizeof(*hdr));
+    return (w == sizeof(*hdr)) ? 0 : -EIO;
+}
+
+int ring_log_open(struct ring_log *log)
+{
+    log->appended = 0;
+    fs_file_t_init(&log->file);
+    int rc = fs_open(&log->file, log->path, FS_O_CREATE | FS_O_RDWR);
+    if (rc) return rc;
+
+    struct log_header hdr;
+    rc = read_header(log, &hdr);
+    if (rc == 0) rc = check_size(log);
+    if (rc == -ENODATA || rc == -EINVAL) {
+        /* new file or another format: initialize. Read errors are passed
+         * up instead, so a flash problem never wipes the log
+         */
+        hdr.magic = log->magic;
+        hdr.write_off = 0;
+        hdr.records = 0;
+
+        /* Preallocate payload area with 0xFF */
+        rc = fs_seek(&log->file, LOG_HEADER_SIZE, FS_SEEK_SET);
+        if (rc) return rc;
+
+        uint8_t buf[64];
+        memset(buf, 0xFF, sizeof(buf));
+        size_t total = 0;
+        while (total < log->payload_max) {
+            size_t chunk = MIN(sizeof(buf), log->payload_max - total);
+            ssize_t w = fs_write(&log->file, buf, chunk);
+            if (w != chunk) return -EIO;
+            total += w;
+        }
+
+        /* write header at start */
+        rc = write_header(log, &hdr);
+        if (rc) return rc;
+        rc = fs_sync(&log->file);
+    }
+    return rc;
+}
+
+int ring_log_close(struct ring_log *log)
+{
+    return fs_close(&log->file);
+}
+
+void ring_log_mark_boot(struct ring_log *log)
+{
+    log->appended = 0;
+}
+
+/* Records at the write offset and the header, not yet committed */
+static int write_records(struct ring_log *log, const uint8_t *recs, size_t n, size_t len)
+{
+    struct log_header hdr;
+    int rc = read_header(log, &hdr);
+    if (rc) return rc;
+
+    hdr.records += n;
+    while (n) {
+        /* the run up to the wrap goes in one write */
+        size_t run = 0;
+        uint32_t next = hdr.write_off;
+        do {
+            next += len;
+            run++;
+        } while (run < n && next + len <= log->payload_max);
+
+        rc = fs_seek(&log->file, LOG_HEADER_SIZE + hdr.write_off, FS_SEEK_SET);
+        if (rc) return rc;
+
+        ssize_t w = fs_write(&log->file, recs, run * len);
+        if (w != run * len) return -EIO;
+
+        /* advance write_off with wrap */
+        if (next + len > log->payload_max) {
+            next = 0; /* wrap to start of payload */
+        }
+        hdr.write_off = next;
+        recs += run * len;
+        n -= run;
+    }
+
+    return write_header(log, &hdr);
+}
+
+int ring_log_write(struct ring_log *log, const void *rec, size_t len)
+{
+    return ring_log_write_batch(log, rec, 1, len);
+}
+
+int ring_log_write_batch(struct ring_log *log, const void *recs, size_t n, size_t len)
+{
+    PIPE_TRACE(fs_write_start, n * len, 0);
+    int rc = write_records(log, recs, n, len);
+    PIPE_TRACE(fs_write_end, rc, 0);
+    if (rc) return rc;
+
+    /* LittleFS commits records and header together at the sync; a power
+     * cut before it leaves the file as it was after the previous one
+     */
+    PIPE_TRACE(fs_sync_start, 0, 0);
+    rc = fs_sync(&log->file);
+    PIPE_TRACE(fs_sync_end, rc, 0);
+    if (rc == 0) log->appended += n;
+    return rc;
+}
+
+int ring_log_records(struct ring_log *log, uint32_t *records)
+{
+    struct log_header hdr;
+
+    int rc = read_header(log, &hdr);
+    if (rc == 0) *records = hdr.records;
+    return rc;
+}
+
+/* -------- Ordered read -------- */
+
+/* A slot still 0xFF from the preallocation has never been written */
+static int slot_written(struct fs_file_t *f, uint32_t pos, size_t rec_size)
+{
+    uint8_t buf[16];
+
+    int rc = fs_seek(f, LOG_HEADER_SIZE + pos, FS_SEEK_SET);
+    if (rc) return rc;
+
+    while (rec_size) {
+        size_t n = MIN(sizeof(buf), rec_size);
+        ssize_t r = fs_read(f, buf, n);
+        if (r < 0) return (int)r;
+        if (r != n) return -ENODATA;
+        for (size_t i = 0; i < n; i++) {
+            if (buf[i] != 0xFF) return 1;
+        }
+        rec_size -= n;
+    }
+    return 0;
+}
+
+static int read_ordered(struct fs_file_t *f, const struct ring_log *log, size_t rec_size,
+                        uint32_t *base, uint32_t off, uint8_t *buf, size_t len,
+                        uint32_t *total)
+{
+    uint32_t slots_end = log->payload_max / rec_size * rec_size;
+    struct log_header hdr;
+
+    ssize_t r = fs_read(f, &hdr, sizeof(hdr));
+    if (r < 0) return (int)r;
+    if (r != sizeof(hdr) || hdr.magic != log->magic) return -ENODATA;
+
+    if (*base == RING_LOG_BASE_CURRENT) {
+        *base = hdr.write_off;
+    }
+    if (*base >= slots_end || *base % rec_size) return -EINVAL;
+
+    int wrapped = slot_written(f, *base, rec_size);
+    if (wrapped < 0) return wrapped;
+
+    /* stream: [base, slots_end) if wrapped, then [0, base) */
+    uint32_t head = wrapped ? slots_end - *base : 0;
+    *total = head + *base;
+
+    size_t done = 0;
+    while (done < len && off < *total) {
+        uint32_t pos, run;
+
+        if (off < head) {
+            pos = *base + off;
+            run = head - off;
+        } else {
+            pos = off - head;
+            run = *total - off;
+        }
+        run = MIN(run, len - done);
+
+        int rc = fs_seek(f, LOG_HEADER_SIZE + pos, FS_SEEK_SET);
+        if (rc) return rc;
+        r = fs_read(f, buf + done, run);
+        if (r < 0) return (int)r;
+        if (r != run) return -EIO;
+        done += run;
+        off += run;
+    }
+    return (int)done;
+}
+
+int ring_log_read_ordered(const struct ring_log *log, size_t rec_size, uint32_t *base,
+                          uint32_t off, void *buf, size_t len, uint32_t *total)
+{
+    struct fs_file_t f;
+
+    if (rec_size == 0 || rec_size > log->payload_max) return -EINVAL;
+
+    fs_file_t_init(&f);
+    int rc = fs_open(&f, log->path, FS_O_READ);
+    if (rc) return rc;
+
+    int n = read_ordered(&f, log, rec_size, base, off, buf, len, total);
+    rc = fs_close(&f);
+    return n < 0 ? n : (rc ? rc : n);
+}
+
+/* -------- Rotating append-only files -------- */
+
+int log_append_rotating(const char *path, const char *old_path, size_t max,
+                        const void *rec, size_t len)
+{
+    struct fs_dirent ent;
+    struct fs_file_t f;
+
+    if (fs_stat(path, &ent) == 0 && ent.size + len > max) {
+        (void)fs_unlink(old_path);
+        int rc = fs_rename(path, old_path);
+        if (rc) return rc;
+    }
+
+    fs_file_t_init(&f);
+    int rc = fs_open(&f, path, FS_O_CREATE | FS_O_WRITE | FS_O_APPEND);
+    if (rc) return rc;
+
+    ssize_t w = fs_write(&f, rec, len);
+    rc = fs_close(&f);
+    if (w != len) return -EIO;
+    return rc;
+}
@@ -0,0 +1,83 @@
+#ifndef RING_LOG_H
+#define RING_LOG_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <zephyr/fs/fs.h>
+
+/*
+ * Fixed-size circular record file on the LittleFS log partition.
+ * The file is a header followed by a payload area preallocated with
+ * 0xFF; the header holds the offset of the next record, which wraps to
+ * the start of the payload when the next record would not fit, and the
+ * count of records committed since the file was created.
+ */
+#define LOG_MOUNT_POINT   "/lfs"
+
+struct log_header {
+    uint32_t magic;
+    uint32_t write_off; /* offset within payload area (not counting header) */
+    uint32_t records;   /* committed since the file was created, wrapping */
+};
+
+#define LOG_HEADER_SIZE   (sizeof(struct log_header))
+
+struct ring_log {
+    const char *path;
+    uint32_t magic;         /* a mismatch re-initialises the file */
+    uint32_t payload_max;
+    uint32_t appended;      /* records written since ring_log_open() or ring_log_mark_boot() */
+    struct fs_file_t file;
+};
+
+#define RING_LOG_INIT(_path, _magic, _payload_max) \
+    { .path = (_path), .magic = (_magic), .payload_max = (_payload_max) }
+
+/* Mount the logs_fs partition at LOG_MOUNT_POINT; 0 if already mounted */
+int log_fs_mount(void);
+
+/* Open, or create and preallocate, the file; one of another size is
+ * another format and is created again
+ */
+int ring_log_open(struct ring_log *log);
+int ring_log_close(struct ring_log *log);
+/* Records written so far belong to an earlier boot: for a writer that
+ * replays them after ring_log_open(), so readers going by appended
+ * (log_query) do not take them for this boot's
+ */
+void ring_log_mark_boot(struct ring_log *log);
+/* One record at the write offset, then the header; the record survives
+ * a power cut once this returns 0
+ */
+int ring_log_write(struct ring_log *log, const void *rec, size_t len);
+/* n records of len bytes, back to back in recs, with one header write
+ * and one sync; all of them or none survive a power cut
+ */
+int ring_log_write_batch(struct ring_log *log, const void *recs, size_t n, size_t len);
+/* The header's record count: it moves with every committed write, and
+ * unlike the offset never comes back to where it was after a wrap
+ */
+int ring_log_records(struct ring_log *log, uint32_t *records);
+
+/* Take the write offset from the file in ring_log_read_ordered() */
+#define RING_LOG_BASE_CURRENT UINT32_MAX
+
+/*
+ * Read the ring's records as one stream, oldest first: after a wrap the
+ * slots from the write offset to the last whole slot, then those from
+ * the start of the payload; before it, only the latter. rec_size is the
+ * writer's record size. Opens its own handle, so the writer can go on.
+ *
+ * The stream is laid out around *base: pass RING_LOG_BASE_CURRENT to use
+ * the file's write offset, which is stored back, and pass the same base
+ * again to resume at a later off. Returns the bytes read, 0 at the end,
+ * or -errno; *total is the stream length.
+ */
+int ring_log_read_ordered(const struct ring_log *log, size_t rec_size, uint32_t *base,
+                          uint32_t off, void *buf, size_t len, uint32_t *total);
+
+/* Append one record; rotate to old_path once the file would exceed max */
+int log_append_rotating(const char *path, const char *old_path, size_t max,
+                        const void *rec, size_t len);
+
+#endif /* RING_LOG_H */
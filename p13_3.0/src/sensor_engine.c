@@ -0,0 +1,275 @@
+#include "sensor_engine.h"
+
+#if defined(CONFIG_APP_SENSOR_ENGINE)
+
+#include <string.h>
+#include <zephyr/kernel.h>
+#include <zephyr/spinlock.h>
+#include <zephyr/logging/log.h>
+
+#include "ring_log.h"
+#include "pipe_trace.h"
+#include "smp_log.h"
+
+LOG_MODULE_REGISTER(sensor_engine, LOG_LEVEL_INF);
+
+#define REC_LOG_PATH        LOG_MOUNT_POINT "/records.bin"
+/* 'ST' + record size: a different table starts the file afresh */
+#define REC_LOG_MAGIC       (0x53540000u | (uint32_t)sizeof(struct sensor_record))
+#define REC_LOG_PAYLOAD_MAX (64 * 1024)
+
+#define REC_Q_DEPTH     32
+#define ENGINE_STACK_SZ 2048
+#define WRITER_STACK_SZ 2048
+
+BUILD_ASSERT(SENSOR_TABLE_COUNT > 0, "sensor table has no entries");
+BUILD_ASSERT(SENSOR_TABLE_COUNT <= 32, "updated mask holds 32 entries");
+
+/* -------- Generated table -------- */
+
+#define TABLE_CHAN(node, prop, idx) \
+    UTIL_CAT(SENSOR_CHAN_, DT_STRING_UPPER_TOKEN_BY_IDX(node, prop, idx)),
+
+/* Per-entry arrays, named by the node's dependency ordinal */
+#define TABLE_ARRAYS(node)                                                              \
+    BUILD_ASSERT(DT_PROP_LEN(node, scale) == DT_PROP_LEN(node, channels),               \
+                 "sensor table: one scale per channel");                                \
+    static const enum sensor_channel UTIL_CAT(chan_, DT_DEP_ORD(node))[] = {            \
+        DT_FOREACH_PROP_ELEM(node, channels, TABLE_CHAN)                                \
+    };                                                                                  \
+    static const char *const UTIL_CAT(chan_name_, DT_DEP_ORD(node))[] =                 \
+        DT_PROP(node, channels);                                                        \
+    static const int32_t UTIL_CAT(scale_, DT_DEP_ORD(node))[] = DT_PROP(node, scale);
+
+#define TABLE_DESC(node)                                                                \
+    {                                                                                   \
+        .dev = DEVICE_DT_GET(DT_PHANDLE(node, sensor)),                                 \
+        .name = DT_PROP(node, field),                                                   \
+        .chan = UTIL_CAT(chan_, DT_DEP_ORD(node)),                                      \
+        .chan_name = UTIL_CAT(chan_name_, DT_DEP_ORD(node)),                            \
+        .scale = UTIL_CAT(scale_, DT_DEP_ORD(node)),                                    \
+        .period_ms = DT_PROP(node, period_ms),                                          \
+        .offset = offsetof(struct sensor_record, DT_STRING_TOKEN(node, field)),         \
+        .n_chan = DT_PROP_LEN(node, channels),                                          \
+        .width = sizeof(SENSOR_TABLE_TYPE(node)),                                       \
+    },
+
+DT_FOREACH_CHILD_STATUS_OKAY(SENSOR_TABLE_NODE, TABLE_ARRAYS)
+
+const struct sensor_desc sensor_table[SENSOR_TABLE_COUNT] = {
+    DT_FOREACH_CHILD_STATUS_OKAY(SENSOR_TABLE_NODE, TABLE_DESC)
+};
+
+/* -------- State -------- */
+
+K_MSGQ_DEFINE(rec_q, sizeof(struct sensor_record), REC_Q_DEPTH, 4);
+
+static struct ring_log rec_log = RING_LOG_INIT(REC_LOG_PATH, REC_LOG_MAGIC, REC_LOG_PAYLOAD_MAX);
+
+K_THREAD_STACK_DEFINE(engine_stack, ENGINE_STACK_SZ);
+K_THREAD_STACK_DEFINE(writer_stack, WRITER_STACK_SZ);
+static struct k_thread engine_thread_data;
+static struct k_thread writer_thread_data;
+
+static struct k_spinlock lock;
+static struct sensor_record last;
+static bool have_last;
+static struct sensor_engine_stats acc;
+
+/* -------- Sampling -------- */
+
+static void put_value(const struct sensor_desc *d, uint8_t ch, uint8_t *rec,
+                      const struct sensor_value *v)
+{
+    int64_t micro = (int64_t)v->val1 * 1000000 + v->val2;
+    int32_t x = (int32_t)(micro * d->scale[ch] / 1000000);
+    uint8_t *p = rec + d->offset + ch * d->width;
+
+    if (d->width == sizeof(int16_t)) {
+        int16_t s = (int16_t)x;
+        memcpy(p, &s, sizeof(s));
+    } else {
+        memcpy(p, &x, sizeof(x));
+    }
+}
+
+/* Read one entry into the record; *drv accumulates the driver time */
+static int sample(const struct sensor_desc *d, uint8_t *rec, uint32_t *drv)
+{
+    uint32_t t0 = k_cycle_get_32();
+    int rc = sensor_sample_fetch(d->dev);
+
+    *drv += k_cycle_get_32() - t0;
+    if (rc) return rc;
+
+    for (uint8_t i = 0; i < d->n_chan; i++) {
+        struct sensor_value v;
+
+        t0 = k_cycle_get_32();
+        rc = sensor_channel_get(d->dev, d->chan[i], &v);
+        *drv += k_cycle_get_32() - t0;
+        if (rc) return rc;
+        put_value(d, i, rec, &v);
+    }
+    return 0;
+}
+
+static void publish(const struct sensor_record *rec)
+{
+    k_spinlock_key_t key = k_spin_lock(&lock);
+    last = *rec;
+    have_last = true;
+    k_spin_unlock(&lock, key);
+
+    /* as enqueue_snapshot(): drop the oldest when full */
+    if (k_msgq_put(&rec_q, rec, K_NO_WAIT) != 0) {
+        struct sensor_record trash;
+        k_msgq_get(&rec_q, &trash, K_NO_WAIT);
+        PIPE_TRACE(drop, 0, 0);
+        key = k_spin_lock(&lock);
+        acc.dropped++;
+        k_spin_unlock(&lock, key);
+        k_msgq_put(&rec_q, rec, K_NO_WAIT);
+    }
+    PIPE_TRACE(enqueue, 0, k_msgq_num_used_get(&rec_q));
+}
+
+static void engine_thread(void *, void *, void *)
+{
+    /* zero: every entry is due on the first pass */
+    int64_t next[SENSOR_TABLE_COUNT] = { 0 };
+    struct sensor_record rec;
+
+    memset(&rec, 0, sizeof(rec));
+    for (int i = 0; i < SENSOR_TABLE_COUNT; i++) {
+        if (!device_is_ready(sensor_table[i].dev)) {
+            LOG_ERR("%s: %s not ready", sensor_table[i].name, sensor_table[i].dev->name);
+        }
+    }
+
+    while (1) {
+        int64_t now = k_uptime_get();
+        int64_t wake = INT64_MAX;
+        uint32_t start = k_cycle_get_32();
+        uint32_t drv = 0, errors = 0;
+
+        rec.updated = 0;
+        for (int i = 0; i < SENSOR_TABLE_COUNT; i++) {
+            const struct sensor_desc *d = &sensor_table[i];
+
+            if (now >= next[i]) {
+                PIPE_TRACE(fetch_start, i, 0);
+                int rc = sample(d, (uint8_t *)&rec, &drv);
+                PIPE_TRACE(fetch_end, i, rc);
+                if (rc == 0) {
+                    rec.updated |= BIT(i);
+                } else {
+                    errors++;
+                }
+                /* next multiple of the period, skipping any missed */
+                next[i] = (now / d->period_ms + 1) * d->period_ms;
+            }
+            wake = MIN(wake, next[i]);
+        }
+
+        if (rec.updated) {
+            rec.timestamp_ms = (uint32_t)now;
+            publish(&rec);
+        }
+
+        uint32_t cyc = k_cycle_get_32() - start;
+        k_spinlock_key_t key = k_spin_lock(&lock);
+        acc.errors += errors;
+        if (rec.updated) {
+            acc.passes++;
+            acc.pass_cycles += cyc;
+            acc.driver_cycles += drv;
+            acc.pass_cycles_max = MAX(acc.pass_cycles_max, cyc);
+        }
+        k_spin_unlock(&lock, key);
+
+        k_sleep(K_TIMEOUT_ABS_MS(wake));
+    }
+}
+
+/* -------- Logger -------- */
+
+static void writer_thread(void *, void *, void *)
+{
+    if (log_fs_mount() != 0) {
+        LOG_ERR("FS mount failed");
+        return;
+    }
+    if (ring_log_open(&rec_log) != 0) {
+        LOG_ERR("Open %s failed", REC_LOG_PATH);
+        return;
+    }
+
+    while (1) {
+        struct sensor_record rec;
+        if (k_msgq_get(&rec_q, &rec, K_FOREVER) == 0) {
+            PIPE_TRACE(dequeue, 0, k_msgq_num_used_get(&rec_q));
+            int rc = ring_log_write(&rec_log, &rec, sizeof(rec));
+            if (rc) {
+                LOG_ERR("record write err %d", rc);
+                k_sleep(K_MSEC(1000));
+                continue;
+            }
+            k_spinlock_key_t key = k_spin_lock(&lock);
+            acc.written++;
+            k_spin_unlock(&lock, key);
+        }
+    }
+}
+
+/* -------- API -------- */
+
+int sensor_engine_start(void)
+{
+#if defined(CONFIG_APP_SMP_LOG)
+    int rc = smp_log_export(&rec_log, sizeof(struct sensor_record));
+    if (rc) return rc;
+#endif
+    k_thread_create(&engine_thread_data, engine_stack, K_THREAD_STACK_SIZEOF(engine_stack),
+                    engine_thread, NULL, NULL, NULL, 5, 0, K_NO_WAIT);
+    k_thread_create(&writer_thread_data, writer_stack, K_THREAD_STACK_SIZEOF(writer_stack),
+                    writer_thread, NULL, NULL, NULL, 6, 0, K_NO_WAIT);
+    return 0;
+}
+
+int sensor_engine_last(struct sensor_record *out)
+{
+    k_spinlock_key_t key = k_spin_lock(&lock);
+    bool ok = have_last;
+    *out = last;
+    k_spin_unlock(&lock, key);
+    return ok ? 0 : -EAGAIN;
+}
+
+int32_t sensor_record_get(const struct sensor_record *rec, const struct sensor_desc *d,
+                          uint8_t ch)
+{
+    const uint8_t *p = (const uint8_t *)rec + d->offset + ch * d->width;
+
+    if (d->width == sizeof(int16_t)) {
+        int16_t s;
+        memcpy(&s, p, sizeof(s));
+        return s;
+    }
+    int32_t x;
+    memcpy(&x, p, sizeof(x));
+    return x;
+}
+
+void sensor_engine_stats_get(struct sensor_engine_stats *st)
+{
+    k_spinlock_key_t key = k_spin_lock(&lock);
+    *st = acc;
+    k_spin_unlock(&lock, key);
+    st->record_size = sizeof(struct sensor_record);
+    st->ram_static = sizeof(struct sensor_record) * (REC_Q_DEPTH + 1) + sizeof(engine_stack) +
+                     sizeof(writer_stack) + sizeof(engine_thread_data) +
+                     sizeof(writer_thread_data);
+}
+
+#endif /* CONFIG_APP_SENSOR_ENGINE */
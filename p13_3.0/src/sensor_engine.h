@@ -0,0 +1,79 @@
+#ifndef SENSOR_ENGINE_H
+#define SENSOR_ENGINE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <zephyr/device.h>
+#include <zephyr/devicetree.h>
+#include <zephyr/drivers/sensor.h>
+#include <zephyr/sys/util.h>
+
+/*
+ * Generic sampling engine (CONFIG_APP_SENSOR_ENGINE) over the sensor
+ * table in devicetree (app,sensor-table, see sensor_table.overlay).
+ * The descriptors and the packed record are generated from the table's
+ * child nodes, so adding a sensor is an overlay change: the engine has
+ * no per-sensor code and every record offset is a compile-time constant.
+ *
+ * One thread reads each sensor at multiples of its period since boot
+ * and, after every pass that read something, queues a record holding
+ * the latest value of every channel. A logger thread writes the records
+ * to the circular file /lfs/records.bin.
+ */
+#if DT_HAS_COMPAT_STATUS_OKAY(app_sensor_table)
+
+#define SENSOR_TABLE_NODE DT_INST(0, app_sensor_table)
+
+/* Storage type of one value */
+#define SENSOR_TABLE_TYPE(node) COND_CODE_1(DT_PROP(node, int16), (int16_t), (int32_t))
+
+#define SENSOR_TABLE_MEMBER(node) \
+    SENSOR_TABLE_TYPE(node) DT_STRING_TOKEN(node, field)[DT_PROP_LEN(node, channels)];
+#define SENSOR_TABLE_ONE(node) 1 +
+
+#define SENSOR_TABLE_COUNT \
+    (DT_FOREACH_CHILD_STATUS_OKAY(SENSOR_TABLE_NODE, SENSOR_TABLE_ONE) 0)
+
+/* One table entry's values, in channel order, under its field name */
+struct __packed sensor_record {
+    uint32_t timestamp_ms;    /* k_uptime at the start of the pass */
+    uint32_t updated;         /* bit n: entry n was read in this pass */
+    DT_FOREACH_CHILD_STATUS_OKAY(SENSOR_TABLE_NODE, SENSOR_TABLE_MEMBER)
+};
+
+struct sensor_desc {
+    const struct device *dev;
+    const char *name;                   /* the field property */
+    const enum sensor_channel *chan;
+    const char *const *chan_name;
+    const int32_t *scale;               /* stored units per SI unit */
+    uint32_t period_ms;
+    uint16_t offset;                    /* of the first value in the record */
+    uint8_t n_chan;
+    uint8_t width;                      /* bytes per value */
+};
+
+extern const struct sensor_desc sensor_table[SENSOR_TABLE_COUNT];
+
+struct sensor_engine_stats {
+    uint32_t passes;                    /* passes that read at least one sensor */
+    uint32_t errors;                    /* failed fetches or channel reads */
+    uint32_t dropped;                   /* oldest record discarded on a full queue */
+    uint32_t written;
+    uint64_t pass_cycles;               /* whole passes */
+    uint64_t driver_cycles;             /* of which in sensor_sample_fetch/channel_get */
+    uint32_t pass_cycles_max;
+    size_t record_size;
+    size_t ram_static;                  /* queue, stacks and engine state */
+};
+
+int sensor_engine_start(void);
+/* The latest record; 0 on success, -EAGAIN before the first pass */
+int sensor_engine_last(struct sensor_record *out);
+int32_t sensor_record_get(const struct sensor_record *rec, const struct sensor_desc *d,
+                          uint8_t ch);
+void sensor_engine_stats_get(struct sensor_engine_stats *st);
+
+#endif /* DT_HAS_COMPAT_STATUS_OKAY(app_sensor_table) */
+
+#endif /* SENSOR_ENGINE_H */
@@ -0,0 +1,237 @@
+#include "sensor_stats.h"
+#include <zephyr/kernel.h>
+#include <string.h>
+
+#if defined(CONFIG_APP_STATS)
+
+#define SLIDE_LEN CONFIG_APP_STATS_SLIDING_LEN
+
+/* Welford accumulator; mean and M2 kept in Q8 fixed point */
+struct welford {
+    uint32_t n;
+    int32_t min;
+    int32_t max;
+    int64_t mean_q8;
+    int64_t m2_q8;
+};
+
+/* Exact sums over a sample ring plus monotonic deques for min/max.
+ * Welford cannot un-add a sample without drift; integer sums can.
+ */
+struct sliding {
+    int32_t buf[SLIDE_LEN];
+    uint32_t seq;                   /* samples ever added */
+    int64_t sum;
+    int64_t sumsq;
+    uint32_t minq[SLIDE_LEN];       /* seq numbers, values increasing */
+    uint32_t maxq[SLIDE_LEN];       /* seq numbers, values decreasing */
+    uint16_t min_head, min_len;
+    uint16_t max_head, max_len;
+};
+
+static const struct stats_channel_info ch_info[STATS_CH_COUNT] = {
+    [STATS_CH_TEMP]  = { "temp",  2 },
+    [STATS_CH_HUM]   = { "hum",   2 },
+    [STATS_CH_PRESS] = { "press", 0 },
+    [STATS_CH_AX]    = { "ax",    2 },
+    [STATS_CH_AY]    = { "ay",    2 },
+    [STATS_CH_AZ]    = { "az",    2 },
+    [STATS_CH_GX]    = { "gx",    2 },
+    [STATS_CH_GY]    = { "gy",    2 },
+    [STATS_CH_GZ]    = { "gz",    2 },
+    [STATS_CH_ROLL]  = { "roll",  2 },
+    [STATS_CH_PITCH] = { "pitch", 2 },
+    [STATS_CH_YAW]   = { "yaw",   2 },
+    [STATS_CH_ALT]   = { "alt",   2 },
+    [STATS_CH_VZ]    = { "vz",    2 },
+};
+
+static struct k_spinlock stats_lock;
+static struct welford cur[STATS_CH_COUNT];
+static struct welford last[STATS_CH_COUNT];
+static uint32_t last_end_ms;
+static struct sliding slide[STATS_CH_COUNT];
+
+static K_SEM_DEFINE(window_sem, 0, 1);
+
+static int64_t div_round(int64_t num, int64_t den)
+{
+    return (num >= 0) ? (num + den / 2) / den : (num - den / 2) / den;
+}
+
+static uint32_t sat_u32(int64_t v)
+{
+    if (v < 0) return 0;
+    return (v > UINT32_MAX) ? UINT32_MAX : (uint32_t)v;
+}
+
+static void welford_add(struct welford *w, int32_t x)
+{
+    int64_t xq = (int64_t)x * 256;
+
+    if (w->n == 0) {
+        w->min = x;
+        w->max = x;
+    } else {
+        if (x < w->min) w->min = x;
+        if (x > w->max) w->max = x;
+    }
+    w->n++;
+
+    int64_t delta = xq - w->mean_q8;
+    w->mean_q8 += div_round(delta, w->n);
+    w->m2_q8 += (delta * (xq - w->mean_q8)) / 256;
+}
+
+static void welford_result(const struct welford *w, struct stats_result *r)
+{
+    r->count = w->n;
+    r->min = w->min;
+    r->max = w->max;
+    r->mean_x100 = (int32_t)div_round(w->mean_q8 * 100, 256);
+    r->variance = (w->n > 1) ? sat_u32(div_round(w->m2_q8, (int64_t)(w->n - 1) * 256)) : 0;
+}
+
+static void sliding_add(struct sliding *s, int32_t x)
+{
+    if (s->seq >= SLIDE_LEN) {
+        uint32_t old_seq = s->seq - SLIDE_LEN;
+        int32_t old = s->buf[old_seq % SLIDE_LEN];
+
+        s->sum -= old;
+        s->sumsq -= (int64_t)old * old;
+        if (s->min_len && s->minq[s->min_head] == old_seq) {
+            s->min_head = (s->min_head + 1) % SLIDE_LEN;
+            s->min_len--;
+        }
+        if (s->max_len && s->maxq[s->max_head] == old_seq) {
+            s->max_head = (s->max_head + 1) % SLIDE_LEN;
+            s->max_len--;
+        }
+    }
+
+    s->buf[s->seq % SLIDE_LEN] = x;
+    s->sum += x;
+    s->sumsq += (int64_t)x * x;
+
+    while (s->min_len &&
+           s->buf[s->minq[(s->min_head + s->min_len - 1) % SLIDE_LEN] % SLIDE_LEN] >= x) {
+        s->min_len--;
+    }
+    s->minq[(s->min_head + s->min_len++) % SLIDE_LEN] = s->seq;
+
+    while (s->max_len &&
+           s->buf[s->maxq[(s->max_head + s->max_len - 1) % SLIDE_LEN] % SLIDE_LEN] <= x) {
+        s->max_len--;
+    }
+    s->maxq[(s->max_head + s->max_len++) % SLIDE_LEN] = s->seq;
+
+    s->seq++;
+}
+
+static void sliding_result(const struct sliding *s, struct stats_result *r)
+{
+    int64_t n = MIN(s->seq, SLIDE_LEN);
+
+    memset(r, 0, sizeof(*r));
+    if (n == 0) return;
+
+    r->count = (uint32_t)n;
+    r->min = s->buf[s->minq[s->min_head] % SLIDE_LEN];
+    r->max = s->buf[s->maxq[s->max_head] % SLIDE_LEN];
+    r->mean_x100 = (int32_t)div_round(s->sum * 100, n);
+    if (n > 1) {
+        r->variance = sat_u32(div_round(n * s->sumsq - s->sum * s->sum, n * (n - 1)));
+    }
+}
+
+/* Tumbling window boundary: runs in timer (ISR) context, so only latch */
+static void window_expiry(struct k_timer *timer)
+{
+    ARG_UNUSED(timer);
+
+    k_spinlock_key_t key = k_spin_lock(&stats_lock);
+    memcpy(last, cur, sizeof(last));
+    memset(cur, 0, sizeof(cur));
+    last_end_ms = k_uptime_get_32();
+    k_spin_unlock(&stats_lock, key);
+
+    k_sem_give(&window_sem);
+}
+
+static K_TIMER_DEFINE(window_timer, window_expiry, NULL);
+
+void sensor_stats_init(void)
+{
+    k_spinlock_key_t key = k_spin_lock(&stats_lock);
+    memset(cur, 0, sizeof(cur));
+    memset(last, 0, sizeof(last));
+    memset(slide, 0, sizeof(slide));
+    k_spin_unlock(&stats_lock, key);
+
+    k_timer_start(&window_timer, K_MSEC(CONFIG_APP_STATS_WINDOW_MS),
+                  K_MSEC(CONFIG_APP_STATS_WINDOW_MS));
+}
+
+void sensor_stats_add(enum stats_channel ch, int32_t value)
+{
+    if (ch >= STATS_CH_COUNT) return;
+
+    k_spinlock_key_t key = k_spin_lock(&stats_lock);
+    welford_add(&cur[ch], value);
+    sliding_add(&slide[ch], value);
+    k_spin_unlock(&stats_lock, key);
+}
+
+int sensor_stats_get(enum stats_channel ch, enum stats_window win, struct stats_result *out)
+{
+    struct welford w;
+
+    if (ch >= STATS_CH_COUNT) return -EINVAL;
+
+    k_spinlock_key_t key = k_spin_lock(&stats_lock);
+    switch (win) {
+    case STATS_WIN_CURRENT:
+        w = cur[ch];
+        break;
+    case STATS_WIN_LAST:
+        w = last[ch];
+        break;
+    case STATS_WIN_SLIDING:
+        sliding_result(&slide[ch], out);
+        k_spin_unlock(&stats_lock, key);
+        return 0;
+    default:
+        k_spin_unlock(&stats_lock, key);
+        return -EINVAL;
+    }
+    k_spin_unlock(&stats_lock, key);
+
+    welford_result(&w, out);
+    return 0;
+}
+
+int sensor_stats_wait_window(struct stats_summary *out, k_timeout_t timeout)
+{
+    struct welford w[STATS_CH_COUNT];
+
+    int rc = k_sem_take(&window_sem, timeout);
+    if (rc) return rc;
+
+    k_spinlock_key_t key = k_spin_lock(&stats_lock);
+    memcpy(w, last, sizeof(w));
+    out->window_end_ms = last_end_ms;
+    k_spin_unlock(&stats_lock, key);
+
+    for (int ch = 0; ch < STATS_CH_COUNT; ch++) {
+        welford_result(&w[ch], &out->ch[ch]);
+    }
+    return 0;
+}
+
+const struct stats_channel_info *sensor_stats_channel_info(enum stats_channel ch)
+{
+    return (ch < STATS_CH_COUNT) ? &ch_info[ch] : NULL;
+}
+
+#endif /* CONFIG_APP_STATS */
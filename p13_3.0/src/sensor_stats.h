@@ -0,0 +1,61 @@
+#ifndef SENSOR_STATS_H
+#define SENSOR_STATS_H
+
+#include <stdint.h>
+#include <zephyr/kernel.h>
+#include "sensors_common.h"
+
+/* One channel per field of struct all_sensors_data */
+enum stats_channel {
+    STATS_CH_TEMP  = SNAP_CH_TEMP,   /* 0.01 degC */
+    STATS_CH_HUM   = SNAP_CH_HUM,    /* 0.01 %RH */
+    STATS_CH_PRESS = SNAP_CH_PRESS,  /* Pa */
+    STATS_CH_AX    = SNAP_CH_AX,     /* 0.01 m/s^2 */
+    STATS_CH_AY    = SNAP_CH_AY,
+    STATS_CH_AZ    = SNAP_CH_AZ,
+    STATS_CH_GX    = SNAP_CH_GX,     /* 0.01 rad/s */
+    STATS_CH_GY    = SNAP_CH_GY,
+    STATS_CH_GZ    = SNAP_CH_GZ,
+    STATS_CH_ROLL  = SNAP_CH_ROLL,   /* 0.01 deg */
+    STATS_CH_PITCH = SNAP_CH_PITCH,
+    STATS_CH_YAW   = SNAP_CH_YAW,
+    STATS_CH_ALT   = SNAP_CH_ALT,    /* 0.01 m */
+    STATS_CH_VZ    = SNAP_CH_VZ,     /* 0.01 m/s */
+    STATS_CH_COUNT = SNAP_CH_COUNT,
+};
+
+enum stats_window {
+    STATS_WIN_CURRENT,  /* tumbling window being filled */
+    STATS_WIN_LAST,     /* last completed tumbling window */
+    STATS_WIN_SLIDING,  /* last CONFIG_APP_STATS_SLIDING_LEN samples */
+};
+
+/* All values in the channel's own units */
+struct stats_result {
+    uint32_t count;
+    int32_t min;
+    int32_t max;
+    int32_t mean_x100;  /* mean * 100 */
+    uint32_t variance;  /* sample variance, units^2, saturated */
+};
+
+/* One closed tumbling window for every channel */
+struct stats_summary {
+    uint32_t window_end_ms;
+    struct stats_result ch[STATS_CH_COUNT];
+};
+
+struct stats_channel_info {
+    const char *name;
+    uint8_t decimals;   /* channel unit = 10^-decimals of the SI/display unit */
+};
+
+void sensor_stats_init(void);
+/* O(1) (amortized for sliding min/max); callable from any thread */
+void sensor_stats_add(enum stats_channel ch, int32_t value);
+int sensor_stats_get(enum stats_channel ch, enum stats_window win, struct stats_result *out);
+/* Blocks until the next tumbling window closes, then returns all channels */
+int sensor_stats_wait_window(struct stats_summary *out, k_timeout_t timeout);
+const struct stats_channel_info *sensor_stats_channel_info(enum stats_channel ch);
+
+#endif /* SENSOR_STATS_H */
@@ -1,23 +1,30 @@
 #ifndef SENSORS_COMMON_H
 #define SENSORS_COMMON_H
 
+#include <stddef.h>
 #include <stdint.h>
 
 /* Master struct that holds everything (your layout) */
 struct all_sensors_data {
+    uint32_t timestamp_ms;    /* k_uptime when this snapshot was merged */
+    uint16_t valid;           /* SNAP_VALID(group): the group holds a reading */
+
     /* HTS221 */
     struct {
+        uint32_t ts_ms;       /* k_uptime at acquisition */
         int16_t temperature;  /* e.g. degC * 100 */
         int16_t humidity;     /* e.g. %RH * 100 */
     } ht;
 
     /* LPS22HB */
     struct {
+        uint32_t ts_ms;
         int32_t pressure;     /* e.g. Pa */
     } press;
 
     /* LSM6DSL (IMU) */
     struct {
+        uint32_t ts_ms;
         struct {
             int16_t x;
             int16_t y;
@@ -30,6 +37,143 @@ struct all_sensors_data {
             int16_t z;
         } gyro;
     } imu;
+
+    /* IMU fusion (CONFIG_APP_FUSION), zero otherwise; stamped by imu.ts_ms */
+    struct {
+        int16_t roll;         /* deg * 100 */
+        int16_t pitch;
+        int16_t yaw;
+    } orient;
+
+    /* Derived from pressure + IMU (CONFIG_APP_BARO_ALT), zero otherwise */
+    struct {
+        uint32_t ts_ms;       /* filter state as of this time */
+        int32_t altitude;     /* ISA altitude, cm */
+        int16_t vspeed;       /* cm/s, up positive */
+    } alt;
 };
 
+/* Field groups sharing one acquisition time */
+enum snapshot_group {
+    SNAP_GRP_HT,
+    SNAP_GRP_PRESS,
+    SNAP_GRP_IMU,
+    SNAP_GRP_ORIENT,
+    SNAP_GRP_ALT,
+    SNAP_GRP_COUNT,
+};
+
+#define SNAP_VALID(grp)   (1u << (grp))
+
+static inline uint32_t snapshot_group_ts(const struct all_sensors_data *d,
+                                         enum snapshot_group grp)
+{
+    switch (grp) {
+    case SNAP_GRP_HT:     return d->ht.ts_ms;
+    case SNAP_GRP_PRESS:  return d->press.ts_ms;
+    case SNAP_GRP_IMU:
+    case SNAP_GRP_ORIENT: return d->imu.ts_ms;
+    case SNAP_GRP_ALT:    return d->alt.ts_ms;
+    default:              return 0;
+    }
+}
+
+/* The orientation shares the IMU's time */
+static inline void snapshot_group_ts_set(struct all_sensors_data *d, enum snapshot_group grp,
+                                         uint32_t ts)
+{
+    switch (grp) {
+    case SNAP_GRP_HT:     d->ht.ts_ms = ts; break;
+    case SNAP_GRP_PRESS:  d->press.ts_ms = ts; break;
+    case SNAP_GRP_IMU:    d->imu.ts_ms = ts; break;
+    case SNAP_GRP_ALT:    d->alt.ts_ms = ts; break;
+    default:              break;
+    }
+}
+
+/* Flat view of the numeric fields, in struct order */
+enum snapshot_channel {
+    SNAP_CH_TEMP,
+    SNAP_CH_HUM,
+    SNAP_CH_PRESS,
+    SNAP_CH_AX,
+    SNAP_CH_AY,
+    SNAP_CH_AZ,
+    SNAP_CH_GX,
+    SNAP_CH_GY,
+    SNAP_CH_GZ,
+    SNAP_CH_ROLL,
+    SNAP_CH_PITCH,
+    SNAP_CH_YAW,
+    SNAP_CH_ALT,
+    SNAP_CH_VZ,
+    SNAP_CH_COUNT,
+};
+
+static inline int32_t snapshot_get(const struct all_sensors_data *d, enum snapshot_channel ch)
+{
+    switch (ch) {
+    case SNAP_CH_TEMP:  return d->ht.temperature;
+    case SNAP_CH_HUM:   return d->ht.humidity;
+    case SNAP_CH_PRESS: return d->press.pressure;
+    case SNAP_CH_AX:    return d->imu.accel.x;
+    case SNAP_CH_AY:    return d->imu.accel.y;
+    case SNAP_CH_AZ:    return d->imu.accel.z;
+    case SNAP_CH_GX:    return d->imu.gyro.x;
+    case SNAP_CH_GY:    return d->imu.gyro.y;
+    case SNAP_CH_GZ:    return d->imu.gyro.z;
+    case SNAP_CH_ROLL:  return d->orient.roll;
+    case SNAP_CH_PITCH: return d->orient.pitch;
+    case SNAP_CH_YAW:   return d->orient.yaw;
+    case SNAP_CH_ALT:   return d->alt.altitude;
+    case SNAP_CH_VZ:    return d->alt.vspeed;
+    default:            return 0;
+    }
+}
+
+static inline const char *snapshot_channel_name(enum snapshot_channel ch)
+{
+    static const char *const names[SNAP_CH_COUNT] = {
+        "temp", "hum", "press", "ax", "ay", "az", "gx", "gy", "gz",
+        "roll", "pitch", "yaw", "alt", "vz",
+    };
+    return (ch < SNAP_CH_COUNT) ? names[ch] : NULL;
+}
+
+/* Fixed-point decimals of the channel's unit: Pa, everything else x100 */
+static inline uint8_t snapshot_channel_decimals(enum snapshot_channel ch)
+{
+    return (ch == SNAP_CH_PRESS) ? 0 : 2;
+}
+
+static inline enum snapshot_group snapshot_channel_group(enum snapshot_channel ch)
+{
+    if (ch <= SNAP_CH_HUM) return SNAP_GRP_HT;
+    if (ch == SNAP_CH_PRESS) return SNAP_GRP_PRESS;
+    if (ch <= SNAP_CH_GZ) return SNAP_GRP_IMU;
+    if (ch <= SNAP_CH_YAW) return SNAP_GRP_ORIENT;
+    return SNAP_GRP_ALT;
+}
+
+static inline void snapshot_set(struct all_sensors_data *d, enum snapshot_channel ch, int32_t v)
+{
+    switch (ch) {
+    case SNAP_CH_TEMP:  d->ht.temperature = (int16_t)v; break;
+    case SNAP_CH_HUM:   d->ht.humidity = (int16_t)v; break;
+    case SNAP_CH_PRESS: d->press.pressure = v; break;
+    case SNAP_CH_AX:    d->imu.accel.x = (int16_t)v; break;
+    case SNAP_CH_AY:    d->imu.accel.y = (int16_t)v; break;
+    case SNAP_CH_AZ:    d->imu.accel.z = (int16_t)v; break;
+    case SNAP_CH_GX:    d->imu.gyro.x = (int16_t)v; break;
+    case SNAP_CH_GY:    d->imu.gyro.y = (int16_t)v; break;
+    case SNAP_CH_GZ:    d->imu.gyro.z = (int16_t)v; break;
+    case SNAP_CH_ROLL:  d->orient.roll = (int16_t)v; break;
+    case SNAP_CH_PITCH: d->orient.pitch = (int16_t)v; break;
+    case SNAP_CH_YAW:   d->orient.yaw = (int16_t)v; break;
+    case SNAP_CH_ALT:   d->alt.altitude = v; break;
+    case SNAP_CH_VZ:    d->alt.vspeed = (int16_t)v; break;
+    default:            break;
+    }
+}
+
 #endif /* SENSORS_COMMON_H */
@@ -0,0 +1,188 @@
+#include "smp_log.h"
+
+#if defined(CONFIG_APP_SMP_LOG)
+
+#include <string.h>
+#include <zephyr/kernel.h>
+#include <zephyr/spinlock.h>
+#include <zephyr/mgmt/mcumgr/mgmt/mgmt.h>
+#include <zephyr/mgmt/mcumgr/mgmt/handlers.h>
+#include <zephyr/mgmt/mcumgr/mgmt/callbacks.h>
+#include <zephyr/mgmt/mcumgr/smp/smp.h>
+#include <zephyr/mgmt/mcumgr/grp/fs_mgmt/fs_mgmt_callbacks.h>
+#include <zcbor_common.h>
+#include <zcbor_decode.h>
+#include <zcbor_encode.h>
+#include <mgmt/mcumgr/util/zcbor_bulk.h>
+
+/* map keys and CBOR framing around the data */
+BUILD_ASSERT(CONFIG_APP_SMP_LOG_CHUNK_SIZE + 64 <= CONFIG_MCUMGR_TRANSPORT_NETBUF_SIZE,
+             "chunk does not fit an SMP response");
+
+struct export {
+    const char *name;
+    const struct ring_log *log;
+    const struct raw_log *raw;  /* instead of log */
+    size_t rec_size;
+};
+
+static struct k_spinlock lock;
+static struct export exports[SMP_LOG_MAX];
+static uint32_t n_exports;
+static struct smp_log_stats acc;
+
+/* Handlers run one at a time on the SMP work queue */
+static uint8_t chunk[CONFIG_APP_SMP_LOG_CHUNK_SIZE];
+
+static int add(const struct export *e)
+{
+    k_spinlock_key_t key = k_spin_lock(&lock);
+    int rc = -ENOMEM;
+
+    if (n_exports < SMP_LOG_MAX) {
+        exports[n_exports++] = *e;
+        rc = 0;
+    }
+    k_spin_unlock(&lock, key);
+    return rc;
+}
+
+int smp_log_export(const struct ring_log *log, size_t rec_size)
+{
+    const struct export e = { .name = log->path, .log = log, .rec_size = rec_size };
+
+    return add(&e);
+}
+
+#if defined(CONFIG_APP_RAW_LOG)
+int smp_log_export_raw(const struct raw_log *log, const char *name)
+{
+    const struct export e = { .name = name, .raw = log, .rec_size = log->rec_size };
+
+    return add(&e);
+}
+#endif
+
+void smp_log_stats_get(struct smp_log_stats *st)
+{
+    k_spinlock_key_t key = k_spin_lock(&lock);
+    *st = acc;
+    k_spin_unlock(&lock, key);
+}
+
+static const struct export *find(const struct zcbor_string *name)
+{
+    k_spinlock_key_t key = k_spin_lock(&lock);
+    uint32_t n = n_exports;
+    k_spin_unlock(&lock, key);
+
+    for (uint32_t i = 0; i < n; i++) {
+        const char *path = exports[i].name;
+
+        if (strlen(path) == name->len && memcmp(path, name->value, name->len) == 0) {
+            return &exports[i];
+        }
+    }
+    return NULL;
+}
+
+static void account(int n, uint32_t cyc)
+{
+    k_spinlock_key_t key = k_spin_lock(&lock);
+    acc.requests++;
+    if (n < 0) {
+        acc.errors++;
+    } else {
+        acc.bytes += n;
+    }
+    acc.cycles += cyc;
+    k_spin_unlock(&lock, key);
+}
+
+/* -------- Group 64: ordered ring read -------- */
+
+static int log_read(struct smp_streamer *ctxt)
+{
+    zcbor_state_t *zsd = ctxt->reader->zs;
+    zcbor_state_t *zse = ctxt->writer->zs;
+    struct zcbor_string name = { 0 };
+    uint32_t off = 0;
+    uint32_t base = RING_LOG_BASE_CURRENT;
+    uint32_t total = 0;
+    size_t decoded;
+
+    struct zcbor_map_decode_key_val req[] = {
+        ZCBOR_MAP_DECODE_KEY_DECODER("name", zcbor_tstr_decode, &name),
+        ZCBOR_MAP_DECODE_KEY_DECODER("off", zcbor_uint32_decode, &off),
+        ZCBOR_MAP_DECODE_KEY_DECODER("base", zcbor_uint32_decode, &base),
+    };
+
+    if (zcbor_map_decode_bulk(zsd, req, ARRAY_SIZE(req), &decoded) != 0 || name.len == 0) {
+        return MGMT_ERR_EINVAL;
+    }
+
+    const struct export *e = find(&name);
+    if (!e) return MGMT_ERR_ENOENT;
+
+    uint32_t t0 = k_cycle_get_32();
+    int n = (IS_ENABLED(CONFIG_APP_RAW_LOG) && e->raw)
+                ? raw_log_read_ordered(e->raw, &base, off, chunk, sizeof(chunk), &total)
+                : ring_log_read_ordered(e->log, e->rec_size, &base, off, chunk, sizeof(chunk),
+                                        &total);
+    account(n, k_cycle_get_32() - t0);
+    if (n == -EINVAL) return MGMT_ERR_EINVAL;
+    if (n < 0) return MGMT_ERR_EUNKNOWN;
+
+    bool ok = zcbor_tstr_put_lit(zse, "off") && zcbor_uint32_put(zse, off) &&
+              zcbor_tstr_put_lit(zse, "base") && zcbor_uint32_put(zse, base) &&
+              zcbor_tstr_put_lit(zse, "total") && zcbor_uint32_put(zse, total) &&
+              zcbor_tstr_put_lit(zse, "data") && zcbor_bstr_encode_ptr(zse, chunk, n);
+
+    return ok ? MGMT_ERR_EOK : MGMT_ERR_EMSGSIZE;
+}
+
+static const struct mgmt_handler log_handlers[] = {
+    [SMP_LOG_ID_READ] = { .mh_read = log_read, .mh_write = NULL },
+};
+
+static struct mgmt_group log_group = {
+    .mg_handlers = log_handlers,
+    .mg_handlers_count = ARRAY_SIZE(log_handlers),
+    .mg_group_id = SMP_LOG_GROUP,
+};
+
+/* -------- fs group: read only -------- */
+
+static enum mgmt_cb_return fs_access(uint32_t event, enum mgmt_cb_return prev_status,
+                                     int32_t *rc, uint16_t *group, bool *abort_more,
+                                     void *data, size_t data_size)
+{
+    const struct fs_mgmt_file_access *fa = data;
+
+    ARG_UNUSED(event);
+    ARG_UNUSED(prev_status);
+    ARG_UNUSED(group);
+    ARG_UNUSED(abort_more);
+    ARG_UNUSED(data_size);
+
+    if (fa->access == FS_MGMT_FILE_ACCESS_WRITE) {
+        *rc = MGMT_ERR_EACCESSDENIED;
+        return MGMT_CB_ERROR_RC;
+    }
+    return MGMT_CB_OK;
+}
+
+static struct mgmt_callback fs_cb = {
+    .callback = fs_access,
+    .event_id = MGMT_EVT_OP_FS_MGMT_FILE_ACCESS,
+};
+
+static void smp_log_register(void)
+{
+    mgmt_register_group(&log_group);
+    mgmt_callback_register(&fs_cb);
+}
+
+MCUMGR_HANDLER_DEFINE(smp_log, smp_log_register);
+
+#endif /* CONFIG_APP_SMP_LOG */
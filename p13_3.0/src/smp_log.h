@@ -0,0 +1,47 @@
+#ifndef SMP_LOG_H
+#define SMP_LOG_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "raw_log.h"
+#include "ring_log.h"
+
+/*
+ * Log download over SMP (CONFIG_APP_SMP_LOG). Whole files come through
+ * the standard fs group (download with an offset, so a transfer can
+ * resume); the fs access hook here refuses uploads, so nothing can be
+ * written over a live log. A user group adds the ordered ring read:
+ *
+ *   group 64, id 0 (read)
+ *     request   {"name": path, "off": uint, "base": uint (optional)}
+ *     response  {"off": uint, "base": uint, "total": uint, "data": bstr}
+ *
+ * returning up to CONFIG_APP_SMP_LOG_CHUNK_SIZE bytes of the records in
+ * write order, as ring_log_read_ordered(). The first request leaves out
+ * "base"; later ones repeat the base from the response, so the stream
+ * keeps its layout while the logger writes. scripts/smp_pull.py drives
+ * both and reports throughput.
+ *
+ * A raw log (CONFIG_APP_RAW_LOG) has no file: it is exported under a
+ * name of its own for the ordered read only, records copied from their
+ * views straight into the response chunk.
+ */
+#define SMP_LOG_GROUP       64      /* MGMT_GROUP_ID_PERUSER */
+#define SMP_LOG_ID_READ     0
+#define SMP_LOG_MAX         4
+
+struct smp_log_stats {
+    uint32_t requests;
+    uint32_t errors;
+    uint64_t bytes;
+    uint64_t cycles;                /* in the read handler, file access included */
+};
+
+/* Make a ring readable by path; rec_size as passed to ring_log_write() */
+int smp_log_export(const struct ring_log *log, size_t rec_size);
+/* An open raw log, readable under name */
+int smp_log_export_raw(const struct raw_log *log, const char *name);
+void smp_log_stats_get(struct smp_log_stats *st);
+
+#endif /* SMP_LOG_H */
@@ -0,0 +1,139 @@
+#include "telemetry.h"
+#include <zephyr/kernel.h>
+#include <zephyr/device.h>
+#include <zephyr/devicetree.h>
+#include <zephyr/drivers/uart.h>
+#include <zephyr/sys/ring_buffer.h>
+#include <zephyr/sys/crc.h>
+#include <zephyr/sys/byteorder.h>
+#include <string.h>
+
+#if defined(CONFIG_APP_TELEMETRY)
+
+/* alias in overlay: telemetry-uart */
+#define TLM_NODE DT_ALIAS(telemetry_uart)
+#if !DT_NODE_HAS_STATUS(TLM_NODE, okay)
+#error "telemetry-uart not enabled in devicetree"
+#endif
+
+/*
+ * Frame on the wire: COBS(type u8 | seq u8 | uptime_ms le32 | payload | crc16 le16) 0x00
+ * crc16 is crc16_ccitt(0xFFFF, ...) over everything before it.
+ */
+#define TLM_HDR_SIZE   6
+#define TLM_RAW_MAX    (TLM_HDR_SIZE + TELEMETRY_PAYLOAD_MAX + 2)
+/* COBS adds one code byte per 254 data bytes (+1), then the 0x00 delimiter */
+#define TLM_FRAME_MAX  (TLM_RAW_MAX + TLM_RAW_MAX / 254 + 2)
+
+static const struct device *const tlm_dev = DEVICE_DT_GET(TLM_NODE);
+
+RING_BUF_DECLARE(tlm_ring, CONFIG_APP_TELEMETRY_RING_SIZE);
+static struct k_spinlock tlm_lock;
+static bool tx_busy;
+static atomic_t tlm_seq;
+static struct telemetry_stats tlm_stats;
+
+static size_t cobs_encode(const uint8_t *in, size_t len, uint8_t *out)
+{
+    size_t code_idx = 0;
+    size_t o = 1;
+    uint8_t code = 1;
+
+    for (size_t i = 0; i < len; i++) {
+        if (in[i] == 0) {
+            out[code_idx] = code;
+            code_idx = o++;
+            code = 1;
+            continue;
+        }
+        out[o++] = in[i];
+        if (++code == 0xFF) {
+            out[code_idx] = code;
+            code_idx = o++;
+            code = 1;
+        }
+    }
+    out[code_idx] = code;
+    return o;
+}
+
+/* Hand the next contiguous chunk of the ring to the UART DMA. Lock held. */
+static void tlm_kick(void)
+{
+    uint8_t *data;
+
+    if (tx_busy) return;
+
+    uint32_t len = ring_buf_get_claim(&tlm_ring, &data, CONFIG_APP_TELEMETRY_RING_SIZE);
+    if (len == 0) return;
+
+    if (uart_tx(tlm_dev, data, len, SYS_FOREVER_US) == 0) {
+        tx_busy = true;
+    } else {
+        /* leave the bytes in the ring; the next send retries */
+        ring_buf_get_finish(&tlm_ring, 0);
+    }
+}
+
+static void tlm_uart_cb(const struct device *dev, struct uart_event *evt, void *user_data)
+{
+    ARG_UNUSED(dev);
+    ARG_UNUSED(user_data);
+
+    if (evt->type != UART_TX_DONE && evt->type != UART_TX_ABORTED) return;
+
+    k_spinlock_key_t key = k_spin_lock(&tlm_lock);
+    ring_buf_get_finish(&tlm_ring, evt->data.tx.len);
+    tlm_stats.bytes += evt->data.tx.len;
+    tx_busy = false;
+    tlm_kick();
+    k_spin_unlock(&tlm_lock, key);
+}
+
+int telemetry_init(void)
+{
+    if (!device_is_ready(tlm_dev)) return -ENODEV;
+    return uart_callback_set(tlm_dev, tlm_uart_cb, NULL);
+}
+
+int telemetry_send(uint8_t type, const void *payload, size_t len)
+{
+    uint8_t raw[TLM_RAW_MAX];
+    uint8_t frame[TLM_FRAME_MAX];
+
+    if (len > TELEMETRY_PAYLOAD_MAX) return -EMSGSIZE;
+
+    raw[0] = type;
+    raw[1] = (uint8_t)atomic_inc(&tlm_seq);
+    sys_put_le32(k_uptime_get_32(), &raw[2]);
+    memcpy(&raw[TLM_HDR_SIZE], payload, len);
+
+    size_t n = TLM_HDR_SIZE + len;
+    sys_put_le16(crc16_ccitt(0xFFFF, raw, n), &raw[n]);
+    n += 2;
+
+    size_t flen = cobs_encode(raw, n, frame);
+    frame[flen++] = 0x00;
+
+    int rc = 0;
+    k_spinlock_key_t key = k_spin_lock(&tlm_lock);
+    if (ring_buf_space_get(&tlm_ring) < flen) {
+        tlm_stats.dropped++;
+        rc = -ENOBUFS;
+    } else {
+        ring_buf_put(&tlm_ring, frame, flen);
+        tlm_stats.frames++;
+        tlm_kick();
+    }
+    k_spin_unlock(&tlm_lock, key);
+    return rc;
+}
+
+void telemetry_stats_get(struct telemetry_stats *st)
+{
+    k_spinlock_key_t key = k_spin_lock(&tlm_lock);
+    *st = tlm_stats;
+    k_spin_unlock(&tlm_lock, key);
+}
+
+#endif /* CONFIG_APP_TELEMETRY */
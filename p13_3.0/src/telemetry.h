@@ -0,0 +1,27 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Frame types carried in the binary telemetry stream */
+enum telemetry_type {
+    TELEMETRY_SNAPSHOT = 1,   /* payload: struct all_sensors_data */
+    TELEMETRY_VIB      = 2,   /* payload: struct vib_features */
+};
+
+/* Largest payload accepted by telemetry_send() */
+#define TELEMETRY_PAYLOAD_MAX 64
+
+struct telemetry_stats {
+    uint32_t frames;    /* frames queued for TX */
+    uint32_t dropped;   /* frames dropped because the TX ring was full */
+    uint32_t bytes;     /* encoded bytes handed to the UART */
+};
+
+int telemetry_init(void);
+/* Never blocks: encodes one frame into the TX ring or drops it (-ENOBUFS) */
+int telemetry_send(uint8_t type, const void *payload, size_t len);
+void telemetry_stats_get(struct telemetry_stats *st);
+
+#endif /* TELEMETRY_H */
@@ -0,0 +1,370 @@
+/*
+ * app,trace-sensor: replays a CSV trace (or a synthetic signal) through
+ * the sensor API so the application runs unchanged on native_sim.
+ * See dts/bindings/app,trace-sensor.yaml.
+ */
+#define DT_DRV_COMPAT app_trace_sensor
+
+#include <zephyr/device.h>
+#include <zephyr/drivers/sensor.h>
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/pm/device.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if DT_HAS_COMPAT_STATUS_OKAY(DT_DRV_COMPAT)
+
+LOG_MODULE_REGISTER(trace_sensor, CONFIG_SENSOR_LOG_LEVEL);
+
+#if defined(CONFIG_ARCH_POSIX)
+#include <cmdline.h>
+#include <posix_native_task.h>
+#include <nsi_host_trampolines.h>
+#endif
+
+#define TRACE_MAX_ROWS  8192
+#define DAY_MS          (24u * 3600u * 1000u)
+#define PI_F            3.14159265f
+
+/* One sample in application units: 0.01 degC, 0.01 %RH, Pa, 0.01 m/s^2, 0.01 rad/s */
+struct trace_row {
+    uint32_t t_ms;
+    int16_t temp;
+    int16_t hum;
+    int32_t press;
+    int16_t acc[3];
+    int16_t gyr[3];
+};
+
+struct trace_config {
+    uint32_t time_scale;
+    uint16_t vib_hz;
+    uint16_t vib_centi;
+    uint16_t noise;
+};
+
+struct trace_data {
+    struct trace_row cur;
+    uint32_t seed;
+    bool suspended;         /* device PM: no samples until resumed */
+};
+
+/* Shared by all instances: they stand in for sensors on one board */
+static struct trace_row rows[TRACE_MAX_ROWS];
+static uint32_t n_rows;
+
+/* -------- CSV loading (native_sim only) -------- */
+
+#if defined(CONFIG_ARCH_POSIX)
+static const char *trace_path;
+
+static void trace_options(void)
+{
+    static struct args_struct_t opts[] = {
+        { .option = "trace", .name = "csv", .type = 's', .dest = (void *)&trace_path,
+          .descript = "Sensor trace for app,trace-sensor (synthetic without it)" },
+        ARG_TABLE_ENDMARKER
+    };
+
+    native_add_command_line_opts(opts);
+}
+
+NATIVE_TASK(trace_options, PRE_BOOT_1, 1);
+
+enum { COL_TS, COL_TEMP, COL_HUM, COL_PRESS, COL_AX, COL_AY, COL_AZ, COL_GX, COL_GY, COL_GZ, COL_N };
+
+static const char *const col_names[COL_N] = {
+    "timestamp_ms", "temp_centi", "hum_centi", "press_pa", "ax", "ay", "az", "gx", "gy", "gz",
+};
+
+static int col_idx[COL_N];
+static bool have_header;
+
+static void parse_line(char *line)
+{
+    char *field[32];
+    int n = 0;
+
+    /* split in place on commas; drop a trailing CR */
+    field[n++] = line;
+    for (char *c = line; *c; c++) {
+        if (*c == '\r') {
+            *c = '\0';
+            break;
+        }
+        if (*c == ',' && n < 32) {
+            *c = '\0';
+            field[n++] = c + 1;
+        }
+    }
+    if (field[0][0] == '\0') return;
+
+    /* a header names the columns; decoder output also has headers for
+     * other frame types, which lack some of them and are ignored
+     */
+    for (int i = 0; i < n; i++) {
+        if (strcmp(field[i], "timestamp_ms") == 0) {
+            int idx[COL_N];
+
+            for (int c = 0; c < COL_N; c++) {
+                idx[c] = -1;
+                for (int j = 0; j < n; j++) {
+                    if (strcmp(field[j], col_names[c]) == 0) idx[c] = j;
+                }
+                if (idx[c] < 0) return;
+            }
+            memcpy(col_idx, idx, sizeof(col_idx));
+            have_header = true;
+            return;
+        }
+    }
+    if (!have_header || n_rows >= TRACE_MAX_ROWS) return;
+    if (strcmp(field[0], "vib") == 0) return;
+
+    long v[COL_N];
+    for (int c = 0; c < COL_N; c++) {
+        char *end;
+        if (col_idx[c] >= n) return;
+        v[c] = strtol(field[col_idx[c]], &end, 10);
+        if (end == field[col_idx[c]] || *end) return;
+    }
+
+    struct trace_row *r = &rows[n_rows];
+
+    if (n_rows && (uint32_t)v[COL_TS] < rows[n_rows - 1].t_ms) return;
+    r->t_ms = (uint32_t)v[COL_TS];
+    r->temp = (int16_t)v[COL_TEMP];
+    r->hum = (int16_t)v[COL_HUM];
+    r->press = (int32_t)v[COL_PRESS];
+    for (int i = 0; i < 3; i++) {
+        r->acc[i] = (int16_t)v[COL_AX + i];
+        r->gyr[i] = (int16_t)v[COL_GX + i];
+    }
+    n_rows++;
+}
+
+static int load_trace(const char *path)
+{
+    static char line[512];
+    char buf[256];
+    size_t len = 0;
+    long r;
+
+    int fd = nsi_host_open(path, 0 /* O_RDONLY */);
+    if (fd < 0) return -ENOENT;
+
+    while ((r = nsi_host_read(fd, buf, sizeof(buf))) > 0) {
+        for (long i = 0; i < r; i++) {
+            if (buf[i] == '\n' || len == sizeof(line) - 1) {
+                line[len] = '\0';
+                parse_line(line);
+                len = 0;
+            } else {
+                line[len++] = buf[i];
+            }
+        }
+    }
+    if (len) {
+        line[len] = '\0';
+        parse_line(line);
+    }
+    nsi_host_close(fd);
+
+    /* replay relative to the first row */
+    for (uint32_t i = 1; i < n_rows; i++) {
+        rows[i].t_ms -= rows[0].t_ms;
+    }
+    if (n_rows) rows[0].t_ms = 0;
+    return n_rows ? 0 : -EINVAL;
+}
+#endif /* CONFIG_ARCH_POSIX */
+
+/* -------- Sample generation -------- */
+
+static int32_t noise(struct trace_data *d, uint16_t ampl)
+{
+    if (ampl == 0) return 0;
+    d->seed = d->seed * 1103515245u + 12345u;
+    return (int32_t)((d->seed >> 16) % (2u * ampl + 1u)) - ampl;
+}
+
+/* Diurnal temperature/humidity, slow weather and a +-2 m climb in the
+ * pressure, board at rest with a vibration tone on x
+ */
+static void synth(const struct trace_config *cfg, struct trace_data *d)
+{
+    int64_t us = k_ticks_to_us_floor64(k_uptime_ticks());
+    float t_s = (float)((us / 1000) * cfg->time_scale % DAY_MS) / 1000.0f;
+    float day = 2.0f * PI_F * t_s / (DAY_MS / 1000);
+    float tone = 2.0f * PI_F * cfg->vib_hz * (float)(us % 1000000) / 1e6f;
+    struct trace_row *r = &d->cur;
+
+    r->temp = (int16_t)(2200 + lrintf(300.0f * sinf(day)) + noise(d, cfg->noise));
+    r->hum = (int16_t)(4500 - lrintf(800.0f * sinf(day)) + noise(d, cfg->noise));
+    r->press = 101325 + lrintf(150.0f * sinf(day / 2) - 24.0f * sinf(2.0f * PI_F * t_s / 60.0f)) +
+               noise(d, cfg->noise);
+    r->acc[0] = (int16_t)(lrintf(cfg->vib_centi * sinf(tone)) + noise(d, cfg->noise));
+    r->acc[1] = (int16_t)noise(d, cfg->noise);
+    r->acc[2] = (int16_t)(981 + noise(d, cfg->noise));
+    for (int i = 0; i < 3; i++) {
+        r->gyr[i] = (int16_t)noise(d, cfg->noise);
+    }
+}
+
+static void replay(const struct trace_config *cfg, struct trace_data *d)
+{
+    uint32_t span = rows[n_rows - 1].t_ms + 1;
+    uint32_t t = (uint32_t)(k_uptime_get() * cfg->time_scale % span);
+    uint32_t lo = 0, hi = n_rows;
+
+    /* last row at or before t */
+    while (hi - lo > 1) {
+        uint32_t mid = (lo + hi) / 2;
+        if (rows[mid].t_ms <= t) lo = mid; else hi = mid;
+    }
+    d->cur = rows[lo];
+}
+
+/* -------- Sensor API -------- */
+
+static void centi_to_value(int32_t v, struct sensor_value *val)
+{
+    val->val1 = v / 100;
+    val->val2 = (v % 100) * 10000;
+}
+
+static int trace_sample_fetch(const struct device *dev, enum sensor_channel chan)
+{
+    const struct trace_config *cfg = dev->config;
+    struct trace_data *d = dev->data;
+
+    ARG_UNUSED(chan);
+
+    /* catches users that skip pm_device_runtime_get() */
+    if (d->suspended) return -EIO;
+
+    if (n_rows) {
+        replay(cfg, d);
+    } else {
+        synth(cfg, d);
+    }
+    return 0;
+}
+
+static int trace_channel_get(const struct device *dev, enum sensor_channel chan,
+                             struct sensor_value *val)
+{
+    struct trace_data *d = dev->data;
+    const struct trace_row *r = &d->cur;
+
+    switch (chan) {
+    case SENSOR_CHAN_AMBIENT_TEMP:
+        centi_to_value(r->temp, val);
+        break;
+    case SENSOR_CHAN_HUMIDITY:
+        centi_to_value(r->hum, val);
+        break;
+    case SENSOR_CHAN_PRESS:
+        /* kPa, as the LPS22HB driver reports it */
+        val->val1 = r->press / 1000;
+        val->val2 = (r->press % 1000) * 1000;
+        break;
+    case SENSOR_CHAN_ACCEL_X:
+    case SENSOR_CHAN_ACCEL_Y:
+    case SENSOR_CHAN_ACCEL_Z:
+        centi_to_value(r->acc[chan - SENSOR_CHAN_ACCEL_X], val);
+        break;
+    case SENSOR_CHAN_ACCEL_XYZ:
+        for (int i = 0; i < 3; i++) centi_to_value(r->acc[i], &val[i]);
+        break;
+    case SENSOR_CHAN_GYRO_X:
+    case SENSOR_CHAN_GYRO_Y:
+    case SENSOR_CHAN_GYRO_Z:
+        centi_to_value(r->gyr[chan - SENSOR_CHAN_GYRO_X], val);
+        break;
+    case SENSOR_CHAN_GYRO_XYZ:
+        for (int i = 0; i < 3; i++) centi_to_value(r->gyr[i], &val[i]);
+        break;
+    default:
+        return -ENOTSUP;
+    }
+    return 0;
+}
+
+static int trace_attr_set(const struct device *dev, enum sensor_channel chan,
+                          enum sensor_attribute attr, const struct sensor_value *val)
+{
+    ARG_UNUSED(dev);
+    ARG_UNUSED(chan);
+    ARG_UNUSED(val);
+
+    /* samples are computed on demand, so any rate is fine */
+    return (attr == SENSOR_ATTR_SAMPLING_FREQUENCY) ? 0 : -ENOTSUP;
+}
+
+static const struct sensor_driver_api trace_api = {
+    .sample_fetch = trace_sample_fetch,
+    .channel_get = trace_channel_get,
+    .attr_set = trace_attr_set,
+};
+
+#if defined(CONFIG_PM_DEVICE)
+static int trace_pm_action(const struct device *dev, enum pm_device_action action)
+{
+    struct trace_data *d = dev->data;
+
+    switch (action) {
+    case PM_DEVICE_ACTION_SUSPEND:
+        d->suspended = true;
+        break;
+    case PM_DEVICE_ACTION_RESUME:
+        d->suspended = false;
+        break;
+    default:
+        return -ENOTSUP;
+    }
+    return 0;
+}
+#endif
+
+static int trace_init(const struct device *dev)
+{
+    struct trace_data *d = dev->data;
+
+    d->seed = (uint32_t)(uintptr_t)dev;
+
+#if defined(CONFIG_ARCH_POSIX)
+    static bool loaded;
+
+    if (!loaded && trace_path) {
+        loaded = true;
+        int rc = load_trace(trace_path);
+        if (rc) {
+            LOG_ERR("trace %s not usable (%d), using synthetic data", trace_path, rc);
+        } else {
+            LOG_INF("trace %s: %u rows over %u ms", trace_path, n_rows, rows[n_rows - 1].t_ms);
+        }
+    }
+#endif
+    return 0;
+}
+
+#define TRACE_SENSOR_DEFINE(inst)                                                   \
+    static struct trace_data trace_data_##inst;                                     \
+    static const struct trace_config trace_config_##inst = {                        \
+        .time_scale = DT_INST_PROP(inst, time_scale),                               \
+        .vib_hz = DT_INST_PROP(inst, vibration_hz),                                 \
+        .vib_centi = DT_INST_PROP(inst, vibration_centi),                           \
+        .noise = DT_INST_PROP(inst, noise),                                         \
+    };                                                                              \
+    PM_DEVICE_DT_INST_DEFINE(inst, trace_pm_action);                                \
+    SENSOR_DEVICE_DT_INST_DEFINE(inst, trace_init, PM_DEVICE_DT_INST_GET(inst),     \
+                                 &trace_data_##inst,                                \
+                                 &trace_config_##inst, POST_KERNEL,                 \
+                                 CONFIG_SENSOR_INIT_PRIORITY, &trace_api);
+
+DT_INST_FOREACH_STATUS_OKAY(TRACE_SENSOR_DEFINE)
+
+#endif /* DT_HAS_COMPAT_STATUS_OKAY(DT_DRV_COMPAT) */
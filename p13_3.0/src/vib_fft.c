@@ -0,0 +1,291 @@
+#include "vib_fft.h"
+#include <zephyr/kernel.h>
+#include <zephyr/sys/atomic.h>
+#include <math.h>
+#include <string.h>
+
+#if defined(CONFIG_APP_VIB)
+
+#include <arm_math.h>
+
+#define N           CONFIG_APP_VIB_FFT_LEN
+#define HALF        (N / 2)
+#define RATE_MHZ    (1000000u / CONFIG_APP_IMU_PERIOD_MS)
+
+BUILD_ASSERT((N & (N - 1)) == 0, "CONFIG_APP_VIB_FFT_LEN must be a power of two");
+BUILD_ASSERT(VIB_BANDS <= HALF, "more bands than spectral lines");
+
+/* Synthetic input for vib_fft_bench(): tone between two bins plus gravity */
+#define BENCH_AMPLITUDE 1000    /* 10 m/s^2 on x */
+#define BENCH_GRAVITY   981
+
+/* -------- Buffers -------- */
+
+/* Filled by the IMU thread; the worker reads the other half */
+static int16_t raw[2][3][N];
+static uint32_t raw_ts[2];
+static uint8_t fill_idx;
+static uint16_t fill;
+static atomic_t busy;
+
+/* Worker scratch; work_lock lets the shell bench share it */
+static float32_t fft_in[N];
+static float32_t fft_out[N];
+static float32_t power[HALF + 1];
+static float32_t hann[N];
+static float32_t hann_power;    /* sum of w^2 */
+static arm_rfft_fast_instance_f32 rfft;
+static K_MUTEX_DEFINE(work_lock);
+static int16_t bench_in[3][N];
+
+static struct k_spinlock vib_lock;
+static struct vib_stats stats;
+static struct vib_features last;
+static bool have_last;
+
+static vib_sink_t vib_sink;
+
+K_THREAD_STACK_DEFINE(vib_stack, CONFIG_APP_VIB_STACK_SIZE);
+static struct k_thread vib_thread_data;
+static K_SEM_DEFINE(vib_ready, 0, 1);
+
+/* -------- Features -------- */
+
+static uint16_t sat_u16(float v)
+{
+    if (v <= 0.0f) return 0;
+    if (v >= 65535.0f) return UINT16_MAX;
+    return (uint16_t)lrintf(v);
+}
+
+/* samples[axis][N] in, features out; caller holds work_lock */
+static void analyse(const int16_t (*samples)[N], uint32_t ts_ms, struct vib_features *f)
+{
+    float32_t sumsq = 0.0f, peak = 0.0f;
+
+    memset(power, 0, sizeof(power));
+
+    for (int axis = 0; axis < 3; axis++) {
+        float32_t mean, p, mx, mn;
+        uint32_t idx;
+
+        for (int n = 0; n < N; n++) {
+            fft_in[n] = samples[axis][n];
+        }
+        arm_mean_f32(fft_in, N, &mean);
+        arm_offset_f32(fft_in, -mean, fft_in, N);
+
+        /* time domain: exact RMS and peak of the AC part */
+        arm_power_f32(fft_in, N, &p);
+        sumsq += p;
+        arm_max_f32(fft_in, N, &mx, &idx);
+        arm_min_f32(fft_in, N, &mn, &idx);
+        peak = MAX(peak, MAX(mx, -mn));
+
+        arm_mult_f32(fft_in, hann, fft_in, N);
+        arm_rfft_fast_f32(&rfft, fft_in, fft_out, 0);
+
+        /* packed output: [DC, Nyquist, re1, im1, ...]; fft_in is free now */
+        arm_cmplx_mag_squared_f32(&fft_out[2], fft_in, HALF - 1);
+        arm_add_f32(&power[1], fft_in, &power[1], HALF - 1);
+        power[HALF] += fft_out[1] * fft_out[1];
+    }
+
+    /* one-sided spectrum scaled so the lines sum to the mean square */
+    const float32_t scale = 2.0f / ((float32_t)N * hann_power);
+    float32_t best = 0.0f;
+    int k_best = 1;
+
+    for (int k = 1; k <= HALF; k++) {
+        power[k] *= (k == HALF) ? scale / 2.0f : scale;
+        if (power[k] > best) {
+            best = power[k];
+            k_best = k;
+        }
+    }
+
+    /* parabola through the log power of the strongest line and its
+     * neighbours; close to exact for the Gaussian-like Hann main lobe
+     */
+    float32_t delta = 0.0f;
+    if (k_best > 1 && k_best < HALF && power[k_best - 1] > 0.0f && power[k_best + 1] > 0.0f) {
+        float32_t a = logf(power[k_best - 1]), b = logf(power[k_best]);
+        float32_t c = logf(power[k_best + 1]);
+        float32_t den = a - 2.0f * b + c;
+        if (den < 0.0f) {
+            delta = 0.5f * (a - c) / den;
+        }
+    }
+
+    const float32_t rms = sqrtf(sumsq / N);
+
+    f->timestamp_ms = ts_ms;
+    f->peak_freq_mhz = (uint32_t)lrintf(((float32_t)k_best + delta) * RATE_MHZ / N);
+    f->rms = sat_u16(rms);
+    f->peak = sat_u16(peak);
+    f->crest_x100 = (rms > 0.0f) ? sat_u16(100.0f * peak / rms) : 0;
+    f->bands = VIB_BANDS;
+
+    /* bins 1..HALF split into VIB_BANDS ranges of (nearly) equal width */
+    for (int b = 0; b < VIB_BANDS; b++) {
+        int lo = 1 + (b * HALF) / VIB_BANDS;
+        int hi = 1 + ((b + 1) * HALF) / VIB_BANDS;
+        float32_t e = 0.0f;
+
+        for (int k = lo; k < hi; k++) {
+            e += power[k];
+        }
+        f->band_rms[b] = sat_u16(sqrtf(e));
+    }
+}
+
+/* -------- Live pipeline -------- */
+
+static void vib_thread(void *, void *, void *)
+{
+    while (1) {
+        struct vib_features f;
+
+        k_sem_take(&vib_ready, K_FOREVER);
+        int idx = fill_idx ^ 1;
+
+        k_mutex_lock(&work_lock, K_FOREVER);
+        uint32_t t0 = k_cycle_get_32();
+        analyse(raw[idx], raw_ts[idx], &f);
+        uint32_t cyc = k_cycle_get_32() - t0;
+        k_mutex_unlock(&work_lock);
+
+        /* raw[idx] has been consumed; the IMU thread may hand over the next one */
+        atomic_clear(&busy);
+
+        k_spinlock_key_t key = k_spin_lock(&vib_lock);
+        stats.windows++;
+        stats.cycles_last = cyc;
+        stats.cycles_max = MAX(stats.cycles_max, cyc);
+        stats.cycles_total += cyc;
+        last = f;
+        have_last = true;
+        k_spin_unlock(&vib_lock, key);
+
+        if (vib_sink) {
+            vib_sink(&f);
+        }
+    }
+}
+
+int vib_fft_init(vib_sink_t sink)
+{
+    if (arm_rfft_fast_init_f32(&rfft, N) != ARM_MATH_SUCCESS) {
+        return -EINVAL;
+    }
+
+    hann_power = 0.0f;
+    for (int n = 0; n < N; n++) {
+        hann[n] = 0.5f - 0.5f * cosf(2.0f * 3.14159265f * n / N);
+        hann_power += hann[n] * hann[n];
+    }
+
+    vib_sink = sink;
+    fill_idx = 0;
+    fill = 0;
+    atomic_clear(&busy);
+
+    /* below the logger so a window never delays a snapshot write */
+    k_thread_create(&vib_thread_data, vib_stack, K_THREAD_STACK_SIZEOF(vib_stack),
+                    vib_thread, NULL, NULL, NULL, 7, 0, K_NO_WAIT);
+    k_thread_name_set(&vib_thread_data, "vib");
+    return 0;
+}
+
+void vib_fft_push(const int16_t acc[3], uint32_t ts_ms)
+{
+    for (int i = 0; i < 3; i++) {
+        raw[fill_idx][i][fill] = acc[i];
+    }
+    if (++fill < N) return;
+    fill = 0;
+
+    if (atomic_set(&busy, 1)) {
+        /* worker still on the previous window: refill this one */
+        k_spinlock_key_t key = k_spin_lock(&vib_lock);
+        stats.dropped++;
+        k_spin_unlock(&vib_lock, key);
+        return;
+    }
+    raw_ts[fill_idx] = ts_ms;
+    fill_idx ^= 1;
+    k_sem_give(&vib_ready);
+}
+
+bool vib_fft_last(struct vib_features *f)
+{
+    k_spinlock_key_t key = k_spin_lock(&vib_lock);
+    bool ok = have_last;
+    *f = last;
+    k_spin_unlock(&vib_lock, key);
+    return ok;
+}
+
+void vib_fft_stats_get(struct vib_stats *st)
+{
+    k_spinlock_key_t key = k_spin_lock(&vib_lock);
+    *st = stats;
+    k_spin_unlock(&vib_lock, key);
+}
+
+void vib_fft_mem_get(struct vib_mem *m)
+{
+    m->samples = sizeof(raw) + sizeof(raw_ts);
+    m->work = sizeof(fft_in) + sizeof(fft_out) + sizeof(power) + sizeof(hann) + sizeof(rfft) +
+              sizeof(bench_in);
+    m->stack_size = K_THREAD_STACK_SIZEOF(vib_stack);
+    m->stack_unused = 0;
+#if defined(CONFIG_INIT_STACKS) && defined(CONFIG_THREAD_STACK_INFO)
+    (void)k_thread_stack_space_get(&vib_thread_data, &m->stack_unused);
+#endif
+}
+
+uint32_t vib_fft_rate_mhz(void)
+{
+    return RATE_MHZ;
+}
+
+/* -------- Bench (shell thread) -------- */
+
+int vib_fft_bench(uint32_t windows, struct vib_bench *out)
+{
+    struct vib_features f;
+    uint64_t cyc = 0;
+
+    if (windows == 0) return -EINVAL;
+    memset(out, 0, sizeof(*out));
+
+    /* N/8 + 0.3 bins: off-grid so the interpolation is exercised */
+    const float32_t bin = (float32_t)(N / 8) + 0.3f;
+    for (int n = 0; n < N; n++) {
+        float32_t ph = 2.0f * 3.14159265f * bin * n / N;
+        bench_in[0][n] = (int16_t)lrintf(BENCH_AMPLITUDE * sinf(ph));
+        bench_in[1][n] = 0;
+        bench_in[2][n] = BENCH_GRAVITY;
+    }
+
+    k_mutex_lock(&work_lock, K_FOREVER);
+    for (uint32_t w = 0; w < windows; w++) {
+        uint32_t t0 = k_cycle_get_32();
+        analyse(bench_in, 0, &f);
+        cyc += k_cycle_get_32() - t0;
+    }
+    k_mutex_unlock(&work_lock);
+
+    out->windows = windows;
+    out->cycles_per_window = (uint32_t)(cyc / windows);
+    out->budget_cycles = (uint32_t)((uint64_t)sys_clock_hw_cycles_per_sec() *
+                                    CONFIG_APP_IMU_PERIOD_MS * N / 1000);
+    out->tone_mhz = (uint32_t)lrintf(bin * RATE_MHZ / N);
+    out->peak_freq_mhz = f.peak_freq_mhz;
+    out->rms_expected = (uint16_t)lrintf(BENCH_AMPLITUDE / 1.41421356f);
+    out->rms = f.rms;
+    return 0;
+}
+
+#endif /* CONFIG_APP_VIB */
@@ -0,0 +1,73 @@
+#ifndef VIB_FFT_H
+#define VIB_FFT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Vibration spectrum features from the accelerometer.
+ * Raw accel samples are collected into windows of CONFIG_APP_VIB_FFT_LEN
+ * per axis. A low-priority worker removes the mean (gravity), applies a
+ * Hann window and runs a CMSIS-DSP real FFT on each axis; the three power
+ * spectra are summed so the features do not depend on mounting direction.
+ * Units follow imu_sensor_fetch(): 0.01 m/s^2.
+ */
+#if defined(CONFIG_APP_VIB_BANDS)
+#define VIB_BANDS CONFIG_APP_VIB_BANDS
+#else
+#define VIB_BANDS 8
+#endif
+
+/* One window; also the TELEMETRY_VIB payload and the vib_log.bin record */
+struct vib_features {
+    uint32_t timestamp_ms;      /* uptime of the last sample in the window */
+    uint32_t peak_freq_mhz;     /* strongest spectral line, 0.001 Hz */
+    uint16_t rms;               /* AC magnitude over all axes, 0.01 m/s^2 */
+    uint16_t peak;              /* largest |a - mean| on any axis, 0.01 m/s^2 */
+    uint16_t crest_x100;        /* peak / rms */
+    uint16_t bands;             /* entries used in band_rms */
+    uint16_t band_rms[VIB_BANDS]; /* equal-width bands from DC to Nyquist */
+};
+
+/* Called from the worker thread once per window */
+typedef void (*vib_sink_t)(const struct vib_features *f);
+
+struct vib_stats {
+    uint32_t windows;
+    uint32_t dropped;           /* windows lost because the worker was busy */
+    uint32_t cycles_last;       /* per window, all three axes */
+    uint32_t cycles_max;
+    uint64_t cycles_total;
+};
+
+struct vib_mem {
+    size_t samples;             /* raw double buffer */
+    size_t work;                /* FFT in/out, power spectrum, window, bench input */
+    size_t stack_size;
+    size_t stack_unused;        /* 0 unless CONFIG_INIT_STACKS */
+};
+
+struct vib_bench {
+    uint32_t windows;
+    uint32_t cycles_per_window;
+    uint32_t budget_cycles;     /* one window of samples at the live rate */
+    uint32_t tone_mhz;          /* synthetic input */
+    uint32_t peak_freq_mhz;     /* measured */
+    uint16_t rms_expected;
+    uint16_t rms;
+};
+
+int vib_fft_init(vib_sink_t sink);
+/* Called from the IMU thread only; never blocks */
+void vib_fft_push(const int16_t acc[3], uint32_t ts_ms);
+/* false until the first window completes */
+bool vib_fft_last(struct vib_features *f);
+void vib_fft_stats_get(struct vib_stats *st);
+void vib_fft_mem_get(struct vib_mem *m);
+/* Sample rate the windows are analysed at, 0.001 Hz */
+uint32_t vib_fft_rate_mhz(void);
+/* Synthetic tone through the same code; live windows wait meanwhile */
+int vib_fft_bench(uint32_t windows, struct vib_bench *out);
+
+#endif /* VIB_FFT_H */
@@ -0,0 +1,132 @@
+/*
+ * The IMU filter-and-decimate stage (src/imu_filter.c) as a twister
+ * suite, once per filter type: the measured gain of the q15 kernels must
+ * meet the spec in filters/imu_filter.json in the passband and the
+ * alias-protected stopband, the live path must emit one output per
+ * decimation of input, and the block path must keep up with the design
+ * input rate.
+ */
+#include <errno.h>
+#include <stdlib.h>
+#include <zephyr/ztest.h>
+
+#include "imu_filter.h"
+#include "imu_filter_coeffs.h"
+
+/* Test tones are in units of the output rate / 16 */
+#define PASS_EDGE_16000 (8 * IMU_FILTER_PASS_EDGE_X1000)
+#define STOP_EDGE_16000 (16000 - PASS_EDGE_16000)
+
+/* DC input per axis, and outputs left to the filter to settle on it.
+ * Near full scale, so the biquad cascade's q15 truncation bias, tens of
+ * LSB, stays well inside 1 %
+ */
+static const int16_t dc_acc[3] = { 16000, -16000, 12000 };
+static const int16_t dc_gyr[3] = { -12000, 14000, -14000 };
+#define SETTLE_OUTPUTS  32
+
+#define BENCH_BLOCKS    2000
+
+static struct imu_filter_info info;
+static uint32_t outputs;
+static uint32_t ts_bad;
+static uint32_t dc_bad;
+
+static void sink(const int16_t acc[3], const int16_t gyr[3], uint32_t ts_ms)
+{
+    /* each output carries the timestamp of the last of its inputs */
+    if (ts_ms != outputs * info.decim + info.decim - 1) ts_bad++;
+
+    /* unit DC gain, within 1 % */
+    if (outputs >= SETTLE_OUTPUTS) {
+        for (int i = 0; i < 3; i++) {
+            if (abs(acc[i] - dc_acc[i]) > abs(dc_acc[i]) / 100 ||
+                abs(gyr[i] - dc_gyr[i]) > abs(dc_gyr[i]) / 100) {
+                dc_bad++;
+                break;
+            }
+        }
+    }
+    outputs++;
+}
+
+static void *setup(void)
+{
+    imu_filter_info_get(&info);
+    TC_PRINT("%s order %u, decimation %u, block %u\n", info.type, info.order, info.decim,
+             info.block);
+    return NULL;
+}
+
+ZTEST(imu_filter, test_response)
+{
+    struct imu_filter_resp rows[16];
+    uint32_t pass_rows = 0, stop_rows = 0;
+
+    int n = imu_filter_response(rows, ARRAY_SIZE(rows));
+    zassert_true(n > 0, "no test tones (%d)", n);
+
+    for (int i = 0; i < n; i++) {
+        const struct imu_filter_resp *r = &rows[i];
+        uint32_t f = r->freq_16th * 1000u;
+
+        TC_PRINT("%u/16 fs_out: expected %d mdB, measured %d mdB\n", r->freq_16th,
+                 r->expected_mdb, r->measured_mdb);
+        zassert_true(r->pass, "%u/16 fs_out: %d mdB against %d", r->freq_16th,
+                     r->measured_mdb, r->expected_mdb);
+        if (f <= PASS_EDGE_16000) {
+            zassert_true(abs(r->measured_mdb) <= IMU_FILTER_SPEC_PASS_MDB,
+                         "passband gain %d mdB at %u/16 fs_out", r->measured_mdb,
+                         r->freq_16th);
+            pass_rows++;
+        } else if (f >= STOP_EDGE_16000) {
+            zassert_true(r->measured_mdb <= -IMU_FILTER_SPEC_STOP_MDB,
+                         "stopband gain %d mdB at %u/16 fs_out", r->measured_mdb,
+                         r->freq_16th);
+            stop_rows++;
+        }
+    }
+    zassert_true(pass_rows > 0 && stop_rows > 0, "%u passband and %u stopband tones",
+                 pass_rows, stop_rows);
+}
+
+ZTEST(imu_filter, test_decimate)
+{
+    const uint32_t blocks = 16;
+    struct imu_filter_stats st;
+    uint32_t ts = 0;
+
+    outputs = ts_bad = dc_bad = 0;
+    imu_filter_init();
+
+    /* whole blocks, then one sample short of the next */
+    for (uint32_t i = 0; i < blocks * info.block + info.block - 1; i++) {
+        imu_filter_push(dc_acc, dc_gyr, ts++, sink);
+    }
+    zassert_equal(outputs, blocks * info.block / info.decim, "%u outputs", outputs);
+    zassert_equal(ts_bad, 0, "%u outputs with the wrong timestamp", ts_bad);
+    zassert_equal(dc_bad, 0, "%u outputs off the DC input", dc_bad);
+
+    imu_filter_stats_get(&st);
+    zassert_equal(st.blocks, blocks);
+    zassert_equal(st.outputs, outputs);
+
+    imu_filter_push(dc_acc, dc_gyr, ts++, sink);
+    zassert_equal(outputs, (blocks + 1) * info.block / info.decim);
+}
+
+ZTEST(imu_filter, test_throughput)
+{
+    struct imu_filter_bench b;
+
+    zassert_equal(imu_filter_bench(0, &b), -EINVAL);
+    zassert_ok(imu_filter_bench(BENCH_BLOCKS, &b));
+    zassert_equal(b.blocks, BENCH_BLOCKS);
+
+    TC_PRINT("%u blocks in %u us: %u samples/s (6 axes)\n", b.blocks, b.us, b.max_rate_hz);
+    zassert_true(b.us > 0, "run not timed");
+    zassert_true(b.max_rate_hz >= info.input_mhz / 1000,
+                 "%u samples/s below the %u Hz design rate", b.max_rate_hz, info.input_mhz / 1000);
+}
+
+ZTEST_SUITE(imu_filter, NULL, setup, NULL, NULL, NULL);
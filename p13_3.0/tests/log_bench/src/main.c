@@ -0,0 +1,134 @@
+/*
+ * The logging path benchmark (src/log_bench.c) as a twister suite: every
+ * run of CONFIG_APP_LOG_BENCH_MATRIX must finish without error, account
+ * for each record as written or dropped, and report the same in its JSON
+ * line. Timings are not asserted; scripts/log_bench.py tracks those.
+ */
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <zephyr/ztest.h>
+
+#include "log_bench.h"
+
+static char json[512];
+
+/* The number after "key": in a JSON line, the first such key, is want */
+static void check_num(const char *js, const char *key, long want)
+{
+    char pat[32];
+
+    snprintf(pat, sizeof(pat), "\"%s\":", key);
+    const char *at = strstr(js, pat);
+    zassert_not_null(at, "no %s in %s", key, js);
+
+    char *end;
+    long v = strtol(at + strlen(pat), &end, 10);
+    zassert_not_equal(end, at + strlen(pat), "%s is not a number in %s", key, js);
+    zassert_equal(v, want, "%s is %ld, not %ld", key, v, want);
+}
+
+static void check_json(const struct log_bench_result *r)
+{
+    int n = log_bench_json(r, json, sizeof(json));
+    int depth = 0;
+
+    zassert_true(n > 0 && (size_t)n < sizeof(json), "json length %d", n);
+    zassert_equal(strlen(json), (size_t)n);
+    zassert_equal(json[0], '{');
+    zassert_equal(json[n - 1], '}');
+    for (int i = 0; i < n; i++) {
+        depth += (json[i] == '{') - (json[i] == '}');
+        zassert_true(depth > 0 || i == n - 1, "unbalanced at %d: %s", i, json);
+    }
+    zassert_equal(depth, 0, "unbalanced: %s", json);
+
+    zassert_not_null(strstr(json, "\"backend\":\"ring_log\""), "%s", json);
+    check_num(json, "rate_hz", r->cfg.rate_hz);
+    check_num(json, "records", r->cfg.records);
+    check_num(json, "size", r->cfg.size);
+    check_num(json, "rc", r->rc);
+    check_num(json, "written", r->written);
+    check_num(json, "dropped", r->dropped);
+    zassert_equal(strstr(json, "\"flash\":null") == NULL, r->have_flash, "%s", json);
+}
+
+ZTEST(log_bench, test_matrix)
+{
+    const char *p = CONFIG_APP_LOG_BENCH_MATRIX;
+    struct log_bench_cfg cfg;
+    uint32_t runs = 0;
+    int more;
+
+    while ((more = log_bench_matrix_next(&p, &cfg)) > 0) {
+        struct log_bench_result r;
+
+        TC_PRINT("%u:%u:%u\n", cfg.rate_hz, cfg.records, cfg.size);
+        int rc = log_bench_run(&cfg, &r);
+
+        zassert_ok(rc, "run failed (%d)", rc);
+        zassert_ok(r.rc);
+        zassert_equal(r.written + r.dropped, cfg.records, "written %u dropped %u of %u",
+                      r.written, r.dropped, cfg.records);
+        /* the newest record is never dropped */
+        zassert_true(r.written > 0);
+        if (cfg.rate_hz == 0) {
+            zassert_equal(r.dropped, 0, "a blocking producer dropped %u", r.dropped);
+        }
+        zassert_equal(r.have_flash, IS_ENABLED(CONFIG_FLASH_SIMULATOR_STATS) &&
+                                    IS_ENABLED(CONFIG_STATS_NAMES));
+        if (r.have_flash) {
+            zassert_true(r.flash_bytes >= r.written * cfg.size, "%u bytes programmed",
+                         r.flash_bytes);
+        }
+        check_json(&r);
+        runs++;
+    }
+    zassert_equal(more, 0, "bad matrix at \"%s\"", p);
+    zassert_true(runs > 0, "empty matrix");
+}
+
+ZTEST(log_bench, test_bad_cfg)
+{
+    static const struct log_bench_cfg bad[] = {
+        { .rate_hz = 0, .records = 0, .size = 60 },
+        { .rate_hz = 0, .records = CONFIG_APP_LOG_BENCH_MAX_RECORDS + 1, .size = 60 },
+        { .rate_hz = 0, .records = 10, .size = LOG_BENCH_REC_MIN - 1 },
+        { .rate_hz = 0, .records = 10, .size = LOG_BENCH_REC_MAX + 1 },
+        { .rate_hz = 1000001, .records = 10, .size = 60 },
+    };
+    struct log_bench_result r;
+
+    for (size_t i = 0; i < ARRAY_SIZE(bad); i++) {
+        zassert_equal(log_bench_run(&bad[i], &r), -EINVAL, "cfg %u", (unsigned)i);
+        zassert_equal(r.written, 0);
+    }
+}
+
+ZTEST(log_bench, test_json_overflow)
+{
+    struct log_bench_result r = { .cfg = { .rate_hz = 0, .records = 10, .size = 60 } };
+    char small[16];
+
+    zassert_equal(log_bench_json(&r, small, sizeof(small)), -ENOMEM);
+}
+
+ZTEST(log_bench, test_matrix_parse)
+{
+    const char *p = " 0:500:60  10:200:8";
+    struct log_bench_cfg cfg;
+
+    zassert_equal(log_bench_matrix_next(&p, &cfg), 1);
+    zassert_true(cfg.rate_hz == 0 && cfg.records == 500 && cfg.size == 60);
+    zassert_equal(log_bench_matrix_next(&p, &cfg), 1);
+    zassert_true(cfg.rate_hz == 10 && cfg.records == 200 && cfg.size == 8);
+    zassert_equal(log_bench_matrix_next(&p, &cfg), 0);
+
+    p = "0:500:60 1:2 0:10:8";
+    zassert_equal(log_bench_matrix_next(&p, &cfg), 1);
+    zassert_equal(log_bench_matrix_next(&p, &cfg), -EINVAL);
+    zassert_equal(strcmp(p, "1:2 0:10:8"), 0, "left at \"%s\"", p);
+}
+
+ZTEST_SUITE(log_bench, NULL, NULL, NULL, NULL, NULL);